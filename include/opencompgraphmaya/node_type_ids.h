@@ -129,4 +129,7 @@
 #define OCGM_IMAGE_CACHE_TYPE_ID 0x0012F19B
 #define OCGM_IMAGE_CACHE_TYPE_NAME "ocgImageCache"
 
+#define OCGM_IMAGE_SCOPES_TYPE_ID 0x0012F19C
+#define OCGM_IMAGE_SCOPES_TYPE_NAME "ocgImageScopes"
+
 #endif // OPENCOMPGRAPHMAYA_NODE_TYPE_IDS_H
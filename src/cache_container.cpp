@@ -0,0 +1,1199 @@
+/*
+ * Copyright (C) 2021 David Cattermole.
+ *
+ * This file is part of OpenCompGraphMaya.
+ *
+ * OpenCompGraphMaya is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * OpenCompGraphMaya is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OpenCompGraphMaya.  If not, see <https://www.gnu.org/licenses/>.
+ * ====================================================================
+ *
+ * Disk caches stored as one container file per cache.
+ *
+ * The layout of a container; all numbers are little-endian.
+ *
+ *   Header (64 bytes):
+ *     0   magic "OCGC"
+ *     4   uint32 version
+ *     8   uint32 chunk alignment
+ *     12  uint32 flags (1: replaced by a compacted container)
+ *     16  uint64 index offset
+ *     24  uint64 index entry count
+ *     32  uint64 index hash (FNV-1a of the index bytes)
+ *     40  reserved
+ *
+ *   Index entry (32 bytes):
+ *     0   int32  frame
+ *     4   uint32 compression
+ *     8   uint64 chunk offset
+ *     16  uint64 chunk stored size
+ *     24  uint64 frame file size
+ */
+
+// STL
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <direct.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+// OCG Maya
+#include "cache_container.h"
+#include "image_header.h"
+#include "logger.h"
+
+namespace open_comp_graph_maya {
+namespace cache_container {
+
+namespace {
+
+const std::array<char, 4> kMagic = {{'O', 'C', 'G', 'C'}};
+const uint32_t kVersion = 1;
+const size_t kHeaderSize = 64;
+const size_t kEntrySize = 32;
+
+// Set in the header of a container replaced by its compacted copy,
+// so readers with the old file open read the new file.
+const uint32_t kFlagReplaced = 1;
+
+// Chunks start on a page, so each chunk can be mapped on its own.
+const uint32_t kChunkAlignment = 4096;
+
+// Indexes with more entries are not containers.
+const uint64_t kMaxEntryCount = 1024 * 1024;
+
+// A writer may replace the index while it is read; the index is read
+// again this many times.
+const int32_t kIndexReadAttempts = 3;
+
+// Bytes are copied between files in blocks.
+const size_t kCopyBlockSize = 1024 * 1024;
+
+// The frames of containers are OpenEXR files.
+const char *const kLocalFileExtension = ".exr";
+
+// Containers with more bytes of replaced frames and old indexes than
+// of frames are compacted when a writer closes.
+const double kMaxDeadFraction = 0.5;
+
+// Writers of a container lock a file next to the container, named
+// with this suffix. The container itself is replaced when compacted,
+// so it cannot hold the lock.
+const char *const kLockFileSuffix = ".lock";
+
+// Only the most recently extracted frames are kept as local files;
+// older frames are deleted, and extracted again when read.
+const size_t kMaxLocalFrames = 32;
+
+// Open containers are checked for being replaced (such as deleted
+// and written again) at most this often.
+const double kReplacedCheckSeconds = 2.0;
+
+void write_uint32_le(uint8_t *bytes, const uint32_t value) {
+    bytes[0] = static_cast<uint8_t>(value & 0xFF);
+    bytes[1] = static_cast<uint8_t>((value >> 8) & 0xFF);
+    bytes[2] = static_cast<uint8_t>((value >> 16) & 0xFF);
+    bytes[3] = static_cast<uint8_t>((value >> 24) & 0xFF);
+}
+
+void write_uint64_le(uint8_t *bytes, const uint64_t value) {
+    write_uint32_le(bytes, static_cast<uint32_t>(value & 0xFFFFFFFF));
+    write_uint32_le(bytes + 4, static_cast<uint32_t>(value >> 32));
+}
+
+uint64_t hash_bytes(const uint8_t *bytes, const size_t size) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+uint64_t align_up(const uint64_t value, const uint64_t alignment) {
+    return ((value + alignment - 1) / alignment) * alignment;
+}
+
+// An open file, read and written at offsets, so threads can share
+// one open file without seeking.
+class File {
+public:
+    File()
+#ifdef _WIN32
+        : m_file(INVALID_HANDLE_VALUE)
+#else
+        : m_file_descriptor(-1)
+#endif
+    {}
+
+    ~File() {
+        this->close();
+    }
+
+    bool open(const std::string &file_path) {
+        this->close();
+#ifdef _WIN32
+        m_file = CreateFileA(
+            file_path.c_str(), GENERIC_READ,
+            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+#else
+        m_file_descriptor = ::open(file_path.c_str(), O_RDONLY);
+#endif
+        return this->is_open();
+    }
+
+    // Open the file to read and write, creating it when it does not
+    // exist.
+    bool open_write(const std::string &file_path) {
+        this->close();
+#ifdef _WIN32
+        m_file = CreateFileA(
+            file_path.c_str(), GENERIC_READ | GENERIC_WRITE,
+            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+            nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+#else
+        m_file_descriptor = ::open(file_path.c_str(), O_RDWR | O_CREAT, 0666);
+#endif
+        return this->is_open();
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (m_file != INVALID_HANDLE_VALUE) {
+            CloseHandle(m_file);
+            m_file = INVALID_HANDLE_VALUE;
+        }
+#else
+        if (m_file_descriptor >= 0) {
+            ::close(m_file_descriptor);
+            m_file_descriptor = -1;
+        }
+#endif
+    }
+
+    bool is_open() const {
+#ifdef _WIN32
+        return m_file != INVALID_HANDLE_VALUE;
+#else
+        return m_file_descriptor >= 0;
+#endif
+    }
+
+    // Read up to 'size' bytes at 'offset'. Returns the number of
+    // bytes read, which is less than 'size' at the end of the file.
+    size_t read_at(const uint64_t offset, void *data, const size_t size) const {
+        size_t total_bytes = 0;
+        while (total_bytes < size) {
+            uint8_t *block = static_cast<uint8_t *>(data) + total_bytes;
+            const uint64_t block_offset = offset + total_bytes;
+#ifdef _WIN32
+            OVERLAPPED overlapped = {};
+            overlapped.Offset = static_cast<DWORD>(block_offset & 0xFFFFFFFF);
+            overlapped.OffsetHigh = static_cast<DWORD>(block_offset >> 32);
+            const DWORD block_size = static_cast<DWORD>(
+                std::min<size_t>(size - total_bytes, 0x40000000));
+            DWORD bytes_read = 0;
+            if (!ReadFile(m_file, block, block_size, &bytes_read, &overlapped)
+                || (bytes_read == 0)) {
+                break;
+            }
+#else
+            const ssize_t bytes_read = ::pread(
+                m_file_descriptor, block, size - total_bytes,
+                static_cast<off_t>(block_offset));
+            if (bytes_read <= 0) {
+                break;
+            }
+#endif
+            total_bytes += static_cast<size_t>(bytes_read);
+        }
+        return total_bytes;
+    }
+
+    bool write_at(const uint64_t offset, const void *data, const size_t size) {
+        size_t total_bytes = 0;
+        while (total_bytes < size) {
+            const uint8_t *block = static_cast<const uint8_t *>(data) + total_bytes;
+            const uint64_t block_offset = offset + total_bytes;
+#ifdef _WIN32
+            OVERLAPPED overlapped = {};
+            overlapped.Offset = static_cast<DWORD>(block_offset & 0xFFFFFFFF);
+            overlapped.OffsetHigh = static_cast<DWORD>(block_offset >> 32);
+            const DWORD block_size = static_cast<DWORD>(
+                std::min<size_t>(size - total_bytes, 0x40000000));
+            DWORD bytes_written = 0;
+            if (!WriteFile(m_file, block, block_size, &bytes_written, &overlapped)
+                || (bytes_written == 0)) {
+                return false;
+            }
+#else
+            const ssize_t bytes_written = ::pwrite(
+                m_file_descriptor, block, size - total_bytes,
+                static_cast<off_t>(block_offset));
+            if (bytes_written <= 0) {
+                return false;
+            }
+#endif
+            total_bytes += static_cast<size_t>(bytes_written);
+        }
+        return true;
+    }
+
+    // Block until no other open file (in any process) holds the
+    // lock of the file.
+    bool lock() {
+#ifdef _WIN32
+        OVERLAPPED overlapped = {};
+        return LockFileEx(
+            m_file, LOCKFILE_EXCLUSIVE_LOCK, 0,
+            MAXDWORD, MAXDWORD, &overlapped) != 0;
+#else
+        while (flock(m_file_descriptor, LOCK_EX) != 0) {
+            if (errno != EINTR) {
+                return false;
+            }
+        }
+        return true;
+#endif
+    }
+
+    void unlock() {
+#ifdef _WIN32
+        OVERLAPPED overlapped = {};
+        UnlockFileEx(m_file, 0, MAXDWORD, MAXDWORD, &overlapped);
+#else
+        flock(m_file_descriptor, LOCK_UN);
+#endif
+    }
+
+    // Does 'file_path' name the open file? False when the file has
+    // been deleted or replaced since it was opened.
+    bool is_file(const std::string &file_path) const {
+#ifdef _WIN32
+        BY_HANDLE_FILE_INFORMATION info;
+        BY_HANDLE_FILE_INFORMATION path_info;
+        HANDLE path_file = CreateFileA(
+            file_path.c_str(), 0,
+            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (path_file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        const bool has_info = GetFileInformationByHandle(m_file, &info)
+            && GetFileInformationByHandle(path_file, &path_info);
+        CloseHandle(path_file);
+        return has_info
+            && (info.dwVolumeSerialNumber == path_info.dwVolumeSerialNumber)
+            && (info.nFileIndexHigh == path_info.nFileIndexHigh)
+            && (info.nFileIndexLow == path_info.nFileIndexLow);
+#else
+        struct stat file_stat;
+        struct stat path_stat;
+        return (fstat(m_file_descriptor, &file_stat) == 0)
+            && (stat(file_path.c_str(), &path_stat) == 0)
+            && (file_stat.st_dev == path_stat.st_dev)
+            && (file_stat.st_ino == path_stat.st_ino);
+#endif
+    }
+
+    // The size and modification time of the open file.
+    bool status(uint64_t &size, int64_t &modified_time) const {
+#ifdef _WIN32
+        BY_HANDLE_FILE_INFORMATION info;
+        if (!GetFileInformationByHandle(m_file, &info)) {
+            return false;
+        }
+        size = (static_cast<uint64_t>(info.nFileSizeHigh) << 32)
+            | info.nFileSizeLow;
+        // From 100 nanosecond intervals since 1601 to seconds since
+        // 1970.
+        const uint64_t file_time =
+            (static_cast<uint64_t>(info.ftLastWriteTime.dwHighDateTime) << 32)
+            | info.ftLastWriteTime.dwLowDateTime;
+        modified_time =
+            static_cast<int64_t>(file_time / 10000000ULL) - 11644473600LL;
+#else
+        struct stat file_stat;
+        if (fstat(m_file_descriptor, &file_stat) != 0) {
+            return false;
+        }
+        size = static_cast<uint64_t>(file_stat.st_size);
+        modified_time = static_cast<int64_t>(file_stat.st_mtime);
+#endif
+        return true;
+    }
+
+private:
+    File(const File &);
+    File &operator=(const File &);
+
+#ifdef _WIN32
+    HANDLE m_file;
+#else
+    int m_file_descriptor;
+#endif
+};
+
+struct Header {
+    Header()
+        : chunk_alignment(kChunkAlignment)
+        , index_offset(0)
+        , entry_count(0)
+        , index_hash(hash_bytes(nullptr, 0))
+        , flags(0) {}
+
+    bool operator==(const Header &other) const {
+        return (chunk_alignment == other.chunk_alignment)
+            && (index_offset == other.index_offset)
+            && (entry_count == other.entry_count)
+            && (index_hash == other.index_hash)
+            && (flags == other.flags);
+    }
+
+    uint32_t chunk_alignment;
+    uint64_t index_offset;
+    uint64_t entry_count;
+    uint64_t index_hash;
+    uint32_t flags;
+};
+
+bool read_container_header(const File &file, Header &header) {
+    std::array<uint8_t, kHeaderSize> bytes;
+    if (file.read_at(0, bytes.data(), bytes.size()) != bytes.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < kMagic.size(); ++i) {
+        if (bytes[i] != static_cast<uint8_t>(kMagic[i])) {
+            return false;
+        }
+    }
+    if (image_header::read_uint32_le(bytes.data() + 4) != kVersion) {
+        return false;
+    }
+    header.chunk_alignment = image_header::read_uint32_le(bytes.data() + 8);
+    header.index_offset = image_header::read_uint64_le(bytes.data() + 16);
+    header.entry_count = image_header::read_uint64_le(bytes.data() + 24);
+    header.index_hash = image_header::read_uint64_le(bytes.data() + 32);
+    header.flags = image_header::read_uint32_le(bytes.data() + 12);
+    return (header.chunk_alignment > 0)
+        && (header.entry_count <= kMaxEntryCount);
+}
+
+bool write_container_header(File &file, const Header &header) {
+    std::array<uint8_t, kHeaderSize> bytes;
+    bytes.fill(0);
+    for (size_t i = 0; i < kMagic.size(); ++i) {
+        bytes[i] = static_cast<uint8_t>(kMagic[i]);
+    }
+    write_uint32_le(bytes.data() + 4, kVersion);
+    write_uint32_le(bytes.data() + 8, header.chunk_alignment);
+    write_uint32_le(bytes.data() + 12, header.flags);
+    write_uint64_le(bytes.data() + 16, header.index_offset);
+    write_uint64_le(bytes.data() + 24, header.entry_count);
+    write_uint64_le(bytes.data() + 32, header.index_hash);
+    return file.write_at(0, bytes.data(), bytes.size());
+}
+
+// Read the index named by 'header'. Returns false when the index
+// does not match its hash, such as while a writer replaces it.
+bool read_container_index(
+        const File &file,
+        const Header &header,
+        Index &index) {
+    index = Index();
+    index.chunk_alignment = header.chunk_alignment;
+    if (header.entry_count == 0) {
+        return true;
+    }
+
+    std::vector<uint8_t> bytes(static_cast<size_t>(header.entry_count) * kEntrySize);
+    if ((file.read_at(header.index_offset, bytes.data(), bytes.size()) != bytes.size())
+        || (hash_bytes(bytes.data(), bytes.size()) != header.index_hash)) {
+        return false;
+    }
+    for (size_t i = 0; i < header.entry_count; ++i) {
+        const uint8_t *entry_bytes = bytes.data() + (i * kEntrySize);
+        const uint32_t compression = image_header::read_uint32_le(entry_bytes + 4);
+        if (compression != static_cast<uint32_t>(Compression::kNone)) {
+            return false;
+        }
+        Entry entry;
+        entry.frame = static_cast<int32_t>(image_header::read_uint32_le(entry_bytes));
+        entry.compression = static_cast<Compression>(compression);
+        entry.offset = image_header::read_uint64_le(entry_bytes + 8);
+        entry.stored_size = image_header::read_uint64_le(entry_bytes + 16);
+        entry.size = image_header::read_uint64_le(entry_bytes + 24);
+        index.entries[entry.frame] = entry;
+    }
+    return true;
+}
+
+// Read the header and the index it names. A writer may replace the
+// index while it is read; the index is read again a few times.
+bool read_container(const File &file, Header &header, Index &index) {
+    for (int32_t i = 0; i < kIndexReadAttempts; ++i) {
+        if (read_container_header(file, header)
+            && read_container_index(file, header, index)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Copy 'size' bytes of 'file' from 'offset' to 'output'.
+bool copy_bytes(
+        const File &file,
+        uint64_t offset,
+        uint64_t size,
+        std::ostream &output) {
+    std::vector<char> buffer(kCopyBlockSize);
+    while (size > 0) {
+        const size_t block_size = static_cast<size_t>(
+            std::min<uint64_t>(size, buffer.size()));
+        if (file.read_at(offset, buffer.data(), block_size) != block_size) {
+            return false;
+        }
+        output.write(buffer.data(), block_size);
+        if (!output) {
+            return false;
+        }
+        offset += block_size;
+        size -= block_size;
+    }
+    return true;
+}
+
+// Copy 'size' bytes of 'input' from 'input_offset' to 'output' at
+// 'output_offset'.
+bool copy_bytes(
+        const File &input,
+        uint64_t input_offset,
+        File &output,
+        uint64_t output_offset,
+        uint64_t size) {
+    std::vector<char> buffer(kCopyBlockSize);
+    while (size > 0) {
+        const size_t block_size = static_cast<size_t>(
+            std::min<uint64_t>(size, buffer.size()));
+        if ((input.read_at(input_offset, buffer.data(), block_size) != block_size)
+            || !output.write_at(output_offset, buffer.data(), block_size)) {
+            return false;
+        }
+        input_offset += block_size;
+        output_offset += block_size;
+        size -= block_size;
+    }
+    return true;
+}
+
+// Write 'index' after 'data_end' and point the header at it. The
+// index is written before the header, so readers never see a partly
+// written index.
+bool write_container_index(
+        File &file,
+        const uint64_t data_end,
+        const Index &index,
+        Header &header) {
+    std::vector<uint8_t> index_bytes(index.entries.size() * kEntrySize, 0);
+    size_t i = 0;
+    for (const auto &it : index.entries) {
+        uint8_t *entry_bytes = index_bytes.data() + (i * kEntrySize);
+        write_uint32_le(entry_bytes, static_cast<uint32_t>(it.second.frame));
+        write_uint32_le(entry_bytes + 4, static_cast<uint32_t>(it.second.compression));
+        write_uint64_le(entry_bytes + 8, it.second.offset);
+        write_uint64_le(entry_bytes + 16, it.second.stored_size);
+        write_uint64_le(entry_bytes + 24, it.second.size);
+        i += 1;
+    }
+    header = Header();
+    header.chunk_alignment = index.chunk_alignment;
+    header.index_offset = data_end;
+    header.entry_count = index.entries.size();
+    header.index_hash = hash_bytes(index_bytes.data(), index_bytes.size());
+    return file.write_at(data_end, index_bytes.data(), index_bytes.size())
+        && write_container_header(file, header);
+}
+
+// Replace 'to_file_path' with 'from_file_path'; readers with the old
+// file open keep reading the old file.
+bool replace_file(
+        const std::string &from_file_path,
+        const std::string &to_file_path) {
+#ifdef _WIN32
+    return MoveFileExA(
+        from_file_path.c_str(), to_file_path.c_str(),
+        MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return std::rename(from_file_path.c_str(), to_file_path.c_str()) == 0;
+#endif
+}
+
+bool make_directory(const std::string &directory) {
+#ifdef _WIN32
+    return _mkdir(directory.c_str()) == 0;
+#else
+    return mkdir(directory.c_str(), 0777) == 0;
+#endif
+}
+
+// Make 'directory' and any missing parent directories.
+void make_directories(const std::string &directory) {
+    size_t separator = directory.find_first_of("/\\", 1);
+    while (separator != std::string::npos) {
+        make_directory(directory.substr(0, separator));
+        separator = directory.find_first_of("/\\", separator + 1);
+    }
+    make_directory(directory);
+}
+
+std::string system_temp_directory() {
+    const char *names[] = {"TEMP", "TMPDIR", "TMP"};
+    for (auto name : names) {
+        const char *value = std::getenv(name);
+        if ((value != nullptr) && (value[0] != '\0')) {
+            return value;
+        }
+    }
+#ifdef _WIN32
+    return "C:/Temp";
+#else
+    return "/tmp";
+#endif
+}
+
+// Write the chunk 'entry' of the container 'file' as the file
+// 'file_path'. Readers never see a partly written file.
+bool write_frame_file(
+        const File &file,
+        const Entry &entry,
+        const std::string &file_path) {
+    const std::string partial_file_path = file_path + ".partial";
+    {
+        std::ofstream output(partial_file_path, std::ios::out | std::ios::binary);
+        if (!output.is_open()
+            || !copy_bytes(file, entry.offset, entry.stored_size, output)) {
+            std::remove(partial_file_path.c_str());
+            return false;
+        }
+    }
+#ifdef _WIN32
+    std::remove(file_path.c_str());
+#endif
+    return std::rename(partial_file_path.c_str(), file_path.c_str()) == 0;
+}
+
+// A container resolved to a local directory.
+struct LocalContainer {
+    std::string container_path;
+
+    // The local frame files are named with this prefix, the frame
+    // number and 'kLocalFileExtension'.
+    std::string file_name_prefix;
+};
+
+// A container kept open for reading, with the index last read from
+// it. Frames are read from the open file at their offsets, so the
+// container is not opened, nor its index read, for each frame.
+struct OpenContainer {
+    OpenContainer()
+        : file()
+        , file_id(0)
+        , checked_time()
+        , has_index(false)
+        , header()
+        , index() {}
+
+    // Replaced, not closed, when the container is opened again, so
+    // reads through the old file can finish.
+    std::shared_ptr<const File> file;
+    // Unique to each time a container is opened, so the chunks of a
+    // replaced container are not mistaken for the old chunks at the
+    // same offsets.
+    uint64_t file_id;
+    std::chrono::steady_clock::time_point checked_time;
+
+    bool has_index;
+    Header header;
+    Index index;
+};
+
+class LocalFrames {
+public:
+    LocalFrames()
+        : m_next_file_id(1) {}
+
+    void set_directory(const std::string &directory) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_directory = directory;
+    }
+
+    std::string resolve_file_path(const std::string &container_path) {
+        std::string directory;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            directory = m_directory;
+        }
+        // Unset environment variables leave the directory unusable.
+        if (directory.empty() || (directory.find('$') != std::string::npos)) {
+            directory = system_temp_directory();
+        }
+
+        const auto separator = container_path.find_last_of("/\\");
+        const size_t name_start =
+            (separator == std::string::npos) ? 0 : separator + 1;
+        const size_t name_end = container_path.size()
+            - std::string(kFileExtension).size();
+        LocalContainer local_container;
+        local_container.container_path = container_path;
+        local_container.file_name_prefix =
+            container_path.substr(name_start, name_end - name_start) + ".";
+
+        // Caches with the same file name (in different directories)
+        // are kept apart.
+        char hash_string[17];
+        std::snprintf(
+            hash_string, sizeof(hash_string), "%016llx",
+            static_cast<unsigned long long>(hash_bytes(
+                reinterpret_cast<const uint8_t *>(container_path.data()),
+                container_path.size())));
+        const std::string local_directory =
+            directory + "/ocgcache_" + hash_string;
+        make_directories(local_directory);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_containers[local_directory] = local_container;
+        return local_directory + "/" + local_container.file_name_prefix
+            + "####" + kLocalFileExtension;
+    }
+
+    // Find the chunk of 'frame' of the container, and the open
+    // file to read it from.
+    bool find_entry(
+            const std::string &container_path,
+            const int32_t frame,
+            Entry &entry,
+            std::shared_ptr<const File> &file,
+            uint64_t &file_id) {
+        std::shared_ptr<OpenContainer> container;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto &open_container = m_open_containers[container_path];
+            if (!open_container) {
+                open_container = std::make_shared<OpenContainer>();
+            }
+            container = open_container;
+        }
+
+        std::lock_guard<std::mutex> lock(m_open_mutex);
+        if (!this->update_index(container_path, *container)) {
+            return false;
+        }
+        auto it = container->index.entries.find(frame);
+        if (it == container->index.entries.end()) {
+            return false;
+        }
+        entry = it->second;
+        file = container->file;
+        file_id = container->file_id;
+        return true;
+    }
+
+    // Find the container and frame of a local frame file. Returns
+    // false when 'file_path' is not a frame of a resolved container.
+    bool find_local_frame(
+            const std::string &file_path,
+            LocalContainer &local_container,
+            int32_t &frame) {
+        const auto separator = file_path.find_last_of("/\\");
+        if (separator == std::string::npos) {
+            return false;
+        }
+        const std::string local_directory = file_path.substr(0, separator);
+        const std::string file_name = file_path.substr(separator + 1);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_containers.find(local_directory);
+            if (it == m_containers.end()) {
+                return false;
+            }
+            local_container = it->second;
+        }
+
+        // The frame number is between the prefix and the extension.
+        const std::string &prefix = local_container.file_name_prefix;
+        const std::string extension(kLocalFileExtension);
+        if ((file_name.size() <= (prefix.size() + extension.size()))
+            || (file_name.compare(0, prefix.size(), prefix) != 0)
+            || (file_name.compare(
+                    file_name.size() - extension.size(),
+                    extension.size(), extension) != 0)) {
+            return false;
+        }
+        const std::string frame_string = file_name.substr(
+            prefix.size(), file_name.size() - prefix.size() - extension.size());
+        char *frame_end = nullptr;
+        const long frame_number = std::strtol(frame_string.c_str(), &frame_end, 10);
+        if ((frame_end == nullptr) || (*frame_end != '\0')) {
+            return false;
+        }
+        frame = static_cast<int32_t>(frame_number);
+        return true;
+    }
+
+    bool extract_local_frame(const std::string &file_path) {
+        LocalContainer local_container;
+        int32_t frame = 0;
+        if (!this->find_local_frame(file_path, local_container, frame)) {
+            return true;
+        }
+
+        Entry entry;
+        std::shared_ptr<const File> file;
+        uint64_t file_id = 0;
+        if (!this->find_entry(
+                local_container.container_path, frame, entry, file, file_id)) {
+            return false;
+        }
+
+        // Frames replaced in the container are extracted again.
+        const ExtractedChunk chunk(file_id, entry.offset);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto extracted_it = m_extracted.find(file_path);
+            if ((extracted_it != m_extracted.end())
+                && (extracted_it->second == chunk)) {
+                return true;
+            }
+        }
+        if (!write_frame_file(*file, entry, file_path)) {
+            return false;
+        }
+
+        std::vector<std::string> removed_file_paths;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_extracted.find(file_path) == m_extracted.end()) {
+                m_extracted_order.push_back(file_path);
+            }
+            m_extracted[file_path] = chunk;
+            while (m_extracted_order.size() > kMaxLocalFrames) {
+                removed_file_paths.push_back(m_extracted_order.front());
+                m_extracted.erase(m_extracted_order.front());
+                m_extracted_order.pop_front();
+            }
+        }
+        for (const auto &removed_file_path : removed_file_paths) {
+            std::remove(removed_file_path.c_str());
+        }
+        return true;
+    }
+
+    uint64_t read_local_frame(
+            const std::string &file_path,
+            std::vector<char> &buffer,
+            const ReadBlockFunction &before_block) {
+        LocalContainer local_container;
+        int32_t frame = 0;
+        Entry entry;
+        std::shared_ptr<const File> file;
+        uint64_t file_id = 0;
+        if (buffer.empty()
+            || !this->find_local_frame(file_path, local_container, frame)
+            || !this->find_entry(
+                local_container.container_path, frame, entry, file, file_id)) {
+            return 0;
+        }
+        uint64_t total_bytes = 0;
+        while (total_bytes < entry.stored_size) {
+            const size_t block_size = static_cast<size_t>(
+                std::min<uint64_t>(
+                    entry.stored_size - total_bytes, buffer.size()));
+            if (!before_block(block_size)) {
+                break;
+            }
+            const size_t bytes_read = file->read_at(
+                entry.offset + total_bytes, buffer.data(), block_size);
+            total_bytes += bytes_read;
+            if (bytes_read != block_size) {
+                break;
+            }
+        }
+        return total_bytes;
+    }
+
+private:
+    // Read the index of the open container again, when a writer has
+    // changed it. The container is opened again when its path names
+    // another file now (such as a container deleted and written
+    // again), checked every 'kReplacedCheckSeconds'.
+    //
+    // Must be called with 'm_open_mutex' locked.
+    bool update_index(
+            const std::string &container_path,
+            OpenContainer &container) {
+        const auto now = std::chrono::steady_clock::now();
+        if (container.file
+            && (std::chrono::duration<double>(
+                    now - container.checked_time).count()
+                > kReplacedCheckSeconds)) {
+            container.checked_time = now;
+            if (!container.file->is_file(container_path)) {
+                container.file.reset();
+            }
+        }
+        if (!container.file) {
+            auto file = std::make_shared<File>();
+            if (!file->open(container_path)) {
+                return false;
+            }
+            container.file = file;
+            container.file_id = m_next_file_id++;
+            container.checked_time = now;
+            container.has_index = false;
+        }
+
+        Header header;
+        if (!read_container_header(*container.file, header)) {
+            container.has_index = false;
+            return false;
+        }
+        if (header.flags & kFlagReplaced) {
+            auto file = std::make_shared<File>();
+            if (!file->open(container_path)
+                || !read_container_header(*file, header)) {
+                container.file.reset();
+                container.has_index = false;
+                return false;
+            }
+            container.file = file;
+            container.file_id = m_next_file_id++;
+            container.checked_time = now;
+            container.has_index = false;
+        }
+        if (container.has_index && (header == container.header)) {
+            return true;
+        }
+        Index index;
+        if (!read_container(*container.file, header, index)) {
+            container.has_index = false;
+            return false;
+        }
+        container.has_index = true;
+        container.header = header;
+        container.index = index;
+        return true;
+    }
+
+private:
+    std::mutex m_mutex;
+    std::string m_directory;
+
+    // Keyed by the local directory of each container.
+    std::map<std::string, LocalContainer> m_containers;
+
+    // Keyed by the container path. Opening and reading the indexes
+    // of containers is serialized by 'm_open_mutex'.
+    std::map<std::string, std::shared_ptr<OpenContainer>> m_open_containers;
+    std::mutex m_open_mutex;
+
+    uint64_t m_next_file_id;
+
+    // The chunk of each extracted local frame file, and the order
+    // the files were extracted in.
+    typedef std::pair<uint64_t, uint64_t> ExtractedChunk;
+    std::map<std::string, ExtractedChunk> m_extracted;
+    std::deque<std::string> m_extracted_order;
+};
+
+LocalFrames &get_local_frames() {
+    static LocalFrames local_frames;
+    return local_frames;
+}
+
+} // namespace
+
+bool is_container_path(const std::string &file_path) {
+    const std::string extension(kFileExtension);
+    return (file_path.size() > extension.size())
+        && (file_path.compare(
+                file_path.size() - extension.size(),
+                extension.size(), extension) == 0);
+}
+
+void set_local_directory(const std::string &directory) {
+    get_local_frames().set_directory(directory);
+}
+
+std::string resolve_file_path(const std::string &file_path) {
+    if (!is_container_path(file_path)) {
+        return file_path;
+    }
+    return get_local_frames().resolve_file_path(file_path);
+}
+
+bool read_index(const std::string &container_path, Index &index) {
+    File file;
+    Header header;
+    return file.open(container_path)
+        && read_container(file, header, index);
+}
+
+struct Writer::Data {
+    Data()
+        : container_path()
+        , lock_file()
+        , file()
+        , index()
+        , data_end(0)
+        , has_changed(false) {}
+
+    std::string container_path;
+    File lock_file;
+    File file;
+    Index index;
+
+    // The end of the chunks; new chunks and the index are written
+    // after it.
+    uint64_t data_end;
+    bool has_changed;
+};
+
+Writer::Writer()
+        : m_data() {}
+
+Writer::~Writer() {
+    this->close();
+}
+
+bool Writer::is_open() const {
+    return static_cast<bool>(m_data);
+}
+
+bool Writer::open(const std::string &container_path) {
+    auto log = log::get_logger();
+    this->close();
+    std::unique_ptr<Data> data(new Data());
+    data->container_path = container_path;
+
+    // Writers in this and other processes wait for each other.
+    const std::string lock_file_path = container_path + kLockFileSuffix;
+    if (!data->lock_file.open_write(lock_file_path)
+        || !data->lock_file.lock()) {
+        log->error("Could not lock cache container \"{}\".", container_path);
+        return false;
+    }
+
+    uint64_t size = 0;
+    int64_t modified_time = 0;
+    if (!data->file.open_write(container_path)
+        || !data->file.status(size, modified_time)) {
+        log->error("Could not open cache container \"{}\".", container_path);
+        return false;
+    }
+    if (size == 0) {
+        // An empty container is only a header.
+        data->index.chunk_alignment = kChunkAlignment;
+        data->data_end = kHeaderSize;
+        if (!write_container_header(data->file, Header())) {
+            log->error("Could not create cache container \"{}\".", container_path);
+            return false;
+        }
+    } else {
+        Header header;
+        if (!read_container(data->file, header, data->index)) {
+            log->error("Could not read cache container \"{}\".", container_path);
+            return false;
+        }
+        data->data_end = size;
+    }
+    m_data = std::move(data);
+    return true;
+}
+
+bool Writer::append_frame(const int32_t frame, const std::string &file_path) {
+    auto log = log::get_logger();
+    if (!m_data) {
+        return false;
+    }
+    File input;
+    uint64_t file_size = 0;
+    int64_t modified_time = 0;
+    if (!input.open(file_path) || !input.status(file_size, modified_time)) {
+        log->error("Could not open frame file \"{}\".", file_path);
+        return false;
+    }
+
+    // The chunk follows the end of the file; the chunks and index
+    // already written are not changed, so readers never see a
+    // partly written frame. The gap left to align the chunk is never
+    // written.
+    Entry entry;
+    entry.frame = frame;
+    entry.compression = Compression::kNone;
+    entry.offset = align_up(m_data->data_end, m_data->index.chunk_alignment);
+    entry.stored_size = file_size;
+    entry.size = file_size;
+    if (!copy_bytes(input, 0, m_data->file, entry.offset, entry.stored_size)) {
+        log->error(
+            "Could not append frame {} to cache container \"{}\".",
+            frame, m_data->container_path);
+        return false;
+    }
+    m_data->index.entries[frame] = entry;
+    m_data->data_end = entry.offset + entry.stored_size;
+    m_data->has_changed = true;
+    return true;
+}
+
+bool Writer::close() {
+    auto log = log::get_logger();
+    if (!m_data) {
+        return true;
+    }
+    std::unique_ptr<Data> data(std::move(m_data));
+    if (!data->has_changed) {
+        return true;
+    }
+
+    const std::string &container_path = data->container_path;
+    Header header;
+    if (!write_container_index(data->file, data->data_end, data->index, header)) {
+        log->error(
+            "Could not write the index of cache container \"{}\".",
+            container_path);
+        return false;
+    }
+
+    // Replaced frames and the old indexes are never read again; once
+    // they outweigh the frames, the frames are copied to a new
+    // container, which replaces the old one.
+    uint64_t live_size = 0;
+    for (const auto &it : data->index.entries) {
+        live_size += align_up(it.second.stored_size, data->index.chunk_alignment);
+    }
+    const uint64_t dead_size =
+        data->data_end - std::min(data->data_end, kHeaderSize + live_size);
+    if (static_cast<double>(dead_size)
+        <= (kMaxDeadFraction * static_cast<double>(kHeaderSize + live_size))) {
+        return true;
+    }
+
+    const std::string compact_file_path = container_path + ".compact";
+    bool compacted = false;
+    {
+        File compact_file;
+        Index compact_index;
+        compact_index.chunk_alignment = data->index.chunk_alignment;
+        uint64_t compact_end = kHeaderSize;
+        compacted = compact_file.open_write(compact_file_path)
+            && write_container_header(compact_file, Header());
+        for (const auto &it : data->index.entries) {
+            if (!compacted) {
+                break;
+            }
+            Entry entry = it.second;
+            entry.offset = align_up(compact_end, compact_index.chunk_alignment);
+            compacted = copy_bytes(
+                data->file, it.second.offset,
+                compact_file, entry.offset, entry.stored_size);
+            compact_index.entries[entry.frame] = entry;
+            compact_end = entry.offset + entry.stored_size;
+        }
+        Header compact_header;
+        compacted = compacted
+            && write_container_index(
+                compact_file, compact_end, compact_index, compact_header);
+    }
+    if (!compacted || !replace_file(compact_file_path, container_path)) {
+        std::remove(compact_file_path.c_str());
+        log->warn("Could not compact cache container \"{}\".", container_path);
+        return true;
+    }
+    header.flags |= kFlagReplaced;
+    write_container_header(data->file, header);
+    log->debug(
+        "Compacted cache container \"{}\", removed {} bytes.",
+        container_path, dead_size);
+    return true;
+}
+
+bool append_frame(
+        const std::string &container_path,
+        const int32_t frame,
+        const std::string &file_path) {
+    Writer writer;
+    return writer.open(container_path)
+        && writer.append_frame(frame, file_path)
+        && writer.close();
+}
+
+bool extract_frame(
+        const std::string &container_path,
+        const int32_t frame,
+        const std::string &file_path) {
+    Entry entry;
+    std::shared_ptr<const File> file;
+    uint64_t file_id = 0;
+    return get_local_frames().find_entry(
+            container_path, frame, entry, file, file_id)
+        && write_frame_file(*file, entry, file_path);
+}
+
+bool is_local_frame_path(const std::string &file_path) {
+    LocalContainer local_container;
+    int32_t frame = 0;
+    return get_local_frames().find_local_frame(
+        file_path, local_container, frame);
+}
+
+bool extract_local_frame(const std::string &file_path) {
+    return get_local_frames().extract_local_frame(file_path);
+}
+
+uint64_t read_local_frame(
+        const std::string &file_path,
+        std::vector<char> &buffer,
+        const ReadBlockFunction &before_block) {
+    return get_local_frames().read_local_frame(
+        file_path, buffer, before_block);
+}
+
+} // namespace cache_container
+} // namespace open_comp_graph_maya
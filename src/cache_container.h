@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) 2021 David Cattermole.
+ *
+ * This file is part of OpenCompGraphMaya.
+ *
+ * OpenCompGraphMaya is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * OpenCompGraphMaya is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OpenCompGraphMaya.  If not, see <https://www.gnu.org/licenses/>.
+ * ====================================================================
+ *
+ * Disk caches stored as one container file per cache.
+ *
+ * A disk cache of one image file per frame needs thousands of file
+ * opens and metadata lookups to play back, which dominate the load
+ * time on network storage. A container ('.ocgcache' file) holds all
+ * frames of a cache in one file:
+ *
+ *  - A fixed size header, naming the offset of the frame index.
+ *
+ *  - The chunks; each chunk holds the bytes of one frame's OpenEXR
+ *    file, starting at a multiple of the chunk alignment, so a chunk
+ *    can be memory mapped on its own.
+ *
+ *  - The frame index, after the last chunk; the frame number, the
+ *    compression, offset and size of each chunk.
+ *
+ * A writer appends the chunks of its frames after the end of the
+ * file, and when closed writes one new index after them, then points
+ * the header at the new index, so a container can be read while a
+ * writer appends to it. Writers (in any process) lock the container
+ * while open. Replaced frames and old indexes are removed by
+ * compacting the container when they outweigh the frames. A frame is
+ * read by looking it up in the index, without reading the other
+ * chunks.
+ *
+ * OCG decodes image files, so the frames of a container are written
+ * and read through files in a local directory ('diskCacheBaseDir' of
+ * the 'ocgPreferences' node); a frame is extracted when the graph
+ * reads it, and packed after it is written. Only the most recently
+ * extracted frames are kept as local files. Containers are kept open
+ * and their chunks read at their offsets, so reading ahead reads the
+ * chunks without extracting them.
+ */
+
+#ifndef OPENCOMPGRAPHMAYA_CACHE_CONTAINER_H
+#define OPENCOMPGRAPHMAYA_CACHE_CONTAINER_H
+
+// STL
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace open_comp_graph_maya {
+namespace cache_container {
+
+// The file name extension of containers.
+const char *const kFileExtension = ".ocgcache";
+
+// How the bytes of a chunk are stored.
+enum class Compression : uint32_t {
+    kNone = 0,
+};
+
+// A chunk of a container; the bytes of one frame's file.
+struct Entry {
+    Entry()
+        : frame(0)
+        , compression(Compression::kNone)
+        , offset(0)
+        , stored_size(0)
+        , size(0) {}
+
+    int32_t frame;
+    Compression compression;
+
+    // Where the chunk starts in the container, and the bytes of the
+    // chunk as stored.
+    uint64_t offset;
+    uint64_t stored_size;
+
+    // The bytes of the frame's file.
+    uint64_t size;
+};
+
+struct Index {
+    Index()
+        : chunk_alignment(0) {}
+
+    uint32_t chunk_alignment;
+    std::map<int32_t, Entry> entries;
+};
+
+// Does 'file_path' name a container?
+bool is_container_path(const std::string &file_path);
+
+// The directory the frames of containers are extracted to and written
+// in. Environment variables (such as '${TEMP}') are expanded by the
+// caller; an empty directory uses the system's temporary directory.
+void set_local_directory(const std::string &directory);
+
+// The file path (with '#' frame padding) OCG reads and writes the
+// frames of 'file_path' as. Containers are given a directory of the
+// local directory, which is created; other paths are returned as
+// they are.
+std::string resolve_file_path(const std::string &file_path);
+
+// Read the index of the container. Returns false when the file is
+// not a container, or a writer changed the index while reading.
+bool read_index(const std::string &container_path, Index &index);
+
+// Appends (or replaces) frames of a container. The container is
+// locked from 'open' until 'close', which writes the index, so
+// writing many frames writes one index.
+class Writer {
+public:
+    Writer();
+    ~Writer();
+
+    // Lock and open the container, waiting for any other writer.
+    // The container is created when it does not exist.
+    bool open(const std::string &container_path);
+
+    bool is_open() const;
+
+    // Append (or replace) 'frame', copying the bytes of 'file_path'.
+    // Readers see the frame once the writer is closed.
+    bool append_frame(const int32_t frame, const std::string &file_path);
+
+    // Write the index, compact the container when needed, and
+    // unlock it.
+    bool close();
+
+private:
+    Writer(const Writer &);
+    Writer &operator=(const Writer &);
+
+    struct Data;
+    std::unique_ptr<Data> m_data;
+};
+
+// Append (or replace) 'frame' of the container, copying the bytes of
+// 'file_path'. The container is created when it does not exist.
+bool append_frame(
+    const std::string &container_path,
+    const int32_t frame,
+    const std::string &file_path);
+
+// Copy 'frame' of the container to 'file_path'. Returns false when
+// the container has no such frame.
+bool extract_frame(
+    const std::string &container_path,
+    const int32_t frame,
+    const std::string &file_path);
+
+// Is 'file_path' a frame of a resolved container path (see
+// 'resolve_file_path')?
+bool is_local_frame_path(const std::string &file_path);
+
+// Called before each block of a frame is read, with the size of the
+// block; reading stops when it returns false.
+typedef std::function<bool(size_t)> ReadBlockFunction;
+
+// When 'file_path' is a frame of a resolved container path (see
+// 'resolve_file_path'), extract the frame from the container, unless
+// already extracted. Returns false only when extracting fails.
+bool extract_local_frame(const std::string &file_path);
+
+// When 'file_path' is a frame of a resolved container path, read the
+// frame's chunk from the container in blocks of 'buffer', without
+// writing the local file. Returns the number of bytes read.
+uint64_t read_local_frame(
+    const std::string &file_path,
+    std::vector<char> &buffer,
+    const ReadBlockFunction &before_block);
+
+} // namespace cache_container
+} // namespace open_comp_graph_maya
+
+#endif // OPENCOMPGRAPHMAYA_CACHE_CONTAINER_H
@@ -38,6 +38,7 @@
 // STL
 #include <cstring>
 #include <cmath>
+#include <mutex>
 
 // OCG
 #include "opencompgraph.h"
@@ -60,7 +61,7 @@ BaseNode::~BaseNode() {}
 
 MStatus BaseNode::updateOcgNodes(
         MDataBlock &data,
-        std::shared_ptr<ocg::Graph> &shared_graph,
+        std::shared_ptr<SharedGraph> &shared_graph,
         std::vector<ocg::Node> input_ocg_nodes,
         ocg::Node &output_ocg_node) {
     return MS::kFailure;
@@ -118,6 +119,8 @@ MStatus BaseNode::computeOcgStream(const MPlug &plug, MDataBlock &data,
         // Update OCG nodes.
         auto shared_graph = get_shared_graph();
         auto output_ocg_node = ocg::Node(ocg::NodeType::kNull, 0);
+        std::lock_guard<std::recursive_mutex> graph_lock(
+            get_shared_graph_mutex());
         if (shared_graph) {
             // Initialise the OCG Graph, and update OCG node values.
             // The output node is modified via an output variable. The
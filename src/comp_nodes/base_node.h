@@ -37,6 +37,9 @@
 // OCG
 #include "opencompgraph.h"
 
+// OCG Maya
+#include "../shared_graph.h"
+
 namespace open_comp_graph_maya {
 
 class BaseNode : public MPxNode {
@@ -56,7 +59,7 @@ public:
 
     virtual MStatus updateOcgNodes(
         MDataBlock &data,
-        std::shared_ptr<ocg::Graph> &shared_graph,
+        std::shared_ptr<SharedGraph> &shared_graph,
         std::vector<ocg::Node> input_ocg_nodes,
         ocg::Node &output_ocg_node);
 
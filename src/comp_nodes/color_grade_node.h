@@ -58,7 +58,7 @@ public:
 
     virtual MStatus updateOcgNodes(
         MDataBlock &data,
-        std::shared_ptr<ocg::Graph> &shared_graph,
+        std::shared_ptr<SharedGraph> &shared_graph,
         std::vector<ocg::Node> input_ocg_nodes,
         ocg::Node &output_ocg_node);
 
@@ -37,6 +37,7 @@
 // STL
 #include <cstring>
 #include <cmath>
+#include <string>
 
 // OCG
 #include "opencompgraph.h"
@@ -47,6 +48,7 @@
 #include "graph_data.h"
 #include "node_utils.h"
 #include "attr_utils.h"
+#include "cache_container.h"
 
 #include "image_cache_node.h"
 
@@ -76,7 +78,7 @@ MString ImageCacheNode::nodeName() {
 
 MStatus ImageCacheNode::updateOcgNodes(
         MDataBlock &data,
-        std::shared_ptr<ocg::Graph> &shared_graph,
+        std::shared_ptr<SharedGraph> &shared_graph,
         std::vector<ocg::Node> input_ocg_nodes,
         ocg::Node &output_ocg_node) {
     MStatus status = MS::kSuccess;
@@ -117,11 +119,14 @@ MStatus ImageCacheNode::updateOcgNodes(
             output_ocg_node = m_ocg_read_node;
         }
 
-        // Disk Cache File Path
+        // Disk Cache File Path; the frames of cache containers are
+        // read from their local files.
         MString file_path = utils::get_attr_value_string(
             data, m_disk_cache_file_path_attr);
+        const std::string resolved_file_path =
+            cache_container::resolve_file_path(file_path.asChar());
         shared_graph->set_node_attr_str(
-            m_ocg_read_node, "file_path", file_path.asChar());
+            m_ocg_read_node, "file_path", resolved_file_path.c_str());
     }
 
     return status;
@@ -39,6 +39,7 @@
 // STL
 #include <cstring>
 #include <cmath>
+#include <string>
 
 // OCG
 #include "opencompgraph.h"
@@ -49,6 +50,8 @@
 #include "graph_data.h"
 #include "node_utils.h"
 #include "attr_utils.h"
+#include "cache_container.h"
+#include "sequence_index.h"
 
 #include "image_read_node.h"
 
@@ -65,6 +68,8 @@ MObject ImageReadNode::m_frame_end_attr;
 MObject ImageReadNode::m_frame_after_attr;
 MObject ImageReadNode::m_frame_before_attr;
 MObject ImageReadNode::m_file_path_attr;
+MObject ImageReadNode::m_layer_name_attr;
+MObject ImageReadNode::m_channel_names_attr;
 MObject ImageReadNode::m_disk_cache_enable_attr;
 MObject ImageReadNode::m_disk_cache_file_path_attr;
 
@@ -84,7 +89,7 @@ MString ImageReadNode::nodeName() {
 
 MStatus ImageReadNode::updateOcgNodes(
         MDataBlock &data,
-        std::shared_ptr<ocg::Graph> &shared_graph,
+        std::shared_ptr<SharedGraph> &shared_graph,
         std::vector<ocg::Node> input_ocg_nodes,
         ocg::Node &output_ocg_node) {
     MStatus status = MS::kSuccess;
@@ -154,10 +159,13 @@ MStatus ImageReadNode::updateOcgNodes(
         shared_graph->set_node_attr_i32(
             m_ocg_read_cache_node, "enable", static_cast<int32_t>(enable));
 
-        // Disk Cache File Path
+        // Disk Cache File Path; the frames of cache containers are
+        // read from their local files.
         MString file_path = utils::get_attr_value_string(data, m_disk_cache_file_path_attr);
+        const std::string resolved_file_path =
+            cache_container::resolve_file_path(file_path.asChar());
         shared_graph->set_node_attr_str(
-            m_ocg_read_cache_node, "file_path", file_path.asChar());
+            m_ocg_read_cache_node, "file_path", resolved_file_path.c_str());
     }
 
     if (m_ocg_read_node.get_id() != 0) {
@@ -166,9 +174,27 @@ MStatus ImageReadNode::updateOcgNodes(
         shared_graph->set_node_attr_i32(
             m_ocg_read_node, "enable", static_cast<int32_t>(enable));
 
-        // Start / End Frame Attribute
+        // File Path Attribute
+        MString file_path = utils::get_attr_value_string(data, m_file_path_attr);
+        shared_graph->set_node_attr_str(
+            m_ocg_read_node, "file_path", file_path.asChar());
+
+        // Start / End Frame Attribute; when both are zero the frame
+        // range of the sequence on disk is used.
         auto start_frame = utils::get_attr_value_int(data, m_frame_start_attr);
         auto end_frame = utils::get_attr_value_int(data, m_frame_end_attr);
+        if ((start_frame == 0) && (end_frame == 0)) {
+            auto frame_sequence = sequence::find_sequence(file_path.asChar());
+            if (frame_sequence && !frame_sequence->is_empty()) {
+                start_frame = frame_sequence->start_frame;
+                end_frame = frame_sequence->end_frame;
+                auto log = log::get_logger();
+                log->debug(
+                    "ocgImageRead: found frames {} to {} of \"{}\", {} missing.",
+                    start_frame, end_frame, file_path.asChar(),
+                    frame_sequence->missing_frames.size());
+            }
+        }
         shared_graph->set_node_attr_i32(m_ocg_read_node, "start_frame", start_frame);
         shared_graph->set_node_attr_i32(m_ocg_read_node, "end_frame", end_frame);
 
@@ -184,10 +210,17 @@ MStatus ImageReadNode::updateOcgNodes(
         shared_graph->set_node_attr_i32(
             m_ocg_read_node, "after_frame", static_cast<int32_t>(after_frame));
 
-        // File Path Attribute
-        MString file_path = utils::get_attr_value_string(data, m_file_path_attr);
+        // Layer Name Attribute; the part (or channel name prefix) of
+        // a multi-part/multi-layer file to read.
+        MString layer_name = utils::get_attr_value_string(data, m_layer_name_attr);
         shared_graph->set_node_attr_str(
-            m_ocg_read_node, "file_path", file_path.asChar());
+            m_ocg_read_node, "layer", layer_name.asChar());
+
+        // Channel Names Attribute; the channels of the layer to read,
+        // separated by commas or spaces.
+        MString channel_names = utils::get_attr_value_string(data, m_channel_names_attr);
+        shared_graph->set_node_attr_str(
+            m_ocg_read_node, "channels", channel_names.asChar());
     }
 
     return status;
@@ -224,6 +257,20 @@ MStatus ImageReadNode::initialize() {
     CHECK_MSTATUS(tAttr.setStorable(true));
     CHECK_MSTATUS(tAttr.setUsedAsFilename(true));
 
+    // Layer Name; the part name of multi-part OpenEXR files, or the
+    // prefix of the channel names (such as "diffuse" in
+    // "diffuse.R"). Empty reads the default layer.
+    m_layer_name_attr = tAttr.create(
+            "layerName", "lyrnm",
+            MFnData::kString, empty_string_data_obj);
+    CHECK_MSTATUS(tAttr.setStorable(true));
+
+    // Channel Names; such as "R,G,B,A". Empty reads all channels.
+    m_channel_names_attr = tAttr.create(
+            "channelNames", "chnnms",
+            MFnData::kString, empty_string_data_obj);
+    CHECK_MSTATUS(tAttr.setStorable(true));
+
     // Start Frame
     uint32_t frame_default = 0;
     m_frame_start_attr = nAttr.create(
@@ -267,6 +314,8 @@ MStatus ImageReadNode::initialize() {
     // Add Attributes
     CHECK_MSTATUS(addAttribute(m_enable_attr));
     CHECK_MSTATUS(addAttribute(m_file_path_attr));
+    CHECK_MSTATUS(addAttribute(m_layer_name_attr));
+    CHECK_MSTATUS(addAttribute(m_channel_names_attr));
     CHECK_MSTATUS(addAttribute(m_frame_start_attr));
     CHECK_MSTATUS(addAttribute(m_frame_end_attr));
     CHECK_MSTATUS(addAttribute(m_frame_after_attr));
@@ -279,9 +328,13 @@ MStatus ImageReadNode::initialize() {
     CHECK_MSTATUS(attributeAffects(m_enable_attr, m_out_stream_attr));
     CHECK_MSTATUS(attributeAffects(m_frame_start_attr, m_out_stream_attr));
     CHECK_MSTATUS(attributeAffects(m_frame_end_attr, m_out_stream_attr));
+    CHECK_MSTATUS(attributeAffects(m_frame_before_attr, m_out_stream_attr));
+    CHECK_MSTATUS(attributeAffects(m_frame_after_attr, m_out_stream_attr));
     CHECK_MSTATUS(attributeAffects(m_disk_cache_enable_attr, m_out_stream_attr));
     CHECK_MSTATUS(attributeAffects(m_disk_cache_file_path_attr, m_out_stream_attr));
     CHECK_MSTATUS(attributeAffects(m_file_path_attr, m_out_stream_attr));
+    CHECK_MSTATUS(attributeAffects(m_layer_name_attr, m_out_stream_attr));
+    CHECK_MSTATUS(attributeAffects(m_channel_names_attr, m_out_stream_attr));
 
     return MS::kSuccess;
 }
@@ -53,7 +53,7 @@ public:
 
     virtual MStatus updateOcgNodes(
         MDataBlock &data,
-        std::shared_ptr<ocg::Graph> &shared_graph,
+        std::shared_ptr<SharedGraph> &shared_graph,
         std::vector<ocg::Node> input_ocg_nodes,
         ocg::Node &output_ocg_node);
 
@@ -67,6 +67,8 @@ public:
     static MObject m_frame_end_attr;
     static MObject m_frame_before_attr;
     static MObject m_frame_after_attr;
+    static MObject m_layer_name_attr;
+    static MObject m_channel_names_attr;
     static MObject m_disk_cache_enable_attr;
     static MObject m_disk_cache_file_path_attr;
 
@@ -77,7 +77,7 @@ MString ImageResampleNode::nodeName() {
 
 MStatus ImageResampleNode::updateOcgNodes(
         MDataBlock &data,
-        std::shared_ptr<ocg::Graph> &shared_graph,
+        std::shared_ptr<SharedGraph> &shared_graph,
         std::vector<ocg::Node> input_ocg_nodes,
         ocg::Node &output_ocg_node) {
     MStatus status = MS::kSuccess;
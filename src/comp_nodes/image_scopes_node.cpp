@@ -0,0 +1,426 @@
+/*
+ * Copyright (C) 2021 David Cattermole.
+ *
+ * This file is part of OpenCompGraphMaya.
+ *
+ * OpenCompGraphMaya is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * OpenCompGraphMaya is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OpenCompGraphMaya.  If not, see <https://www.gnu.org/licenses/>.
+ * ====================================================================
+ *
+ * Measure the histogram, waveform and channel statistics of an image
+ * stream.
+ *
+ * The input stream is passed through unchanged; the scopes are
+ * computed when one of the output scope attributes is requested.
+ */
+
+// Maya
+#include <maya/MPlug.h>
+#include <maya/MDataBlock.h>
+#include <maya/MDataHandle.h>
+#include <maya/MFnNumericAttribute.h>
+#include <maya/MFnTypedAttribute.h>
+#include <maya/MFnUnitAttribute.h>
+#include <maya/MFnNumericData.h>
+#include <maya/MFnDoubleArrayData.h>
+#include <maya/MFnIntArrayData.h>
+#include <maya/MDoubleArray.h>
+#include <maya/MIntArray.h>
+#include <maya/MString.h>
+#include <maya/MTime.h>
+#include <maya/MTypeId.h>
+#include <maya/MFnPluginData.h>
+#include <maya/MFnDependencyNode.h>
+#include <maya/MUuid.h>
+
+// STL
+#include <cstring>
+#include <cmath>
+#include <memory>
+
+// OCG
+#include "opencompgraph.h"
+
+// OCG Maya
+#include <opencompgraphmaya/node_type_ids.h>
+#include "logger.h"
+#include "graph_data.h"
+#include "graph_execute.h"
+#include "global_cache.h"
+#include "image_scopes.h"
+#include "node_utils.h"
+#include "attr_utils.h"
+
+#include "image_scopes_node.h"
+
+namespace ocg = open_comp_graph;
+
+namespace open_comp_graph_maya {
+
+MTypeId ImageScopesNode::m_id(OCGM_IMAGE_SCOPES_TYPE_ID);
+
+// Input Attributes
+MObject ImageScopesNode::m_in_stream_attr;
+MObject ImageScopesNode::m_enable_attr;
+MObject ImageScopesNode::m_time_attr;
+
+// Output Attributes
+MObject ImageScopesNode::m_out_stream_attr;
+MObject ImageScopesNode::m_out_num_channels_attr;
+MObject ImageScopesNode::m_out_minimum_attr;
+MObject ImageScopesNode::m_out_maximum_attr;
+MObject ImageScopesNode::m_out_mean_attr;
+MObject ImageScopesNode::m_out_clipped_low_attr;
+MObject ImageScopesNode::m_out_clipped_high_attr;
+MObject ImageScopesNode::m_out_histogram_bins_attr;
+MObject ImageScopesNode::m_out_histogram_attr;
+MObject ImageScopesNode::m_out_waveform_columns_attr;
+MObject ImageScopesNode::m_out_waveform_rows_attr;
+MObject ImageScopesNode::m_out_waveform_attr;
+
+namespace {
+
+MStatus set_output_double_array(
+        MDataBlock &data,
+        MObject &attr,
+        const MDoubleArray &values) {
+    MStatus status;
+    MFnDoubleArrayData fn_data;
+    MObject data_object = fn_data.create(values, &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+    MDataHandle handle = data.outputValue(attr, &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+    handle.setMObject(data_object);
+    return status;
+}
+
+MStatus set_output_int_array(
+        MDataBlock &data,
+        MObject &attr,
+        const MIntArray &values) {
+    MStatus status;
+    MFnIntArrayData fn_data;
+    MObject data_object = fn_data.create(values, &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+    MDataHandle handle = data.outputValue(attr, &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+    handle.setMObject(data_object);
+    return status;
+}
+
+MStatus set_output_int(MDataBlock &data, MObject &attr, const int32_t value) {
+    MStatus status;
+    MDataHandle handle = data.outputValue(attr, &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+    handle.setInt(value);
+    return status;
+}
+
+template <typename T>
+MDoubleArray to_double_array(const std::vector<T> &values) {
+    MDoubleArray array(static_cast<uint32_t>(values.size()), 0.0);
+    for (uint32_t i = 0; i < values.size(); ++i) {
+        array[i] = static_cast<double>(values[i]);
+    }
+    return array;
+}
+
+MIntArray to_int_array(const std::vector<uint32_t> &values) {
+    MIntArray array(static_cast<uint32_t>(values.size()), 0);
+    for (uint32_t i = 0; i < values.size(); ++i) {
+        array[i] = static_cast<int>(values[i]);
+    }
+    return array;
+}
+
+} // namespace
+
+ImageScopesNode::ImageScopesNode() {}
+
+ImageScopesNode::~ImageScopesNode() {}
+
+MString ImageScopesNode::nodeName() {
+    return MString(OCGM_IMAGE_SCOPES_TYPE_NAME);
+}
+
+// The scopes node does not change the stream, the input is the
+// output.
+MStatus ImageScopesNode::updateOcgNodes(
+        MDataBlock &/*data*/,
+        std::shared_ptr<SharedGraph> &/*shared_graph*/,
+        std::vector<ocg::Node> input_ocg_nodes,
+        ocg::Node &output_ocg_node) {
+    if (input_ocg_nodes.size() != 1) {
+        return MS::kFailure;
+    }
+    output_ocg_node = input_ocg_nodes[0];
+    return MS::kSuccess;
+}
+
+MStatus ImageScopesNode::computeScopes(MDataBlock &data) {
+    MStatus status = MS::kSuccess;
+    auto log = log::get_logger();
+
+    MDataHandle in_stream_handle = data.inputValue(m_in_stream_attr, &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+    auto input_ocg_node = ocg::Node(ocg::NodeType::kNull, 0);
+    GraphData *input_stream_data =
+        static_cast<GraphData *>(in_stream_handle.asPluginData());
+    if (input_stream_data != nullptr) {
+        input_ocg_node = input_stream_data->get_node();
+    }
+
+    bool enable = utils::get_attr_value_bool(data, m_enable_attr);
+    MTime time = data.inputValue(m_time_attr, &status).asTime();
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+    double execute_frame = time.asUnits(MTime::uiUnit());
+
+    // The scopes of the same stream are shared with other scopes
+    // nodes and image planes, so when the stream has already been
+    // computed this only copies the cached values.
+    std::shared_ptr<const scopes::ImageScopes> image_scopes;
+    if (enable && (input_ocg_node.get_id() != 0)) {
+        auto shared_graph = get_shared_graph();
+        auto shared_cache = cache::get_shared_cache();
+        std::shared_ptr<ocg::StreamData> stream_data;
+        auto exec_status = graph::execute_ocg_graph_stream(
+            input_ocg_node,
+            execute_frame,
+            shared_graph,
+            shared_cache,
+            stream_data);
+        if ((exec_status == ocg::ExecuteStatus::kSuccess) && stream_data) {
+            image_scopes = scopes::get_image_scopes(*stream_data);
+        } else {
+            log->warn(
+                "ocgImageScopes: Failed to execute graph: frame={}",
+                execute_frame);
+        }
+    }
+
+    // Disabled nodes, or streams without pixels, output empty
+    // scopes.
+    auto empty_scopes = std::make_shared<scopes::ImageScopes>();
+    const scopes::ImageScopes &values =
+        image_scopes ? *image_scopes : *empty_scopes;
+    const bool has_scopes = static_cast<bool>(image_scopes);
+
+    CHECK_MSTATUS(set_output_int(
+        data, m_out_num_channels_attr, values.num_channels));
+    CHECK_MSTATUS(set_output_double_array(
+        data, m_out_minimum_attr, to_double_array(values.minimum)));
+    CHECK_MSTATUS(set_output_double_array(
+        data, m_out_maximum_attr, to_double_array(values.maximum)));
+    CHECK_MSTATUS(set_output_double_array(
+        data, m_out_mean_attr, to_double_array(values.mean)));
+    CHECK_MSTATUS(set_output_double_array(
+        data, m_out_clipped_low_attr, to_double_array(values.clipped_low)));
+    CHECK_MSTATUS(set_output_double_array(
+        data, m_out_clipped_high_attr, to_double_array(values.clipped_high)));
+    CHECK_MSTATUS(set_output_int(
+        data, m_out_histogram_bins_attr,
+        has_scopes ? static_cast<int32_t>(scopes::kHistogramBins) : 0));
+    CHECK_MSTATUS(set_output_int_array(
+        data, m_out_histogram_attr, to_int_array(values.histogram)));
+    CHECK_MSTATUS(set_output_int(
+        data, m_out_waveform_columns_attr,
+        has_scopes ? static_cast<int32_t>(scopes::kWaveformColumns) : 0));
+    CHECK_MSTATUS(set_output_int(
+        data, m_out_waveform_rows_attr,
+        has_scopes ? static_cast<int32_t>(scopes::kWaveformRows) : 0));
+    CHECK_MSTATUS(set_output_int_array(
+        data, m_out_waveform_attr, to_int_array(values.waveform)));
+
+    // All the scopes are computed together, so every output is
+    // marked clean, not just the plug Maya asked for; otherwise
+    // reading the other outputs computes the scopes again.
+    MObject output_attrs[] = {
+        m_out_num_channels_attr,
+        m_out_minimum_attr,
+        m_out_maximum_attr,
+        m_out_mean_attr,
+        m_out_clipped_low_attr,
+        m_out_clipped_high_attr,
+        m_out_histogram_bins_attr,
+        m_out_histogram_attr,
+        m_out_waveform_columns_attr,
+        m_out_waveform_rows_attr,
+        m_out_waveform_attr,
+    };
+    for (auto &output_attr : output_attrs) {
+        CHECK_MSTATUS(data.setClean(output_attr));
+    }
+    return status;
+}
+
+MStatus ImageScopesNode::compute(const MPlug &plug, MDataBlock &data) {
+    if (plug == m_out_stream_attr) {
+        MObjectArray in_attr_array;
+        in_attr_array.append(m_in_stream_attr);
+        return computeOcgStream(
+            plug, data,
+            in_attr_array,
+            m_out_stream_attr);
+    }
+
+    const MUuid empty_uuid = MUuid();
+    if (m_node_uuid == empty_uuid) {
+        return MS::kUnknownParameter;
+    }
+
+    if ((plug == m_out_num_channels_attr)
+        || (plug == m_out_minimum_attr)
+        || (plug == m_out_maximum_attr)
+        || (plug == m_out_mean_attr)
+        || (plug == m_out_clipped_low_attr)
+        || (plug == m_out_clipped_high_attr)
+        || (plug == m_out_histogram_bins_attr)
+        || (plug == m_out_histogram_attr)
+        || (plug == m_out_waveform_columns_attr)
+        || (plug == m_out_waveform_rows_attr)
+        || (plug == m_out_waveform_attr)) {
+        return computeScopes(data);
+    }
+    return MS::kUnknownParameter;
+}
+
+void *ImageScopesNode::creator() {
+    return (new ImageScopesNode());
+}
+
+MStatus ImageScopesNode::initialize() {
+    MStatus status;
+    MFnNumericAttribute nAttr;
+    MFnTypedAttribute tAttr;
+    MFnUnitAttribute uAttr;
+
+    // Create Common Attributes
+    CHECK_MSTATUS(utils::create_enable_attribute(m_enable_attr));
+    CHECK_MSTATUS(utils::create_input_stream_attribute(m_in_stream_attr));
+    CHECK_MSTATUS(utils::create_output_stream_attribute(m_out_stream_attr));
+
+    // Time
+    m_time_attr = uAttr.create("time", "tm", MFnUnitAttribute::kTime, 0.0);
+    CHECK_MSTATUS(uAttr.setStorable(true));
+
+    // Output Channel Statistics
+    m_out_num_channels_attr = nAttr.create(
+        "outNumChannels", "onchn",
+        MFnNumericData::kInt, 0);
+    CHECK_MSTATUS(nAttr.setStorable(false));
+    CHECK_MSTATUS(nAttr.setWritable(false));
+
+    m_out_minimum_attr = tAttr.create(
+        "outMinimum", "omin",
+        MFnData::kDoubleArray);
+    CHECK_MSTATUS(tAttr.setStorable(false));
+    CHECK_MSTATUS(tAttr.setWritable(false));
+
+    m_out_maximum_attr = tAttr.create(
+        "outMaximum", "omax",
+        MFnData::kDoubleArray);
+    CHECK_MSTATUS(tAttr.setStorable(false));
+    CHECK_MSTATUS(tAttr.setWritable(false));
+
+    m_out_mean_attr = tAttr.create(
+        "outMean", "omean",
+        MFnData::kDoubleArray);
+    CHECK_MSTATUS(tAttr.setStorable(false));
+    CHECK_MSTATUS(tAttr.setWritable(false));
+
+    m_out_clipped_low_attr = tAttr.create(
+        "outClippedLow", "oclplw",
+        MFnData::kDoubleArray);
+    CHECK_MSTATUS(tAttr.setStorable(false));
+    CHECK_MSTATUS(tAttr.setWritable(false));
+
+    m_out_clipped_high_attr = tAttr.create(
+        "outClippedHigh", "oclphi",
+        MFnData::kDoubleArray);
+    CHECK_MSTATUS(tAttr.setStorable(false));
+    CHECK_MSTATUS(tAttr.setWritable(false));
+
+    // Output Histogram
+    m_out_histogram_bins_attr = nAttr.create(
+        "outHistogramBins", "ohstbn",
+        MFnNumericData::kInt, 0);
+    CHECK_MSTATUS(nAttr.setStorable(false));
+    CHECK_MSTATUS(nAttr.setWritable(false));
+
+    m_out_histogram_attr = tAttr.create(
+        "outHistogram", "ohst",
+        MFnData::kIntArray);
+    CHECK_MSTATUS(tAttr.setStorable(false));
+    CHECK_MSTATUS(tAttr.setWritable(false));
+
+    // Output Waveform
+    m_out_waveform_columns_attr = nAttr.create(
+        "outWaveformColumns", "owfmcl",
+        MFnNumericData::kInt, 0);
+    CHECK_MSTATUS(nAttr.setStorable(false));
+    CHECK_MSTATUS(nAttr.setWritable(false));
+
+    m_out_waveform_rows_attr = nAttr.create(
+        "outWaveformRows", "owfmrw",
+        MFnNumericData::kInt, 0);
+    CHECK_MSTATUS(nAttr.setStorable(false));
+    CHECK_MSTATUS(nAttr.setWritable(false));
+
+    m_out_waveform_attr = tAttr.create(
+        "outWaveform", "owfm",
+        MFnData::kIntArray);
+    CHECK_MSTATUS(tAttr.setStorable(false));
+    CHECK_MSTATUS(tAttr.setWritable(false));
+
+    // Add Attributes
+    CHECK_MSTATUS(addAttribute(m_enable_attr));
+    CHECK_MSTATUS(addAttribute(m_time_attr));
+    CHECK_MSTATUS(addAttribute(m_in_stream_attr));
+    CHECK_MSTATUS(addAttribute(m_out_stream_attr));
+    CHECK_MSTATUS(addAttribute(m_out_num_channels_attr));
+    CHECK_MSTATUS(addAttribute(m_out_minimum_attr));
+    CHECK_MSTATUS(addAttribute(m_out_maximum_attr));
+    CHECK_MSTATUS(addAttribute(m_out_mean_attr));
+    CHECK_MSTATUS(addAttribute(m_out_clipped_low_attr));
+    CHECK_MSTATUS(addAttribute(m_out_clipped_high_attr));
+    CHECK_MSTATUS(addAttribute(m_out_histogram_bins_attr));
+    CHECK_MSTATUS(addAttribute(m_out_histogram_attr));
+    CHECK_MSTATUS(addAttribute(m_out_waveform_columns_attr));
+    CHECK_MSTATUS(addAttribute(m_out_waveform_rows_attr));
+    CHECK_MSTATUS(addAttribute(m_out_waveform_attr));
+
+    // Attribute Affects
+    CHECK_MSTATUS(attributeAffects(m_in_stream_attr, m_out_stream_attr));
+
+    MObjectArray scopes_attr_array;
+    scopes_attr_array.append(m_out_num_channels_attr);
+    scopes_attr_array.append(m_out_minimum_attr);
+    scopes_attr_array.append(m_out_maximum_attr);
+    scopes_attr_array.append(m_out_mean_attr);
+    scopes_attr_array.append(m_out_clipped_low_attr);
+    scopes_attr_array.append(m_out_clipped_high_attr);
+    scopes_attr_array.append(m_out_histogram_bins_attr);
+    scopes_attr_array.append(m_out_histogram_attr);
+    scopes_attr_array.append(m_out_waveform_columns_attr);
+    scopes_attr_array.append(m_out_waveform_rows_attr);
+    scopes_attr_array.append(m_out_waveform_attr);
+    for (uint32_t i = 0; i < scopes_attr_array.length(); ++i) {
+        CHECK_MSTATUS(attributeAffects(m_enable_attr, scopes_attr_array[i]));
+        CHECK_MSTATUS(attributeAffects(m_time_attr, scopes_attr_array[i]));
+        CHECK_MSTATUS(attributeAffects(m_in_stream_attr, scopes_attr_array[i]));
+    }
+
+    return MS::kSuccess;
+}
+
+} // namespace open_comp_graph_maya
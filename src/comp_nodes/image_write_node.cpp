@@ -39,6 +39,7 @@
 // STL
 #include <cstring>
 #include <cmath>
+#include <string>
 
 // OCG
 #include "opencompgraph.h"
@@ -50,6 +51,7 @@
 #include "image_write_node.h"
 #include "node_utils.h"
 #include "attr_utils.h"
+#include "cache_container.h"
 
 namespace ocg = open_comp_graph;
 
@@ -113,7 +115,7 @@ MString ImageWriteNode::nodeName() {
 
 MStatus ImageWriteNode::updateOcgNodes(
         MDataBlock &data,
-        std::shared_ptr<ocg::Graph> &shared_graph,
+        std::shared_ptr<SharedGraph> &shared_graph,
         std::vector<ocg::Node> input_ocg_nodes,
         ocg::Node &output_ocg_node) {
     MStatus status = MS::kSuccess;
@@ -151,10 +153,13 @@ MStatus ImageWriteNode::updateOcgNodes(
         shared_graph->set_node_attr_i32(
             m_ocg_node, "enable", static_cast<int32_t>(enable));
 
-        // File Path Attribute
+        // File Path Attribute; the frames of cache containers are
+        // written to local files, then packed by 'ocgExecute'.
         MString file_path = utils::get_attr_value_string(data, m_file_path_attr);
+        const std::string resolved_file_path =
+            cache_container::resolve_file_path(file_path.asChar());
         shared_graph->set_node_attr_str(
-            m_ocg_node, "file_path", file_path.asChar());
+            m_ocg_node, "file_path", resolved_file_path.c_str());
 
         // Crop-on-Write Attribute
         int16_t crop_on_write = utils::get_attr_value_short(
@@ -189,14 +194,14 @@ MStatus ImageWriteNode::updateOcgNodes(
             data, m_png_compression_level_attr);
         shared_graph->set_node_attr_i32(
             m_ocg_node, "png_compression_level",
-            exr_dwa_compression_level);
+            png_compression_level);
 
         // JPEG Compression Level Attribute
         int32_t jpeg_compression_level = utils::get_attr_value_int(
             data, m_jpeg_compression_level_attr);
         shared_graph->set_node_attr_i32(
             m_ocg_node, "jpeg_compression_level",
-            exr_dwa_compression_level);
+            jpeg_compression_level);
 
         // JPEG Sub-Sampling Attribute
         int16_t jpeg_subsampling = utils::get_attr_value_short(
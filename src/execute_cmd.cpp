@@ -27,12 +27,18 @@
  *   ocgExecute
  *       -frameStart 1001
  *       -frameEnd 1101
+ *       -writeQueueDepth 2
  *       -dryRun false
  *       "myNodeName1";
  *
  */
 
 // STL
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <string>
 #include <vector>
 #include <cmath>
 #include <cassert>
@@ -63,10 +69,16 @@
 
 // OCG Maya
 #include <opencompgraphmaya/node_type_ids.h>
+#include <comp_nodes/image_write_node.h>
+#include "cache_container.h"
 #include "logger.h"
 #include "global_cache.h"
 #include "graph_data.h"
 #include "graph_execute.h"
+#include "graph_write_queue.h"
+#include "io_pool.h"
+#include "region_of_interest.h"
+#include "sequence_index.h"
 #include "node_utils.h"
 
 #include "execute_cmd.h"
@@ -87,6 +99,164 @@ namespace open_comp_graph_maya {
 #define FRAME_END_FLAG          "-fe"
 #define FRAME_END_FLAG_LONG     "-frameEnd"
 
+// The number of frames executed behind the command; zero executes
+// each frame before the next frame starts.
+#define WRITE_QUEUE_DEPTH_FLAG       "-wqd"
+#define WRITE_QUEUE_DEPTH_FLAG_LONG  "-writeQueueDepth"
+#define WRITE_QUEUE_DEPTH_DEFAULT    2
+
+
+namespace {
+
+// Take the results of the frames finished by 'write_queue', returning
+// true if any frame (taken now or before) failed.
+bool take_write_results(
+        ocgm_graph::WriteQueue &write_queue,
+        std::vector<ocgm_graph::WriteResult> &results) {
+    auto new_results = write_queue.take_results();
+    results.insert(results.end(), new_results.begin(), new_results.end());
+    for (const auto &result : results) {
+        if (result.status != ocg::ExecuteStatus::kSuccess) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint64_t get_file_size(const std::string &file_path) {
+    std::ifstream file(file_path, std::ios::in | std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        return 0;
+    }
+    const std::streamoff size = file.tellg();
+    return size > 0 ? static_cast<uint64_t>(size) : 0;
+}
+
+// Pack the frames written by the node of 'stream_plug' into its cache
+// container with 'writer', when its file path names one. Frames are
+// packed as they finish, from the result 'packed_count' on, while the
+// write queue writes the next frames. The local frame files are
+// removed once packed, and their sizes kept in 'packed_byte_counts'.
+// Returns true if any frame failed to pack.
+bool pack_write_results(
+        const MPlug &stream_plug,
+        const std::vector<ocgm_graph::WriteResult> &results,
+        size_t &packed_count,
+        cache_container::Writer &writer,
+        std::map<int32_t, uint64_t> &packed_byte_counts) {
+    MObject node = stream_plug.node();
+    MFnDependencyNode dep(node);
+    if (dep.typeId() != ImageWriteNode::m_id) {
+        packed_count = results.size();
+        return false;
+    }
+    const std::string container_path =
+        MPlug(node, ImageWriteNode::m_file_path_attr).asString().asChar();
+    if (!cache_container::is_container_path(container_path)) {
+        packed_count = results.size();
+        return false;
+    }
+
+    bool failed = false;
+    const std::string file_path_pattern =
+        cache_container::resolve_file_path(container_path);
+    for (; packed_count < results.size(); ++packed_count) {
+        const auto &result = results[packed_count];
+        if (result.status != ocg::ExecuteStatus::kSuccess) {
+            continue;
+        }
+        // The container stays locked until all frames are packed.
+        if (!writer.is_open() && !writer.open(container_path)) {
+            failed = true;
+            continue;
+        }
+        const int32_t frame = static_cast<int32_t>(std::lround(result.frame));
+        const std::string file_path =
+            sequence::expand_frame_path(file_path_pattern, frame);
+        packed_byte_counts[frame] = get_file_size(file_path);
+        if (!writer.append_frame(frame, file_path)) {
+            failed = true;
+            continue;
+        }
+        std::remove(file_path.c_str());
+    }
+    return failed;
+}
+
+// Log the failed frames, and the time taken to execute the frames of
+// the node of 'stream_plug'. The throughput of write nodes, such as
+// to compare compression modes, is measured from the sizes of the
+// files written; 'packed_byte_counts' for frames packed into cache
+// containers. Returns true if any frame failed.
+bool log_write_results(
+        const MPlug &stream_plug,
+        const std::vector<ocgm_graph::WriteResult> &results,
+        const std::map<int32_t, uint64_t> &packed_byte_counts) {
+    auto log = log::get_logger();
+
+    MObject node = stream_plug.node();
+    MFnDependencyNode dep(node);
+    const bool is_write_node = dep.typeId() == ImageWriteNode::m_id;
+    std::string file_path_pattern;
+    if (is_write_node) {
+        file_path_pattern = cache_container::resolve_file_path(
+            MPlug(node, ImageWriteNode::m_file_path_attr).asString().asChar());
+    }
+
+    bool failed = false;
+    uint32_t frame_count = 0;
+    uint64_t byte_count = 0;
+    double seconds = 0.0;
+    for (const auto &result : results) {
+        if (result.status != ocg::ExecuteStatus::kSuccess) {
+            failed = true;
+            log->error(
+                "{}: Failed to execute Node {} on Frame {}, status={}.",
+                OCGM_EXECUTE_CMD_NAME,
+                result.node_id,
+                result.frame,
+                static_cast<uint64_t>(result.status));
+            continue;
+        }
+
+        uint64_t frame_byte_count = 0;
+        if (is_write_node) {
+            const int32_t frame = static_cast<int32_t>(std::lround(result.frame));
+            auto packed_it = packed_byte_counts.find(frame);
+            frame_byte_count = (packed_it != packed_byte_counts.end())
+                ? packed_it->second
+                : get_file_size(
+                    sequence::expand_frame_path(file_path_pattern, frame));
+        }
+        log->debug(
+            "{}: Executed Node {} on Frame {} in {} seconds, wrote {} bytes.",
+            OCGM_EXECUTE_CMD_NAME,
+            result.node_id,
+            result.frame,
+            result.seconds,
+            frame_byte_count);
+        frame_count += 1;
+        byte_count += frame_byte_count;
+        seconds += result.seconds;
+    }
+
+    if ((frame_count > 0) && (seconds > 0.0)) {
+        const double megabytes = static_cast<double>(byte_count) / (1024.0 * 1024.0);
+        log->info(
+            "{}: Executed {} frames of {} in {} seconds; "
+            "{} frames/second, wrote {} MB at {} MB/second.",
+            OCGM_EXECUTE_CMD_NAME,
+            frame_count,
+            dep.name().asChar(),
+            seconds,
+            static_cast<double>(frame_count) / seconds,
+            megabytes,
+            megabytes / seconds);
+    }
+    return failed;
+}
+
+} // namespace
 
 ExecuteCmd::~ExecuteCmd() {}
 
@@ -121,6 +291,8 @@ MSyntax ExecuteCmd::newSyntax() {
     syntax.addFlag(DRY_RUN_FLAG, DRY_RUN_FLAG_LONG, MSyntax::kBoolean);
     syntax.addFlag(FRAME_START_FLAG, FRAME_START_FLAG_LONG, MSyntax::kLong);
     syntax.addFlag(FRAME_END_FLAG, FRAME_END_FLAG_LONG, MSyntax::kLong);
+    syntax.addFlag(
+        WRITE_QUEUE_DEPTH_FLAG, WRITE_QUEUE_DEPTH_FLAG_LONG, MSyntax::kLong);
     return syntax;
 }
 
@@ -175,6 +347,17 @@ MStatus ExecuteCmd::parseArgs(const MArgList &args) {
         CHECK_MSTATUS_AND_RETURN_IT(status);
     }
 
+    // Write Queue Depth flag
+    m_write_queue_depth = WRITE_QUEUE_DEPTH_DEFAULT;
+    bool writeQueueDepthFlagIsSet = argData.isFlagSet(
+        WRITE_QUEUE_DEPTH_FLAG, &status);
+    if (writeQueueDepthFlagIsSet == true) {
+        int depth = 0;
+        status = argData.getFlagArgument(WRITE_QUEUE_DEPTH_FLAG, 0, depth);
+        CHECK_MSTATUS_AND_RETURN_IT(status);
+        m_write_queue_depth = static_cast<uint32_t>(std::max(0, depth));
+    }
+
     // Check frame range is valid.
     if (m_frame_end < m_frame_start) {
         log->error(
@@ -217,6 +400,7 @@ MStatus ExecuteCmd::doIt(const MArgList &args) {
     // Get OCG Nodes to be executed.
     auto shared_graph = get_shared_graph();
     std::vector<ocg::Node> ocg_nodes;
+    std::vector<MPlug> stream_plugs;
     for (auto i = 0; i < m_nodes.length(); ++i) {
         MPlug stream_plug;
 
@@ -294,6 +478,7 @@ MStatus ExecuteCmd::doIt(const MArgList &args) {
         }
 
         ocg_nodes.push_back(stream_node);
+        stream_plugs.push_back(stream_plug);
     }
 
     if (ocg_nodes.size() == 0) {
@@ -324,65 +509,115 @@ MStatus ExecuteCmd::doIt(const MArgList &args) {
     auto execute_count = 0;
     computation.setProgressRange(0, num_node_frames);
 
-    auto shared_cache = ocgm_cache::get_shared_cache();
-    for (auto ocg_node : ocg_nodes) {
+    uint64_t start_bytes_read = 0;
+    uint64_t start_bytes_skipped = 0;
+    io_pool::read_statistics(start_bytes_read, start_bytes_skipped);
+
+    // Each frame is computed, encoded and written on the write
+    // queue's thread, while the next frames are prepared here.
+    ocgm_graph::WriteQueue write_queue(m_write_queue_depth);
+    bool failed = false;
+    for (size_t i = 0; (i < ocg_nodes.size()) && !failed; ++i) {
+        auto ocg_node = ocg_nodes[i];
+        auto stream_plug = stream_plugs[i];
+        std::vector<ocgm_graph::WriteResult> results;
+        size_t packed_count = 0;
+        cache_container::Writer container_writer;
+        std::map<int32_t, uint64_t> packed_byte_counts;
+        bool node_failed = false;
         for (auto frame = m_frame_start; frame <= m_frame_end; ++frame) {
             double execute_frame = static_cast<double>(frame);
             log->debug("ocgExecute: execute_frame={}", execute_frame);
+
+            // The files of this frame are read (within the I/O
+            // bandwidth limit) before executing, and the files of
+            // the next frames are read while this frame executes.
+            //
+            // The display window is not known before executing, so
+            // transforms do not narrow the regions read.
+            const ocg::BBox2Di display_window = ocg::BBox2Di();
+            std::vector<int32_t> frames;
+            frames.push_back(static_cast<int32_t>(frame));
+            std::vector<std::string> frame_file_paths;
+            std::vector<roi::Region> frame_regions;
+            std::vector<io_pool::ChannelSelection> frame_selections;
+            CHECK_MSTATUS(io_pool::find_upstream_file_paths(
+                stream_plug, frames, display_window,
+                frame_file_paths, frame_regions, frame_selections));
+            io_pool::request_frame_extracts(frame_file_paths);
+            io_pool::request_reads(
+                frame_file_paths, frame_regions, frame_selections);
+
+            frames.clear();
+            const uint32_t read_ahead_end = std::min(
+                m_frame_end, frame + io_pool::read_ahead_frames());
+            for (auto ahead = frame + 1; ahead <= read_ahead_end; ++ahead) {
+                frames.push_back(static_cast<int32_t>(ahead));
+            }
+            std::vector<std::string> ahead_file_paths;
+            std::vector<roi::Region> ahead_regions;
+            std::vector<io_pool::ChannelSelection> ahead_selections;
+            CHECK_MSTATUS(io_pool::find_upstream_file_paths(
+                stream_plug, frames, display_window,
+                ahead_file_paths, ahead_regions, ahead_selections));
+            io_pool::request_reads(
+                ahead_file_paths, ahead_regions, ahead_selections);
+            io_pool::wait_for_reads(frame_file_paths);
             log->info(
                 "{}: Executing Node {} on Frame {}.",
                 OCGM_EXECUTE_CMD_NAME,
                 ocg_node.get_id(),
                 execute_frame);
 
+            // The graph is copied for the frame when it is queued, so
+            // the frame can be changed while earlier frames execute.
+            //
             // TODO: Add a callback that can be run by Maya to
             // periodically check the status of the executing.
             //
             MGlobal::viewFrame(execute_frame);
-            auto exec_status = ocgm_graph::execute_ocg_graph(
-                ocg_node,
-                execute_frame,
-                shared_graph,
-                shared_cache);
-
-            if (exec_status != ocg::ExecuteStatus::kSuccess) {
-                log->warn("Execute failed!");
-            } else {
-                log->info("Execute finished with success.");
-                // TODO: Print statistics to the log.
-
-                // // std::cout << "Graph as string:\n"
-                // //           << graph.data_debug_string();
-                // // exec_status == ocg::ExecuteStatus::kSuccess
-
-                // auto stream_data = graph.output_stream();
-                // auto state_id = stream_data.state_id();
-                // auto hash = stream_data.hash();
-                // // std::cout << "state_id=" << state_id << '\n';
-                // // std::cout << "hash=" << hash << '\n';
-
-                // auto pixel_buffer = stream_data1.pixel_buffer();
-                // std::cout << "pixel_buffer"
-                //           << " data=" << &pixel_buffer
-                //           << " size=" << pixel_buffer.size() << '\n';
-
-                // auto width = stream_data.pixel_width();
-                // auto height = stream_data.pixel_height();
-                // auto num_channels = stream_data.pixel_num_channels();
-                // std::cout << "width=" << width << '\n';
-                // std::cout << "height=" << height << '\n';
-                // std::cout << "num_channels="
-                //     << static_cast<uint32_t>(num_channels) << '\n';
-            }
-            if (computation.isInterruptRequested()) {
+            write_queue.submit(ocg_node, execute_frame);
+
+            // Frames are not written after a failed frame.
+            node_failed = take_write_results(write_queue, results);
+            node_failed = pack_write_results(
+                stream_plug, results, packed_count,
+                container_writer, packed_byte_counts) || node_failed;
+            if (node_failed || computation.isInterruptRequested()) {
                 break;
             }
             computation.setProgress(execute_count);
             execute_count += 1;
         }
+
+        // All frames of the range are written before the next node
+        // (or the command) finishes.
+        write_queue.flush();
+        take_write_results(write_queue, results);
+        failed = pack_write_results(
+            stream_plug, results, packed_count,
+            container_writer, packed_byte_counts) || failed;
+        failed = !container_writer.close() || failed;
+        failed = log_write_results(
+            stream_plug, results, packed_byte_counts) || failed;
     }
     computation.endComputation();
 
+    // Files still being read ahead are counted by the next command.
+    uint64_t end_bytes_read = 0;
+    uint64_t end_bytes_skipped = 0;
+    io_pool::read_statistics(end_bytes_read, end_bytes_skipped);
+    log->info(
+        "{}: Read {} bytes ahead of the graph, skipped {} bytes "
+        "outside the regions, layers and channels used.",
+        OCGM_EXECUTE_CMD_NAME,
+        end_bytes_read - start_bytes_read,
+        end_bytes_skipped - start_bytes_skipped);
+
+    if (failed) {
+        status = MS::kFailure;
+        status.perror("Failed to execute nodes.");
+    }
     return status;
 }
 
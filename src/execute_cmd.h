@@ -56,7 +56,8 @@ public:
             : m_nodes()
             , m_dry_run(false)
             , m_frame_start(1)
-            , m_frame_end(1) {};
+            , m_frame_end(1)
+            , m_write_queue_depth(0) {};
 
     virtual ~ExecuteCmd();
 
@@ -78,6 +79,7 @@ private:
     bool m_dry_run;
     uint32_t m_frame_start;
     uint32_t m_frame_end;
+    uint32_t m_write_queue_depth;
 };
 
 } // namespace open_comp_graph_maya
@@ -24,7 +24,17 @@
 #include <maya/MHWGeometry.h>
 
 // STL
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <utility>
+#include <vector>
 
 // OCG
 #include "opencompgraph.h"
@@ -38,14 +48,120 @@ namespace ocg = open_comp_graph;
 namespace open_comp_graph_maya {
 namespace geometry_buffer {
 
-// Vertex Positions.
-void generate_vertex_positions(
-        MHWRender::MVertexBuffer *vertex_buffer,
+namespace {
+
+typedef std::pair<size_t, size_t> DivisionsKey;
+
+struct CanvasGeometryCache {
+    std::mutex mutex;
+    std::map<DivisionsKey, std::weak_ptr<const CanvasGeometry>> geometry;
+};
+
+CanvasGeometryCache &get_canvas_geometry_cache() {
+    static CanvasGeometryCache cache;
+    return cache;
+}
+
+// Shared GPU buffers, by the kind of buffer and the divisions.
+template<typename BufferType>
+struct SharedBufferCache {
+    std::mutex mutex;
+    std::map<std::tuple<uint8_t, size_t, size_t>,
+             std::weak_ptr<BufferType>> buffers;
+};
+
+template<typename BufferType, typename BuildFunc>
+std::shared_ptr<BufferType> get_shared_buffer(
+        SharedBufferCache<BufferType> &cache,
+        const uint8_t kind,
         const size_t divisions_x,
         const size_t divisions_y,
-        ocg::StreamData &stream_data) {
+        BuildFunc build_func) {
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    auto key = std::make_tuple(kind, divisions_x, divisions_y);
+    auto search = cache.buffers.find(key);
+    if (search != cache.buffers.end()) {
+        auto buffer = search->second.lock();
+        if (buffer) {
+            return buffer;
+        }
+    }
+
+    // Forget the buffers that are no longer used by anyone.
+    for (auto it = cache.buffers.begin(); it != cache.buffers.end();) {
+        if (it->second.expired()) {
+            it = cache.buffers.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    auto buffer = std::shared_ptr<BufferType>(
+        build_func(divisions_x, divisions_y));
+    cache.buffers[key] = buffer;
+    return buffer;
+}
+
+SharedBufferCache<MHWRender::MVertexBuffer> &get_shared_vertex_buffers() {
+    static SharedBufferCache<MHWRender::MVertexBuffer> cache;
+    return cache;
+}
+
+SharedBufferCache<MHWRender::MIndexBuffer> &get_shared_index_buffers() {
+    static SharedBufferCache<MHWRender::MIndexBuffer> cache;
+    return cache;
+}
+
+const uint8_t buffer_kind_uvs = 0;
+const uint8_t buffer_kind_triangles = 1;
+const uint8_t buffer_kind_border_lines = 2;
+const uint8_t buffer_kind_wire_lines = 3;
+
+// Copy the cached values into the (GPU) buffer.
+template<typename BufferType, typename ValueType>
+void copy_into_buffer(
+        BufferType *buffer,
+        const std::vector<ValueType> &values,
+        const size_t count) {
+    bool write_only = true;  // We don't need the current buffer values
+    ValueType *data = static_cast<ValueType *>(
+        buffer->acquire(count, write_only));
+    if (data) {
+        std::memcpy(data, values.data(), values.size() * sizeof(ValueType));
+        buffer->commit(data);
+    }
+}
+
+} // namespace
+
+
+std::shared_ptr<const CanvasGeometry> get_canvas_geometry(
+        const size_t divisions_x,
+        const size_t divisions_y) {
+    auto &cache = get_canvas_geometry_cache();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+
+    auto key = DivisionsKey(divisions_x, divisions_y);
+    auto search = cache.geometry.find(key);
+    if (search != cache.geometry.end()) {
+        auto geometry = search->second.lock();
+        if (geometry) {
+            return geometry;
+        }
+    }
+
+    for (auto it = cache.geometry.begin(); it != cache.geometry.end();) {
+        if (it->second.expired()) {
+            it = cache.geometry.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
     auto log = log::get_logger();
+    log->debug("Building canvas geometry: {}x{}", divisions_x, divisions_y);
 
+    // All buffers are filled from one geometry plane.
     auto center_x = -0.5f;
     auto center_y = -0.5f;
     auto size_x = 1.0f;
@@ -55,14 +171,512 @@ void generate_vertex_positions(
         size_x, size_y,
         divisions_x, divisions_y);
 
-    auto pos_buffer_size = geom->calc_buffer_size_vertex_positions();
-    auto pos_count = geom->calc_count_vertex_positions();
+    auto geometry = std::make_shared<CanvasGeometry>();
+    geometry->divisions_x = divisions_x;
+    geometry->divisions_y = divisions_y;
+
+    geometry->position_count = geom->calc_count_vertex_positions();
+    geometry->positions.resize(geom->calc_buffer_size_vertex_positions());
+    rust::Slice<float> pos_slice{
+        geometry->positions.data(), geometry->positions.size()};
+    geom->fill_buffer_vertex_positions(pos_slice);
+
+    geometry->uv_count = geom->calc_count_vertex_uvs();
+    geometry->uvs.resize(geom->calc_buffer_size_vertex_uvs());
+    rust::Slice<float> uv_slice{geometry->uvs.data(), geometry->uvs.size()};
+    geom->fill_buffer_vertex_uvs(uv_slice);
+
+    geometry->index_triangles.resize(geom->calc_buffer_size_index_tris());
+    rust::Slice<uint32_t> tri_slice{
+        geometry->index_triangles.data(), geometry->index_triangles.size()};
+    geom->fill_buffer_index_tris(tri_slice);
+
+    geometry->index_border_lines.resize(
+        geom->calc_buffer_size_index_border_lines());
+    rust::Slice<uint32_t> border_slice{
+        geometry->index_border_lines.data(),
+        geometry->index_border_lines.size()};
+    geom->fill_buffer_index_border_lines(border_slice);
+
+    geometry->index_wire_lines.resize(
+        geom->calc_buffer_size_index_wire_lines());
+    rust::Slice<uint32_t> wire_slice{
+        geometry->index_wire_lines.data(), geometry->index_wire_lines.size()};
+    geom->fill_buffer_index_wire_lines(wire_slice);
+
+    std::shared_ptr<const CanvasGeometry> const_geometry = geometry;
+    cache.geometry[key] = const_geometry;
+    return const_geometry;
+}
+
+
+namespace {
+
+// The corners of the canvas, taken from the uniform geometry so the
+// adaptive geometry covers exactly the same area and UVs.
+struct CanvasFrame {
+    float pos_min_x;
+    float pos_min_y;
+    float pos_max_x;
+    float pos_max_y;
+    float pos_z;
+    float uv_min_u;
+    float uv_min_v;
+    float uv_max_u;
+    float uv_max_v;
+    bool flip_winding;
+};
+
+CanvasFrame get_canvas_frame(const CanvasGeometry &geometry) {
+    CanvasFrame frame = {0.0f, 0.0f, 1.0f, 1.0f, 0.0f,
+                         0.0f, 0.0f, 1.0f, 1.0f, false};
+    if ((geometry.position_count == 0)
+        || (geometry.position_count != geometry.uv_count)) {
+        return frame;
+    }
+    const size_t pos_stride = geometry.positions.size() / geometry.position_count;
+    const size_t uv_stride = geometry.uvs.size() / geometry.uv_count;
+
+    size_t min_index = 0;
+    size_t max_index = 0;
+    for (size_t i = 0; i < geometry.position_count; ++i) {
+        const float *pos = &geometry.positions[i * pos_stride];
+        const float *min_pos = &geometry.positions[min_index * pos_stride];
+        const float *max_pos = &geometry.positions[max_index * pos_stride];
+        if ((pos[0] <= min_pos[0]) && (pos[1] <= min_pos[1])) {
+            min_index = i;
+        }
+        if ((pos[0] >= max_pos[0]) && (pos[1] >= max_pos[1])) {
+            max_index = i;
+        }
+    }
+    frame.pos_min_x = geometry.positions[min_index * pos_stride + 0];
+    frame.pos_min_y = geometry.positions[min_index * pos_stride + 1];
+    frame.pos_max_x = geometry.positions[max_index * pos_stride + 0];
+    frame.pos_max_y = geometry.positions[max_index * pos_stride + 1];
+    frame.pos_z = geometry.positions[min_index * pos_stride + 2];
+    frame.uv_min_u = geometry.uvs[min_index * uv_stride + 0];
+    frame.uv_min_v = geometry.uvs[min_index * uv_stride + 1];
+    frame.uv_max_u = geometry.uvs[max_index * uv_stride + 0];
+    frame.uv_max_v = geometry.uvs[max_index * uv_stride + 1];
+
+    // Match the triangle winding of the uniform geometry.
+    if (geometry.index_triangles.size() >= 3) {
+        const float *a = &geometry.positions[geometry.index_triangles[0] * pos_stride];
+        const float *b = &geometry.positions[geometry.index_triangles[1] * pos_stride];
+        const float *c = &geometry.positions[geometry.index_triangles[2] * pos_stride];
+        const float area =
+            ((b[0] - a[0]) * (c[1] - a[1]))
+            - ((b[1] - a[1]) * (c[0] - a[0]));
+        frame.flip_winding = area < 0.0f;
+    }
+    return frame;
+}
+
+// A (leaf) cell of the adaptive tessellation, with the lower-left
+// corner on the finest lattice.
+struct AdaptiveCell {
+    uint32_t level;
+    size_t x;
+    size_t y;
+};
+
+class AdaptiveTessellator {
+public:
+    AdaptiveTessellator(const size_t divisions_x,
+                        const size_t divisions_y,
+                        const uint32_t max_level,
+                        const CanvasFrame &frame)
+            : m_max_level(max_level)
+            , m_scale(static_cast<size_t>(1) << max_level)
+            , m_lattice_x(divisions_x * m_scale)
+            , m_lattice_y(divisions_y * m_scale)
+            , m_frame(frame)
+            , m_levels(m_lattice_x * m_lattice_y, 0)
+            , m_vertex_indices((m_lattice_x + 1) * (m_lattice_y + 1), -1) {}
+
+    size_t span(const AdaptiveCell &cell) const {
+        return m_scale >> cell.level;
+    }
+
+    void lattice_position(const size_t x, const size_t y,
+                          float &out_x, float &out_y) const {
+        const float ratio_x = static_cast<float>(x) / static_cast<float>(m_lattice_x);
+        const float ratio_y = static_cast<float>(y) / static_cast<float>(m_lattice_y);
+        out_x = m_frame.pos_min_x + ((m_frame.pos_max_x - m_frame.pos_min_x) * ratio_x);
+        out_y = m_frame.pos_min_y + ((m_frame.pos_max_y - m_frame.pos_min_y) * ratio_y);
+    }
+
+    // The largest distance between the deformed cell and the
+    // bilinear interpolation of the deformed corners.
+    float cell_error(const AdaptiveCell &cell,
+                     const CanvasDeformFunction &deform_function) const {
+        const size_t cell_span = span(cell);
+        float x0 = 0.0f, y0 = 0.0f, x1 = 0.0f, y1 = 0.0f;
+        lattice_position(cell.x, cell.y, x0, y0);
+        lattice_position(cell.x + cell_span, cell.y + cell_span, x1, y1);
+
+        float corners[4][2];
+        deform_function(x0, y0, corners[0][0], corners[0][1]);
+        deform_function(x1, y0, corners[1][0], corners[1][1]);
+        deform_function(x0, y1, corners[2][0], corners[2][1]);
+        deform_function(x1, y1, corners[3][0], corners[3][1]);
+
+        const float samples[5][2] = {
+            {0.5f, 0.5f},
+            {0.5f, 0.0f},
+            {0.0f, 0.5f},
+            {1.0f, 0.5f},
+            {0.5f, 1.0f},
+        };
+        float max_error = 0.0f;
+        for (size_t i = 0; i < 5; ++i) {
+            const float s = samples[i][0];
+            const float t = samples[i][1];
+            float deformed_x = 0.0f;
+            float deformed_y = 0.0f;
+            deform_function(
+                x0 + ((x1 - x0) * s), y0 + ((y1 - y0) * t),
+                deformed_x, deformed_y);
+            float linear[2];
+            for (size_t j = 0; j < 2; ++j) {
+                const float bottom = corners[0][j] + ((corners[1][j] - corners[0][j]) * s);
+                const float top = corners[2][j] + ((corners[3][j] - corners[2][j]) * s);
+                linear[j] = bottom + ((top - bottom) * t);
+            }
+            const float dx = deformed_x - linear[0];
+            const float dy = deformed_y - linear[1];
+            max_error = std::max(max_error, std::sqrt((dx * dx) + (dy * dy)));
+        }
+        return max_error;
+    }
+
+    void cell_errors(const size_t divisions_x,
+                     const size_t divisions_y,
+                     const CanvasDeformFunction &deform_function,
+                     std::vector<float> &errors) const {
+        errors.clear();
+        errors.reserve(divisions_x * divisions_y);
+        for (size_t y = 0; y < divisions_y; ++y) {
+            for (size_t x = 0; x < divisions_x; ++x) {
+                const AdaptiveCell cell{0, x * m_scale, y * m_scale};
+                errors.push_back(cell_error(cell, deform_function));
+            }
+        }
+    }
+
+    void set_cell_level(const AdaptiveCell &cell) {
+        const size_t cell_span = span(cell);
+        for (size_t y = cell.y; y < cell.y + cell_span; ++y) {
+            for (size_t x = cell.x; x < cell.x + cell_span; ++x) {
+                m_levels[(y * m_lattice_x) + x] = static_cast<uint8_t>(cell.level);
+            }
+        }
+    }
+
+    uint32_t level_at(const size_t x, const size_t y) const {
+        return m_levels[(y * m_lattice_x) + x];
+    }
+
+    void split(const AdaptiveCell &cell, std::vector<AdaptiveCell> &cells) const {
+        const size_t half = span(cell) / 2;
+        const uint32_t level = cell.level + 1;
+        cells.push_back(AdaptiveCell{level, cell.x, cell.y});
+        cells.push_back(AdaptiveCell{level, cell.x + half, cell.y});
+        cells.push_back(AdaptiveCell{level, cell.x, cell.y + half});
+        cells.push_back(AdaptiveCell{level, cell.x + half, cell.y + half});
+    }
+
+    void refine(const size_t divisions_x,
+                const size_t divisions_y,
+                const float tolerance,
+                const CanvasDeformFunction &deform_function) {
+        std::vector<AdaptiveCell> pending;
+        for (size_t y = 0; y < divisions_y; ++y) {
+            for (size_t x = 0; x < divisions_x; ++x) {
+                pending.push_back(AdaptiveCell{0, x * m_scale, y * m_scale});
+            }
+        }
+        while (!pending.empty()) {
+            AdaptiveCell cell = pending.back();
+            pending.pop_back();
+            if ((cell.level < m_max_level)
+                && (cell_error(cell, deform_function) > tolerance)) {
+                split(cell, pending);
+            } else {
+                m_cells.push_back(cell);
+                set_cell_level(cell);
+            }
+        }
+    }
+
+    // Is a neighbour along the cell edge more than one level finer?
+    bool needs_balance(const AdaptiveCell &cell) const {
+        const size_t cell_span = span(cell);
+        const uint32_t max_neighbour_level = cell.level + 1;
+        for (size_t i = 0; i < cell_span; ++i) {
+            if ((cell.y > 0)
+                && (level_at(cell.x + i, cell.y - 1) > max_neighbour_level)) {
+                return true;
+            }
+            if ((cell.y + cell_span < m_lattice_y)
+                && (level_at(cell.x + i, cell.y + cell_span) > max_neighbour_level)) {
+                return true;
+            }
+            if ((cell.x > 0)
+                && (level_at(cell.x - 1, cell.y + i) > max_neighbour_level)) {
+                return true;
+            }
+            if ((cell.x + cell_span < m_lattice_x)
+                && (level_at(cell.x + cell_span, cell.y + i) > max_neighbour_level)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Split cells until neighbouring cells differ by at most one
+    // level, so each cell edge has at most one extra (middle) vertex.
+    void balance() {
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            std::vector<AdaptiveCell> cells;
+            cells.reserve(m_cells.size());
+            for (auto cell : m_cells) {
+                if ((cell.level < m_max_level) && needs_balance(cell)) {
+                    std::vector<AdaptiveCell> children;
+                    split(cell, children);
+                    for (auto child : children) {
+                        set_cell_level(child);
+                        cells.push_back(child);
+                    }
+                    changed = true;
+                } else {
+                    cells.push_back(cell);
+                }
+            }
+            m_cells.swap(cells);
+        }
+    }
+
+    uint32_t vertex(const size_t x, const size_t y, CanvasGeometry &geometry) {
+        int64_t &index = m_vertex_indices[(y * (m_lattice_x + 1)) + x];
+        if (index < 0) {
+            index = static_cast<int64_t>(geometry.position_count);
+            float pos_x = 0.0f;
+            float pos_y = 0.0f;
+            lattice_position(x, y, pos_x, pos_y);
+            geometry.positions.push_back(pos_x);
+            geometry.positions.push_back(pos_y);
+            geometry.positions.push_back(m_frame.pos_z);
+
+            const float ratio_x = static_cast<float>(x) / static_cast<float>(m_lattice_x);
+            const float ratio_y = static_cast<float>(y) / static_cast<float>(m_lattice_y);
+            geometry.uvs.push_back(
+                m_frame.uv_min_u + ((m_frame.uv_max_u - m_frame.uv_min_u) * ratio_x));
+            geometry.uvs.push_back(
+                m_frame.uv_min_v + ((m_frame.uv_max_v - m_frame.uv_min_v) * ratio_y));
+            geometry.position_count += 1;
+            geometry.uv_count += 1;
+        }
+        return static_cast<uint32_t>(index);
+    }
+
+    void add_line(std::vector<uint32_t> &indices,
+                  const uint32_t a, const uint32_t b) const {
+        indices.push_back(a);
+        indices.push_back(b);
+    }
+
+    void triangulate(CanvasGeometry &geometry) {
+        for (auto cell : m_cells) {
+            const size_t cell_span = span(cell);
+            const size_t half = cell_span / 2;
+            const size_t x0 = cell.x;
+            const size_t y0 = cell.y;
+            const size_t x1 = cell.x + cell_span;
+            const size_t y1 = cell.y + cell_span;
+
+            // A finer neighbour adds a vertex to the middle of the
+            // shared edge.
+            const bool split_bottom =
+                (y0 > 0) && (level_at(x0, y0 - 1) > cell.level);
+            const bool split_right =
+                (x1 < m_lattice_x) && (level_at(x1, y0) > cell.level);
+            const bool split_top =
+                (y1 < m_lattice_y) && (level_at(x0, y1) > cell.level);
+            const bool split_left =
+                (x0 > 0) && (level_at(x0 - 1, y0) > cell.level);
+
+            const uint32_t c00 = vertex(x0, y0, geometry);
+            const uint32_t c10 = vertex(x1, y0, geometry);
+            const uint32_t c11 = vertex(x1, y1, geometry);
+            const uint32_t c01 = vertex(x0, y1, geometry);
+
+            // Counter-clockwise loop around the cell.
+            std::vector<uint32_t> loop;
+            loop.push_back(c00);
+            if (split_bottom) {
+                loop.push_back(vertex(x0 + half, y0, geometry));
+            }
+            loop.push_back(c10);
+            if (split_right) {
+                loop.push_back(vertex(x1, y0 + half, geometry));
+            }
+            loop.push_back(c11);
+            if (split_top) {
+                loop.push_back(vertex(x0 + half, y1, geometry));
+            }
+            loop.push_back(c01);
+            if (split_left) {
+                loop.push_back(vertex(x0, y0 + half, geometry));
+            }
+
+            if (loop.size() == 4) {
+                add_triangle(geometry, c00, c10, c11);
+                add_triangle(geometry, c00, c11, c01);
+            } else {
+                const uint32_t center = vertex(x0 + half, y0 + half, geometry);
+                for (size_t i = 0; i < loop.size(); ++i) {
+                    add_triangle(
+                        geometry, center, loop[i], loop[(i + 1) % loop.size()]);
+                }
+            }
+
+            // Each cell draws its bottom and left edges, the finer
+            // cells draw the shared edges of coarser cells. The edges
+            // of the canvas are also the border.
+            auto &wire = geometry.index_wire_lines;
+            auto &border = geometry.index_border_lines;
+            if (split_bottom) {
+                const uint32_t mid = vertex(x0 + half, y0, geometry);
+                add_line(wire, c00, mid);
+                add_line(wire, mid, c10);
+            } else {
+                add_line(wire, c00, c10);
+            }
+            if (split_left) {
+                const uint32_t mid = vertex(x0, y0 + half, geometry);
+                add_line(wire, c00, mid);
+                add_line(wire, mid, c01);
+            } else {
+                add_line(wire, c00, c01);
+            }
+            if (y0 == 0) {
+                add_line(border, c00, c10);
+            }
+            if (x0 == 0) {
+                add_line(border, c00, c01);
+            }
+            if (x1 == m_lattice_x) {
+                add_line(wire, c10, c11);
+                add_line(border, c10, c11);
+            }
+            if (y1 == m_lattice_y) {
+                add_line(wire, c01, c11);
+                add_line(border, c01, c11);
+            }
+        }
+    }
+
+    size_t cell_count() const {
+        return m_cells.size();
+    }
+
+private:
+    void add_triangle(CanvasGeometry &geometry,
+                      const uint32_t a, const uint32_t b, const uint32_t c) const {
+        geometry.index_triangles.push_back(a);
+        if (m_frame.flip_winding) {
+            geometry.index_triangles.push_back(c);
+            geometry.index_triangles.push_back(b);
+        } else {
+            geometry.index_triangles.push_back(b);
+            geometry.index_triangles.push_back(c);
+        }
+    }
+
+    uint32_t m_max_level;
+    size_t m_scale;
+    size_t m_lattice_x;
+    size_t m_lattice_y;
+    CanvasFrame m_frame;
+    std::vector<uint8_t> m_levels;
+    std::vector<int64_t> m_vertex_indices;
+    std::vector<AdaptiveCell> m_cells;
+};
+
+} // namespace
+
+
+std::shared_ptr<const CanvasGeometry> build_adaptive_canvas_geometry(
+        const size_t divisions_x,
+        const size_t divisions_y,
+        const uint32_t max_level,
+        const float tolerance,
+        const CanvasDeformFunction &deform_function) {
+    auto log = log::get_logger();
+
+    auto uniform_geometry = get_canvas_geometry(divisions_x, divisions_y);
+    CanvasFrame frame = get_canvas_frame(*uniform_geometry);
+
+    AdaptiveTessellator tessellator(
+        divisions_x, divisions_y, max_level, frame);
+    tessellator.refine(divisions_x, divisions_y, tolerance, deform_function);
+    tessellator.balance();
+
+    auto geometry = std::make_shared<CanvasGeometry>();
+    geometry->divisions_x = divisions_x;
+    geometry->divisions_y = divisions_y;
+    geometry->position_count = 0;
+    geometry->uv_count = 0;
+    tessellator.triangulate(*geometry);
+
+    log->debug(
+        "Built adaptive canvas geometry: {}x{} max_level={} cells={} "
+        "vertices={} (uniform vertices={})",
+        divisions_x, divisions_y, max_level,
+        tessellator.cell_count(),
+        geometry->position_count,
+        uniform_geometry->position_count);
+    return geometry;
+}
+
+void adaptive_canvas_cell_errors(
+        const size_t divisions_x,
+        const size_t divisions_y,
+        const CanvasDeformFunction &deform_function,
+        std::vector<float> &cell_errors) {
+    auto uniform_geometry = get_canvas_geometry(divisions_x, divisions_y);
+    CanvasFrame frame = get_canvas_frame(*uniform_geometry);
+
+    const uint32_t max_level = 0;
+    AdaptiveTessellator tessellator(
+        divisions_x, divisions_y, max_level, frame);
+    tessellator.cell_errors(
+        divisions_x, divisions_y, deform_function, cell_errors);
+}
+
+
+// Vertex Positions.
+void generate_vertex_positions(
+        MHWRender::MVertexBuffer *vertex_buffer,
+        const CanvasGeometry &geometry,
+        ocg::StreamData &stream_data) {
+    auto log = log::get_logger();
+
+    auto pos_buffer_size = geometry.positions.size();
+    auto pos_count = geometry.position_count;
     bool write_only = true;  // We don't need the current buffer values
     float *buffer = static_cast<float *>(
         vertex_buffer->acquire(pos_count, write_only));
     if (buffer) {
+        std::memcpy(
+            buffer,
+            geometry.positions.data(),
+            pos_buffer_size * sizeof(float));
         rust::Slice<float> slice{buffer, pos_buffer_size};
-        geom->fill_buffer_vertex_positions(slice);
 
         if (stream_data.deformers_len() > 0) {
             // TODO: Work out the correct maths to ensure lens
@@ -97,115 +711,142 @@ void generate_vertex_positions(
     return;
 }
 
+void generate_vertex_positions(
+        MHWRender::MVertexBuffer *vertex_buffer,
+        const size_t divisions_x,
+        const size_t divisions_y,
+        ocg::StreamData &stream_data) {
+    auto geometry = get_canvas_geometry(divisions_x, divisions_y);
+    generate_vertex_positions(vertex_buffer, *geometry, stream_data);
+    return;
+}
 
-// UVs for Vertices.
-void generate_vertex_uvs(
-        MHWRender::MVertexBuffer* vertex_buffer,
+
+// Vertex Positions, undeformed.
+void generate_vertex_positions(
+        MHWRender::MVertexBuffer *vertex_buffer,
+        const CanvasGeometry &geometry) {
+    copy_into_buffer(
+        vertex_buffer, geometry.positions, geometry.position_count);
+    return;
+}
+
+void generate_vertex_positions(
+        MHWRender::MVertexBuffer *vertex_buffer,
         const size_t divisions_x,
         const size_t divisions_y) {
-    auto log = log::get_logger();
+    auto geometry = get_canvas_geometry(divisions_x, divisions_y);
+    generate_vertex_positions(vertex_buffer, *geometry);
+    return;
+}
 
-    auto center_x = -0.5f;
-    auto center_y = -0.5f;
-    auto size_x = 1.0f;
-    auto size_y = 1.0f;
-    auto geom = ocg::internal::create_geometry_plane_box(
-        center_x, center_y,
-        size_x, size_y,
-        divisions_x, divisions_y);
 
-    auto uv_buffer_size = geom->calc_buffer_size_vertex_uvs();
-    auto uv_count = geom->calc_count_vertex_uvs();
+// Vertex Positions, deformed on the CPU.
+void generate_vertex_positions(
+        MHWRender::MVertexBuffer *vertex_buffer,
+        const CanvasGeometry &geometry,
+        const CanvasPositionsDeformFunction &deform_function) {
+    auto log = log::get_logger();
+
+    auto pos_count = geometry.position_count;
     bool write_only = true;  // We don't need the current buffer values
     float *buffer = static_cast<float *>(
-        vertex_buffer->acquire(uv_count, write_only));
+        vertex_buffer->acquire(pos_count, write_only));
     if (buffer) {
-        rust::Slice<float> slice{buffer, uv_buffer_size};
-        geom->fill_buffer_vertex_uvs(slice);
+        auto start_time = std::chrono::steady_clock::now();
+        deform_function(geometry.positions.data(), buffer, pos_count);
+        auto end_time = std::chrono::steady_clock::now();
         vertex_buffer->commit(buffer);
+
+        std::chrono::duration<double> duration = end_time - start_time;
+        auto seconds = std::max(duration.count(), 1e-9);
+        log->debug(
+            "Deformed {} canvas vertices in {:.3f} ms ({:.1f} M vertices/sec).",
+            pos_count,
+            seconds * 1000.0,
+            (static_cast<double>(pos_count) / seconds) / 1.0e6);
     }
     return;
 }
 
 
+// UVs for Vertices.
+void generate_vertex_uvs(
+        MHWRender::MVertexBuffer *vertex_buffer,
+        const CanvasGeometry &geometry) {
+    copy_into_buffer(vertex_buffer, geometry.uvs, geometry.uv_count);
+    return;
+}
+
+void generate_vertex_uvs(
+        MHWRender::MVertexBuffer* vertex_buffer,
+        const size_t divisions_x,
+        const size_t divisions_y) {
+    auto geometry = get_canvas_geometry(divisions_x, divisions_y);
+    generate_vertex_uvs(vertex_buffer, *geometry);
+    return;
+}
+
+
 // Indexes for triangles.
+void generate_index_triangles(
+        MHWRender::MIndexBuffer *index_buffer,
+        const CanvasGeometry &geometry) {
+    copy_into_buffer(
+        index_buffer,
+        geometry.index_triangles,
+        geometry.index_triangles.size());
+    return;
+}
+
 void generate_index_triangles(
         MHWRender::MIndexBuffer *index_buffer,
         const size_t divisions_x,
         const size_t divisions_y) {
-    auto center_x = -0.5f;
-    auto center_y = -0.5f;
-    auto size_x = 1.0f;
-    auto size_y = 1.0f;
-    auto geom = ocg::internal::create_geometry_plane_box(
-        center_x, center_y,
-        size_x, size_y,
-        divisions_x, divisions_y);
-
-    auto tri_count = geom->calc_buffer_size_index_tris();
-    bool write_only = true;  // We don't need the current buffer values
-    uint32_t *buffer = static_cast<uint32_t *>(
-        index_buffer->acquire(tri_count, write_only));
-    if (buffer) {
-        rust::Slice<uint32_t> slice{buffer, tri_count};
-        geom->fill_buffer_index_tris(slice);
-        index_buffer->commit(buffer);
-    }
+    auto geometry = get_canvas_geometry(divisions_x, divisions_y);
+    generate_index_triangles(index_buffer, *geometry);
     return;
 }
 
 
 // Indexes for border lines.
+void generate_index_border_lines(
+        MHWRender::MIndexBuffer *index_buffer,
+        const CanvasGeometry &geometry) {
+    copy_into_buffer(
+        index_buffer,
+        geometry.index_border_lines,
+        geometry.index_border_lines.size());
+    return;
+}
+
 void generate_index_border_lines(
         MHWRender::MIndexBuffer *index_buffer,
         const size_t divisions_x,
         const size_t divisions_y) {
-    auto center_x = -0.5f;
-    auto center_y = -0.5f;
-    auto size_x = 1.0f;
-    auto size_y = 1.0f;
-    auto geom = ocg::internal::create_geometry_plane_box(
-        center_x, center_y,
-        size_x, size_y,
-        divisions_x, divisions_y);
-
-    auto tri_count = geom->calc_buffer_size_index_border_lines();
-    bool write_only = true;  // We don't need the current buffer values
-    uint32_t *buffer = static_cast<uint32_t *>(
-        index_buffer->acquire(tri_count, write_only));
-    if (buffer) {
-        rust::Slice<uint32_t> slice{buffer, tri_count};
-        geom->fill_buffer_index_border_lines(slice);
-        index_buffer->commit(buffer);
-    }
+    auto geometry = get_canvas_geometry(divisions_x, divisions_y);
+    generate_index_border_lines(index_buffer, *geometry);
     return;
 }
 
 
 // Indexes for wire lines.
+void generate_index_wire_lines(
+        MHWRender::MIndexBuffer *index_buffer,
+        const CanvasGeometry &geometry) {
+    copy_into_buffer(
+        index_buffer,
+        geometry.index_wire_lines,
+        geometry.index_wire_lines.size());
+    return;
+}
+
 void generate_index_wire_lines(
         MHWRender::MIndexBuffer *index_buffer,
         const size_t divisions_x,
         const size_t divisions_y) {
-    auto center_x = -0.5f;
-    auto center_y = -0.5f;
-    auto size_x = 1.0f;
-    auto size_y = 1.0f;
-    auto geom = ocg::internal::create_geometry_plane_box(
-        center_x, center_y,
-        size_x, size_y,
-        divisions_x, divisions_y);
-
-    auto tri_count = geom->calc_buffer_size_index_wire_lines();
-    bool write_only = true;  // We don't need the current buffer values
-    uint32_t *buffer = static_cast<uint32_t *>(
-        index_buffer->acquire(tri_count, write_only));
-    if (buffer) {
-        rust::Slice<uint32_t> slice{buffer, tri_count};
-        geom->fill_buffer_index_wire_lines(slice);
-        index_buffer->commit(buffer);
-    }
-
+    auto geometry = get_canvas_geometry(divisions_x, divisions_y);
+    generate_index_wire_lines(index_buffer, *geometry);
     return;
 }
 
@@ -385,6 +1026,46 @@ MHWRender::MVertexBuffer* build_window_vertex_buffer_positions(
 }
 
 
+// Shared UV vertex buffer.
+std::shared_ptr<MHWRender::MVertexBuffer> get_shared_vertex_buffer_uvs(
+        const size_t divisions_x,
+        const size_t divisions_y) {
+    return get_shared_buffer(
+        get_shared_vertex_buffers(), buffer_kind_uvs,
+        divisions_x, divisions_y, build_vertex_buffer_uvs);
+}
+
+
+// Shared index buffer for triangles.
+std::shared_ptr<MHWRender::MIndexBuffer> get_shared_index_buffer_triangles(
+        const size_t divisions_x,
+        const size_t divisions_y) {
+    return get_shared_buffer(
+        get_shared_index_buffers(), buffer_kind_triangles,
+        divisions_x, divisions_y, build_index_buffer_triangles);
+}
+
+
+// Shared index buffer for border lines.
+std::shared_ptr<MHWRender::MIndexBuffer> get_shared_index_buffer_border_lines(
+        const size_t divisions_x,
+        const size_t divisions_y) {
+    return get_shared_buffer(
+        get_shared_index_buffers(), buffer_kind_border_lines,
+        divisions_x, divisions_y, build_index_buffer_border_lines);
+}
+
+
+// Shared index buffer for wire lines.
+std::shared_ptr<MHWRender::MIndexBuffer> get_shared_index_buffer_wire_lines(
+        const size_t divisions_x,
+        const size_t divisions_y) {
+    return get_shared_buffer(
+        get_shared_index_buffers(), buffer_kind_wire_lines,
+        divisions_x, divisions_y, build_index_buffer_wire_lines);
+}
+
+
 // Index buffer for border lines, of window.
 MHWRender::MIndexBuffer* build_window_index_buffer_border_lines() {
     MHWRender::MIndexBuffer* index_buffer = new MHWRender::MIndexBuffer(
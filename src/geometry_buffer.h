@@ -26,6 +26,11 @@
 // Maya Viewport 2.0
 #include <maya/MHWGeometry.h>
 
+// STL
+#include <functional>
+#include <memory>
+#include <vector>
+
 // OCG
 #include <opencompgraph.h>
 
@@ -34,17 +39,113 @@ namespace ocg = open_comp_graph;
 namespace open_comp_graph_maya {
 namespace geometry_buffer {
 
+// CPU copy of the (un-deformed) canvas plane geometry.
+//
+// The geometry only depends on the divisions, so it is built once
+// and shared by every image plane using the same divisions.
+struct CanvasGeometry {
+    size_t divisions_x;
+    size_t divisions_y;
+    size_t position_count;
+    size_t uv_count;
+    std::vector<float> positions;
+    std::vector<float> uvs;
+    std::vector<uint32_t> index_triangles;
+    std::vector<uint32_t> index_border_lines;
+    std::vector<uint32_t> index_wire_lines;
+};
+
+// Get the canvas geometry, building it only if nobody else holds the
+// geometry with the same divisions.
+std::shared_ptr<const CanvasGeometry> get_canvas_geometry(
+    const size_t divisions_x,
+    const size_t divisions_y);
+
+// Deform a canvas position (x, y), the output units are used to
+// measure the error of an adaptive tessellation.
+typedef std::function<void(
+    const float x, const float y,
+    float &out_x, float &out_y)> CanvasDeformFunction;
+
+// Deform 'count' canvas positions (3 floats each) from
+// 'in_positions', writing the results to 'out_positions'.
+typedef std::function<void(
+    const float *in_positions,
+    float *out_positions,
+    const size_t count)> CanvasPositionsDeformFunction;
+
+// Build canvas geometry starting from a uniform grid of divisions,
+// splitting each cell in half (up to 'max_level' times) while the
+// deformed cell differs from a straight (bilinear) cell by more than
+// 'tolerance'. Neighbouring cells differ by at most one level, and
+// cells next to finer cells are triangulated to avoid cracks.
+std::shared_ptr<const CanvasGeometry> build_adaptive_canvas_geometry(
+    const size_t divisions_x,
+    const size_t divisions_y,
+    const uint32_t max_level,
+    const float tolerance,
+    const CanvasDeformFunction &deform_function);
+
+// The error of each cell of the uniform grid of divisions, as
+// measured by 'build_adaptive_canvas_geometry'. Deformations with
+// similar cell errors are tessellated alike.
+void adaptive_canvas_cell_errors(
+    const size_t divisions_x,
+    const size_t divisions_y,
+    const CanvasDeformFunction &deform_function,
+    std::vector<float> &cell_errors);
+
 void generate_vertex_positions(
     MHWRender::MVertexBuffer *vertex_buffer,
     const size_t divisions_x,
     const size_t divisions_y,
     ocg::StreamData &stream_data);
 
+// Vertex positions without any deformation, for when the deformers
+// are evaluated by the shader.
+void generate_vertex_positions(
+    MHWRender::MVertexBuffer *vertex_buffer,
+    const size_t divisions_x,
+    const size_t divisions_y);
+
 void generate_vertex_uvs(
     MHWRender::MVertexBuffer *vertex_buffer,
     const size_t divisions_x,
     const size_t divisions_y);
 
+// Fill buffers from the given canvas geometry.
+void generate_vertex_positions(
+    MHWRender::MVertexBuffer *vertex_buffer,
+    const CanvasGeometry &geometry,
+    ocg::StreamData &stream_data);
+
+void generate_vertex_positions(
+    MHWRender::MVertexBuffer *vertex_buffer,
+    const CanvasGeometry &geometry);
+
+// Vertex positions deformed by 'deform_function', written directly
+// into the vertex buffer.
+void generate_vertex_positions(
+    MHWRender::MVertexBuffer *vertex_buffer,
+    const CanvasGeometry &geometry,
+    const CanvasPositionsDeformFunction &deform_function);
+
+void generate_vertex_uvs(
+    MHWRender::MVertexBuffer *vertex_buffer,
+    const CanvasGeometry &geometry);
+
+void generate_index_triangles(
+    MHWRender::MIndexBuffer *index_buffer,
+    const CanvasGeometry &geometry);
+
+void generate_index_border_lines(
+    MHWRender::MIndexBuffer *index_buffer,
+    const CanvasGeometry &geometry);
+
+void generate_index_wire_lines(
+    MHWRender::MIndexBuffer *index_buffer,
+    const CanvasGeometry &geometry);
+
 void generate_index_triangles(
     MHWRender::MIndexBuffer *index_buffer,
     const size_t divisions_x,
@@ -90,6 +191,24 @@ MHWRender::MIndexBuffer* build_index_buffer_wire_lines(
     const size_t divisions_x,
     const size_t divisions_y);
 
+// Buffers shared by all users with the same divisions. The buffers
+// are deleted when the last user releases them.
+std::shared_ptr<MHWRender::MVertexBuffer> get_shared_vertex_buffer_uvs(
+    const size_t divisions_x,
+    const size_t divisions_y);
+
+std::shared_ptr<MHWRender::MIndexBuffer> get_shared_index_buffer_triangles(
+    const size_t divisions_x,
+    const size_t divisions_y);
+
+std::shared_ptr<MHWRender::MIndexBuffer> get_shared_index_buffer_border_lines(
+    const size_t divisions_x,
+    const size_t divisions_y);
+
+std::shared_ptr<MHWRender::MIndexBuffer> get_shared_index_buffer_wire_lines(
+    const size_t divisions_x,
+    const size_t divisions_y);
+
 ////////////////////////////////////////////////////////////////////////
 
 MHWRender::MVertexBuffer* build_window_vertex_buffer_positions(
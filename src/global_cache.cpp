@@ -22,6 +22,7 @@
 
 // STL
 #include <memory>
+#include <mutex>
 
 // OCG
 #include "opencompgraph.h"
@@ -39,11 +40,22 @@ std::shared_ptr<ocg::Cache> &get_shared_cache() {
     return shared_cache;
 }
 
+std::shared_ptr<ocg::Cache> create_worker_cache() {
+    auto worker_cache = std::make_shared<ocg::Cache>();
+    worker_cache->set_capacity_bytes(kWorkerCacheCapacityBytes);
+    return worker_cache;
+}
+
 std::shared_ptr<ocg::Cache> &get_shared_color_transform_cache() {
     static std::shared_ptr<ocg::Cache> shared_color_transform_cache = \
         std::make_shared<ocg::Cache>();
     return shared_color_transform_cache;
 }
 
+std::mutex &get_shared_color_transform_cache_mutex() {
+    static std::mutex shared_color_transform_cache_mutex;
+    return shared_color_transform_cache_mutex;
+}
+
 } // namespace cache
 } // namespace open_comp_graph_maya
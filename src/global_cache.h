@@ -26,6 +26,7 @@
 // STL
 #include <iostream>
 #include <memory>
+#include <mutex>
 
 // OCG
 #include <opencompgraph.h>
@@ -35,10 +36,25 @@ namespace ocg = open_comp_graph;
 namespace open_comp_graph_maya {
 namespace cache {
 
+// The capacity of the cache of each worker thread executing graphs.
+const size_t kWorkerCacheCapacityBytes =
+    static_cast<size_t>(2) * 1024 * 1024 * 1024;  // 2GB
+
+// The cache executed with the graph of the main thread, which is
+// only executed with the main graph's lock held.
 std::shared_ptr<ocg::Cache> &get_shared_cache();
 
+// Create the cache of a worker thread. A cache cannot be used by two
+// executing graphs at once, so each thread executing graphs in the
+// background owns a cache, rather than waiting on the shared cache.
+std::shared_ptr<ocg::Cache> create_worker_cache();
+
 std::shared_ptr<ocg::Cache> &get_shared_color_transform_cache();
 
+// Lock while baking LUTs with the color transform cache, LUTs may be
+// baked on background threads.
+std::mutex &get_shared_color_transform_cache_mutex();
+
 } // namespace cache
 } // namespace open_comp_graph_maya
 
@@ -35,11 +35,16 @@ namespace ocg = open_comp_graph;
 namespace open_comp_graph_maya {
 
 
-std::shared_ptr<ocg::Graph> get_shared_graph() {
-    static std::shared_ptr<ocg::Graph> shared_graph = std::make_shared<ocg::Graph>();
+std::shared_ptr<SharedGraph> get_shared_graph() {
+    static std::shared_ptr<SharedGraph> shared_graph = std::make_shared<SharedGraph>();
     return shared_graph;
 }
 
+std::recursive_mutex &get_shared_graph_mutex() {
+    static std::recursive_mutex shared_graph_mutex;
+    return shared_graph_mutex;
+}
+
 
 const MTypeId GraphData::m_id(OCGM_GRAPH_DATA_TYPE_ID);
 const MString GraphData::m_type_name(OCGM_GRAPH_DATA_TYPE_NAME);
@@ -32,16 +32,30 @@
 
 // STL
 #include <memory>
+#include <mutex>
 
 // OCG
 #include "opencompgraph.h"
 
+// OCG Maya
+#include "shared_graph.h"
+
 namespace ocg = open_comp_graph;
 
 namespace open_comp_graph_maya{
 
 // Get the global shared graph.
-std::shared_ptr<ocg::Graph> get_shared_graph();
+std::shared_ptr<SharedGraph> get_shared_graph();
+
+// Get the lock guarding the global shared graph.
+//
+// The graph is edited by DG computes on the main thread and copied
+// by executions on background threads, so all access must hold this
+// lock. Executions only hold it while copying the graph (see
+// 'graph::execute_ocg_graph'). The lock is recursive because a plug
+// query made while holding the lock may trigger a DG compute that
+// edits the graph.
+std::recursive_mutex &get_shared_graph_mutex();
 
 class GraphData : public MPxData {
 public:
@@ -20,70 +20,218 @@
  * Executes the OCG Graph.
  */
 
+// STL
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
 // OCG
 #include "opencompgraph.h"
 
 // OCG Maya
 #include "graph_data.h"
+#include "graph_execute.h"
+#include "global_cache.h"
 #include "logger.h"
+#include "sequence_index.h"
+#include "shared_graph.h"
 
 namespace ocg = open_comp_graph;
 
 namespace open_comp_graph_maya {
 namespace graph {
 
+namespace {
 
-// Trigger an OCG Graph evaluation and return the computed data.
-ocg::ExecuteStatus execute_ocg_graph_frames(
+// The number of computed streams remembered for sharing between
+// image planes.
+const size_t shared_streams_capacity = 16;
+
+// Streams are found by the hash of the node computing them, so
+// nodes of different image planes viewing the same stream share it.
+// The node hash does not change when the files read are replaced on
+// disk, so the identities of the files are part of the key too.
+struct SharedStream {
+    uint64_t node_hash;
+    uint64_t files_hash;
+    double frame;
+    std::shared_ptr<ocg::StreamData> stream_data;
+};
+
+// Streams computed recently.
+//
+// Must only be accessed while the shared streams mutex is locked.
+std::deque<SharedStream> &get_shared_streams() {
+    static std::deque<SharedStream> shared_streams;
+    return shared_streams;
+}
+
+std::mutex &get_shared_streams_mutex() {
+    static std::mutex shared_streams_mutex;
+    return shared_streams_mutex;
+}
+
+bool find_shared_stream(
+        const uint64_t node_hash,
+        const uint64_t files_hash,
+        const double frame,
+        std::shared_ptr<ocg::StreamData> &stream_data) {
+    std::lock_guard<std::mutex> lock(get_shared_streams_mutex());
+    for (const auto &shared_stream : get_shared_streams()) {
+        if ((shared_stream.node_hash == node_hash)
+            && (shared_stream.files_hash == files_hash)
+            && (shared_stream.frame == frame)) {
+            stream_data = shared_stream.stream_data;
+            return true;
+        }
+    }
+    return false;
+}
+
+void add_shared_stream(
+        const uint64_t node_hash,
+        const uint64_t files_hash,
+        const double frame,
+        const std::shared_ptr<ocg::StreamData> &stream_data) {
+    std::lock_guard<std::mutex> lock(get_shared_streams_mutex());
+    auto &shared_streams = get_shared_streams();
+    SharedStream shared_stream;
+    shared_stream.node_hash = node_hash;
+    shared_stream.files_hash = files_hash;
+    shared_stream.frame = frame;
+    shared_stream.stream_data = stream_data;
+    shared_streams.push_back(shared_stream);
+    while (shared_streams.size() > shared_streams_capacity) {
+        shared_streams.pop_front();
+    }
+}
+
+// The graph executed by the main thread.
+ExecuteGraph &get_main_execute_graph() {
+    static ExecuteGraph main_execute_graph;
+    return main_execute_graph;
+}
+
+std::mutex &get_main_execute_graph_mutex() {
+    static std::mutex main_execute_graph_mutex;
+    return main_execute_graph_mutex;
+}
+
+// Execute 'execute_graph', and read the output stream when
+// 'stream_data' is given.
+ocg::ExecuteStatus execute_graph_edits(
+        ExecuteGraph &execute_graph,
+        const GraphEdits &edits,
         ocg::Node stream_ocg_node,
         std::vector<double> execute_frames,
-        std::shared_ptr <ocg::Graph> shared_graph,
-        std::shared_ptr <ocg::Cache> shared_cache) {
+        std::shared_ptr<ocg::Cache> shared_cache,
+        std::shared_ptr<ocg::StreamData> *stream_data) {
     auto log = log::get_logger();
 
-    bool exists = shared_graph->node_exists(stream_ocg_node);
+    if (edits.generation > execute_graph.generation) {
+        apply_graph_edits(edits, execute_graph.graph);
+        execute_graph.generation = edits.generation;
+    }
+
+    bool exists = execute_graph.graph.node_exists(stream_ocg_node);
     log->debug(
-        "input node id={} node type={} exists={}",
+        "input node id={} node type={} exists={} generation={}",
         stream_ocg_node.get_id(),
         static_cast<uint64_t>(stream_ocg_node.get_node_type()),
-        exists);
+        exists,
+        execute_graph.generation);
 
     for (auto f : execute_frames) {
         log->debug("execute_frames={}", f);
     }
 
-    auto exec_status = shared_graph->execute(
+    // Each thread executes with its own cache (see
+    // 'cache::create_worker_cache'), so the threads execute at the
+    // same time.
+    auto exec_status = execute_graph.graph.execute(
         stream_ocg_node, execute_frames, shared_cache);
     log->debug(
         "execute status={}",
         static_cast<uint64_t>(exec_status));
 
-    auto input_node_status = shared_graph->node_status(stream_ocg_node);
+    auto input_node_status = execute_graph.graph.node_status(stream_ocg_node);
     log->debug(
         "input node status={}",
         static_cast<uint64_t>(input_node_status));
     log->debug(
         "Graph as string:\n{}",
-        shared_graph->data_debug_string());
+        execute_graph.graph.data_debug_string());
     log->debug(
         "Cache as string:\n{}",
         shared_cache->data_debug_string());
 
     if (exec_status != ocg::ExecuteStatus::kSuccess) {
         log->error("Failed to execute OCG node network!");
+    } else if (stream_data != nullptr) {
+        *stream_data = std::make_shared<ocg::StreamData>(
+            execute_graph.graph.output_stream());
     }
     return exec_status;
 }
 
+} // namespace
+
+
+GraphEdits find_graph_edits(
+        const ExecuteGraph &execute_graph,
+        std::shared_ptr<SharedGraph> shared_graph) {
+    GraphEdits edits;
+    std::lock_guard<std::recursive_mutex> graph_lock(
+        get_shared_graph_mutex());
+    shared_graph->edits_since(execute_graph.generation, edits);
+    return edits;
+}
+
+
+ocg::ExecuteStatus execute_ocg_graph_edits(
+        ExecuteGraph &execute_graph,
+        const GraphEdits &edits,
+        ocg::Node stream_ocg_node,
+        std::vector<double> execute_frames,
+        std::shared_ptr<ocg::Cache> shared_cache) {
+    return execute_graph_edits(
+        execute_graph,
+        edits,
+        stream_ocg_node,
+        execute_frames,
+        shared_cache,
+        nullptr);
+}
+
+
+// Trigger an OCG Graph evaluation and return the computed data.
+ocg::ExecuteStatus execute_ocg_graph_frames(
+        ocg::Node stream_ocg_node,
+        std::vector<double> execute_frames,
+        std::shared_ptr<SharedGraph> shared_graph,
+        std::shared_ptr<ocg::Cache> shared_cache) {
+    std::lock_guard<std::mutex> execute_graph_lock(
+        get_main_execute_graph_mutex());
+    auto &execute_graph = get_main_execute_graph();
+    auto edits = find_graph_edits(execute_graph, shared_graph);
+    return execute_ocg_graph_edits(
+        execute_graph,
+        edits,
+        stream_ocg_node,
+        execute_frames,
+        shared_cache);
+}
+
 
 // Trigger an OCG Graph evaluation and return the computed data.
 ocg::ExecuteStatus execute_ocg_graph(
         ocg::Node stream_ocg_node,
         double execute_frame,
-        std::shared_ptr <ocg::Graph> shared_graph,
-        std::shared_ptr <ocg::Cache> shared_cache) {
-    auto log = log::get_logger();
-
+        std::shared_ptr<SharedGraph> shared_graph,
+        std::shared_ptr<ocg::Cache> shared_cache) {
     std::vector <double> execute_frames;
     execute_frames.push_back(execute_frame);
 
@@ -95,5 +243,71 @@ ocg::ExecuteStatus execute_ocg_graph(
 }
 
 
+ocg::ExecuteStatus execute_ocg_graph_stream(
+        ocg::Node stream_ocg_node,
+        double execute_frame,
+        std::shared_ptr<SharedGraph> shared_graph,
+        std::shared_ptr<ocg::Cache> shared_cache,
+        std::shared_ptr<ocg::StreamData> &stream_data) {
+    std::lock_guard<std::mutex> execute_graph_lock(
+        get_main_execute_graph_mutex());
+    return execute_ocg_graph_stream(
+        get_main_execute_graph(),
+        stream_ocg_node,
+        execute_frame,
+        shared_graph,
+        shared_cache,
+        stream_data);
+}
+
+
+ocg::ExecuteStatus execute_ocg_graph_stream(
+        ExecuteGraph &execute_graph,
+        ocg::Node stream_ocg_node,
+        double execute_frame,
+        std::shared_ptr<SharedGraph> shared_graph,
+        std::shared_ptr<ocg::Cache> shared_cache,
+        std::shared_ptr<ocg::StreamData> &stream_data) {
+    auto log = log::get_logger();
+
+    // The hash is found with the same copy of the graph that is
+    // executed.
+    GraphEdits edits;
+    uint64_t node_hash = 0;
+    std::vector<std::string> file_paths;
+    {
+        std::lock_guard<std::recursive_mutex> graph_lock(
+            get_shared_graph_mutex());
+        shared_graph->edits_since(execute_graph.generation, edits);
+        node_hash = shared_graph->node_hash(stream_ocg_node);
+        shared_graph->node_file_paths(stream_ocg_node, execute_frame, file_paths);
+    }
+    // The files are looked at without the graph lock.
+    const uint64_t files_hash = sequence::hash_file_identities(file_paths);
+
+    if (find_shared_stream(node_hash, files_hash, execute_frame, stream_data)) {
+        log->debug(
+            "re-using stream: node id={} hash={} frame={}",
+            stream_ocg_node.get_id(), node_hash, execute_frame);
+        return ocg::ExecuteStatus::kSuccess;
+    }
+
+    std::vector<double> execute_frames;
+    execute_frames.push_back(execute_frame);
+    auto exec_status = execute_graph_edits(
+        execute_graph,
+        edits,
+        stream_ocg_node,
+        execute_frames,
+        shared_cache,
+        &stream_data);
+    if (exec_status != ocg::ExecuteStatus::kSuccess) {
+        return exec_status;
+    }
+    add_shared_stream(node_hash, files_hash, execute_frame, stream_data);
+    return exec_status;
+}
+
+
 } // namespace graph
 } // namespace open_comp_graph_maya
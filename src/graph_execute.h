@@ -24,31 +24,88 @@
 #define OPENCOMPGRAPHMAYA_GRAPH_EXECUTE_H
 
 // STL
+#include <cstdint>
 #include <memory>
+#include <vector>
 
 // OCG
 #include "opencompgraph.h"
 
 // OCG Maya
 #include "graph_data.h"
+#include "shared_graph.h"
 
 namespace ocg = open_comp_graph;
 
 namespace open_comp_graph_maya {
 namespace graph {
 
+// An OCG graph owned by the thread executing it. Before each
+// execution the edits made to the shared graph since the last
+// execution are copied in, so the shared graph lock is not held
+// while images are computed.
+struct ExecuteGraph {
+    ExecuteGraph()
+        : graph()
+        , generation(0) {}
+
+    ocg::Graph graph;
+
+    // The generation of the shared graph last copied.
+    uint64_t generation;
+};
+
+// Copy the edits of 'shared_graph' that 'execute_graph' has not seen
+// yet. The shared graph lock is held only while copying.
+GraphEdits find_graph_edits(
+    const ExecuteGraph &execute_graph,
+    std::shared_ptr<SharedGraph> shared_graph);
+
+// Copy 'edits' into 'execute_graph' and execute it.
+ocg::ExecuteStatus execute_ocg_graph_edits(
+    ExecuteGraph &execute_graph,
+    const GraphEdits &edits,
+    ocg::Node stream_ocg_node,
+    std::vector<double> execute_frames,
+    std::shared_ptr<ocg::Cache> shared_cache);
+
+// The functions below execute the graph of the main thread.
 ocg::ExecuteStatus execute_ocg_graph_frames(
     ocg::Node stream_ocg_node,
     std::vector<double> execute_frames,
-    std::shared_ptr<ocg::Graph> shared_graph,
+    std::shared_ptr<SharedGraph> shared_graph,
     std::shared_ptr<ocg::Cache> shared_cache);
 
 ocg::ExecuteStatus execute_ocg_graph(
     ocg::Node stream_ocg_node,
     double execute_frame,
-    std::shared_ptr<ocg::Graph> shared_graph,
+    std::shared_ptr<SharedGraph> shared_graph,
     std::shared_ptr<ocg::Cache> shared_cache);
 
+// Execute the graph and return the output stream of
+// 'stream_ocg_node' at 'execute_frame'.
+//
+// When a node with the same hash (see 'SharedGraph::node_hash') has
+// already been computed at the frame, the previously computed stream
+// is returned without executing the graph again. This allows many
+// image planes viewing the same node to share one evaluation, even
+// though each image plane executes its own output node.
+ocg::ExecuteStatus execute_ocg_graph_stream(
+    ocg::Node stream_ocg_node,
+    double execute_frame,
+    std::shared_ptr<SharedGraph> shared_graph,
+    std::shared_ptr<ocg::Cache> shared_cache,
+    std::shared_ptr<ocg::StreamData> &stream_data);
+
+// As above, executing 'execute_graph'.
+ocg::ExecuteStatus execute_ocg_graph_stream(
+    ExecuteGraph &execute_graph,
+    ocg::Node stream_ocg_node,
+    double execute_frame,
+    std::shared_ptr<SharedGraph> shared_graph,
+    std::shared_ptr<ocg::Cache> shared_cache,
+    std::shared_ptr<ocg::StreamData> &stream_data);
+
 } // namespace graph
 } // namespace open_comp_graph_maya
 
@@ -0,0 +1,213 @@
+/*
+ * Copyright (C) 2021 David Cattermole.
+ *
+ * This file is part of OpenCompGraphMaya.
+ *
+ * OpenCompGraphMaya is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * OpenCompGraphMaya is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OpenCompGraphMaya.  If not, see <https://www.gnu.org/licenses/>.
+ * ====================================================================
+ *
+ * Executes the OCG graph on a background thread.
+ */
+
+// STL
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <condition_variable>
+
+// OCG
+#include "opencompgraph.h"
+
+// OCG Maya
+#include "graph_data.h"
+#include "graph_execute.h"
+#include "graph_execute_async.h"
+#include "global_cache.h"
+#include "io_pool.h"
+#include "logger.h"
+
+namespace ocg = open_comp_graph;
+
+namespace open_comp_graph_maya {
+namespace graph {
+
+AsyncExecutor::AsyncExecutor()
+        : m_started(false)
+        , m_stop(false)
+        , m_running(false)
+        , m_has_request(false)
+        , m_request_id(0)
+        , m_request_frame(0.0)
+        , m_request_node(ocg::Node(ocg::NodeType::kNull, 0))
+        , m_request_wait_file_paths()
+        , m_has_result(false)
+        , m_result()
+        , m_completed_callback()
+        , m_execute_graph()
+        , m_cache() {}
+
+AsyncExecutor::~AsyncExecutor() {
+    this->stop();
+}
+
+void AsyncExecutor::set_completed_callback(CompletedCallback callback) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_completed_callback = callback;
+}
+
+// The worker thread is only started when first needed, so image
+// planes that are never drawn do not cost a thread.
+void AsyncExecutor::start() {
+    if (m_started) {
+        return;
+    }
+    m_stop = false;
+    m_thread = std::thread(&AsyncExecutor::run, this);
+    m_started = true;
+}
+
+void AsyncExecutor::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_started) {
+            return;
+        }
+        m_stop = true;
+        m_has_request = false;
+    }
+    m_condition.notify_all();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_started = false;
+}
+
+uint64_t AsyncExecutor::request(
+        ocg::Node stream_ocg_node,
+        double execute_frame,
+        const std::vector<std::string> &wait_file_paths) {
+    auto log = log::get_logger();
+    uint64_t request_id = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_has_request) {
+            log->debug(
+                "AsyncExecutor: cancelled stale request id={} frame={}",
+                m_request_id, m_request_frame);
+        }
+        m_request_id += 1;
+        m_request_frame = execute_frame;
+        m_request_node = stream_ocg_node;
+        m_request_wait_file_paths = wait_file_paths;
+        m_has_request = true;
+        request_id = m_request_id;
+        this->start();
+    }
+    m_condition.notify_one();
+    return request_id;
+}
+
+void AsyncExecutor::cancel_pending() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_has_request = false;
+}
+
+bool AsyncExecutor::is_busy() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_has_request || m_running;
+}
+
+uint64_t AsyncExecutor::latest_request_id() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_request_id;
+}
+
+bool AsyncExecutor::take_result(AsyncExecuteResult &result) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_has_result) {
+        return false;
+    }
+    result = m_result;
+    m_result = AsyncExecuteResult();
+    m_has_result = false;
+    return true;
+}
+
+void AsyncExecutor::run() {
+    auto log = log::get_logger();
+    if (!m_cache) {
+        m_cache = cache::create_worker_cache();
+    }
+    while (true) {
+        uint64_t request_id = 0;
+        double execute_frame = 0.0;
+        auto stream_ocg_node = ocg::Node(ocg::NodeType::kNull, 0);
+        std::vector<std::string> wait_file_paths;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this] {
+                return m_stop || m_has_request;
+            });
+            if (m_stop) {
+                break;
+            }
+            request_id = m_request_id;
+            execute_frame = m_request_frame;
+            stream_ocg_node = m_request_node;
+            wait_file_paths.swap(m_request_wait_file_paths);
+            m_has_request = false;
+            m_running = true;
+        }
+
+        // The worker executes its own copy of the graph, so DG
+        // computes editing the shared graph are only blocked while
+        // the edits are copied, not while the image is computed.
+        AsyncExecuteResult result;
+        result.request_id = request_id;
+        result.frame = execute_frame;
+        io_pool::wait_for_reads(wait_file_paths);
+        {
+            auto shared_graph = get_shared_graph();
+            result.status = execute_ocg_graph_stream(
+                m_execute_graph,
+                stream_ocg_node,
+                execute_frame,
+                shared_graph,
+                m_cache,
+                result.stream_data);
+        }
+        log->debug(
+            "AsyncExecutor: finished request id={} frame={} status={}",
+            request_id, execute_frame,
+            static_cast<uint64_t>(result.status));
+
+        CompletedCallback callback;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_result = result;
+            m_has_result = true;
+            m_running = false;
+            callback = m_completed_callback;
+        }
+        if (callback) {
+            callback();
+        }
+    }
+}
+
+} // namespace graph
+} // namespace open_comp_graph_maya
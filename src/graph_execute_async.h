@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2021 David Cattermole.
+ *
+ * This file is part of OpenCompGraphMaya.
+ *
+ * OpenCompGraphMaya is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * OpenCompGraphMaya is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OpenCompGraphMaya.  If not, see <https://www.gnu.org/licenses/>.
+ * ====================================================================
+ *
+ * Executes the OCG graph on a background thread.
+ */
+
+#ifndef OPENCOMPGRAPHMAYA_GRAPH_EXECUTE_ASYNC_H
+#define OPENCOMPGRAPHMAYA_GRAPH_EXECUTE_ASYNC_H
+
+// STL
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <condition_variable>
+#include <functional>
+
+// OCG
+#include "opencompgraph.h"
+
+// OCG Maya
+#include "graph_data.h"
+#include "graph_execute.h"
+
+namespace ocg = open_comp_graph;
+
+namespace open_comp_graph_maya {
+namespace graph {
+
+// The outcome of a single background graph evaluation.
+struct AsyncExecuteResult {
+    AsyncExecuteResult()
+        : request_id(0)
+        , frame(0.0)
+        , status(ocg::ExecuteStatus::kUninitialized)
+        , stream_data() {}
+
+    uint64_t request_id;
+    double frame;
+    ocg::ExecuteStatus status;
+    std::shared_ptr<ocg::StreamData> stream_data;
+};
+
+// Evaluates an OCG node on a worker thread, so the caller (the
+// Viewport 2.0 override) never blocks while images are read and
+// processed.
+//
+// Only the newest request is kept; a request that has not started is
+// cancelled when a new request replaces it. The OCG graph cannot be
+// interrupted once executing, so a running request always completes
+// and is returned as a result - callers compare the request id/frame
+// to decide if the result is stale.
+class AsyncExecutor {
+public:
+    // Called on the worker thread once a result is ready.
+    typedef std::function<void()> CompletedCallback;
+
+    AsyncExecutor();
+    ~AsyncExecutor();
+
+    void set_completed_callback(CompletedCallback callback);
+
+    // Queue an evaluation of 'stream_ocg_node' at 'execute_frame',
+    // replacing any pending request. The worker waits for the I/O
+    // pool to finish with 'wait_file_paths' (see
+    // 'io_pool::wait_for_reads') before executing. Returns the new
+    // request id.
+    uint64_t request(
+        ocg::Node stream_ocg_node,
+        double execute_frame,
+        const std::vector<std::string> &wait_file_paths =
+            std::vector<std::string>());
+
+    // Cancel the pending request, if it has not started yet.
+    void cancel_pending();
+
+    // Is a request waiting or being evaluated?
+    bool is_busy() const;
+
+    // The id of the newest request made.
+    uint64_t latest_request_id() const;
+
+    // Take the newest completed result. Returns false if no new
+    // result has finished since the last call.
+    bool take_result(AsyncExecuteResult &result);
+
+    // Stop and join the worker thread, waiting for any running
+    // evaluation to finish.
+    void stop();
+
+private:
+    void start();
+    void run();
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::thread m_thread;
+    bool m_started;
+    bool m_stop;
+    bool m_running;
+
+    // Pending request.
+    bool m_has_request;
+    uint64_t m_request_id;
+    double m_request_frame;
+    ocg::Node m_request_node;
+    std::vector<std::string> m_request_wait_file_paths;
+
+    // Latest completed result.
+    bool m_has_result;
+    AsyncExecuteResult m_result;
+
+    CompletedCallback m_completed_callback;
+
+    // Only used by the worker thread.
+    ExecuteGraph m_execute_graph;
+    std::shared_ptr<ocg::Cache> m_cache;
+};
+
+} // namespace graph
+} // namespace open_comp_graph_maya
+
+#endif // OPENCOMPGRAPHMAYA_GRAPH_EXECUTE_ASYNC_H
@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2021 David Cattermole.
+ *
+ * This file is part of OpenCompGraphMaya.
+ *
+ * OpenCompGraphMaya is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * OpenCompGraphMaya is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OpenCompGraphMaya.  If not, see <https://www.gnu.org/licenses/>.
+ * ====================================================================
+ *
+ * Executes write nodes on a background thread, frame after frame.
+ */
+
+// STL
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// OCG
+#include "opencompgraph.h"
+
+// OCG Maya
+#include "graph_data.h"
+#include "graph_execute.h"
+#include "graph_write_queue.h"
+#include "global_cache.h"
+#include "logger.h"
+
+namespace ocg = open_comp_graph;
+
+namespace open_comp_graph_maya {
+namespace graph {
+
+WriteQueue::WriteQueue(const size_t depth)
+        : m_depth(depth)
+        , m_stop(false)
+        , m_running(false)
+        , m_queued_generation(0)
+        , m_execute_graph()
+        , m_cache(cache::create_worker_cache()) {
+    if (m_depth > 0) {
+        m_thread = std::thread(&WriteQueue::run, this);
+    }
+}
+
+WriteQueue::~WriteQueue() {
+    this->stop();
+}
+
+void WriteQueue::submit(ocg::Node stream_ocg_node, double execute_frame) {
+    Request request;
+    request.node = stream_ocg_node;
+    request.frame = execute_frame;
+    {
+        std::lock_guard<std::recursive_mutex> graph_lock(
+            get_shared_graph_mutex());
+        get_shared_graph()->edits_since(m_queued_generation, request.edits);
+        m_queued_generation = request.edits.generation;
+    }
+    if (m_depth == 0) {
+        this->execute(request);
+        return;
+    }
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done_condition.wait(lock, [this] {
+            const size_t count =
+                m_queue.size() + static_cast<size_t>(m_running);
+            return m_stop || (count < m_depth);
+        });
+        if (m_stop) {
+            return;
+        }
+        m_queue.push_back(std::move(request));
+    }
+    m_condition.notify_one();
+}
+
+void WriteQueue::flush() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done_condition.wait(lock, [this] {
+        return m_stop || (m_queue.empty() && !m_running);
+    });
+}
+
+std::vector<WriteResult> WriteQueue::take_results() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<WriteResult> results;
+    results.swap(m_results);
+    return results;
+}
+
+void WriteQueue::stop() {
+    this->flush();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_condition.notify_all();
+    m_done_condition.notify_all();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+void WriteQueue::execute(const Request &request) {
+    auto log = log::get_logger();
+    WriteResult result;
+    result.node_id = request.node.get_id();
+    result.frame = request.frame;
+    std::vector<double> execute_frames;
+    execute_frames.push_back(request.frame);
+    auto start_time = std::chrono::steady_clock::now();
+    result.status = execute_ocg_graph_edits(
+        m_execute_graph,
+        request.edits,
+        request.node,
+        execute_frames,
+        m_cache);
+    auto end_time = std::chrono::steady_clock::now();
+    result.seconds =
+        std::chrono::duration<double>(end_time - start_time).count();
+    log->debug(
+        "WriteQueue: finished node id={} frame={} status={} seconds={}",
+        result.node_id, result.frame,
+        static_cast<uint64_t>(result.status), result.seconds);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_results.push_back(result);
+}
+
+void WriteQueue::run() {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this] {
+                return m_stop || !m_queue.empty();
+            });
+            if (m_stop) {
+                break;
+            }
+        }
+
+        Request request;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            request = std::move(m_queue.front());
+            m_queue.pop_front();
+            m_running = true;
+        }
+        m_done_condition.notify_all();
+
+        this->execute(request);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_running = false;
+        }
+        m_done_condition.notify_all();
+    }
+}
+
+} // namespace graph
+} // namespace open_comp_graph_maya
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2021 David Cattermole.
+ *
+ * This file is part of OpenCompGraphMaya.
+ *
+ * OpenCompGraphMaya is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * OpenCompGraphMaya is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OpenCompGraphMaya.  If not, see <https://www.gnu.org/licenses/>.
+ * ====================================================================
+ *
+ * Executes write nodes on a background thread, frame after frame.
+ */
+
+#ifndef OPENCOMPGRAPHMAYA_GRAPH_WRITE_QUEUE_H
+#define OPENCOMPGRAPHMAYA_GRAPH_WRITE_QUEUE_H
+
+// STL
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// OCG
+#include "opencompgraph.h"
+
+// OCG Maya
+#include "graph_data.h"
+#include "graph_execute.h"
+
+namespace ocg = open_comp_graph;
+
+namespace open_comp_graph_maya {
+namespace graph {
+
+// The outcome of a frame executed by a write queue.
+struct WriteResult {
+    WriteResult()
+        : node_id(0)
+        , frame(0.0)
+        , status(ocg::ExecuteStatus::kUninitialized)
+        , seconds(0.0) {}
+
+    uint64_t node_id;
+    double frame;
+    ocg::ExecuteStatus status;
+
+    // The time taken to execute (compute, encode and write) the
+    // frame.
+    double seconds;
+};
+
+// Executes (write) nodes on a worker thread in the order queued, so
+// the caller can prepare the next frames - evaluate the Maya scene
+// and wait for the files read ahead - while a frame is computed,
+// encoded and written.
+//
+// The shared graph holds one set of node attributes, so the edits
+// made to the shared graph since the previous frame are copied when
+// a frame is queued, and the worker applies them in order. The
+// caller may change the graph for the next frames as soon as a frame
+// is queued.
+class WriteQueue {
+public:
+    // At most 'depth' frames are queued or executing; zero executes
+    // each frame on the calling thread.
+    explicit WriteQueue(const size_t depth);
+    ~WriteQueue();
+
+    // Queue 'stream_ocg_node' to be executed at 'execute_frame',
+    // with the shared graph as it is now. Blocks while the queue is
+    // full.
+    void submit(ocg::Node stream_ocg_node, double execute_frame);
+
+    // Block until every queued frame has finished executing.
+    void flush();
+
+    // Take the results of the frames finished since the last call.
+    std::vector<WriteResult> take_results();
+
+    // Stop and join the worker thread, after the queued frames have
+    // finished executing.
+    void stop();
+
+private:
+    struct Request {
+        ocg::Node node;
+        double frame;
+
+        // The edits since the previous frame queued.
+        GraphEdits edits;
+    };
+
+    void run();
+    void execute(const Request &request);
+
+    const size_t m_depth;
+
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::condition_variable m_done_condition;
+    std::thread m_thread;
+    bool m_stop;
+
+    // Frames queued and not yet started.
+    std::deque<Request> m_queue;
+    bool m_running;
+
+    // The generation of the shared graph copied by the last frame
+    // queued. Only used by the thread queueing frames.
+    uint64_t m_queued_generation;
+
+    std::vector<WriteResult> m_results;
+
+    // Only used by the thread executing the frames.
+    ExecuteGraph m_execute_graph;
+    std::shared_ptr<ocg::Cache> m_cache;
+};
+
+} // namespace graph
+} // namespace open_comp_graph_maya
+
+#endif // OPENCOMPGRAPHMAYA_GRAPH_WRITE_QUEUE_H
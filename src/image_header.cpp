@@ -0,0 +1,486 @@
+/*
+ * Copyright (C) 2021 David Cattermole.
+ *
+ * This file is part of OpenCompGraphMaya.
+ *
+ * OpenCompGraphMaya is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * OpenCompGraphMaya is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OpenCompGraphMaya.  If not, see <https://www.gnu.org/licenses/>.
+ * ====================================================================
+ *
+ * Read the headers of image files.
+ */
+
+// STL
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// OCG Maya
+#include "image_header.h"
+
+namespace open_comp_graph_maya {
+namespace image_header {
+
+namespace {
+
+// Bits of the OpenEXR version field.
+const uint32_t kExrTiledFlag = 0x200;
+const uint32_t kExrMultiPartFlag = 0x1000;
+
+// Headers larger than this are not searched for the compression
+// attribute; the file is then read as if it were compressed. Each
+// part of a multi-part file has a header.
+const size_t kMaxExrHeaderSize = 1024 * 1024;
+
+// JPEG markers are only searched for the frame header this far into
+// the file.
+const size_t kMaxJpegHeaderSize = 256 * 1024;
+
+// The bytes of one sample of each OpenEXR pixel type; UINT, HALF and
+// FLOAT.
+const uint32_t kExrPixelTypeSizes[] = {4, 2, 4};
+
+// The scan lines in each chunk, for each OpenEXR compression; NONE,
+// RLE, ZIPS, ZIP, PIZ, PXR24, B44, B44A, DWAA and DWAB.
+const int32_t kExrLinesPerChunk[] = {1, 1, 1, 16, 32, 16, 32, 32, 32, 256};
+
+uint16_t read_uint16_be(const uint8_t *bytes) {
+    return static_cast<uint16_t>(
+        (static_cast<uint32_t>(bytes[0]) << 8)
+        | static_cast<uint32_t>(bytes[1]));
+}
+
+uint32_t read_uint32_be(const uint8_t *bytes) {
+    return (static_cast<uint32_t>(bytes[0]) << 24)
+        | (static_cast<uint32_t>(bytes[1]) << 16)
+        | (static_cast<uint32_t>(bytes[2]) << 8)
+        | static_cast<uint32_t>(bytes[3]);
+}
+
+// A part with equal display and data windows starting at zero, and
+// the named channels.
+Part make_part(
+        const int32_t width,
+        const int32_t height,
+        const char *const *channel_names,
+        const size_t channel_count,
+        const uint32_t sample_size) {
+    Part part;
+    part.display_max_x = width - 1;
+    part.display_max_y = height - 1;
+    part.data_max_x = width - 1;
+    part.data_max_y = height - 1;
+    for (size_t i = 0; i < channel_count; ++i) {
+        Channel channel;
+        channel.name = channel_names[i];
+        channel.sample_size = sample_size;
+        part.channels.push_back(channel);
+    }
+    return part;
+}
+
+// Parse the value of a 'chlist' attribute; each channel is a name,
+// the pixel type, the linear flag, three reserved bytes and the X
+// and Y sampling, ending with an empty name.
+bool parse_exr_channels(
+        const std::vector<uint8_t> &value,
+        std::vector<Channel> &channels) {
+    channels.clear();
+    size_t offset = 0;
+    while (offset < value.size()) {
+        const auto name_begin = value.begin() + offset;
+        const auto name_end = std::find(name_begin, value.end(), 0);
+        if (name_end == value.end()) {
+            return false;
+        }
+        if (name_end == name_begin) {
+            return true;
+        }
+        offset += (name_end - name_begin) + 1;
+        if ((offset + 16) > value.size()) {
+            return false;
+        }
+        const uint32_t pixel_type = read_uint32_le(value.data() + offset);
+        if (pixel_type > 2) {
+            return false;
+        }
+        Channel channel;
+        channel.name = std::string(name_begin, name_end);
+        channel.sample_size = kExrPixelTypeSizes[pixel_type];
+        channel.x_sampling =
+            static_cast<int32_t>(read_uint32_le(value.data() + offset + 8));
+        channel.y_sampling =
+            static_cast<int32_t>(read_uint32_le(value.data() + offset + 12));
+        channels.push_back(channel);
+        offset += 16;
+    }
+    return false;
+}
+
+// Read one OpenEXR header; a list of attributes, each a name, a type
+// name, a little-endian 32-bit size and the value, ending with an
+// empty name.
+bool read_exr_header(
+        std::ifstream &file,
+        const bool is_tiled_file,
+        Part &part) {
+    part = Part();
+    part.is_tiled = is_tiled_file;
+    bool has_display_window = false;
+    bool has_data_window = false;
+    bool has_channels = false;
+    std::vector<uint8_t> value;
+    while (static_cast<size_t>(file.tellg()) < kMaxExrHeaderSize) {
+        std::string name;
+        std::string type_name;
+        if (!std::getline(file, name, '\0')) {
+            return false;
+        }
+        if (name.empty()) {
+            return part.has_compression
+                && has_display_window
+                && has_data_window
+                && has_channels;
+        }
+        if (!std::getline(file, type_name, '\0')) {
+            return false;
+        }
+        std::array<uint8_t, 4> size_bytes;
+        file.read(reinterpret_cast<char *>(size_bytes.data()), size_bytes.size());
+        if (file.gcount() != static_cast<std::streamsize>(size_bytes.size())) {
+            return false;
+        }
+        const uint32_t size = read_uint32_le(size_bytes.data());
+        if (size > kMaxExrHeaderSize) {
+            return false;
+        }
+        value.resize(size);
+        file.read(reinterpret_cast<char *>(value.data()), size);
+        if (file.gcount() != static_cast<std::streamsize>(size)) {
+            return false;
+        }
+
+        if ((name == "compression") && (size == 1)) {
+            part.has_compression = true;
+            part.compression = value[0];
+        } else if (((name == "displayWindow") || (name == "dataWindow"))
+                   && (size == 16)) {
+            const int32_t min_x =
+                static_cast<int32_t>(read_uint32_le(value.data()));
+            const int32_t min_y =
+                static_cast<int32_t>(read_uint32_le(value.data() + 4));
+            const int32_t max_x =
+                static_cast<int32_t>(read_uint32_le(value.data() + 8));
+            const int32_t max_y =
+                static_cast<int32_t>(read_uint32_le(value.data() + 12));
+            if (name == "displayWindow") {
+                has_display_window = true;
+                part.display_min_x = min_x;
+                part.display_min_y = min_y;
+                part.display_max_x = max_x;
+                part.display_max_y = max_y;
+            } else {
+                has_data_window = true;
+                part.data_min_x = min_x;
+                part.data_min_y = min_y;
+                part.data_max_x = max_x;
+                part.data_max_y = max_y;
+            }
+        } else if (name == "channels") {
+            has_channels = parse_exr_channels(value, part.channels);
+        } else if (name == "name") {
+            part.name = std::string(value.begin(), value.end());
+        } else if (name == "type") {
+            const std::string type(value.begin(), value.end());
+            part.is_tiled = (type == "tiledimage") || (type == "deeptile");
+            part.is_deep = (type == "deepscanline") || (type == "deeptile");
+        } else if ((name == "chunkCount") && (size == 4)) {
+            part.chunk_count = static_cast<int32_t>(read_uint32_le(value.data()));
+        } else if ((type_name == "string")
+                   && ((name == "oiio:ColorSpace")
+                       || (name == "colorSpace")
+                       || (name == "colorspace"))) {
+            part.color_space = std::string(value.begin(), value.end());
+        }
+    }
+    return false;
+}
+
+bool read_exr_file_header(
+        std::ifstream &file,
+        const uint32_t version,
+        ImageHeader &header) {
+    const bool is_tiled_file = (version & kExrTiledFlag) != 0;
+    const bool is_multi_part = (version & kExrMultiPartFlag) != 0;
+
+    // Multi-part files have one header per part, ending with an
+    // empty header.
+    std::vector<Part> parts;
+    while (true) {
+        Part part;
+        if (!read_exr_header(file, is_tiled_file, part)) {
+            return true;
+        }
+        parts.push_back(part);
+        if (!is_multi_part) {
+            break;
+        }
+        if (file.peek() == 0) {
+            file.get();
+            break;
+        }
+        if (!file) {
+            return true;
+        }
+    }
+
+    // Single-part scan line files do not store their chunk count.
+    for (auto &part : parts) {
+        const bool has_lines = part.data_max_y >= part.data_min_y;
+        const int32_t lines_per_chunk = exr_lines_per_chunk(part.compression);
+        if ((part.chunk_count < 0) && !part.is_tiled && has_lines
+            && (lines_per_chunk > 0)) {
+            const int32_t line_count = (part.data_max_y - part.data_min_y) + 1;
+            part.chunk_count =
+                (line_count + lines_per_chunk - 1) / lines_per_chunk;
+        }
+    }
+
+    header.format = FileFormat::kExr;
+    header.is_multi_part = is_multi_part;
+    header.header_size = static_cast<size_t>(file.tellg());
+    header.parts = parts;
+    header.is_uncompressed = true;
+    for (const auto &part : parts) {
+        header.is_uncompressed = header.is_uncompressed
+            && (part.compression == kExrNoCompression) && !part.is_deep;
+    }
+    return true;
+}
+
+// The image information header follows the 768 byte file information
+// header; the first image element describes the channels.
+bool read_dpx_file_header(
+        std::ifstream &file,
+        const bool is_big_endian,
+        ImageHeader &header) {
+    std::array<uint8_t, 804> bytes;
+    file.seekg(0);
+    file.read(reinterpret_cast<char *>(bytes.data()), bytes.size());
+    if (file.gcount() != static_cast<std::streamsize>(bytes.size())) {
+        return true;
+    }
+    const uint32_t width = is_big_endian
+        ? read_uint32_be(bytes.data() + 772)
+        : read_uint32_le(bytes.data() + 772);
+    const uint32_t height = is_big_endian
+        ? read_uint32_be(bytes.data() + 776)
+        : read_uint32_le(bytes.data() + 776);
+    const uint8_t descriptor = bytes[800];
+    const uint8_t transfer = bytes[801];
+    const uint8_t bit_size = bytes[803];
+
+    static const char *const kLuminance[] = {"Y"};
+    static const char *const kAlpha[] = {"A"};
+    static const char *const kRgb[] = {"R", "G", "B"};
+    static const char *const kRgba[] = {"R", "G", "B", "A"};
+    const char *const *channel_names = kRgb;
+    size_t channel_count = 3;
+    if (descriptor == 4) {
+        channel_names = kAlpha;
+        channel_count = 1;
+    } else if (descriptor == 6) {
+        channel_names = kLuminance;
+        channel_count = 1;
+    } else if ((descriptor == 51) || (descriptor == 52)) {
+        channel_names = kRgba;
+        channel_count = 4;
+    }
+    const uint32_t sample_size = bit_size <= 8 ? 1 : (bit_size <= 16 ? 2 : 4);
+    Part part = make_part(
+        static_cast<int32_t>(width), static_cast<int32_t>(height),
+        channel_names, channel_count, sample_size);
+    if (transfer == 2) {
+        part.color_space = "linear";
+    } else if ((transfer == 1) || (transfer == 3)) {
+        part.color_space = "log";
+    } else if (transfer == 6) {
+        part.color_space = "rec709";
+    }
+
+    header.format = FileFormat::kDpx;
+    header.is_uncompressed = true;
+    header.parts.push_back(part);
+    return true;
+}
+
+// The IHDR chunk is the first chunk after the signature.
+bool read_png_file_header(std::ifstream &file, ImageHeader &header) {
+    std::array<uint8_t, 26> bytes;
+    file.seekg(0);
+    file.read(reinterpret_cast<char *>(bytes.data()), bytes.size());
+    if ((file.gcount() != static_cast<std::streamsize>(bytes.size()))
+        || (bytes[12] != 'I') || (bytes[13] != 'H')
+        || (bytes[14] != 'D') || (bytes[15] != 'R')) {
+        return true;
+    }
+    const uint32_t width = read_uint32_be(bytes.data() + 16);
+    const uint32_t height = read_uint32_be(bytes.data() + 20);
+    const uint8_t bit_depth = bytes[24];
+    const uint8_t color_type = bytes[25];
+
+    static const char *const kLuminance[] = {"Y"};
+    static const char *const kLuminanceAlpha[] = {"Y", "A"};
+    static const char *const kRgb[] = {"R", "G", "B"};
+    static const char *const kRgba[] = {"R", "G", "B", "A"};
+    const char *const *channel_names = kRgb;
+    size_t channel_count = 3;
+    if (color_type == 0) {
+        channel_names = kLuminance;
+        channel_count = 1;
+    } else if (color_type == 4) {
+        channel_names = kLuminanceAlpha;
+        channel_count = 2;
+    } else if (color_type == 6) {
+        channel_names = kRgba;
+        channel_count = 4;
+    }
+    const uint32_t sample_size = bit_depth == 16 ? 2 : 1;
+    header.format = FileFormat::kPng;
+    header.parts.push_back(make_part(
+        static_cast<int32_t>(width), static_cast<int32_t>(height),
+        channel_names, channel_count, sample_size));
+    return true;
+}
+
+// Search the markers for the start of the frame; each marker is 0xFF,
+// the marker type and (for most types) a big-endian 16-bit size.
+bool read_jpeg_file_header(std::ifstream &file, ImageHeader &header) {
+    file.seekg(2);
+    while (static_cast<size_t>(file.tellg()) < kMaxJpegHeaderSize) {
+        std::array<uint8_t, 4> marker;
+        file.read(reinterpret_cast<char *>(marker.data()), marker.size());
+        if ((file.gcount() != static_cast<std::streamsize>(marker.size()))
+            || (marker[0] != 0xFF)) {
+            return true;
+        }
+        const uint8_t type = marker[1];
+        const uint16_t size = read_uint16_be(marker.data() + 2);
+        const bool is_start_of_frame =
+            (type >= 0xC0) && (type <= 0xCF)
+            && (type != 0xC4) && (type != 0xC8) && (type != 0xCC);
+        if (!is_start_of_frame) {
+            if (size < 2) {
+                return true;
+            }
+            file.seekg(size - 2, std::ios::cur);
+            continue;
+        }
+
+        std::array<uint8_t, 6> frame;
+        file.read(reinterpret_cast<char *>(frame.data()), frame.size());
+        if (file.gcount() != static_cast<std::streamsize>(frame.size())) {
+            return true;
+        }
+        const uint8_t precision = frame[0];
+        const uint16_t height = read_uint16_be(frame.data() + 1);
+        const uint16_t width = read_uint16_be(frame.data() + 3);
+        const uint8_t component_count = frame[5];
+
+        static const char *const kLuminance[] = {"Y"};
+        static const char *const kRgb[] = {"R", "G", "B"};
+        const bool is_luminance = component_count == 1;
+        header.format = FileFormat::kJpeg;
+        header.parts.push_back(make_part(
+            static_cast<int32_t>(width), static_cast<int32_t>(height),
+            is_luminance ? kLuminance : kRgb,
+            is_luminance ? 1 : 3,
+            precision > 8 ? 2 : 1));
+        return true;
+    }
+    return true;
+}
+
+} // namespace
+
+uint32_t read_uint32_le(const uint8_t *bytes) {
+    return static_cast<uint32_t>(bytes[0])
+        | (static_cast<uint32_t>(bytes[1]) << 8)
+        | (static_cast<uint32_t>(bytes[2]) << 16)
+        | (static_cast<uint32_t>(bytes[3]) << 24);
+}
+
+uint64_t read_uint64_le(const uint8_t *bytes) {
+    return static_cast<uint64_t>(read_uint32_le(bytes))
+        | (static_cast<uint64_t>(read_uint32_le(bytes + 4)) << 32);
+}
+
+int32_t exr_lines_per_chunk(const uint8_t compression) {
+    const size_t count = sizeof(kExrLinesPerChunk) / sizeof(kExrLinesPerChunk[0]);
+    if (compression >= count) {
+        return 0;
+    }
+    return kExrLinesPerChunk[compression];
+}
+
+// OpenEXR files (including the disk cache files written by OCG) are
+// uncompressed when the 'compression' header attribute is
+// NO_COMPRESSION. DPX files are always uncompressed.
+bool read_header(const std::string &file_path, ImageHeader &header) {
+    header = ImageHeader();
+    std::ifstream file(file_path, std::ios::in | std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::array<uint8_t, 8> magic;
+    file.read(reinterpret_cast<char *>(magic.data()), magic.size());
+    if (file.gcount() != static_cast<std::streamsize>(magic.size())) {
+        return false;
+    }
+
+    const bool is_exr =
+        (magic[0] == 0x76) && (magic[1] == 0x2f)
+        && (magic[2] == 0x31) && (magic[3] == 0x01);
+    if (is_exr) {
+        return read_exr_file_header(file, read_uint32_le(magic.data() + 4), header);
+    }
+
+    const bool is_dpx_big_endian =
+        (magic[0] == 'S') && (magic[1] == 'D')
+        && (magic[2] == 'P') && (magic[3] == 'X');
+    const bool is_dpx_little_endian =
+        (magic[0] == 'X') && (magic[1] == 'P')
+        && (magic[2] == 'D') && (magic[3] == 'S');
+    if (is_dpx_big_endian || is_dpx_little_endian) {
+        return read_dpx_file_header(file, is_dpx_big_endian, header);
+    }
+
+    const bool is_png =
+        (magic[0] == 0x89) && (magic[1] == 'P')
+        && (magic[2] == 'N') && (magic[3] == 'G');
+    if (is_png) {
+        return read_png_file_header(file, header);
+    }
+
+    const bool is_jpeg = (magic[0] == 0xFF) && (magic[1] == 0xD8);
+    if (is_jpeg) {
+        return read_jpeg_file_header(file, header);
+    }
+    return true;
+}
+
+} // namespace image_header
+} // namespace open_comp_graph_maya
@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2021 David Cattermole.
+ *
+ * This file is part of OpenCompGraphMaya.
+ *
+ * OpenCompGraphMaya is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * OpenCompGraphMaya is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OpenCompGraphMaya.  If not, see <https://www.gnu.org/licenses/>.
+ * ====================================================================
+ *
+ * Read the headers of image files, without reading their pixels.
+ *
+ * OpenEXR headers are read completely (every part, its windows,
+ * channels, compression and chunk count), so the offset tables and
+ * chunks of the pixels can be found in the file. Of DPX, PNG and JPEG
+ * files only the resolution and channels are read.
+ */
+
+#ifndef OPENCOMPGRAPHMAYA_IMAGE_HEADER_H
+#define OPENCOMPGRAPHMAYA_IMAGE_HEADER_H
+
+// STL
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace open_comp_graph_maya {
+namespace image_header {
+
+// The value of the 'compression' attribute for uncompressed OpenEXR
+// files, as defined by the OpenEXR file layout.
+const uint8_t kExrNoCompression = 0;
+
+enum class FileFormat : uint8_t {
+    kUnknown = 0,
+    kExr,
+    kDpx,
+    kPng,
+    kJpeg,
+};
+
+// A channel of an image part.
+struct Channel {
+    Channel()
+        : sample_size(0)
+        , x_sampling(1)
+        , y_sampling(1) {}
+
+    std::string name;
+
+    // The bytes of one sample in the file; zero when unknown.
+    uint32_t sample_size;
+    int32_t x_sampling;
+    int32_t y_sampling;
+};
+
+// A part of an image file; only multi-part OpenEXR files have more
+// than one.
+struct Part {
+    Part()
+        : compression(0)
+        , has_compression(false)
+        , is_tiled(false)
+        , is_deep(false)
+        , chunk_count(-1)
+        , display_min_x(0)
+        , display_min_y(0)
+        , display_max_x(-1)
+        , display_max_y(-1)
+        , data_min_x(0)
+        , data_min_y(0)
+        , data_max_x(-1)
+        , data_max_y(-1) {}
+
+    std::string name;
+
+    // OpenEXR compression; zero for other formats.
+    uint8_t compression;
+    bool has_compression;
+    bool is_tiled;
+    bool is_deep;
+
+    // The entries of the part's OpenEXR offset table; -1 when not
+    // known.
+    int32_t chunk_count;
+
+    // The maximum is inclusive and Y increases downwards, as stored
+    // in OpenEXR files. Other formats have equal windows starting at
+    // zero.
+    int32_t display_min_x;
+    int32_t display_min_y;
+    int32_t display_max_x;
+    int32_t display_max_y;
+    int32_t data_min_x;
+    int32_t data_min_y;
+    int32_t data_max_x;
+    int32_t data_max_y;
+
+    // OpenEXR channels are sorted by name, which is the order of the
+    // channels in each scan line.
+    std::vector<Channel> channels;
+
+    // The color space named by the file; empty when not known.
+    std::string color_space;
+};
+
+// What the start of a file says about its image and where its pixels
+// are.
+struct ImageHeader {
+    ImageHeader()
+        : format(FileFormat::kUnknown)
+        , is_uncompressed(false)
+        , is_multi_part(false)
+        , header_size(0) {}
+
+    // Files with incomplete headers have an unknown format.
+    FileFormat format;
+
+    // The bytes on disk are the pixels the decoder will use.
+    bool is_uncompressed;
+
+    // The offset tables of OpenEXR parts, in order, follow the
+    // headers, which end at 'header_size'.
+    bool is_multi_part;
+    size_t header_size;
+
+    std::vector<Part> parts;
+};
+
+uint32_t read_uint32_le(const uint8_t *bytes);
+uint64_t read_uint64_le(const uint8_t *bytes);
+
+// The scan lines in each chunk of an OpenEXR part with
+// 'compression'; zero when the compression is not known.
+int32_t exr_lines_per_chunk(const uint8_t compression);
+
+// Read the header of 'file_path'. Returns false when the file cannot
+// be read; files of unknown formats (or with incomplete headers)
+// return true with an unknown format.
+bool read_header(const std::string &file_path, ImageHeader &header);
+
+} // namespace image_header
+} // namespace open_comp_graph_maya
+
+#endif // OPENCOMPGRAPHMAYA_IMAGE_HEADER_H
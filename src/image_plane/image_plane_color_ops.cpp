@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2021 David Cattermole.
+ *
+ * This file is part of OpenCompGraphMaya.
+ *
+ * OpenCompGraphMaya is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * OpenCompGraphMaya is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OpenCompGraphMaya.  If not, see <https://www.gnu.org/licenses/>.
+ * ====================================================================
+ *
+ * Identify the color operations of a stream, so the color-ops LUTs
+ * are only baked when an upstream color operation changes.
+ */
+
+// Maya
+#include <maya/MObject.h>
+#include <maya/MPlug.h>
+#include <maya/MFn.h>
+#include <maya/MFnDependencyNode.h>
+#include <maya/MItDependencyGraph.h>
+
+// STL
+#include <cstring>
+
+// OCG Maya
+#include <comp_nodes/color_grade_node.h>
+#include "image_plane_color_ops.h"
+
+namespace open_comp_graph_maya {
+namespace image_plane {
+namespace color_ops {
+
+bool ColorOpsKey::operator==(const ColorOpsKey &other) const {
+    return (hash == other.hash)
+        && (color_ops_len == other.color_ops_len);
+}
+
+bool ColorOpsKey::operator!=(const ColorOpsKey &other) const {
+    return !(*this == other);
+}
+
+namespace {
+
+// 64-bit FNV-1a.
+const uint64_t kHashOffsetBasis = 14695981039346656037ULL;
+const uint64_t kHashPrime = 1099511628211ULL;
+
+uint64_t hash_bytes(uint64_t hash, const void *data, const size_t size) {
+    auto bytes = static_cast<const uint8_t *>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<uint64_t>(bytes[i]);
+        hash *= kHashPrime;
+    }
+    return hash;
+}
+
+uint64_t hash_float(uint64_t hash, float value) {
+    // Both zeros give the same color.
+    if (value == 0.0f) {
+        value = 0.0f;
+    }
+    uint32_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return hash_bytes(hash, &bits, sizeof(bits));
+}
+
+uint64_t hash_bool(uint64_t hash, const bool value) {
+    const uint8_t byte = value ? 1 : 0;
+    return hash_bytes(hash, &byte, sizeof(byte));
+}
+
+uint64_t hash_color_grade_node(uint64_t hash, const MObject &node) {
+    const MObject bool_attrs[] = {
+        ColorGradeNode::m_process_r_attr,
+        ColorGradeNode::m_process_g_attr,
+        ColorGradeNode::m_process_b_attr,
+        ColorGradeNode::m_process_a_attr,
+        ColorGradeNode::m_reverse_attr,
+        ColorGradeNode::m_clamp_black_attr,
+        ColorGradeNode::m_clamp_white_attr,
+        ColorGradeNode::m_premult_attr,
+    };
+    const MObject float_attrs[] = {
+        ColorGradeNode::m_black_point_r_attr,
+        ColorGradeNode::m_black_point_g_attr,
+        ColorGradeNode::m_black_point_b_attr,
+        ColorGradeNode::m_black_point_a_attr,
+        ColorGradeNode::m_white_point_r_attr,
+        ColorGradeNode::m_white_point_g_attr,
+        ColorGradeNode::m_white_point_b_attr,
+        ColorGradeNode::m_white_point_a_attr,
+        ColorGradeNode::m_lift_r_attr,
+        ColorGradeNode::m_lift_g_attr,
+        ColorGradeNode::m_lift_b_attr,
+        ColorGradeNode::m_lift_a_attr,
+        ColorGradeNode::m_gain_r_attr,
+        ColorGradeNode::m_gain_g_attr,
+        ColorGradeNode::m_gain_b_attr,
+        ColorGradeNode::m_gain_a_attr,
+        ColorGradeNode::m_multiply_r_attr,
+        ColorGradeNode::m_multiply_g_attr,
+        ColorGradeNode::m_multiply_b_attr,
+        ColorGradeNode::m_multiply_a_attr,
+        ColorGradeNode::m_offset_r_attr,
+        ColorGradeNode::m_offset_g_attr,
+        ColorGradeNode::m_offset_b_attr,
+        ColorGradeNode::m_offset_a_attr,
+        ColorGradeNode::m_gamma_r_attr,
+        ColorGradeNode::m_gamma_g_attr,
+        ColorGradeNode::m_gamma_b_attr,
+        ColorGradeNode::m_gamma_a_attr,
+        ColorGradeNode::m_mix_attr,
+    };
+
+    const uint32_t type_id = ColorGradeNode::m_id.id();
+    hash = hash_bytes(hash, &type_id, sizeof(type_id));
+    for (auto &attr : bool_attrs) {
+        hash = hash_bool(hash, MPlug(node, attr).asBool());
+    }
+    for (auto &attr : float_attrs) {
+        hash = hash_float(hash, MPlug(node, attr).asFloat());
+    }
+    return hash;
+}
+
+} // namespace
+
+MStatus find_upstream_color_ops_key(
+        const MPlug &plug,
+        ColorOpsKey &key) {
+    MStatus status;
+    key = ColorOpsKey();
+    key.hash = kHashOffsetBasis;
+    if (plug.isNull()) {
+        return MS::kSuccess;
+    }
+
+    // All OCG nodes are plug-in nodes, anything else (such as the
+    // 'time' node) ends the traversal.
+    MPlug root_plug(plug);
+    MItDependencyGraph it(
+        root_plug,
+        MFn::kPluginDependNode,
+        MItDependencyGraph::kUpstream,
+        MItDependencyGraph::kDepthFirst,
+        MItDependencyGraph::kNodeLevel,
+        &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    for (; !it.isDone(); it.next()) {
+        MObject node = it.currentItem();
+        MFnDependencyNode fn_node(node, &status);
+        if (!status || fn_node.typeId() != ColorGradeNode::m_id) {
+            continue;
+        }
+
+        MPlug enable_plug(node, ColorGradeNode::m_enable_attr);
+        if (!enable_plug.asBool()) {
+            continue;
+        }
+
+        key.hash = hash_color_grade_node(key.hash, node);
+        key.color_ops_len += 1;
+    }
+    return MS::kSuccess;
+}
+
+bool is_key_valid(
+        const ColorOpsKey &key,
+        const size_t stream_color_ops_len) {
+    return (stream_color_ops_len > 0)
+        && (key.color_ops_len == stream_color_ops_len);
+}
+
+} // namespace color_ops
+} // namespace image_plane
+} // namespace open_comp_graph_maya
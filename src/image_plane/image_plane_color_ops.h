@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2021 David Cattermole.
+ *
+ * This file is part of OpenCompGraphMaya.
+ *
+ * OpenCompGraphMaya is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * OpenCompGraphMaya is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OpenCompGraphMaya.  If not, see <https://www.gnu.org/licenses/>.
+ * ====================================================================
+ *
+ * Identify the color operations of a stream, so the color-ops LUTs
+ * are only baked when an upstream color operation changes.
+ */
+
+#ifndef OPENCOMPGRAPHMAYA_IMAGE_PLANE_COLOR_OPS_H
+#define OPENCOMPGRAPHMAYA_IMAGE_PLANE_COLOR_OPS_H
+
+// Maya
+#include <maya/MPlug.h>
+#include <maya/MStatus.h>
+
+// STL
+#include <cstdint>
+
+namespace open_comp_graph_maya {
+namespace image_plane {
+namespace color_ops {
+
+// The parameters of all enabled color operation nodes upstream of a
+// stream, reduced to a single hash.
+struct ColorOpsKey {
+    ColorOpsKey()
+        : hash(0)
+        , color_ops_len(0) {}
+
+    bool operator==(const ColorOpsKey &other) const;
+    bool operator!=(const ColorOpsKey &other) const;
+
+    uint64_t hash;
+    size_t color_ops_len;
+};
+
+// Hash the parameters of the enabled color operation nodes upstream
+// of 'plug', nearest node first.
+MStatus find_upstream_color_ops_key(
+    const MPlug &plug,
+    ColorOpsKey &key);
+
+// Do the upstream nodes found account for all of the stream's color
+// operations? If not, the key cannot identify the color operations
+// and the LUTs must be baked every time.
+bool is_key_valid(
+    const ColorOpsKey &key,
+    const size_t stream_color_ops_len);
+
+} // namespace color_ops
+} // namespace image_plane
+} // namespace open_comp_graph_maya
+
+#endif // OPENCOMPGRAPHMAYA_IMAGE_PLANE_COLOR_OPS_H
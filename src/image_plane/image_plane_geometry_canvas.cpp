@@ -27,6 +27,7 @@
 #include <algorithm>
 #include <memory>
 #include <cstdlib>
+#include <cmath>
 
 // OCG
 #include "opencompgraph.h"
@@ -44,11 +45,19 @@ namespace image_plane {
 GeometryCanvas::GeometryCanvas()
         : m_divisions_x(16)
         , m_divisions_y(16)
+        , m_adaptive(false)
+        , m_adaptive_max_level(0)
+        , m_adaptive_tolerance(1.0f)
+        , m_adaptive_deformer()
+        , m_adaptive_display_window()
+        , m_adaptive_data_window()
+        , m_adaptive_cell_errors()
+        , m_geometry()
         , m_position_buffer(nullptr)
-        , m_uv_buffer(nullptr)
-        , m_wire_lines_index_buffer(nullptr)
-        , m_border_lines_index_buffer(nullptr)
-        , m_shaded_index_buffer(nullptr) {}
+        , m_uv_buffer()
+        , m_wire_lines_index_buffer()
+        , m_border_lines_index_buffer()
+        , m_shaded_index_buffer() {}
 
 GeometryCanvas::~GeometryCanvas() {
     this->clear_all();
@@ -63,12 +72,112 @@ size_t GeometryCanvas::divisions_y() const noexcept {
     return m_divisions_y;
 }
 
+bool GeometryCanvas::has_geometry() const noexcept {
+    return static_cast<bool>(m_geometry);
+}
+
 void GeometryCanvas::set_divisions_x(size_t value) {
-    m_divisions_x = std::max<size_t>(2, value);
+    value = std::max<size_t>(2, value);
+    if (value != m_divisions_x) {
+        m_geometry.reset();
+    }
+    m_divisions_x = value;
 }
 
 void GeometryCanvas::set_divisions_y(size_t value) {
-    m_divisions_y = std::max<size_t>(2, value);
+    value = std::max<size_t>(2, value);
+    if (value != m_divisions_y) {
+        m_geometry.reset();
+    }
+    m_divisions_y = value;
+}
+
+static bool bbox_is_equal(const ocg::BBox2Di &a, const ocg::BBox2Di &b) {
+    return (a.min_x == b.min_x)
+        && (a.min_y == b.min_y)
+        && (a.max_x == b.max_x)
+        && (a.max_y == b.max_y);
+}
+
+void GeometryCanvas::set_adaptive(
+        const bool enable,
+        const uint32_t max_level,
+        const float tolerance,
+        const lens_deformer::LensDeformer &deformer,
+        const ocg::BBox2Di &display_window,
+        const ocg::BBox2Di &data_window) {
+    bool has_changed = enable != m_adaptive;
+    bool deformer_has_changed = false;
+    if (enable) {
+        has_changed = has_changed
+            || (max_level != m_adaptive_max_level)
+            || (tolerance != m_adaptive_tolerance)
+            || !bbox_is_equal(display_window, m_adaptive_display_window)
+            || !bbox_is_equal(data_window, m_adaptive_data_window);
+        deformer_has_changed = deformer != m_adaptive_deformer;
+    }
+    if (!has_changed && !deformer_has_changed) {
+        return;
+    }
+
+    // Lens edits (and animated lenses) move the vertices in the
+    // shader; the cells only need re-building when the deformation
+    // error they were built for has moved by more than the
+    // tolerance.
+    if (!has_changed && m_geometry) {
+        m_adaptive_deformer = deformer;
+        std::vector<float> cell_errors;
+        geometry_buffer::adaptive_canvas_cell_errors(
+            m_divisions_x, m_divisions_y,
+            lens_deformer::canvas_deform_function(
+                deformer, display_window, data_window),
+            cell_errors);
+        if (cell_errors.size() == m_adaptive_cell_errors.size()) {
+            bool errors_have_changed = false;
+            for (size_t i = 0; i < cell_errors.size(); ++i) {
+                const float difference =
+                    std::abs(cell_errors[i] - m_adaptive_cell_errors[i]);
+                if (difference > tolerance) {
+                    errors_have_changed = true;
+                    break;
+                }
+            }
+            if (!errors_have_changed) {
+                return;
+            }
+        }
+    }
+    m_adaptive = enable;
+    m_adaptive_max_level = max_level;
+    m_adaptive_tolerance = tolerance;
+    m_adaptive_deformer = deformer;
+    m_adaptive_display_window = display_window;
+    m_adaptive_data_window = data_window;
+    m_geometry.reset();
+}
+
+void GeometryCanvas::hold_geometry() {
+    if (m_geometry) {
+        return;
+    }
+    if (m_adaptive) {
+        auto deform_function = lens_deformer::canvas_deform_function(
+            m_adaptive_deformer,
+            m_adaptive_display_window,
+            m_adaptive_data_window);
+        m_geometry = geometry_buffer::build_adaptive_canvas_geometry(
+            m_divisions_x, m_divisions_y,
+            m_adaptive_max_level,
+            m_adaptive_tolerance,
+            deform_function);
+        geometry_buffer::adaptive_canvas_cell_errors(
+            m_divisions_x, m_divisions_y,
+            deform_function,
+            m_adaptive_cell_errors);
+    } else {
+        m_geometry = geometry_buffer::get_canvas_geometry(
+            m_divisions_x, m_divisions_y);
+    }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -76,47 +185,67 @@ void GeometryCanvas::set_divisions_y(size_t value) {
 void GeometryCanvas::fill_vertex_buffer_positions(
         MHWRender::MVertexBuffer *vertex_buffer,
         ocg::StreamData &stream_data) {
+    this->hold_geometry();
+    geometry_buffer::generate_vertex_positions(
+        vertex_buffer,
+        *m_geometry,
+        stream_data);
+    return;
+}
+
+void GeometryCanvas::fill_vertex_buffer_positions(
+        MHWRender::MVertexBuffer *vertex_buffer) {
+    this->hold_geometry();
+    geometry_buffer::generate_vertex_positions(
+        vertex_buffer,
+        *m_geometry);
+    return;
+}
+
+void GeometryCanvas::fill_vertex_buffer_positions(
+        MHWRender::MVertexBuffer *vertex_buffer,
+        const geometry_buffer::CanvasPositionsDeformFunction &deform_function) {
+    this->hold_geometry();
     geometry_buffer::generate_vertex_positions(
         vertex_buffer,
-        m_divisions_x,
-        m_divisions_y,
-        std::move(stream_data));
+        *m_geometry,
+        deform_function);
     return;
 }
 
 void GeometryCanvas::fill_vertex_buffer_uvs(
         MHWRender::MVertexBuffer *vertex_buffer) {
+    this->hold_geometry();
     geometry_buffer::generate_vertex_uvs(
         vertex_buffer,
-        m_divisions_x,
-        m_divisions_y);
+        *m_geometry);
     return;
 }
 
 void GeometryCanvas::fill_index_buffer_triangles(
         MHWRender::MIndexBuffer* index_buffer) {
+    this->hold_geometry();
     geometry_buffer::generate_index_triangles(
         index_buffer,
-        m_divisions_x,
-        m_divisions_y);
+        *m_geometry);
     return;
 }
 
 void GeometryCanvas::fill_index_buffer_border_lines(
         MHWRender::MIndexBuffer* index_buffer) {
+    this->hold_geometry();
     geometry_buffer::generate_index_border_lines(
         index_buffer,
-        m_divisions_x,
-        m_divisions_y);
+        *m_geometry);
     return;
 }
 
 void GeometryCanvas::fill_index_buffer_wire_lines(
         MHWRender::MIndexBuffer* index_buffer) {
+    this->hold_geometry();
     geometry_buffer::generate_index_wire_lines(
         index_buffer,
-        m_divisions_x,
-        m_divisions_y);
+        *m_geometry);
     return;
 }
 
@@ -127,68 +256,63 @@ MHWRender::MVertexBuffer* GeometryCanvas::vertex_buffer_positions() const noexce
 }
 
 MHWRender::MVertexBuffer* GeometryCanvas::vertex_buffer_uvs() const noexcept {
-    return GeometryCanvas::m_uv_buffer;
+    return GeometryCanvas::m_uv_buffer.get();
 }
 
 MHWRender::MIndexBuffer* GeometryCanvas::index_buffer_triangles() const noexcept {
-    return GeometryCanvas::m_shaded_index_buffer;
+    return GeometryCanvas::m_shaded_index_buffer.get();
 }
 
 MHWRender::MIndexBuffer* GeometryCanvas::index_buffer_border_lines() const noexcept {
-    return GeometryCanvas::m_border_lines_index_buffer;
+    return GeometryCanvas::m_border_lines_index_buffer.get();
 }
 
 MHWRender::MIndexBuffer* GeometryCanvas::index_buffer_wire_lines() const noexcept {
-    return GeometryCanvas::m_wire_lines_index_buffer;
+    return GeometryCanvas::m_wire_lines_index_buffer.get();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
 void GeometryCanvas::rebuild_vertex_buffer_positions(ocg::StreamData &stream_data) {
+    this->hold_geometry();
     this->clear_vertex_positions();
     m_position_buffer = geometry_buffer::build_vertex_buffer_positions(
-        m_divisions_x, m_divisions_y, std::move(stream_data));
+        m_divisions_x, m_divisions_y, stream_data);
 }
 
 void GeometryCanvas::rebuild_vertex_buffer_uvs() {
-    this->clear_vertex_uvs();
-    m_uv_buffer = geometry_buffer::build_vertex_buffer_uvs(
+    this->hold_geometry();
+    m_uv_buffer = geometry_buffer::get_shared_vertex_buffer_uvs(
         m_divisions_x, m_divisions_y);
 }
 
 void GeometryCanvas::rebuild_index_buffer_triangles() {
-    this->clear_index_triangles();
-    m_shaded_index_buffer = geometry_buffer::build_index_buffer_triangles(
+    this->hold_geometry();
+    m_shaded_index_buffer = geometry_buffer::get_shared_index_buffer_triangles(
         m_divisions_x, m_divisions_y);
 }
 
 void GeometryCanvas::rebuild_index_buffer_border_lines() {
-    this->clear_index_border_lines();
-    m_border_lines_index_buffer = geometry_buffer::build_index_buffer_border_lines(
+    this->hold_geometry();
+    m_border_lines_index_buffer = geometry_buffer::get_shared_index_buffer_border_lines(
         m_divisions_x, m_divisions_y);
 }
 
 void GeometryCanvas::rebuild_index_buffer_wire_lines() {
-    this->clear_index_wire_lines();
-    m_wire_lines_index_buffer = geometry_buffer::build_index_buffer_wire_lines(
+    this->hold_geometry();
+    m_wire_lines_index_buffer = geometry_buffer::get_shared_index_buffer_wire_lines(
         m_divisions_x, m_divisions_y);
 }
 
 void GeometryCanvas::rebuild_buffer_all(ocg::StreamData &stream_data) {
     auto log = log::get_logger();
-    this->clear_all();
     log->debug("rebuild_buffer_all geometry buffers");
     log->debug("divisions: {}x{}", m_divisions_x, m_divisions_y);
-    m_position_buffer = geometry_buffer::build_vertex_buffer_positions(
-        m_divisions_x, m_divisions_y, std::move(stream_data));
-    m_uv_buffer = geometry_buffer::build_vertex_buffer_uvs(
-        m_divisions_x, m_divisions_y);
-    m_shaded_index_buffer = geometry_buffer::build_index_buffer_triangles(
-        m_divisions_x, m_divisions_y);
-    m_border_lines_index_buffer = geometry_buffer::build_index_buffer_border_lines(
-        m_divisions_x, m_divisions_y);
-    m_wire_lines_index_buffer = geometry_buffer::build_index_buffer_wire_lines(
-        m_divisions_x, m_divisions_y);
+    this->rebuild_vertex_buffer_positions(stream_data);
+    this->rebuild_vertex_buffer_uvs();
+    this->rebuild_index_buffer_triangles();
+    this->rebuild_index_buffer_border_lines();
+    this->rebuild_index_buffer_wire_lines();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -198,24 +322,21 @@ void GeometryCanvas::clear_vertex_positions() {
     m_position_buffer = nullptr;
 }
 
+// The shared buffers are deleted once the last canvas releases them.
 void GeometryCanvas::clear_vertex_uvs() {
-    delete m_uv_buffer;
-    m_uv_buffer = nullptr;
+    m_uv_buffer.reset();
 }
 
 void GeometryCanvas::clear_index_triangles() {
-    delete m_shaded_index_buffer;
-    m_shaded_index_buffer = nullptr;
+    m_shaded_index_buffer.reset();
 }
 
 void GeometryCanvas::clear_index_border_lines() {
-    delete m_border_lines_index_buffer;
-    m_border_lines_index_buffer = nullptr;
+    m_border_lines_index_buffer.reset();
 }
 
 void GeometryCanvas::clear_index_wire_lines() {
-    delete m_wire_lines_index_buffer;
-    m_wire_lines_index_buffer = nullptr;
+    m_wire_lines_index_buffer.reset();
 }
 
 void GeometryCanvas::clear_all() {
@@ -224,6 +345,7 @@ void GeometryCanvas::clear_all() {
     clear_index_triangles();
     clear_index_border_lines();
     clear_index_wire_lines();
+    m_geometry.reset();
 }
 
 } // namespace image_plane
@@ -42,10 +42,15 @@
 // STL
 #include <map>
 #include <memory>
+#include <vector>
 
 // OCG
 #include "opencompgraph.h"
 
+// OCG Maya
+#include "geometry_buffer.h"
+#include "image_plane_lens_deformer.h"
+
 namespace ocg = open_comp_graph;
 
 namespace open_comp_graph_maya{
@@ -60,11 +65,31 @@ public:
     size_t divisions_x() const noexcept;
     size_t divisions_y() const noexcept;
 
+    // Is the geometry built? Changing the divisions or adaptive
+    // values releases it, to be re-built when next filled.
+    bool has_geometry() const noexcept;
+
     void set_divisions_x(size_t value);
     void set_divisions_y(size_t value);
 
+    // Tessellate the canvas adaptively for the lens deformer, so
+    // cells are only subdivided where the deformation needs it. The
+    // geometry is only re-built when the values change; a changed
+    // deformer only re-builds it when the error of a cell of the
+    // grid moves by more than the tolerance.
+    void set_adaptive(const bool enable,
+                      const uint32_t max_level,
+                      const float tolerance,
+                      const lens_deformer::LensDeformer &deformer,
+                      const ocg::BBox2Di &display_window,
+                      const ocg::BBox2Di &data_window);
+
     void fill_vertex_buffer_positions(MHWRender::MVertexBuffer* vertex_buffer,
                                       ocg::StreamData &stream_data);
+    void fill_vertex_buffer_positions(MHWRender::MVertexBuffer* vertex_buffer);
+    void fill_vertex_buffer_positions(
+        MHWRender::MVertexBuffer* vertex_buffer,
+        const geometry_buffer::CanvasPositionsDeformFunction &deform_function);
     void fill_vertex_buffer_uvs(MHWRender::MVertexBuffer *vertex_buffer);
     void fill_index_buffer_triangles(MHWRender::MIndexBuffer* index_buffer);
     void fill_index_buffer_border_lines(MHWRender::MIndexBuffer* index_buffer);
@@ -98,12 +123,31 @@ private:
     size_t m_divisions_x;
     size_t m_divisions_y;
 
-    // The internal buffer data.
+    // Adaptive tessellation.
+    bool m_adaptive;
+    uint32_t m_adaptive_max_level;
+    float m_adaptive_tolerance;
+    lens_deformer::LensDeformer m_adaptive_deformer;
+    ocg::BBox2Di m_adaptive_display_window;
+    ocg::BBox2Di m_adaptive_data_window;
+
+    // The error of each cell of the uniform grid, for the deformer
+    // the adaptive geometry was built with.
+    std::vector<float> m_adaptive_cell_errors;
+
+    // Hold on to the shared (or adaptive) geometry, so it is not
+    // re-built while this canvas uses it.
+    void hold_geometry();
+    std::shared_ptr<const geometry_buffer::CanvasGeometry> m_geometry;
+
+    // The internal buffer data. Only the positions are unique to
+    // this canvas (they are deformed by the stream), the other
+    // buffers are shared with all canvases using the same divisions.
     MHWRender::MVertexBuffer* m_position_buffer;
-    MHWRender::MVertexBuffer* m_uv_buffer;
-    MHWRender::MIndexBuffer* m_shaded_index_buffer;
-    MHWRender::MIndexBuffer* m_border_lines_index_buffer;
-    MHWRender::MIndexBuffer* m_wire_lines_index_buffer;
+    std::shared_ptr<MHWRender::MVertexBuffer> m_uv_buffer;
+    std::shared_ptr<MHWRender::MIndexBuffer> m_shaded_index_buffer;
+    std::shared_ptr<MHWRender::MIndexBuffer> m_border_lines_index_buffer;
+    std::shared_ptr<MHWRender::MIndexBuffer> m_wire_lines_index_buffer;
 };
 
 } // namespace image_plane
@@ -35,32 +35,55 @@
 #include <maya/MFnPluginData.h>
 #include <maya/MDagMessage.h>
 #include <maya/MSelectionContext.h>
+#include <maya/MObjectHandle.h>
+#include <maya/MFnAttribute.h>
+#include <maya/MNodeMessage.h>
+#include <maya/MDGMessage.h>
+#include <maya/MMessage.h>
+#include <maya/MCallbackIdArray.h>
+#include <maya/MGlobal.h>
 #include <maya/M3dView.h>
+#include <maya/MPointArray.h>
+#include <maya/MColorArray.h>
+#include <maya/MVector.h>
 
 // Maya Viewport 2.0
 #include <maya/MPxGeometryOverride.h>
 #include <maya/MShaderManager.h>
 #include <maya/MStateManager.h>
+#include <maya/MUIDrawManager.h>
+#include <maya/MFrameContext.h>
 
 // STL
+#include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <memory>
+#include <string>
 #include <tuple>
 #include <cstdlib>
 #include <vector>
+#include <mutex>
 
 // OCG
 #include "opencompgraph.h"
 
 // OCG Maya
+#include "cache_container.h"
 #include "constant_texture_data.h"
 #include "image_plane_utils.h"
 #include "image_plane_geometry_override.h"
+#include "image_plane_lut_baker.h"
 #include "image_plane_shape.h"
 #include "graph_data.h"
 #include "graph_execute.h"
+#include "graph_execute_async.h"
 #include "global_cache.h"
+#include "image_spec.h"
+#include "io_pool.h"
 #include "logger.h"
+#include "proxy_resolution.h"
+#include "sequence_index.h"
 #include "node_utils.h"
 
 namespace ocg = open_comp_graph;
@@ -196,14 +219,48 @@ MString GeometryOverride::m_display_window_stream_name = "ocgImagePlaneDisplayWi
 MString GeometryOverride::m_data_window_stream_name = "ocgImagePlaneDataWindowStream";
 
 
+// Idle task queued by the background evaluation thread, so the image
+// plane is re-drawn (on the main thread) once the new image is ready.
+static void request_redraw_task(void *data) {
+    MObjectHandle *node_handle = static_cast<MObjectHandle *>(data);
+    if (node_handle == nullptr) {
+        return;
+    }
+    if (node_handle->isValid()) {
+        MObject node = node_handle->object();
+        MHWRender::MRenderer::setGeometryDrawDirty(node);
+        M3dView::scheduleRefreshAllViews();
+    }
+    delete node_handle;
+}
+
 GeometryOverride::GeometryOverride(const MObject &obj)
         : MHWRender::MPxGeometryOverride(obj)
         , m_locator_node(obj)
-        , m_update_vertices(true)
-        , m_update_topology(true)
+        , m_dirty_index_items()
+        , m_dirty_streams()
         , m_update_shader(true)
         , m_update_shader_border(true)
         , m_exec_status(ocg::ExecuteStatus::kUninitialized)
+        , m_async_executor()
+        , m_lut_baker()
+        , m_stream_data()
+        , m_stream_request_id(0)
+        , m_stream_frame(0.0)
+        , m_requested_frame(0.0)
+        , m_is_stale(false)
+        , m_requested_spec()
+        , m_input_spec()
+        , m_input_spec_plug_name()
+        , m_input_spec_frame(0.0)
+        , m_lens_deformers()
+        , m_deform_in_shader(false)
+        , m_color_ops_key()
+        , m_color_ops_lut_key()
+        , m_color_ops_lut_edge_size(0)
+        , m_has_color_ops_lut(false)
+        , m_viewer_ops()
+        , m_image_scopes()
         , m_display_mode(0)
         , m_display_color()
         , m_display_alpha(1.0f)
@@ -213,12 +270,16 @@ GeometryOverride::GeometryOverride(const MObject &obj)
         , m_display_soft_clip(0.0f)
         , m_display_use_draw_depth(false)
         , m_display_draw_depth(100.0f)
+        , m_display_scopes(kDisplayScopesNone)
         , m_focal_length(35.0f)
         , m_card_depth(1.0f)
         , m_card_size_x(1.0f)
         , m_card_size_y(1.0f)
         , m_card_res_x(16)
         , m_card_res_y(16)
+        , m_card_adaptive(true)
+        , m_card_adaptive_tolerance(0.5f)
+        , m_card_adaptive_max_level(3)
         , m_time(0.0f)
         , m_display_window_width(0)
         , m_display_window_height(0)
@@ -229,28 +290,405 @@ GeometryOverride::GeometryOverride(const MObject &obj)
         , m_lut_edge_size(0)
         , m_from_color_space_name()
         , m_color_space_name()
+        , m_proxy_resolution(proxy::kResolutionUseGlobal)
+        , m_resolved_proxy_resolution(proxy::kResolutionFull)
         , m_disk_cache_enable(false)
         , m_disk_cache_file_path()
+        , m_async_evaluation(true)
+        , m_display_stale_indicator(true)
+        , m_viewer_fast_path(true)
         , m_in_stream_node(ocg::Node(ocg::NodeType::kNull, 0))
+        , m_graph_generation(0)
+        , m_viewer_input_node(ocg::Node(ocg::NodeType::kNull, 0))
+        , m_proxy_node(ocg::Node(ocg::NodeType::kNull, 0))
         , m_viewer_node(ocg::Node(ocg::NodeType::kNull, 0))
-        , m_read_cache_node(ocg::Node(ocg::NodeType::kNull, 0)) {
+        , m_read_cache_node(ocg::Node(ocg::NodeType::kNull, 0))
+        , m_dirty_flags(kDirtyAll)
+        , m_connected_flags(kDirtyNone)
+        , m_connected_flags_dirty(true)
+        , m_callback_ids()
+        , m_camera_node()
+        , m_camera_callback_ids()
+        , m_viewer_input_source_node()
+        , m_viewer_input_callback_ids() {
+    MStatus status;
+
+    // Everything is filled the first time the geometry is drawn.
+    this->markVerticesDirty();
+    this->markTopologyDirty();
+    this->markWindowsDirty();
+    m_dirty_index_items.insert(m_data_window_render_item_name.asChar());
+    m_dirty_index_items.insert(m_display_window_render_item_name.asChar());
+
+    MObjectHandle node_handle(obj);
+    m_async_executor.set_completed_callback([node_handle]() {
+        MGlobal::executeTaskOnIdle(
+            request_redraw_task,
+            new MObjectHandle(node_handle));
+    });
+    m_lut_baker.set_completed_callback([node_handle]() {
+        MGlobal::executeTaskOnIdle(
+            request_redraw_task,
+            new MObjectHandle(node_handle));
+    });
+
+    // Attribute values that are set, and plugs dirtied by incoming
+    // connections (such as time, or the input stream) mark the
+    // attribute groups to be read in the next updateDG().
+    MObject node(obj);
+    MCallbackId callback_id = MNodeMessage::addAttributeChangedCallback(
+        node, GeometryOverride::attributeChangedCallback, this, &status);
+    CHECK_MSTATUS(status);
+    if (status) {
+        m_callback_ids.append(callback_id);
+    }
+    callback_id = MNodeMessage::addNodeDirtyPlugCallback(
+        node, GeometryOverride::nodeDirtyPlugCallback, this, &status);
+    CHECK_MSTATUS(status);
+    if (status) {
+        m_callback_ids.append(callback_id);
+    }
+
+    // With the Evaluation Manager enabled, animated plugs are not
+    // dirtied when the time changes, so connected attributes are
+    // marked dirty when the time changes.
+    callback_id = MDGMessage::addTimeChangeCallback(
+        GeometryOverride::timeChangedCallback, this, &status);
+    CHECK_MSTATUS(status);
+    if (status) {
+        m_callback_ids.append(callback_id);
+    }
 }
 
 GeometryOverride::~GeometryOverride() {
+    if (m_camera_callback_ids.length() > 0) {
+        MMessage::removeCallbacks(m_camera_callback_ids);
+        m_camera_callback_ids.clear();
+    }
+    if (m_viewer_input_callback_ids.length() > 0) {
+        MMessage::removeCallbacks(m_viewer_input_callback_ids);
+        m_viewer_input_callback_ids.clear();
+    }
+    if (m_callback_ids.length() > 0) {
+        MMessage::removeCallbacks(m_callback_ids);
+        m_callback_ids.clear();
+    }
+
+    // Wait for a running evaluation (or LUT bake) before the
+    // override is deleted.
+    m_async_executor.stop();
+    m_lut_baker.stop();
 }
 
+// The attribute group that must be re-read when 'attr' changes.
+uint32_t GeometryOverride::dirtyFlagsFromAttribute(const MObject &attr) {
+    if (attr == ShapeNode::m_in_stream_attr) {
+        return kDirtyInStream;
+    } else if (attr == ShapeNode::m_time_attr) {
+        return kDirtyTime;
+    } else if (attr == ShapeNode::m_camera_attr) {
+        return kDirtyCamera;
+    } else if ((attr == ShapeNode::m_display_mode_attr)
+               || (attr == ShapeNode::m_display_color_attr)
+               || (attr == ShapeNode::m_display_alpha_attr)
+               || (attr == ShapeNode::m_display_saturation_attr)
+               || (attr == ShapeNode::m_display_exposure_attr)
+               || (attr == ShapeNode::m_display_gamma_attr)
+               || (attr == ShapeNode::m_display_soft_clip_attr)
+               || (attr == ShapeNode::m_display_use_draw_depth_attr)
+               || (attr == ShapeNode::m_display_draw_depth_attr)
+               || (attr == ShapeNode::m_display_scopes_attr)) {
+        return kDirtyDisplay;
+    } else if ((attr == ShapeNode::m_card_depth_attr)
+               || (attr == ShapeNode::m_card_size_x_attr)
+               || (attr == ShapeNode::m_card_size_y_attr)) {
+        return kDirtyCard;
+    } else if ((attr == ShapeNode::m_card_res_x_attr)
+               || (attr == ShapeNode::m_card_res_y_attr)
+               || (attr == ShapeNode::m_card_adaptive_attr)
+               || (attr == ShapeNode::m_card_adaptive_tolerance_attr)
+               || (attr == ShapeNode::m_card_adaptive_max_level_attr)) {
+        return kDirtyCardResolution;
+    } else if ((attr == ShapeNode::m_color_space_name_attr)
+               || (attr == ShapeNode::m_lut_edge_size_attr)) {
+        return kDirtyColorSpace;
+    } else if ((attr == ShapeNode::m_cache_option_attr)
+               || (attr == ShapeNode::m_cache_pixel_data_type_attr)
+               || (attr == ShapeNode::m_cache_crop_on_format_attr)
+               || (attr == ShapeNode::m_proxy_resolution_attr)) {
+        return kDirtyCacheOptions;
+    } else if ((attr == ShapeNode::m_disk_cache_enable_attr)
+               || (attr == ShapeNode::m_disk_cache_file_path_attr)) {
+        return kDirtyDiskCache;
+    } else if ((attr == ShapeNode::m_async_evaluation_attr)
+               || (attr == ShapeNode::m_display_stale_indicator_attr)
+               || (attr == ShapeNode::m_viewer_fast_path_attr)) {
+        return kDirtyEvaluation;
+    }
+    return kDirtyNone;
+}
 
-// Generate a 3D volume texture to be used to look up approximations
-// to colour operations.
+// Child plugs (for example 'displayColorR') are treated as the
+// parent compound attribute.
+static MObject plug_root_attribute(MPlug &plug) {
+    MPlug root_plug(plug);
+    while (root_plug.isChild()) {
+        root_plug = root_plug.parent();
+    }
+    return root_plug.attribute();
+}
+
+void GeometryOverride::attributeChangedCallback(
+        MNodeMessage::AttributeMessage msg,
+        MPlug &plug,
+        MPlug &/*other_plug*/,
+        void *client_data) {
+    const int relevant_messages =
+        MNodeMessage::kAttributeSet
+        | MNodeMessage::kConnectionMade
+        | MNodeMessage::kConnectionBroken;
+    if ((msg & relevant_messages) == 0) {
+        return;
+    }
+    GeometryOverride *geometry_override =
+        static_cast<GeometryOverride *>(client_data);
+    geometry_override->m_dirty_flags |=
+        dirtyFlagsFromAttribute(plug_root_attribute(plug));
+    if (msg & (MNodeMessage::kConnectionMade | MNodeMessage::kConnectionBroken)) {
+        geometry_override->m_connected_flags_dirty = true;
+    }
+}
+
+void GeometryOverride::timeChangedCallback(
+        MTime &/*time*/,
+        void *client_data) {
+    GeometryOverride *geometry_override =
+        static_cast<GeometryOverride *>(client_data);
+    geometry_override->m_dirty_flags |= geometry_override->m_connected_flags;
+}
+
+// The attribute groups with at least one incoming connection, which
+// may change value with time.
+uint32_t GeometryOverride::connectedDirtyFlags() const {
+    const MObject attrs[] = {
+        ShapeNode::m_in_stream_attr,
+        ShapeNode::m_time_attr,
+        ShapeNode::m_display_mode_attr,
+        ShapeNode::m_display_color_attr,
+        ShapeNode::m_display_alpha_attr,
+        ShapeNode::m_display_saturation_attr,
+        ShapeNode::m_display_exposure_attr,
+        ShapeNode::m_display_gamma_attr,
+        ShapeNode::m_display_soft_clip_attr,
+        ShapeNode::m_display_use_draw_depth_attr,
+        ShapeNode::m_display_draw_depth_attr,
+        ShapeNode::m_display_scopes_attr,
+        ShapeNode::m_card_depth_attr,
+        ShapeNode::m_card_size_x_attr,
+        ShapeNode::m_card_size_y_attr,
+        ShapeNode::m_card_res_x_attr,
+        ShapeNode::m_card_res_y_attr,
+        ShapeNode::m_card_adaptive_attr,
+        ShapeNode::m_card_adaptive_tolerance_attr,
+        ShapeNode::m_card_adaptive_max_level_attr,
+        ShapeNode::m_color_space_name_attr,
+        ShapeNode::m_lut_edge_size_attr,
+        ShapeNode::m_cache_option_attr,
+        ShapeNode::m_cache_pixel_data_type_attr,
+        ShapeNode::m_cache_crop_on_format_attr,
+        ShapeNode::m_proxy_resolution_attr,
+        ShapeNode::m_disk_cache_enable_attr,
+        ShapeNode::m_disk_cache_file_path_attr,
+    };
+    const size_t attrs_count = sizeof(attrs) / sizeof(attrs[0]);
+
+    uint32_t flags = kDirtyNone;
+    for (size_t i = 0; i < attrs_count; ++i) {
+        MPlug plug(m_locator_node, attrs[i]);
+        if (plug.isNull()) {
+            continue;
+        }
+        bool connected = plug.isDestination();
+        for (uint32_t j = 0; !connected && (j < plug.numChildren()); ++j) {
+            connected = plug.child(j).isDestination();
+        }
+        if (connected) {
+            flags |= dirtyFlagsFromAttribute(attrs[i]);
+        }
+    }
+
+    // The camera focal length may be animated.
+    MPlug camera_plug(m_locator_node, ShapeNode::m_camera_attr);
+    if (!camera_plug.isNull() && camera_plug.isDestination()) {
+        flags |= kDirtyCamera;
+    }
+    return flags;
+}
+
+void GeometryOverride::nodeDirtyPlugCallback(
+        MObject &/*node*/,
+        MPlug &plug,
+        void *client_data) {
+    GeometryOverride *geometry_override =
+        static_cast<GeometryOverride *>(client_data);
+    geometry_override->m_dirty_flags |=
+        dirtyFlagsFromAttribute(plug_root_attribute(plug));
+}
+
+void GeometryOverride::cameraAttributeChangedCallback(
+        MNodeMessage::AttributeMessage msg,
+        MPlug &plug,
+        MPlug &/*other_plug*/,
+        void *client_data) {
+    if ((msg & MNodeMessage::kAttributeSet) == 0) {
+        return;
+    }
+    MObject node = plug.node();
+    GeometryOverride::cameraDirtyPlugCallback(node, plug, client_data);
+}
+
+// Only the camera attributes used by the image plane mark the image
+// plane dirty; the camera transform changes every frame when
+// animated.
+void GeometryOverride::cameraDirtyPlugCallback(
+        MObject &/*node*/,
+        MPlug &plug,
+        void *client_data) {
+    MStatus status;
+    MFnAttribute attr_fn(plug_root_attribute(plug), &status);
+    if (!status || (attr_fn.name() != MString("focalLength"))) {
+        return;
+    }
+    GeometryOverride *geometry_override =
+        static_cast<GeometryOverride *>(client_data);
+    geometry_override->m_dirty_flags |= kDirtyCamera;
+    MHWRender::MRenderer::setGeometryDrawDirty(
+        geometry_override->m_locator_node);
+}
+
+// Watch the given camera node for changes, replacing the callbacks on
+// the previous camera. Returns true if the camera node is different
+// from the last call.
+bool GeometryOverride::updateCameraCallbacks(MObject &camera_node) {
+    MStatus status;
+    bool camera_is_same =
+        m_camera_node.isValid()
+        && !camera_node.isNull()
+        && (m_camera_node.object() == camera_node);
+    if (camera_is_same) {
+        return false;
+    }
+
+    if (m_camera_callback_ids.length() > 0) {
+        MMessage::removeCallbacks(m_camera_callback_ids);
+        m_camera_callback_ids.clear();
+    }
+    m_camera_node = MObjectHandle();
+    if (camera_node.isNull()) {
+        return true;
+    }
+
+    m_camera_node = MObjectHandle(camera_node);
+    MCallbackId callback_id = MNodeMessage::addAttributeChangedCallback(
+        camera_node, GeometryOverride::cameraAttributeChangedCallback,
+        this, &status);
+    CHECK_MSTATUS(status);
+    if (status) {
+        m_camera_callback_ids.append(callback_id);
+    }
+    callback_id = MNodeMessage::addNodeDirtyPlugCallback(
+        camera_node, GeometryOverride::cameraDirtyPlugCallback,
+        this, &status);
+    CHECK_MSTATUS(status);
+    if (status) {
+        m_camera_callback_ids.append(callback_id);
+    }
+    return true;
+}
+
+// Any change to the node the viewer reads the stream from (and so
+// anything upstream of it) needs the graph to be executed.
+void GeometryOverride::viewerInputDirtyPlugCallback(
+        MObject &/*node*/,
+        MPlug &/*plug*/,
+        void *client_data) {
+    GeometryOverride *geometry_override =
+        static_cast<GeometryOverride *>(client_data);
+    geometry_override->m_dirty_flags |= kDirtyViewerInput;
+    MHWRender::MRenderer::setGeometryDrawDirty(
+        geometry_override->m_locator_node);
+}
+
+// Watch the node connected above the viewer fast path nodes,
+// replacing the callbacks on the previous node. Returns true if the
+// node is different from the last call.
+bool GeometryOverride::updateViewerInputCallbacks(MObject &source_node) {
+    MStatus status;
+    bool node_is_same =
+        m_viewer_input_source_node.isValid()
+        && !source_node.isNull()
+        && (m_viewer_input_source_node.object() == source_node);
+    if (node_is_same) {
+        return false;
+    }
+    bool had_node = m_viewer_input_source_node.isValid();
+
+    if (m_viewer_input_callback_ids.length() > 0) {
+        MMessage::removeCallbacks(m_viewer_input_callback_ids);
+        m_viewer_input_callback_ids.clear();
+    }
+    m_viewer_input_source_node = MObjectHandle();
+    if (source_node.isNull()) {
+        return had_node;
+    }
+
+    m_viewer_input_source_node = MObjectHandle(source_node);
+    MCallbackId callback_id = MNodeMessage::addNodeDirtyPlugCallback(
+        source_node, GeometryOverride::viewerInputDirtyPlugCallback,
+        this, &status);
+    CHECK_MSTATUS(status);
+    if (status) {
+        m_viewer_input_callback_ids.append(callback_id);
+    }
+    return true;
+}
+
+
+// The sampler used for the color transform 3D LUT textures.
+MStatus setColorTransformLutSampler(
+        Shader &shader,
+        MString &param_name_texture_sampler,
+        MHWRender::MSamplerStateDesc &sampler_description) {
+    sampler_description.filter = MSamplerState::TextureFilter::kMinMagMipLinear;
+    sampler_description.addressU = MSamplerState::TextureAddress::kTexClamp;
+    sampler_description.addressV = MSamplerState::TextureAddress::kTexClamp;
+    sampler_description.addressW = MSamplerState::TextureAddress::kTexClamp;
+    sampler_description.minLOD = 0;
+    sampler_description.maxLOD = 0;
+    MStatus status = shader.set_texture_sampler_param(
+        param_name_texture_sampler,
+        sampler_description
+    );
+    CHECK_MSTATUS(status);
+    return status;
+}
+
+// Generate a 3D volume texture to be used to look up colour space
+// transforms.
+//
+// LUTs larger than 'kProgressiveLutEdgeSize' are baked at that size
+// first, so the viewport is not blocked, and the full size LUT is
+// baked by 'lut_baker' and uploaded by 'uploadBakedColorTransformLut'
+// once ready.
 MStatus generateColorTransformLut(
         bool lut_edge_size_has_changed,
         bool color_space_name_has_changed,
         bool from_color_space_changed,
         uint32_t lut_edge_size,
-        rust::String &from_color_space,
         std::string &from_color_space_str,
         std::string &from_color_space_name,
         MString &color_space_name,
+        LutBaker &lut_baker,
         Shader &shader,
         MString &param_name_edge_size,
         MString &param_name_enable,
@@ -260,73 +698,122 @@ MStatus generateColorTransformLut(
     auto log = log::get_logger();
     MStatus status;
 
-    if (lut_edge_size_has_changed) {
+    if (!lut_edge_size_has_changed
+        && !color_space_name_has_changed
+        && !from_color_space_changed) {
+        return status;
+    }
+    from_color_space_name = from_color_space_str;
 
-        // 3D LUT Edge Size.
-        status = shader.set_int_param(
-            param_name_edge_size,
-            lut_edge_size);
-        CHECK_MSTATUS(status);
+    // Color Space Conversion values
+    std::string to_color_space = color_space_name.asChar();
+    auto use_3dlut = (from_color_space_str != to_color_space)
+        && (lut_edge_size > 0);
 
-        // Generate a 3D volume texture to be used to look
-        // up colour space transforms.
-        if (color_space_name_has_changed
-            || from_color_space_changed) {
-            from_color_space_name = from_color_space_str;
+    log->debug("GeometryOverride:: use 3D LUT: {}", use_3dlut);
+    log->debug("GeometryOverride:: 3D LUT Edge Size: {}", lut_edge_size);
+    log->debug("GeometryOverride:: Color Space: {} to {}",
+               from_color_space_str, to_color_space);
 
-            // Color Space Conversion values
-            auto to_color_space = color_space_name.asChar();
-            auto use_3dlut = (from_color_space != to_color_space)
-                && (lut_edge_size > 0);
+    // Should we use the 3D LUT texture?
+    status = shader.set_bool_param(
+        param_name_enable, use_3dlut);
+    CHECK_MSTATUS(status);
 
-            log->debug("GeometryOverride:: use 3D LUT: {}", use_3dlut);
-            log->debug("GeometryOverride:: 3D LUT Edge Size: {}", lut_edge_size);
-            log->debug("GeometryOverride:: Color Space: {} to {}", from_color_space_str, to_color_space);
+    if (!use_3dlut) {
+        lut_baker.cancel();
+        return status;
+    }
 
-            // Should we use the 3D LUT texture?
-            status = shader.set_bool_param(
-                param_name_enable, use_3dlut);
-            CHECK_MSTATUS(status);
+    // The small LUT is baked before the full size bake is requested,
+    // so the two bakes do not compete with each other.
+    const bool progressive = lut_edge_size > kProgressiveLutEdgeSize;
+    auto first_lut_edge_size = lut_edge_size;
+    if (progressive) {
+        first_lut_edge_size = kProgressiveLutEdgeSize;
+    }
+    auto lut_image = bake_color_transform_3dlut(
+        from_color_space_str, to_color_space, first_lut_edge_size);
+    if (progressive) {
+        lut_baker.request(
+            from_color_space_str, to_color_space, lut_edge_size);
+    } else {
+        lut_baker.cancel();
+    }
 
-            if (use_3dlut) {
-                auto shared_color_transform_cache =
-                    ocgm_cache::get_shared_color_transform_cache();
-                auto lut_image = ocg::get_color_transform_3dlut(
-                    from_color_space, to_color_space,
-                    lut_edge_size, shared_color_transform_cache);
-
-                // 3D LUT Texture Sampler.
-                MHWRender::MSamplerStateDesc sampler_description;
-                sampler_description.filter = MSamplerState::TextureFilter::kMinMagMipLinear;
-                sampler_description.addressU = MSamplerState::TextureAddress::kTexClamp;
-                sampler_description.addressV = MSamplerState::TextureAddress::kTexClamp;
-                sampler_description.addressW = MSamplerState::TextureAddress::kTexClamp;
-                sampler_description.minLOD = 0;
-                sampler_description.maxLOD = 0;
-                status = shader.set_texture_sampler_param(
-                    param_name_texture_sampler,
-                    sampler_description
-                );
-                CHECK_MSTATUS(status);
+    // 3D LUT Edge Size.
+    status = shader.set_int_param(
+        param_name_edge_size,
+        first_lut_edge_size);
+    CHECK_MSTATUS(status);
 
-                uploadLut3d(
-                    lut_edge_size,
-                    shader,
-                    param_name_texture,
-                    lut_image,
-                    sampler_description);
-            }
-        }
+    // 3D LUT Texture Sampler.
+    MHWRender::MSamplerStateDesc sampler_description;
+    status = setColorTransformLutSampler(
+        shader, param_name_texture_sampler, sampler_description);
+    CHECK_MSTATUS(status);
+
+    uploadLut3d(
+        first_lut_edge_size,
+        shader,
+        param_name_texture,
+        lut_image,
+        sampler_description);
+
+    return status;
+}
+
+// Upload the full size color transform 3D LUT, once baked in the
+// background.
+MStatus uploadBakedColorTransformLut(
+        LutBaker &lut_baker,
+        Shader &shader,
+        MString &param_name_edge_size,
+        MString &param_name_texture_sampler,
+        MString &param_name_texture) {
+    auto log = log::get_logger();
+    MStatus status;
+
+    LutBakeResult result;
+    if (!lut_baker.take_result(result) || !result.image) {
+        return status;
+    }
+    if (result.request_id != lut_baker.latest_request_id()) {
+        // The color space or edge size has changed since.
+        return status;
     }
+    log->debug("GeometryOverride:: uploading baked 3D LUT: edge_size={}",
+               result.lut_edge_size);
 
+    status = shader.set_int_param(
+        param_name_edge_size,
+        result.lut_edge_size);
+    CHECK_MSTATUS(status);
+
+    MHWRender::MSamplerStateDesc sampler_description;
+    status = setColorTransformLutSampler(
+        shader, param_name_texture_sampler, sampler_description);
+    CHECK_MSTATUS(status);
+
+    uploadLut3d(
+        result.lut_edge_size,
+        shader,
+        param_name_texture,
+        *result.image,
+        sampler_description);
     return status;
 }
 
 // Generate a 3D volume texture to be used to look up approximations
 // to colour operations.
+//
+// When 'reuse_uploaded_luts' is true the textures already set on the
+// shader were baked for the same colour operations, so nothing is
+// baked or uploaded.
 MStatus generateColorOpsLut(
         ocg::StreamData &stream_data,
         uint32_t lut_edge_size,
+        const bool reuse_uploaded_luts,
         Shader &shader,
         MString &param_name_enable,
         MString &param_name_edge_size,
@@ -355,8 +842,16 @@ MStatus generateColorOpsLut(
             lut_edge_size);
         CHECK_MSTATUS(status);
 
+        if (reuse_uploaded_luts) {
+            log->debug("GeometryOverride:: ColorOps LUTs unchanged, not baked.");
+            return status;
+        }
+
+        std::unique_lock<std::mutex> cache_lock(
+            ocgm_cache::get_shared_color_transform_cache_mutex());
         auto shared_color_transform_cache =
             ocgm_cache::get_shared_color_transform_cache();
+        auto start_time = std::chrono::steady_clock::now();
 
         // 3D LUT (for RGB channels)
         auto num_channels_3d = 3;
@@ -370,6 +865,14 @@ MStatus generateColorOpsLut(
             stream_data, lut_edge_size, num_channels_1d,
             shared_color_transform_cache);
 
+        auto end_time = std::chrono::steady_clock::now();
+        cache_lock.unlock();
+        std::chrono::duration<double, std::milli> duration =
+            end_time - start_time;
+        log->debug(
+            "GeometryOverride:: Baked ColorOps LUTs: edge_size={} time={:.2f} ms",
+            lut_edge_size, duration.count());
+
         // 3D LUT Texture Sampler.
         MHWRender::MSamplerStateDesc sampler_description_3d;
         sampler_description_3d.filter = MSamplerState::TextureFilter::kMinMagMipLinear;
@@ -432,6 +935,7 @@ MStatus updatePlaneGeometry(
         Shader &shader_border,
         Shader &shader_display_window,
         Shader &shader_data_window,
+        const MFloatMatrix &image_transform,
         MString &param_name_rescale_transform)
 {
     auto log = log::get_logger();
@@ -492,8 +996,14 @@ MStatus updatePlaneGeometry(
         {data_offset_x, data_offset_y, 0.0, 1.0},
     };
     MFloatMatrix move_data_window_transform(move_data_window_values);
+    move_data_window_transform *= image_transform;
     move_data_window_transform *= rescale_display_window_transform;
 
+    // The data window moves with the image, the display window does
+    // not.
+    MFloatMatrix transform_data_window_transform = image_transform;
+    transform_data_window_transform *= rescale_display_window_transform;
+
     status = shader_wire.set_float_matrix4x4_param(
         param_name_rescale_transform,
         move_data_window_transform);
@@ -516,7 +1026,7 @@ MStatus updatePlaneGeometry(
 
     status = shader_data_window.set_float_matrix4x4_param(
         param_name_rescale_transform,
-        rescale_display_window_transform);
+        transform_data_window_transform);
     CHECK_MSTATUS(status);
 
     return status;
@@ -530,13 +1040,17 @@ MStatus updatePlaneGeometry(
 #define LUMINANCE_GREEN (0.7152)
 #define LUMINANCE_BLUE  (0.0722)
 
-MStatus GeometryOverride::updateWithStream(std::shared_ptr<ocg::Graph> &shared_graph,
+MStatus GeometryOverride::updateWithStream(std::shared_ptr<SharedGraph> &shared_graph,
                                            ocg::StreamData &stream_data) {
     auto log = log::get_logger();
     MStatus status;
 
     auto display_window = stream_data.display_window();
     auto data_window = stream_data.data_window();
+
+    // The viewer fast path transforms.
+    MFloatMatrix image_transform = viewer_ops::transform_matrix(
+        m_viewer_ops.transforms, display_window);
     status = updatePlaneGeometry(
         display_window,
         data_window,
@@ -551,9 +1065,36 @@ MStatus GeometryOverride::updateWithStream(std::shared_ptr<ocg::Graph> &shared_g
         m_shader_border,
         m_shader_display_window,
         m_shader_data_window,
+        image_transform,
         m_shader_rescale_transform_parameter_name);
     CHECK_MSTATUS(status);
 
+    // The viewer fast path grade.
+    status = viewer_ops::set_shader_grade_params(
+        m_shader, m_viewer_ops.has_grade, m_viewer_ops.grade);
+    CHECK_MSTATUS(status);
+
+    // Lens distortion of the canvas. The display and data window
+    // shaders draw undeformed rectangles.
+    {
+        lens_deformer::LensDeformer deformer;
+        if (m_deform_in_shader) {
+            deformer = m_lens_deformers[0];
+        }
+        status = lens_deformer::set_shader_params(
+            m_shader, m_deform_in_shader, deformer,
+            display_window, data_window);
+        CHECK_MSTATUS(status);
+        status = lens_deformer::set_shader_params(
+            m_shader_wire, m_deform_in_shader, deformer,
+            display_window, data_window);
+        CHECK_MSTATUS(status);
+        status = lens_deformer::set_shader_params(
+            m_shader_border, m_deform_in_shader, deformer,
+            display_window, data_window);
+        CHECK_MSTATUS(status);
+    }
+
     // Display Mode
     status = m_shader.set_int_param(
         m_shader_display_mode_parameter_name,
@@ -664,10 +1205,10 @@ MStatus GeometryOverride::updateWithStream(std::shared_ptr<ocg::Graph> &shared_g
         color_space_name_has_changed,
         from_color_space_changed,
         m_lut_edge_size,
-        from_color_space,
         from_color_space_str,
         m_from_color_space_name,
         m_color_space_name,
+        m_lut_baker,
         m_shader,
         m_shader_3d_lut_edge_size_parameter_name,
         m_shader_3d_lut_enable_parameter_name,
@@ -675,9 +1216,31 @@ MStatus GeometryOverride::updateWithStream(std::shared_ptr<ocg::Graph> &shared_g
         m_shader_3d_lut_texture_parameter_name);
     CHECK_MSTATUS(status);
 
+    status = uploadBakedColorTransformLut(
+        m_lut_baker,
+        m_shader,
+        m_shader_3d_lut_edge_size_parameter_name,
+        m_shader_3d_lut_texture_sampler_parameter_name,
+        m_shader_3d_lut_texture_parameter_name);
+    CHECK_MSTATUS(status);
+
+    // The uploaded color-ops LUTs are reused while the upstream color
+    // operations are unchanged. A stream still being evaluated in
+    // the background may hold older color operations than the
+    // upstream nodes, so its LUTs are not kept for the current key.
+    auto color_ops_key_is_valid = color_ops::is_key_valid(
+        m_color_ops_key, stream_data.color_ops_len());
+    auto stream_is_current =
+        m_stream_request_id == m_async_executor.latest_request_id();
+    auto reuse_color_ops_lut =
+        color_ops_key_is_valid
+        && m_has_color_ops_lut
+        && (m_color_ops_lut_key == m_color_ops_key)
+        && (m_color_ops_lut_edge_size == m_lut_edge_size);
     status = generateColorOpsLut(
         stream_data,
         m_lut_edge_size,
+        reuse_color_ops_lut,
         m_shader,
         m_shader_color_ops_lut_enable_parameter_name,
         m_shader_color_ops_lut_edge_size_parameter_name,
@@ -686,6 +1249,11 @@ MStatus GeometryOverride::updateWithStream(std::shared_ptr<ocg::Graph> &shared_g
         m_shader_color_ops_3d_lut_texture_parameter_name,
         m_shader_color_ops_1d_lut_texture_parameter_name);
     CHECK_MSTATUS(status);
+    if (!reuse_color_ops_lut) {
+        m_has_color_ops_lut = color_ops_key_is_valid && stream_is_current;
+        m_color_ops_lut_key = m_color_ops_key;
+        m_color_ops_lut_edge_size = m_lut_edge_size;
+    }
 
     // Set the matrix parameter expected to adjust the colors
     // of the image texture.
@@ -716,13 +1284,58 @@ MStatus GeometryOverride::updateWithStream(std::shared_ptr<ocg::Graph> &shared_g
     // Upload main image texture.
     status = m_shader.set_texture_param_with_stream_data(
         m_shader_image_texture_parameter_name,
-        std::move(stream_data));
+        stream_data);
     CHECK_MSTATUS(status);
 
     return status;
 }
 
 
+// Set up the canvas and window geometry for the current stream and
+// card values, returning true when the canvas must be re-built.
+bool GeometryOverride::updateCanvasGeometry() {
+    if (m_stream_data) {
+        auto display_window = m_stream_data->display_window();
+        auto data_window = m_stream_data->data_window();
+        auto old_display_window = m_geometry_window_display.bounding_box();
+        auto old_data_window = m_geometry_window_data.bounding_box();
+        bool windows_changed =
+            (display_window.min_x != old_display_window.min_x)
+            || (display_window.min_y != old_display_window.min_y)
+            || (display_window.max_x != old_display_window.max_x)
+            || (display_window.max_y != old_display_window.max_y)
+            || (data_window.min_x != old_data_window.min_x)
+            || (data_window.min_y != old_data_window.min_y)
+            || (data_window.max_x != old_data_window.max_x)
+            || (data_window.max_y != old_data_window.max_y);
+        if (windows_changed) {
+            this->markWindowsDirty();
+        }
+        m_geometry_window_display.set_bounding_box(display_window);
+        m_geometry_window_data.set_bounding_box(data_window);
+
+        // The adaptive tessellation measures the error with the same
+        // lens model as the shader, so it is only used when the
+        // shader evaluates the deformers.
+        bool adaptive = m_card_adaptive && m_deform_in_shader;
+        lens_deformer::LensDeformer deformer;
+        if (adaptive) {
+            deformer = m_lens_deformers[0];
+        }
+        m_geometry_canvas.set_adaptive(
+            adaptive,
+            m_card_adaptive_max_level,
+            m_card_adaptive_tolerance,
+            deformer,
+            display_window,
+            data_window);
+    }
+
+    m_geometry_canvas.set_divisions_x(m_card_res_x);
+    m_geometry_canvas.set_divisions_y(m_card_res_y);
+    return !m_geometry_canvas.has_geometry();
+}
+
 // Cache values on the DG node.
 //
 // In the updateDG() call, all data needed to compute the indexing and
@@ -734,11 +1347,38 @@ void GeometryOverride::updateDG() {
     MStatus status;
     log->debug("GeometryOverride::updateDG: start.");
 
+    // Only the attributes marked dirty by callbacks since the last
+    // update are read.
+    if (m_connected_flags_dirty) {
+        m_connected_flags = connectedDirtyFlags();
+        m_connected_flags_dirty = false;
+    }
+    const uint32_t dirty_flags = m_dirty_flags;
+    m_dirty_flags = kDirtyNone;
+    log->debug("GeometryOverride::updateDG: dirty_flags={}", dirty_flags);
+
+    // Swap in the image finished by the background evaluation,
+    // if any.
+    bool stream_data_has_changed = false;
+    graph::AsyncExecuteResult async_result;
+    if (m_async_executor.take_result(async_result)) {
+        m_exec_status = async_result.status;
+        if (async_result.status == ocg::ExecuteStatus::kSuccess) {
+            m_stream_data = async_result.stream_data;
+            m_stream_request_id = async_result.request_id;
+            m_stream_frame = async_result.frame;
+            stream_data_has_changed = true;
+        }
+    }
+
     ocg::Node new_stream_node = m_in_stream_node;
     bool in_stream_has_changed = false;
-    MPlug in_stream_plug(m_locator_node, ShapeNode::m_in_stream_attr);
-    std::tie(new_stream_node, in_stream_has_changed) =
-        utils::get_plug_value_stream(in_stream_plug, m_in_stream_node);
+    if (dirty_flags & kDirtyInStream) {
+        MPlug in_stream_plug(m_locator_node, ShapeNode::m_in_stream_attr);
+        std::tie(new_stream_node, in_stream_has_changed) =
+            utils::get_plug_value_stream(
+                in_stream_plug, m_in_stream_node, m_graph_generation);
+    }
     auto shared_graph = get_shared_graph();
     if (!shared_graph) {
         log->error("OCG Graph is not valid.");
@@ -752,133 +1392,297 @@ void GeometryOverride::updateDG() {
 
     // Use disk cache?
     bool disk_cache_enable_has_changed = false;
+    bool disk_cache_file_path_has_changed = false;
+    if (dirty_flags & kDirtyDiskCache) {
+        MPlug disk_cache_enable_plug(
+            m_locator_node, ShapeNode::m_disk_cache_enable_attr);
+        std::tie(m_disk_cache_enable, disk_cache_enable_has_changed) =
+            utils::get_plug_value_bool(disk_cache_enable_plug, m_disk_cache_enable);
 
-    MPlug disk_cache_enable_plug(
-        m_locator_node, ShapeNode::m_disk_cache_enable_attr);
-
-    std::tie(m_disk_cache_enable, disk_cache_enable_has_changed) =
-        utils::get_plug_value_bool(disk_cache_enable_plug, m_disk_cache_enable);
+        // Disk Cache File Path
+        MPlug disk_cache_file_path_plug(
+            m_locator_node, ShapeNode::m_disk_cache_file_path_attr);
+        std::tie(m_disk_cache_file_path, disk_cache_file_path_has_changed) =
+            utils::get_plug_value_string(disk_cache_file_path_plug, m_disk_cache_file_path);
+    }
 
-    // Get the shape node.
-    MFnDagNode node(m_locator_node, &status);
-    ShapeNode *fp = status ? dynamic_cast<ShapeNode *>(node.userNode()) : nullptr;
+    // Viewer attributes
+    bool cache_option_has_changed = false;
+    bool pixel_data_type_has_changed = false;
+    bool cache_crop_on_format_has_changed = false;
+    if (dirty_flags & kDirtyCacheOptions) {
+        MPlug cache_option_plug(
+            m_locator_node, ShapeNode::m_cache_option_attr);
+        MPlug pixel_data_type_plug(
+            m_locator_node, ShapeNode::m_cache_pixel_data_type_attr);
+        MPlug cache_crop_on_format_plug(
+            m_locator_node, ShapeNode::m_cache_crop_on_format_attr);
+
+        std::tie(m_cache_option, cache_option_has_changed) =
+            utils::get_plug_value_uint32(cache_option_plug, m_cache_option);
+        std::tie(m_cache_pixel_data_type, pixel_data_type_has_changed) =
+            utils::get_plug_value_uint32(pixel_data_type_plug, m_cache_pixel_data_type);
+        std::tie(m_cache_crop_on_format, cache_crop_on_format_has_changed) =
+            utils::get_plug_value_bool(cache_crop_on_format_plug, m_cache_crop_on_format);
+
+        MPlug proxy_resolution_plug(
+            m_locator_node, ShapeNode::m_proxy_resolution_attr);
+        m_proxy_resolution = proxy_resolution_plug.asShort();
+    }
 
-    // Create Viewer node.
-    bool viewer_exists = shared_graph->node_exists(m_viewer_node);
-    if (!viewer_exists) {
-        auto node_uuid = fp->m_node_uuid;
-        MString node_name = "viewer";
-        auto node_hash = ocgm_utils::generate_unique_node_hash(
-            node_uuid,
-            node_name);
-        m_viewer_node = shared_graph->create_node(
-            ocg::NodeType::kViewer,
-            node_hash);
-    }
-
-    // Create Read node.
-    bool read_cache_exists = shared_graph->node_exists(m_read_cache_node);
-    if (!read_cache_exists) {
-        auto node_uuid = fp->m_node_uuid;
-        MString node_name = "read_cache";
-        auto node_hash = ocgm_utils::generate_unique_node_hash(
-            node_uuid,
-            node_name);
-        m_read_cache_node = shared_graph->create_node(
-            ocg::NodeType::kReadImage,
-            node_hash);
-    }
-
-    // Create Output node.
-    bool output_exists = shared_graph->node_exists(fp->m_out_stream_node);
-    if (!output_exists) {
-        auto node_uuid = fp->m_node_uuid;
-        MString node_name = "output";
-        auto node_hash = ocgm_utils::generate_unique_node_hash(
-            node_uuid,
-            node_name);
-        fp->m_out_stream_node = shared_graph->create_node(
-            ocg::NodeType::kNull,
-            node_hash);
-    }
-
-    // Connect input stream to the input.
-    if (in_stream_has_changed) {
-        uint8_t input_num = 0;
-        status = ocgm_utils::join_ocg_nodes(
-            shared_graph,
-            m_in_stream_node,
-            m_viewer_node,
-            input_num);
-        CHECK_MSTATUS(status);
+    // The preferences can change the resolution without changing any
+    // attribute of the image plane, so it is resolved every update.
+    const int32_t resolved_proxy_resolution =
+        proxy::resolve(m_proxy_resolution);
+    bool proxy_resolution_has_changed =
+        resolved_proxy_resolution != m_resolved_proxy_resolution;
+    m_resolved_proxy_resolution = resolved_proxy_resolution;
+
+    // Evaluation options.
+    bool viewer_fast_path_has_changed = false;
+    if (dirty_flags & kDirtyEvaluation) {
+        bool async_evaluation_has_changed = false;
+        bool display_stale_indicator_has_changed = false;
+        MPlug async_evaluation_plug(
+            m_locator_node, ShapeNode::m_async_evaluation_attr);
+        MPlug display_stale_indicator_plug(
+            m_locator_node, ShapeNode::m_display_stale_indicator_attr);
+        std::tie(m_async_evaluation, async_evaluation_has_changed) =
+            utils::get_plug_value_bool(async_evaluation_plug, m_async_evaluation);
+        std::tie(m_display_stale_indicator, display_stale_indicator_has_changed) =
+            utils::get_plug_value_bool(
+                display_stale_indicator_plug, m_display_stale_indicator);
+
+        MPlug viewer_fast_path_plug(
+            m_locator_node, ShapeNode::m_viewer_fast_path_attr);
+        std::tie(m_viewer_fast_path, viewer_fast_path_has_changed) =
+            utils::get_plug_value_bool(
+                viewer_fast_path_plug, m_viewer_fast_path);
     }
 
-    // Connect the read or viewer node to the output node.
-    uint8_t input_num = 0;
-    auto input_ocg_node = ocg::Node(ocg::NodeType::kNull, 0);
-    if (!m_disk_cache_enable) {
-        input_ocg_node = m_viewer_node;
+    // Viewer fast path.
+    //
+    // Grade and transform nodes at the end of the input stream are
+    // drawn with shader parameters, and the viewer reads the stream
+    // above them. Editing those nodes then only changes the shader,
+    // the graph is not executed and the texture is not uploaded
+    // again. Writing images still evaluates the full graph.
+    //
+    // Editing the fast path nodes dirties the (shared) graph, so the
+    // graph state cannot tell if the stream above them changed; the
+    // node above them is watched with a callback instead.
+    MPlug viewer_input_plug(m_locator_node, ShapeNode::m_in_stream_attr);
+    bool viewer_ops_have_changed = false;
+    bool viewer_input_has_changed = in_stream_has_changed;
+    ocg::Node new_viewer_input_node = m_in_stream_node;
+    if ((dirty_flags & (kDirtyInStream | kDirtyViewerInput))
+            || viewer_fast_path_has_changed
+            || stream_data_has_changed) {
+        MPlug in_stream_plug(m_locator_node, ShapeNode::m_in_stream_attr);
+        viewer_ops::ViewerOps viewer_ops;
+        if (m_viewer_fast_path) {
+            status = viewer_ops::find_trailing_viewer_ops(
+                in_stream_plug, viewer_ops, viewer_input_plug);
+            CHECK_MSTATUS(status);
+        }
+        viewer_ops_have_changed = viewer_ops != m_viewer_ops;
+        m_viewer_ops = viewer_ops;
+
+        MObject source_node;
+        if (m_viewer_ops.nodes_len > 0) {
+            uint64_t viewer_input_graph_generation = m_graph_generation;
+            new_viewer_input_node = std::get<0>(
+                utils::get_plug_value_stream(
+                    viewer_input_plug,
+                    m_viewer_input_node,
+                    viewer_input_graph_generation));
+            MPlug source_plug = viewer_input_plug.source(&status);
+            if (status && !source_plug.isNull()) {
+                source_node = source_plug.node();
+            }
+            viewer_input_has_changed =
+                (dirty_flags & kDirtyViewerInput) != 0;
+        }
+        bool source_node_has_changed =
+            updateViewerInputCallbacks(source_node);
+        viewer_input_has_changed =
+            viewer_input_has_changed
+            || source_node_has_changed
+            || viewer_fast_path_has_changed;
     } else {
-        input_ocg_node = m_read_cache_node;
+        new_viewer_input_node = m_viewer_input_node;
     }
-    status = ocgm_utils::join_ocg_nodes(
-        shared_graph,
-        input_ocg_node,
-        fp->m_out_stream_node,
-        input_num);
-    CHECK_MSTATUS(status);
+    bool viewer_input_node_has_changed =
+        new_viewer_input_node.get_id() != m_viewer_input_node.get_id();
+    viewer_input_has_changed =
+        viewer_input_has_changed || viewer_input_node_has_changed;
+    m_viewer_input_node = new_viewer_input_node;
 
-    // Disk Cache File Path
-    bool disk_cache_file_path_has_changed = false;
+    // Get the shape node.
+    MFnDagNode node(m_locator_node, &status);
+    ShapeNode *fp = status ? dynamic_cast<ShapeNode *>(node.userNode()) : nullptr;
 
-    MPlug disk_cache_file_path_plug(
-        m_locator_node, ShapeNode::m_disk_cache_file_path_attr);
+    // Edit the OCG graph.
+    //
+    // Executions copy the graph and release the lock before
+    // computing images, so the lock is never held for long.
+    bool viewer_exists = false;
+    bool proxy_exists = false;
+    bool read_cache_exists = false;
+    bool output_exists = false;
+    {
+        std::lock_guard<std::recursive_mutex> graph_lock(
+            get_shared_graph_mutex());
+        viewer_exists = shared_graph->node_exists(m_viewer_node);
+        proxy_exists = shared_graph->node_exists(m_proxy_node);
+        read_cache_exists = shared_graph->node_exists(m_read_cache_node);
+        output_exists = shared_graph->node_exists(fp->m_out_stream_node);
+    }
+    bool graph_needs_edit =
+        !viewer_exists
+        || !proxy_exists
+        || !read_cache_exists
+        || !output_exists
+        || viewer_input_node_has_changed
+        || disk_cache_enable_has_changed
+        || disk_cache_file_path_has_changed
+        || cache_option_has_changed
+        || pixel_data_type_has_changed
+        || cache_crop_on_format_has_changed
+        || proxy_resolution_has_changed;
+    if (graph_needs_edit) {
+        std::lock_guard<std::recursive_mutex> graph_lock(
+            get_shared_graph_mutex());
+
+        // Create Viewer node.
+        if (!viewer_exists) {
+            auto node_uuid = fp->m_node_uuid;
+            MString node_name = "viewer";
+            auto node_hash = ocgm_utils::generate_unique_node_hash(
+                node_uuid,
+                node_name);
+            m_viewer_node = shared_graph->create_node(
+                ocg::NodeType::kViewer,
+                node_hash);
+        }
 
-    std::tie(m_disk_cache_file_path, disk_cache_file_path_has_changed) =
-        utils::get_plug_value_string(disk_cache_file_path_plug, m_disk_cache_file_path);
+        // Create Proxy node; reduces the resolution of the image
+        // before the viewer caches it, so the cache, the color
+        // operations and the texture upload all work on the smaller
+        // image.
+        if (!proxy_exists) {
+            auto node_uuid = fp->m_node_uuid;
+            MString node_name = "proxy";
+            auto node_hash = ocgm_utils::generate_unique_node_hash(
+                node_uuid,
+                node_name);
+            m_proxy_node = shared_graph->create_node(
+                ocg::NodeType::kResampleImage,
+                node_hash);
+        }
 
-    if (m_read_cache_node.get_id() != 0) {
-        // Disk Cache Enable
-        shared_graph->set_node_attr_i32(
-            m_read_cache_node, "enable",
-            static_cast<int32_t>(m_disk_cache_enable));
+        // Create Read node.
+        if (!read_cache_exists) {
+            auto node_uuid = fp->m_node_uuid;
+            MString node_name = "read_cache";
+            auto node_hash = ocgm_utils::generate_unique_node_hash(
+                node_uuid,
+                node_name);
+            m_read_cache_node = shared_graph->create_node(
+                ocg::NodeType::kReadImage,
+                node_hash);
+        }
 
-        // Disk Cache File Path
-        shared_graph->set_node_attr_str(
-            m_read_cache_node, "file_path", m_disk_cache_file_path.asChar());
-    }
+        // Create Output node.
+        if (!output_exists) {
+            auto node_uuid = fp->m_node_uuid;
+            MString node_name = "output";
+            auto node_hash = ocgm_utils::generate_unique_node_hash(
+                node_uuid,
+                node_name);
+            fp->m_out_stream_node = shared_graph->create_node(
+                ocg::NodeType::kNull,
+                node_hash);
+        }
 
-    // Set attributes on Viewer
-    bool cache_option_has_changed = false;
-    bool pixel_data_type_has_changed = false;
-    bool cache_crop_on_format_has_changed = false;
+        // Connect input stream to the input, through the proxy.
+        if (viewer_input_node_has_changed || !proxy_exists) {
+            uint8_t input_num = 0;
+            status = ocgm_utils::join_ocg_nodes(
+                shared_graph,
+                m_viewer_input_node,
+                m_proxy_node,
+                input_num);
+            CHECK_MSTATUS(status);
+        }
+        if (!proxy_exists || !viewer_exists) {
+            uint8_t input_num = 0;
+            status = ocgm_utils::join_ocg_nodes(
+                shared_graph,
+                m_proxy_node,
+                m_viewer_node,
+                input_num);
+            CHECK_MSTATUS(status);
+        }
 
-    MPlug cache_option_plug(
-        m_locator_node, ShapeNode::m_cache_option_attr);
-    MPlug pixel_data_type_plug(
-        m_locator_node, ShapeNode::m_cache_pixel_data_type_attr);
-    MPlug cache_crop_on_format_plug(
-        m_locator_node, ShapeNode::m_cache_crop_on_format_attr);
-
-    std::tie(m_cache_option, cache_option_has_changed) =
-        utils::get_plug_value_uint32(cache_option_plug, m_cache_option);
-    std::tie(m_cache_pixel_data_type, pixel_data_type_has_changed) =
-        utils::get_plug_value_uint32(pixel_data_type_plug, m_cache_pixel_data_type);
-    std::tie(m_cache_crop_on_format, cache_crop_on_format_has_changed) =
-        utils::get_plug_value_bool(cache_crop_on_format_plug, m_cache_crop_on_format);
-
-    if (m_viewer_node.get_id() != 0) {
-        if (cache_option_has_changed) {
-            shared_graph->set_node_attr_i32(
-                m_viewer_node, "bake_option", m_cache_option);
+        // Connect the read or viewer node to the output node.
+        uint8_t input_num = 0;
+        auto input_ocg_node = ocg::Node(ocg::NodeType::kNull, 0);
+        if (!m_disk_cache_enable) {
+            input_ocg_node = m_viewer_node;
+        } else {
+            input_ocg_node = m_read_cache_node;
         }
-        if (pixel_data_type_has_changed) {
+        status = ocgm_utils::join_ocg_nodes(
+            shared_graph,
+            input_ocg_node,
+            fp->m_out_stream_node,
+            input_num);
+        CHECK_MSTATUS(status);
+
+        if (m_read_cache_node.get_id() != 0) {
+            // Disk Cache Enable
             shared_graph->set_node_attr_i32(
-                m_viewer_node, "bake_pixel_data_type", m_cache_pixel_data_type);
+                m_read_cache_node, "enable",
+                static_cast<int32_t>(m_disk_cache_enable));
+
+            // Disk Cache File Path; the frames of cache containers
+            // are read from their local files.
+            const std::string disk_cache_file_path =
+                cache_container::resolve_file_path(
+                    m_disk_cache_file_path.asChar());
+            shared_graph->set_node_attr_str(
+                m_read_cache_node, "file_path", disk_cache_file_path.c_str());
         }
-        if (cache_crop_on_format_has_changed) {
+
+        // Set attributes on Proxy; nearest pixel decimation is
+        // enough for reviews, and the fastest.
+        if ((m_proxy_node.get_id() != 0)
+            && (proxy_resolution_has_changed || !proxy_exists)) {
+            const bool enable =
+                m_resolved_proxy_resolution != proxy::kResolutionFull;
+            shared_graph->set_node_attr_i32(
+                m_proxy_node, "enable", static_cast<int32_t>(enable));
             shared_graph->set_node_attr_i32(
-                m_viewer_node, "crop_to_format", m_cache_crop_on_format);
+                m_proxy_node, "factor",
+                proxy::resample_factor(m_resolved_proxy_resolution));
+            shared_graph->set_node_attr_i32(m_proxy_node, "interpolate", 0);
+        }
+
+        // Set attributes on Viewer
+        if (m_viewer_node.get_id() != 0) {
+            if (cache_option_has_changed || !viewer_exists) {
+                shared_graph->set_node_attr_i32(
+                    m_viewer_node, "bake_option", m_cache_option);
+            }
+            if (pixel_data_type_has_changed || !viewer_exists) {
+                shared_graph->set_node_attr_i32(
+                    m_viewer_node, "bake_pixel_data_type", m_cache_pixel_data_type);
+            }
+            if (cache_crop_on_format_has_changed || !viewer_exists) {
+                shared_graph->set_node_attr_i32(
+                    m_viewer_node, "crop_to_format", m_cache_crop_on_format);
+            }
         }
     }
 
@@ -892,46 +1696,57 @@ void GeometryOverride::updateDG() {
     bool display_soft_clip_has_changed = false;
     bool display_use_draw_depth_has_changed = false;
     bool display_draw_depth_has_changed = false;
+    if (dirty_flags & kDirtyDisplay) {
+        MPlug display_mode_plug(
+            m_locator_node, ShapeNode::m_display_mode_attr);
+        MPlug display_color_plug(
+            m_locator_node, ShapeNode::m_display_color_attr);
+        MPlug display_alpha_plug(
+            m_locator_node, ShapeNode::m_display_alpha_attr);
+        MPlug display_saturation_plug(
+            m_locator_node, ShapeNode::m_display_saturation_attr);
+        MPlug display_exposure_plug(
+            m_locator_node, ShapeNode::m_display_exposure_attr);
+        MPlug display_gamma_plug(
+            m_locator_node, ShapeNode::m_display_gamma_attr);
+        MPlug display_soft_clip_plug(
+            m_locator_node, ShapeNode::m_display_soft_clip_attr);
+        MPlug display_use_draw_depth_plug(
+            m_locator_node, ShapeNode::m_display_use_draw_depth_attr);
+        MPlug display_draw_depth_plug(
+            m_locator_node, ShapeNode::m_display_draw_depth_attr);
+
+        std::tie(m_display_mode, display_mode_has_changed) =
+            utils::get_plug_value_uint32(display_mode_plug, m_display_mode);
+        std::tie(m_display_color, display_color_has_changed) =
+            utils::get_plug_value_color(display_color_plug, m_display_color);
+        std::tie(m_display_alpha, display_alpha_has_changed) =
+            utils::get_plug_value_float(display_alpha_plug, m_display_alpha);
+        std::tie(m_display_saturation, display_saturation_has_changed) =
+            utils::get_plug_value_float(display_saturation_plug, m_display_saturation);
+        std::tie(m_display_exposure, display_exposure_has_changed) =
+            utils::get_plug_value_float(display_exposure_plug, m_display_exposure);
+        std::tie(m_display_gamma, display_gamma_has_changed) =
+            utils::get_plug_value_float(display_gamma_plug, m_display_gamma);
+        std::tie(m_display_soft_clip, display_soft_clip_has_changed) =
+            utils::get_plug_value_float(display_soft_clip_plug, m_display_soft_clip);
+        std::tie(m_display_use_draw_depth, display_use_draw_depth_has_changed) =
+            utils::get_plug_value_bool(display_use_draw_depth_plug, m_display_use_draw_depth);
+        std::tie(m_display_draw_depth, display_draw_depth_has_changed) =
+            utils::get_plug_value_float(display_draw_depth_plug, m_display_draw_depth);
+
+        // Only drawn with UI drawables, no shader or geometry
+        // changes.
+        bool display_scopes_has_changed = false;
+        MPlug display_scopes_plug(
+            m_locator_node, ShapeNode::m_display_scopes_attr);
+        std::tie(m_display_scopes, display_scopes_has_changed) =
+            utils::get_plug_value_uint32(display_scopes_plug, m_display_scopes);
+    }
 
-    MPlug display_mode_plug(
-        m_locator_node, ShapeNode::m_display_mode_attr);
-    MPlug display_color_plug(
-        m_locator_node, ShapeNode::m_display_color_attr);
-    MPlug display_alpha_plug(
-        m_locator_node, ShapeNode::m_display_alpha_attr);
-    MPlug display_saturation_plug(
-        m_locator_node, ShapeNode::m_display_saturation_attr);
-    MPlug display_exposure_plug(
-        m_locator_node, ShapeNode::m_display_exposure_attr);
-    MPlug display_gamma_plug(
-        m_locator_node, ShapeNode::m_display_gamma_attr);
-    MPlug display_soft_clip_plug(
-        m_locator_node, ShapeNode::m_display_soft_clip_attr);
-    MPlug display_use_draw_depth_plug(
-        m_locator_node, ShapeNode::m_display_use_draw_depth_attr);
-    MPlug display_draw_depth_plug(
-        m_locator_node, ShapeNode::m_display_draw_depth_attr);
-
-    std::tie(m_display_mode, display_mode_has_changed) =
-        utils::get_plug_value_uint32(display_mode_plug, m_display_mode);
-    std::tie(m_display_color, display_color_has_changed) =
-        utils::get_plug_value_color(display_color_plug, m_display_color);
-    std::tie(m_display_alpha, display_alpha_has_changed) =
-        utils::get_plug_value_float(display_alpha_plug, m_display_alpha);
-    std::tie(m_display_saturation, display_saturation_has_changed) =
-        utils::get_plug_value_float(display_saturation_plug, m_display_saturation);
-    std::tie(m_display_exposure, display_exposure_has_changed) =
-        utils::get_plug_value_float(display_exposure_plug, m_display_exposure);
-    std::tie(m_display_gamma, display_gamma_has_changed) =
-        utils::get_plug_value_float(display_gamma_plug, m_display_gamma);
-    std::tie(m_display_soft_clip, display_soft_clip_has_changed) =
-        utils::get_plug_value_float(display_soft_clip_plug, m_display_soft_clip);
-    std::tie(m_display_use_draw_depth, display_use_draw_depth_has_changed) =
-        utils::get_plug_value_bool(display_use_draw_depth_plug, m_display_use_draw_depth);
-    std::tie(m_display_draw_depth, display_draw_depth_has_changed) =
-        utils::get_plug_value_float(display_draw_depth_plug, m_display_draw_depth);
-
-    // TODO: Detect when the camera matrix has changed.
+    // The camera is found from the connection to the 'camera'
+    // attribute, and the camera node is watched with a callback, so
+    // changes to the camera also mark this node dirty.
     //
     // TODO: Find the camera by following the node's 'message'
     // attribute. This is the way Maya image planes normally work, so
@@ -939,49 +1754,90 @@ void GeometryOverride::updateDG() {
     //
     // TODO: Query other attributes, like film back size, and iflm
     // back offsets.
-    bool camera_has_changed = true;
-    bool focal_length_has_changed = true;
-    MPlug camera_plug(m_locator_node, ShapeNode::m_camera_attr);
-    if (!camera_plug.isNull()) {
-        MPlug src_plug = camera_plug.source(&status);
-        if (!src_plug.isNull()) {
-            MObject camera_object = src_plug.node(&status);
-            CHECK_MSTATUS(status);
-            MFnCamera camera_fn(camera_object, &status);
-            CHECK_MSTATUS(status);
+    bool camera_has_changed = false;
+    bool focal_length_has_changed = false;
+    if (dirty_flags & kDirtyCamera) {
+        MObject camera_object;
+        MPlug camera_plug(m_locator_node, ShapeNode::m_camera_attr);
+        if (!camera_plug.isNull()) {
+            MPlug src_plug = camera_plug.source(&status);
+            if (!src_plug.isNull()) {
+                camera_object = src_plug.node(&status);
+                CHECK_MSTATUS(status);
+            }
+        }
+        camera_has_changed = updateCameraCallbacks(camera_object);
 
-            m_focal_length = camera_fn.focalLength(&status);
+        if (!camera_object.isNull()) {
+            MFnCamera camera_fn(camera_object, &status);
             CHECK_MSTATUS(status);
+            if (status) {
+                float focal_length =
+                    static_cast<float>(camera_fn.focalLength(&status));
+                CHECK_MSTATUS(status);
+                focal_length_has_changed = focal_length != m_focal_length;
+                m_focal_length = focal_length;
+            }
         }
     }
 
     bool card_depth_has_changed = false;
-    MPlug card_depth_plug(m_locator_node, ShapeNode::m_card_depth_attr);
-    std::tie(m_card_depth, card_depth_has_changed) =
-        utils::get_plug_value_distance_float(card_depth_plug, m_card_depth);
-
     bool card_size_x_has_changed = false;
     bool card_size_y_has_changed = false;
-    MPlug card_size_x_plug(m_locator_node, ShapeNode::m_card_size_x_attr);
-    MPlug card_size_y_plug(m_locator_node, ShapeNode::m_card_size_y_attr);
-    std::tie(m_card_size_x, card_size_x_has_changed) =
-        utils::get_plug_value_distance_float(card_size_x_plug, m_card_size_x);
-    std::tie(m_card_size_y, card_size_y_has_changed) =
-        utils::get_plug_value_distance_float(card_size_y_plug, m_card_size_y);
+    if (dirty_flags & kDirtyCard) {
+        MPlug card_depth_plug(m_locator_node, ShapeNode::m_card_depth_attr);
+        std::tie(m_card_depth, card_depth_has_changed) =
+            utils::get_plug_value_distance_float(card_depth_plug, m_card_depth);
+
+        MPlug card_size_x_plug(m_locator_node, ShapeNode::m_card_size_x_attr);
+        MPlug card_size_y_plug(m_locator_node, ShapeNode::m_card_size_y_attr);
+        std::tie(m_card_size_x, card_size_x_has_changed) =
+            utils::get_plug_value_distance_float(card_size_x_plug, m_card_size_x);
+        std::tie(m_card_size_y, card_size_y_has_changed) =
+            utils::get_plug_value_distance_float(card_size_y_plug, m_card_size_y);
+    }
 
     bool card_res_x_has_changed = false;
     bool card_res_y_has_changed = false;
-    MPlug card_res_x_plug(m_locator_node, ShapeNode::m_card_res_x_attr);
-    MPlug card_res_y_plug(m_locator_node, ShapeNode::m_card_res_y_attr);
-    std::tie(m_card_res_x, card_res_x_has_changed) =
-        utils::get_plug_value_uint32(card_res_x_plug, m_card_res_x);
-    std::tie(m_card_res_y, card_res_y_has_changed) =
-        utils::get_plug_value_uint32(card_res_y_plug, m_card_res_y);
+    bool card_adaptive_has_changed = false;
+    bool card_adaptive_tolerance_has_changed = false;
+    bool card_adaptive_max_level_has_changed = false;
+    if (dirty_flags & kDirtyCardResolution) {
+        MPlug card_res_x_plug(m_locator_node, ShapeNode::m_card_res_x_attr);
+        MPlug card_res_y_plug(m_locator_node, ShapeNode::m_card_res_y_attr);
+        std::tie(m_card_res_x, card_res_x_has_changed) =
+            utils::get_plug_value_uint32(card_res_x_plug, m_card_res_x);
+        std::tie(m_card_res_y, card_res_y_has_changed) =
+            utils::get_plug_value_uint32(card_res_y_plug, m_card_res_y);
+
+        MPlug card_adaptive_plug(
+            m_locator_node, ShapeNode::m_card_adaptive_attr);
+        MPlug card_adaptive_tolerance_plug(
+            m_locator_node, ShapeNode::m_card_adaptive_tolerance_attr);
+        MPlug card_adaptive_max_level_plug(
+            m_locator_node, ShapeNode::m_card_adaptive_max_level_attr);
+        std::tie(m_card_adaptive, card_adaptive_has_changed) =
+            utils::get_plug_value_bool(card_adaptive_plug, m_card_adaptive);
+        std::tie(m_card_adaptive_tolerance, card_adaptive_tolerance_has_changed) =
+            utils::get_plug_value_float(
+                card_adaptive_tolerance_plug, m_card_adaptive_tolerance);
+        std::tie(m_card_adaptive_max_level, card_adaptive_max_level_has_changed) =
+            utils::get_plug_value_uint32(
+                card_adaptive_max_level_plug, m_card_adaptive_max_level);
+    }
 
     bool time_has_changed = false;
-    MPlug time_plug(m_locator_node, ShapeNode::m_time_attr);
-    std::tie(m_time, time_has_changed) =
-        utils::get_plug_value_frame_float(time_plug, m_time);
+    if (dirty_flags & kDirtyTime) {
+        MPlug time_plug(m_locator_node, ShapeNode::m_time_attr);
+        std::tie(m_time, time_has_changed) =
+            utils::get_plug_value_frame_float(time_plug, m_time);
+    }
+
+    // The color space attributes are read when the shader is
+    // updated. A LUT baked in the background is also uploaded then.
+    bool color_space_has_changed =
+        ((dirty_flags & kDirtyColorSpace) != 0)
+        || m_lut_baker.has_result();
 
     uint32_t stream_values_changed = 0;
     uint32_t shader_values_changed = 0;
@@ -1002,21 +1858,29 @@ void GeometryOverride::updateDG() {
     shader_values_changed += static_cast<uint32_t>(card_depth_has_changed);
     shader_values_changed += static_cast<uint32_t>(card_size_x_has_changed);
     shader_values_changed += static_cast<uint32_t>(card_size_y_has_changed);
+    shader_values_changed += static_cast<uint32_t>(color_space_has_changed);
+    shader_values_changed += static_cast<uint32_t>(viewer_ops_have_changed);
 
     shader_border_values_changed += static_cast<uint32_t>(focal_length_has_changed);
     shader_border_values_changed += static_cast<uint32_t>(card_depth_has_changed);
     shader_border_values_changed += static_cast<uint32_t>(card_size_x_has_changed);
     shader_border_values_changed += static_cast<uint32_t>(card_size_y_has_changed);
+    shader_border_values_changed += static_cast<uint32_t>(viewer_ops_have_changed);
 
     topology_values_changed += static_cast<uint32_t>(card_res_x_has_changed);
     topology_values_changed += static_cast<uint32_t>(card_res_y_has_changed);
-
-    shader_values_changed += static_cast<uint32_t>(time_has_changed);
-    shader_values_changed += static_cast<uint32_t>(in_stream_has_changed);
+    topology_values_changed += static_cast<uint32_t>(card_adaptive_has_changed);
+    topology_values_changed += static_cast<uint32_t>(card_adaptive_tolerance_has_changed);
+    topology_values_changed += static_cast<uint32_t>(card_adaptive_max_level_has_changed);
 
     stream_values_changed += static_cast<uint32_t>(time_has_changed);
-    stream_values_changed += static_cast<uint32_t>(in_stream_has_changed);
+    stream_values_changed += static_cast<uint32_t>(viewer_input_has_changed);
     stream_values_changed += static_cast<uint32_t>(disk_cache_enable_has_changed);
+    stream_values_changed += static_cast<uint32_t>(disk_cache_file_path_has_changed);
+    stream_values_changed += static_cast<uint32_t>(cache_option_has_changed);
+    stream_values_changed += static_cast<uint32_t>(pixel_data_type_has_changed);
+    stream_values_changed += static_cast<uint32_t>(cache_crop_on_format_has_changed);
+    stream_values_changed += static_cast<uint32_t>(proxy_resolution_has_changed);
 
     vertex_values_changed += static_cast<uint32_t>(focal_length_has_changed);
     vertex_values_changed += static_cast<uint32_t>(card_depth_has_changed);
@@ -1029,32 +1893,190 @@ void GeometryOverride::updateDG() {
     log->debug("stream_values_changed: {}", stream_values_changed);
 
     // Evaluate the OCG Graph.
-    m_exec_status = ocg::ExecuteStatus::kUninitialized;
+    //
+    // With asynchronous evaluation the graph is executed on a
+    // background thread, and the last completed image continues to
+    // be drawn until the new image is ready. A request that has not
+    // started yet is replaced (cancelled) by the newer request.
     if (stream_values_changed > 0) {
         log->debug("ocgImagePlane: m_time={}", m_time);
         double execute_frame = std::lround(m_time);
         log->debug("ocgImagePlane: execute_frame={}", execute_frame);
-        auto shared_cache = ocgm_cache::get_shared_cache();
-        m_exec_status = ocgm_graph::execute_ocg_graph(
-            fp->m_out_stream_node,
-            execute_frame,
-            shared_graph,
-            shared_cache);
+        m_requested_frame = execute_frame;
+
+        // The windows of the requested frame are found from the file
+        // headers, so they are shown while the pixels are computed.
+        // The spec only depends on the stream above the viewer input
+        // and the frame, so the headers are not walked again when
+        // only the cache or proxy options change.
+        const std::string input_spec_plug_name =
+            viewer_input_plug.name().asChar();
+        if (viewer_input_has_changed
+                || (execute_frame != m_input_spec_frame)
+                || (input_spec_plug_name != m_input_spec_plug_name)) {
+            m_input_spec = image_spec::ImageSpec();
+            CHECK_MSTATUS(image_spec::find_stream_spec(
+                viewer_input_plug, execute_frame, m_input_spec));
+            m_input_spec_plug_name = input_spec_plug_name;
+            m_input_spec_frame = execute_frame;
+        }
+        const image_spec::ImageSpec &spec = m_input_spec;
+
+        // The shape's bounding box is sized from the same spec, so
+        // the shape never reads the upstream nodes itself.
+        if (fp != nullptr) {
+            fp->m_stream_spec = spec;
+        }
+
+        // The files of the next frames are read while this frame is
+        // evaluated, so playback does not wait on the file server.
+        // The display window places the transforms of the regions of
+        // interest; the last image's is used when the headers do not
+        // give one. The proxy reduces the image after the read nodes,
+        // so the last image's window is scaled back to their
+        // resolution.
+        ocg::BBox2Di display_window = ocg::BBox2Di();
+        if (spec.is_known) {
+            display_window = spec.display_window;
+        } else if (m_stream_data) {
+            const int32_t proxy_scale = 1 << m_resolved_proxy_resolution;
+            display_window = m_stream_data->display_window();
+            display_window.min_x *= proxy_scale;
+            display_window.min_y *= proxy_scale;
+            display_window.max_x *= proxy_scale;
+            display_window.max_y *= proxy_scale;
+        }
+        m_requested_spec = image_spec::resampled(
+            spec, proxy::resample_factor(m_resolved_proxy_resolution));
+        //
+        // The frames of cache containers read at this frame are
+        // extracted by the I/O pool; the graph waits for them before
+        // executing.
+        std::vector<std::string> frame_file_paths;
+        CHECK_MSTATUS(io_pool::read_ahead(
+            viewer_input_plug, execute_frame, display_window,
+            frame_file_paths));
+        if (m_disk_cache_enable
+            && cache_container::is_container_path(
+                m_disk_cache_file_path.asChar())) {
+            std::vector<std::string> disk_cache_file_paths;
+            disk_cache_file_paths.push_back(
+                sequence::expand_frame_path(
+                    cache_container::resolve_file_path(
+                        m_disk_cache_file_path.asChar()),
+                    static_cast<int32_t>(execute_frame)));
+            io_pool::request_frame_extracts(disk_cache_file_paths);
+            frame_file_paths.insert(
+                frame_file_paths.end(),
+                disk_cache_file_paths.begin(),
+                disk_cache_file_paths.end());
+        }
+
+        if (m_async_evaluation) {
+            m_async_executor.request(
+                fp->m_out_stream_node,
+                execute_frame,
+                frame_file_paths);
+        } else {
+            m_async_executor.cancel_pending();
+            io_pool::wait_for_reads(frame_file_paths);
+            auto shared_cache = ocgm_cache::get_shared_cache();
+            std::shared_ptr<ocg::StreamData> stream_data;
+            m_exec_status = ocgm_graph::execute_ocg_graph_stream(
+                fp->m_out_stream_node,
+                execute_frame,
+                shared_graph,
+                shared_cache,
+                stream_data);
+            if (m_exec_status == ocg::ExecuteStatus::kSuccess) {
+                m_stream_data = stream_data;
+                m_stream_request_id = m_async_executor.latest_request_id();
+                m_stream_frame = execute_frame;
+                stream_data_has_changed = true;
+            }
+        }
+    }
+
+    // The lens deformers are read from the upstream nodes directly,
+    // so a lens change reaches the shader without waiting for the
+    // (background) evaluation.
+    bool lens_deformers_have_changed = false;
+    if ((dirty_flags & kDirtyInStream) || stream_data_has_changed) {
+        std::vector<lens_deformer::LensDeformer> lens_deformers;
+        status = lens_deformer::find_upstream_deformers(
+            viewer_input_plug, lens_deformers);
+        CHECK_MSTATUS(status);
+        lens_deformers_have_changed = lens_deformers != m_lens_deformers;
+        m_lens_deformers = lens_deformers;
+    }
+
+    // The color operations are identified the same way, so the
+    // color-ops LUTs are not re-baked when only the frame changes.
+    if ((dirty_flags & kDirtyInStream) || stream_data_has_changed) {
+        status = color_ops::find_upstream_color_ops_key(
+            viewer_input_plug, m_color_ops_key);
+        CHECK_MSTATUS(status);
+    }
+
+    bool deform_in_shader = false;
+    if (m_stream_data) {
+        deform_in_shader = lens_deformer::can_deform_in_shader(
+            m_lens_deformers, m_stream_data->deformers_len());
+    }
+    bool deform_in_shader_has_changed = deform_in_shader != m_deform_in_shader;
+    m_deform_in_shader = deform_in_shader;
+    log->debug("deform_in_shader: {}", m_deform_in_shader);
+
+    if (stream_data_has_changed) {
+        shader_values_changed += 1;
 
         // TODO: Get and check if the color_ops have changed.
 
-        // TODO: Get and check if the deformer has changed.
+        // The display and data windows may have changed.
         vertex_values_changed += 1;
     }
+    if (lens_deformers_have_changed || deform_in_shader_has_changed) {
+        // Deformers evaluated on the CPU change the canvas vertices,
+        // those in the shader only change the shader parameters.
+        shader_values_changed += 1;
+        if (!m_deform_in_shader || deform_in_shader_has_changed) {
+            vertex_values_changed += 1;
+        }
+    }
+
+    // The displayed image is stale while it is waiting on a newer
+    // evaluation.
+    bool is_stale =
+        m_async_executor.is_busy()
+        || (m_stream_data && (m_stream_frame != m_requested_frame));
+    m_is_stale = is_stale && m_display_stale_indicator;
+
+    // The scopes are computed once per displayed stream (and shared
+    // with other users of the stream), redraws use the cached
+    // values. With the viewer fast path the scopes measure the
+    // stream above the trailing grade nodes.
+    if ((m_display_scopes == kDisplayScopesNone) || !m_stream_data) {
+        m_image_scopes.reset();
+    } else if (!m_image_scopes
+               || (m_image_scopes->stream_hash != m_stream_data->hash())) {
+        m_image_scopes = scopes::get_image_scopes(*m_stream_data);
+    }
     log->debug("vertex_values_changed: {}", vertex_values_changed);
     log->debug("exec_status: {}", m_exec_status);
 
+    // Buffers from a changed canvas geometry must all be re-filled.
+    bool canvas_geometry_changed = this->updateCanvasGeometry();
+    if (canvas_geometry_changed) {
+        vertex_values_changed += 1;
+        topology_values_changed += 1;
+    }
+
     // Have the attribute values changed?
     if (vertex_values_changed > 0) {
-        m_update_vertices = true;
+        this->markVerticesDirty();
     }
     if (topology_values_changed > 0) {
-        m_update_topology = true;
+        this->markTopologyDirty();
     }
     if (shader_values_changed > 0) {
         m_update_shader = true;
@@ -1064,8 +2086,8 @@ void GeometryOverride::updateDG() {
     }
     log->debug("update_shader_border={}", m_update_shader_border);
     log->debug("update_shader={}", m_update_shader);
-    log->debug("update_topology={}", m_update_topology);
-    log->debug("update_vertices={}", m_update_vertices);
+    log->debug("dirty_index_items={}", m_dirty_index_items.size());
+    log->debug("dirty_streams={}", m_dirty_streams.size());
 
     // // TODO: Query the bounding box and store it for later use.
     //
@@ -1177,13 +2199,25 @@ void GeometryOverride::updateRenderItems(const MDagPath &path,
             m_shader_geometry_transform_parameter_name, geom_matrix);
         CHECK_MSTATUS(status);
 
-        if (m_exec_status == ocg::ExecuteStatus::kSuccess) {
+        if (m_stream_data) {
             auto shared_graph = get_shared_graph();
-            auto stream_data = shared_graph->output_stream();
-            updateWithStream(shared_graph, stream_data);
+            updateWithStream(shared_graph, *m_stream_data);
         }
         m_update_shader = false;
         m_update_shader_border = false;
+
+        log->debug(
+            "GeometryOverride: shader parameter updates: issued={} skipped={}",
+            m_shader.param_updates_issued()
+            + m_shader_wire.param_updates_issued()
+            + m_shader_border.param_updates_issued()
+            + m_shader_display_window.param_updates_issued()
+            + m_shader_data_window.param_updates_issued(),
+            m_shader.param_updates_skipped()
+            + m_shader_wire.param_updates_skipped()
+            + m_shader_border.param_updates_skipped()
+            + m_shader_display_window.param_updates_skipped()
+            + m_shader_data_window.param_updates_skipped());
     }
 
     bool items_changed = false;
@@ -1280,6 +2314,16 @@ void GeometryOverride::updateRenderItems(const MDagPath &path,
         shaded_item = list.itemAt(index);
     }
 
+    // Nothing can be drawn until the first stream has been
+    // evaluated. Disabled items are not drawn and do not ask for any
+    // geometry.
+    const bool has_stream = static_cast<bool>(m_stream_data);
+    display_window_item->enable(has_stream);
+    data_window_item->enable(has_stream);
+    wireframe_item->enable(has_stream);
+    border_item->enable(has_stream);
+    shaded_item->enable(has_stream);
+
     if (items_changed) {
         // Canvas
         wireframe_item->setShader(m_shader_wire.instance(), &m_canvas_stream_name);
@@ -1309,7 +2353,7 @@ void GeometryOverride::updateRenderItems(const MDagPath &path,
 void GeometryOverride::addUIDrawables(
         const MDagPath &path,
         MHWRender::MUIDrawManager &draw_manager,
-        const MHWRender::MFrameContext &/*frame_context*/) {
+        const MHWRender::MFrameContext &frame_context) {
     // TODO Calculate the correct positions for the image window.
     MPoint center_pos(0.0, 0.0, 0.0);
     MPoint upper_right(1.0, 1.0, 0.0);
@@ -1322,10 +2366,29 @@ void GeometryOverride::addUIDrawables(
     // Draw Display Window
     //
     // TODO: draw the pixel aspect ratio.
+    //
+    // While a newer frame is computed its windows are drawn, when the
+    // file headers give them.
+    int window_width = m_display_window_width;
+    int window_height = m_display_window_height;
+    int window_min_x = m_data_window_min_x;
+    int window_min_y = m_data_window_min_y;
+    int window_max_x = m_data_window_max_x;
+    int window_max_y = m_data_window_max_y;
+    if (m_is_stale && m_requested_spec.is_known) {
+        const ocg::BBox2Di &display = m_requested_spec.display_window;
+        const ocg::BBox2Di &data = m_requested_spec.data_window;
+        window_width = display.max_x - display.min_x;
+        window_height = display.max_y - display.min_y;
+        window_min_x = data.min_x;
+        window_min_y = data.min_y;
+        window_max_x = data.max_x;
+        window_max_y = data.max_y;
+    }
     MString display_window_width = "";
     MString display_window_height = "";
-    display_window_width.set(m_display_window_width, 0);
-    display_window_height.set(m_display_window_height, 0);
+    display_window_width.set(window_width, 0);
+    display_window_height.set(window_height, 0);
     MString display_window =
         display_window_width + " x " + display_window_height;
 
@@ -1335,10 +2398,10 @@ void GeometryOverride::addUIDrawables(
     MString data_window_min_y = "";
     MString data_window_max_x = "";
     MString data_window_max_y = "";
-    data_window_min_x.set(m_data_window_min_x, 0);
-    data_window_min_y.set(m_data_window_min_y, 0);
-    data_window_max_x.set(m_data_window_max_x, 0);
-    data_window_max_y.set(m_data_window_max_y, 0);
+    data_window_min_x.set(window_min_x, 0);
+    data_window_min_y.set(window_min_y, 0);
+    data_window_max_x.set(window_max_x, 0);
+    data_window_max_y.set(window_max_y, 0);
     MString data_window_min =
         data_window_min_x + " x " + data_window_min_y;
     MString data_window_max =
@@ -1351,7 +2414,192 @@ void GeometryOverride::addUIDrawables(
     draw_manager.text(lower_left, data_window_min, MHWRender::MUIDrawManager::kRight);
     draw_manager.text(upper_right, data_window_max, MHWRender::MUIDrawManager::kLeft);
     draw_manager.text(lower_right, display_window, MHWRender::MUIDrawManager::kLeft);
+    if (m_is_stale) {
+        // The image drawn is the last completed frame, a newer frame
+        // is still being computed.
+        MPoint upper_left(-1.0, 1.0, 0.0);
+        MString stale_frame = "";
+        stale_frame.set(m_stream_frame, 0);
+        MString stale_text = MString("Computing... (showing frame ")
+            + stale_frame + MString(")");
+        MColor stale_color(0.9f, 0.6f, 0.1f, 1.0f);
+        draw_manager.setColor(stale_color);
+        draw_manager.text(upper_left, stale_text, MHWRender::MUIDrawManager::kRight);
+    }
     draw_manager.endDrawable();
+
+    if (m_image_scopes && (m_display_scopes != kDisplayScopesNone)) {
+        this->addScopesUIDrawables(draw_manager, frame_context);
+    }
+}
+
+// The scopes are drawn from the cached values; nothing here reads
+// the pixels.
+void GeometryOverride::addScopesUIDrawables(
+        MHWRender::MUIDrawManager &draw_manager,
+        const MHWRender::MFrameContext &frame_context) {
+    const scopes::ImageScopes &image_scopes = *m_image_scopes;
+    const int32_t num_channels = image_scopes.num_channels;
+    if (num_channels <= 0) {
+        return;
+    }
+
+    // Panel placement, in viewport pixels.
+    const double margin = 10.0;
+    const double panel_width = 256.0;
+    const double panel_height = 128.0;
+    const double text_line_height = 16.0;
+    int origin_x = 0;
+    int origin_y = 0;
+    int viewport_width = 0;
+    int viewport_height = 0;
+    frame_context.getViewportDimensions(
+        origin_x, origin_y, viewport_width, viewport_height);
+    const double panel_min_x = origin_x + margin;
+    const double panel_min_y = origin_y + margin;
+
+    // The alpha channel is not drawn.
+    const int32_t draw_channels = std::min(num_channels, 3);
+    const MColor channel_colors[] = {
+        MColor(1.0f, 0.2f, 0.2f, 1.0f),
+        MColor(0.2f, 1.0f, 0.2f, 1.0f),
+        MColor(0.3f, 0.4f, 1.0f, 1.0f),
+    };
+    const MColor single_channel_color(0.9f, 0.9f, 0.9f, 1.0f);
+    const char *channel_names[] = {"R", "G", "B", "A"};
+
+    draw_manager.beginDrawable();
+
+    // Background.
+    draw_manager.setColor(MColor(0.0f, 0.0f, 0.0f, 0.6f));
+    draw_manager.rect2d(
+        MPoint(panel_min_x + (panel_width * 0.5),
+               panel_min_y + (panel_height * 0.5)),
+        MVector(0.0, 1.0, 0.0),
+        panel_width * 0.5,
+        panel_height * 0.5,
+        /*filled=*/ true);
+
+    if (m_display_scopes == kDisplayScopesHistogram) {
+        // Counts are drawn with a log scale, otherwise the clipped
+        // (first and last) bins flatten everything else.
+        const double peak_scale =
+            1.0 / std::log1p(std::max<double>(image_scopes.histogram_peak, 1.0));
+        const double bin_width =
+            panel_width / static_cast<double>(scopes::kHistogramBins - 1);
+        draw_manager.setLineWidth(1.0f);
+        for (int32_t c = 0; c < draw_channels; ++c) {
+            MPointArray points(scopes::kHistogramBins);
+            const uint32_t *histogram =
+                &image_scopes.histogram[c * scopes::kHistogramBins];
+            for (uint32_t i = 0; i < scopes::kHistogramBins; ++i) {
+                const double value = std::log1p(
+                    static_cast<double>(histogram[i])) * peak_scale;
+                points[i] = MPoint(
+                    panel_min_x + (i * bin_width),
+                    panel_min_y + (value * panel_height));
+            }
+            draw_manager.setColor(
+                draw_channels == 1 ? single_channel_color : channel_colors[c]);
+            draw_manager.mesh2d(
+                MHWRender::MUIDrawManager::kLineStrip, points);
+        }
+
+    } else if (m_display_scopes == kDisplayScopesWaveform) {
+        // One point per non-empty waveform cell, brighter for more
+        // pixels.
+        const uint32_t cell_count =
+            scopes::kWaveformColumns * scopes::kWaveformRows;
+        const double peak_scale =
+            1.0 / std::log1p(std::max<double>(image_scopes.waveform_peak, 1.0));
+        const double cell_width =
+            panel_width / static_cast<double>(scopes::kWaveformColumns);
+        const double cell_height =
+            panel_height / static_cast<double>(scopes::kWaveformRows);
+        MPointArray points;
+        MColorArray colors;
+        for (int32_t c = 0; c < draw_channels; ++c) {
+            const MColor color =
+                draw_channels == 1 ? single_channel_color : channel_colors[c];
+            const uint32_t *waveform = &image_scopes.waveform[c * cell_count];
+            for (uint32_t row = 0; row < scopes::kWaveformRows; ++row) {
+                for (uint32_t column = 0; column < scopes::kWaveformColumns; ++column) {
+                    const uint32_t count =
+                        waveform[(row * scopes::kWaveformColumns) + column];
+                    if (count == 0) {
+                        continue;
+                    }
+                    const float intensity = static_cast<float>(
+                        std::log1p(static_cast<double>(count)) * peak_scale);
+                    points.append(MPoint(
+                        panel_min_x + ((column + 0.5) * cell_width),
+                        panel_min_y + ((row + 0.5) * cell_height)));
+                    colors.append(MColor(
+                        color.r, color.g, color.b,
+                        0.25f + (0.75f * intensity)));
+                }
+            }
+        }
+        draw_manager.setPointSize(2.0f);
+        draw_manager.mesh2d(
+            MHWRender::MUIDrawManager::kPoints, points, &colors);
+    }
+
+    // Channel statistics, above the panel.
+    draw_manager.setFontSize(MHWRender::MUIDrawManager::kSmallFontSize);
+    for (int32_t c = 0; c < num_channels; ++c) {
+        MString minimum = "";
+        MString maximum = "";
+        MString mean = "";
+        minimum.set(image_scopes.minimum[c], 4);
+        maximum.set(image_scopes.maximum[c], 4);
+        mean.set(image_scopes.mean[c], 4);
+        MString channel_name =
+            c < 4 ? MString(channel_names[c]) : MString("?");
+        MString text = channel_name
+            + MString("  min ") + minimum
+            + MString("  max ") + maximum
+            + MString("  mean ") + mean;
+        const double text_y =
+            panel_min_y + panel_height + ((num_channels - c) * text_line_height);
+        draw_manager.setColor(
+            (c < draw_channels) && (draw_channels > 1)
+            ? channel_colors[c]
+            : single_channel_color);
+        draw_manager.text2d(
+            MPoint(panel_min_x, text_y),
+            text,
+            MHWRender::MUIDrawManager::kLeft);
+    }
+
+    draw_manager.endDrawable();
+}
+
+void GeometryOverride::markVerticesDirty() {
+    m_dirty_streams.emplace(
+        m_canvas_stream_name.asChar(), MHWRender::MGeometry::kPosition);
+}
+
+// The canvas positions and UVs are ordered by the canvas topology, so
+// both are re-filled with the index buffers. The window border lines
+// never change topology.
+void GeometryOverride::markTopologyDirty() {
+    m_dirty_index_items.insert(m_shaded_render_item_name.asChar());
+    m_dirty_index_items.insert(m_border_render_item_name.asChar());
+    m_dirty_index_items.insert(m_wireframe_render_item_name.asChar());
+    m_dirty_streams.emplace(
+        m_canvas_stream_name.asChar(), MHWRender::MGeometry::kPosition);
+    m_dirty_streams.emplace(
+        m_canvas_stream_name.asChar(), MHWRender::MGeometry::kTexture);
+}
+
+void GeometryOverride::markWindowsDirty() {
+    m_dirty_streams.emplace(
+        m_display_window_stream_name.asChar(),
+        MHWRender::MGeometry::kPosition);
+    m_dirty_streams.emplace(
+        m_data_window_stream_name.asChar(),
+        MHWRender::MGeometry::kPosition);
 }
 
 // Create Geometry Buffers.
@@ -1362,6 +2610,18 @@ void GeometryOverride::addUIDrawables(
 // instance passed to this method. Failure to fulfill the geometry
 // requirements may result in incorrect drawing or possibly complete
 // failure to draw the object.
+bool GeometryOverride::isIndexingDirty(const MHWRender::MRenderItem &item) {
+    return m_dirty_index_items.count(item.name().asChar()) > 0;
+}
+
+bool GeometryOverride::isStreamDirty(
+        const MHWRender::MVertexBufferDescriptor &desc) {
+    const auto key = std::make_pair(
+        std::string(desc.name().asChar()),
+        static_cast<int>(desc.semantic()));
+    return m_dirty_streams.count(key) > 0;
+}
+
 void GeometryOverride::populateGeometry(
         const MHWRender::MGeometryRequirements &requirements,
         const MHWRender::MRenderItemList &renderItems,
@@ -1370,26 +2630,20 @@ void GeometryOverride::populateGeometry(
     MStatus status;
 
     log->debug("GeometryOverride::populateGeometry: start.");
-    log->debug("GeometryOverride::populateGeometry: m_update_vertices: {}",
-               m_update_vertices);
-    log->debug("GeometryOverride::populateGeometry: m_update_topology: {}",
-               m_update_topology);
+    log->debug("GeometryOverride::populateGeometry: dirty index items: {}",
+               m_dirty_index_items.size());
+    log->debug("GeometryOverride::populateGeometry: dirty streams: {}",
+               m_dirty_streams.size());
 
     // Generate vertex buffer data (Position and UVs).
-    auto shared_graph = get_shared_graph();
-    auto stream_data = shared_graph->output_stream();
-    auto num_deformers = stream_data.deformers_len();
-    log->debug("Updating vertex position... num_deformers={}",
-               num_deformers);
-
-    auto display_window = stream_data.display_window();
-    auto data_window = stream_data.data_window();
-    m_geometry_window_display.set_bounding_box(display_window);
-    m_geometry_window_data.set_bounding_box(data_window);
-
-    m_geometry_canvas.set_divisions_x(m_card_res_x);
-    m_geometry_canvas.set_divisions_y(m_card_res_y);
-
+    //
+    // The requirements only contain the streams that are dirty (see
+    // 'isStreamDirty()') and are used by a render item that is
+    // drawn, the geometry itself was set up in 'updateDG()'.
+    //
+    // The geometry is generated from the last completed stream; the
+    // canvas positions cannot be generated until the first image
+    // has been computed.
     MHWRender::MVertexBuffer *canvas_positions_buffer = nullptr;
     MHWRender::MVertexBuffer *canvas_uvs_buffer = nullptr;
     MHWRender::MVertexBuffer *window_display_positions_buffer = nullptr;
@@ -1407,12 +2661,32 @@ void GeometryOverride::populateGeometry(
         if (desc.name() == m_canvas_stream_name) {
             // Canvas - Positions and UVs.
             if (desc.semantic() == MHWRender::MGeometry::kPosition) {
-                if (!canvas_positions_buffer) {
+                if (!canvas_positions_buffer && m_stream_data) {
                     canvas_positions_buffer = data.createVertexBuffer(desc);
-                    if (canvas_positions_buffer) {
+                    if (canvas_positions_buffer && m_deform_in_shader) {
+                        m_geometry_canvas.fill_vertex_buffer_positions(
+                            canvas_positions_buffer);
+                    } else if (canvas_positions_buffer
+                               && lens_deformer::can_deform_on_cpu(
+                                   m_lens_deformers,
+                                   m_stream_data->deformers_len())) {
+                        // Too many deformers for the shader, the
+                        // same lens model is evaluated on the CPU.
+                        m_geometry_canvas.fill_vertex_buffer_positions(
+                            canvas_positions_buffer,
+                            lens_deformer::canvas_positions_deform_function(
+                                m_lens_deformers,
+                                m_stream_data->display_window(),
+                                m_stream_data->data_window()));
+                    } else if (canvas_positions_buffer) {
                         m_geometry_canvas.fill_vertex_buffer_positions(
                             canvas_positions_buffer,
-                            stream_data);
+                            *m_stream_data);
+                    }
+                    if (canvas_positions_buffer) {
+                        m_dirty_streams.erase(std::make_pair(
+                            std::string(desc.name().asChar()),
+                            static_cast<int>(desc.semantic())));
                     }
                 }
             } else if (desc.semantic() == MHWRender::MGeometry::kTexture) {
@@ -1420,6 +2694,9 @@ void GeometryOverride::populateGeometry(
                     canvas_uvs_buffer = data.createVertexBuffer(desc);
                     if (canvas_uvs_buffer) {
                         m_geometry_canvas.fill_vertex_buffer_uvs(canvas_uvs_buffer);
+                        m_dirty_streams.erase(std::make_pair(
+                            std::string(desc.name().asChar()),
+                            static_cast<int>(desc.semantic())));
                     }
                 }
             }
@@ -1432,6 +2709,9 @@ void GeometryOverride::populateGeometry(
                     if (window_display_positions_buffer) {
                         m_geometry_window_display.fill_vertex_buffer_positions(
                             window_display_positions_buffer);
+                        m_dirty_streams.erase(std::make_pair(
+                            std::string(desc.name().asChar()),
+                            static_cast<int>(desc.semantic())));
                     }
                 }
             }
@@ -1444,6 +2724,9 @@ void GeometryOverride::populateGeometry(
                     if (window_data_positions_buffer) {
                         m_geometry_window_data.fill_vertex_buffer_positions(
                             window_data_positions_buffer);
+                        m_dirty_streams.erase(std::make_pair(
+                            std::string(desc.name().asChar()),
+                            static_cast<int>(desc.semantic())));
                     }
                 }
             }
@@ -1453,7 +2736,18 @@ void GeometryOverride::populateGeometry(
     // Index Buffers
     for (int i = 0; i < renderItems.length(); ++i) {
         const MHWRender::MRenderItem *item = renderItems.itemAt(i);
-        if (!item) {
+        if (!item || !item->isEnabled()) {
+            continue;
+        }
+
+        const MString item_name = item->name();
+        const bool is_known_item =
+            (item_name == m_data_window_render_item_name)
+            || (item_name == m_display_window_render_item_name)
+            || (item_name == m_shaded_render_item_name)
+            || (item_name == m_border_render_item_name)
+            || (item_name == m_wireframe_render_item_name);
+        if (!is_known_item) {
             continue;
         }
 
@@ -1478,6 +2772,7 @@ void GeometryOverride::populateGeometry(
 
         if (index_buffer) {
             item->associateWithIndexBuffer(index_buffer);
+            m_dirty_index_items.erase(item_name.asChar());
         }
     }
 
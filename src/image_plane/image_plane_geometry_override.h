@@ -35,6 +35,10 @@
 #include <maya/MGlobal.h>
 #include <maya/MFnDagNode.h>
 #include <maya/MDagMessage.h>
+#include <maya/MNodeMessage.h>
+#include <maya/MTime.h>
+#include <maya/MCallbackIdArray.h>
+#include <maya/MObjectHandle.h>
 
 // Maya Viewport 2.0
 #include <maya/MPxGeometryOverride.h>
@@ -45,15 +49,25 @@
 // STL
 #include <map>
 #include <memory>
+#include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
 // OCG
 #include <opencompgraph.h>
 
 // OCG Maya
+#include "image_scopes.h"
+#include "graph_execute_async.h"
+#include "image_spec.h"
+#include "image_plane_color_ops.h"
 #include "image_plane_geometry_canvas.h"
 #include "image_plane_geometry_window.h"
+#include "image_plane_lens_deformer.h"
+#include "image_plane_lut_baker.h"
 #include "image_plane_shader.h"
+#include "image_plane_viewer_ops.h"
 
 
 namespace ocg = open_comp_graph;
@@ -76,14 +90,12 @@ public:
 
     void updateDG() override;
 
-    bool isIndexingDirty(const MHWRender::MRenderItem &item) override {
-        return true;
-    }
+    // Only the buffers that have changed are re-generated, everything
+    // else is kept from the previous 'populateGeometry()' call.
+    bool isIndexingDirty(const MHWRender::MRenderItem &item) override;
 
     bool
-    isStreamDirty(const MHWRender::MVertexBufferDescriptor &desc) override {
-        return true;
-    }
+    isStreamDirty(const MHWRender::MVertexBufferDescriptor &desc) override;
 
     void updateRenderItems(
         const MDagPath &path,
@@ -108,13 +120,89 @@ public:
         const MHWRender::MFrameContext &frameContext) override;
 
 private:
+    // Draw the scopes in the lower-left corner of the viewport.
+    void addScopesUIDrawables(
+        MHWRender::MUIDrawManager &draw_manager,
+        const MHWRender::MFrameContext &frame_context);
 
     GeometryOverride(const MObject &obj);
 
     MStatus updateWithStream(
-        std::shared_ptr<ocg::Graph> &shared_graph,
+        std::shared_ptr<SharedGraph> &shared_graph,
         ocg::StreamData &stream_data);
 
+    // Set up the canvas and window geometry for the current stream
+    // and attributes. Returns true if the canvas geometry changed.
+    bool updateCanvasGeometry();
+
+    // Mark the vertex streams and index buffers that must be
+    // re-filled by the next 'populateGeometry()' call.
+    void markVerticesDirty();
+    void markTopologyDirty();
+    void markWindowsDirty();
+
+    // Groups of attributes, marked dirty by Maya callbacks, so
+    // updateDG() only reads the plugs that have changed.
+    enum DirtyFlag : uint32_t {
+        kDirtyNone = 0,
+        kDirtyInStream = 1 << 0,
+        kDirtyTime = 1 << 1,
+        kDirtyCamera = 1 << 2,
+        kDirtyDisplay = 1 << 3,
+        kDirtyCard = 1 << 4,
+        kDirtyCardResolution = 1 << 5,
+        kDirtyColorSpace = 1 << 6,
+        kDirtyCacheOptions = 1 << 7,
+        kDirtyDiskCache = 1 << 8,
+        kDirtyEvaluation = 1 << 9,
+        kDirtyViewerInput = 1 << 10,
+        kDirtyAll = 0xFFFFFFFF
+    };
+
+    // Values of the 'displayScopes' attribute.
+    enum DisplayScopes : uint8_t {
+        kDisplayScopesNone = 0,
+        kDisplayScopesHistogram = 1,
+        kDisplayScopesWaveform = 2
+    };
+
+    static uint32_t dirtyFlagsFromAttribute(const MObject &attr);
+
+    static void attributeChangedCallback(
+        MNodeMessage::AttributeMessage msg,
+        MPlug &plug,
+        MPlug &other_plug,
+        void *client_data);
+
+    static void nodeDirtyPlugCallback(
+        MObject &node,
+        MPlug &plug,
+        void *client_data);
+
+    static void timeChangedCallback(
+        MTime &time,
+        void *client_data);
+
+    static void cameraAttributeChangedCallback(
+        MNodeMessage::AttributeMessage msg,
+        MPlug &plug,
+        MPlug &other_plug,
+        void *client_data);
+
+    static void cameraDirtyPlugCallback(
+        MObject &node,
+        MPlug &plug,
+        void *client_data);
+
+    static void viewerInputDirtyPlugCallback(
+        MObject &node,
+        MPlug &plug,
+        void *client_data);
+
+    bool updateCameraCallbacks(MObject &camera_node);
+    bool updateViewerInputCallbacks(MObject &source_node);
+    uint32_t connectedDirtyFlags() const;
+
     GeometryCanvas m_geometry_canvas;
     GeometryWindow m_geometry_window_display;
     GeometryWindow m_geometry_window_data;
@@ -156,12 +244,63 @@ private:
 
     // Internal state.
     MObject m_locator_node;
-    bool m_update_vertices;
-    bool m_update_topology;
+
+    // The render items (by name) with out of date index buffers, and
+    // the vertex streams (by name and semantic) with out of date
+    // vertex buffers. Only the items and streams that are filled by
+    // 'populateGeometry()' are cleared, the others stay dirty until
+    // Maya asks for them.
+    std::set<std::string> m_dirty_index_items;
+    std::set<std::pair<std::string, int>> m_dirty_streams;
     bool m_update_shader;
     bool m_update_shader_border;
     ocg::ExecuteStatus m_exec_status;
 
+    // Background graph evaluation. The last successfully computed
+    // stream is kept and drawn until a newer one is ready.
+    graph::AsyncExecutor m_async_executor;
+
+    // Bakes large color transform LUTs in the background.
+    LutBaker m_lut_baker;
+    std::shared_ptr<ocg::StreamData> m_stream_data;
+    uint64_t m_stream_request_id;
+    double m_stream_frame;
+    double m_requested_frame;
+    bool m_is_stale;
+
+    // The windows of the requested frame, found from the file
+    // headers, at the proxy resolution.
+    image_spec::ImageSpec m_requested_spec;
+
+    // The spec of the viewer input plug on a frame, at the resolution
+    // of the files read, kept until the input stream, the plug or the
+    // frame changes.
+    image_spec::ImageSpec m_input_spec;
+    std::string m_input_spec_plug_name;
+    double m_input_spec_frame;
+
+    // Lens deformers found upstream. When the shader can evaluate
+    // them, the canvas vertices are not deformed on the CPU.
+    std::vector<lens_deformer::LensDeformer> m_lens_deformers;
+    bool m_deform_in_shader;
+
+    // Color operations found upstream, and the color operations the
+    // uploaded color-ops LUTs were baked for. The LUTs are only
+    // re-baked when the keys differ.
+    color_ops::ColorOpsKey m_color_ops_key;
+    color_ops::ColorOpsKey m_color_ops_lut_key;
+    uint32_t m_color_ops_lut_edge_size;
+    bool m_has_color_ops_lut;
+
+    // Grade and transform nodes at the end of the input stream that
+    // are drawn by the shader. The viewer node reads the stream
+    // above them, so editing them does not execute the graph.
+    viewer_ops::ViewerOps m_viewer_ops;
+
+    // Scopes of the displayed stream, only computed while they are
+    // displayed.
+    std::shared_ptr<const scopes::ImageScopes> m_image_scopes;
+
     // Cached attribute values
     float m_focal_length;
     uint8_t m_display_mode;
@@ -173,11 +312,15 @@ private:
     float m_display_soft_clip;
     bool m_display_use_draw_depth;
     float m_display_draw_depth;
+    uint8_t m_display_scopes;
     float m_card_depth;
     float m_card_size_x;
     float m_card_size_y;
     uint32_t m_card_res_x;
     uint32_t m_card_res_y;
+    bool m_card_adaptive;
+    float m_card_adaptive_tolerance;
+    uint32_t m_card_adaptive_max_level;
     float m_time;
     uint32_t m_lut_edge_size;
     std::string m_from_color_space_name;
@@ -185,9 +328,17 @@ private:
     uint8_t m_cache_option;
     uint8_t m_cache_pixel_data_type;
     bool m_cache_crop_on_format;
+    int32_t m_proxy_resolution;
+    int32_t m_resolved_proxy_resolution;
     bool m_disk_cache_enable;
     MString m_disk_cache_file_path;
+    bool m_async_evaluation;
+    bool m_display_stale_indicator;
+    bool m_viewer_fast_path;
     ocg::Node m_in_stream_node;
+    uint64_t m_graph_generation;
+    ocg::Node m_viewer_input_node;
+    ocg::Node m_proxy_node;
     ocg::Node m_viewer_node;
     ocg::Node m_read_cache_node;
     int m_display_window_width;
@@ -197,6 +348,16 @@ private:
     int m_data_window_max_x;
     int m_data_window_max_y;
 
+    // Attribute change tracking.
+    uint32_t m_dirty_flags;
+    uint32_t m_connected_flags;
+    bool m_connected_flags_dirty;
+    MCallbackIdArray m_callback_ids;
+    MObjectHandle m_camera_node;
+    MCallbackIdArray m_camera_callback_ids;
+    MObjectHandle m_viewer_input_source_node;
+    MCallbackIdArray m_viewer_input_callback_ids;
+
     // Viewport 2.0 render item names
     static MString m_data_window_render_item_name;
     static MString m_display_window_render_item_name;
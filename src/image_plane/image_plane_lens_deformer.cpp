@@ -0,0 +1,595 @@
+/*
+ * Copyright (C) 2021 David Cattermole.
+ *
+ * This file is part of OpenCompGraphMaya.
+ *
+ * OpenCompGraphMaya is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * OpenCompGraphMaya is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OpenCompGraphMaya.  If not, see <https://www.gnu.org/licenses/>.
+ * ====================================================================
+ *
+ * Lens distortion deformers evaluated in the image plane vertex shader.
+ */
+
+// Maya
+#include <maya/MObject.h>
+#include <maya/MPlug.h>
+#include <maya/MString.h>
+#include <maya/MFn.h>
+#include <maya/MFnDependencyNode.h>
+#include <maya/MItDependencyGraph.h>
+#include <maya/MFloatMatrix.h>
+
+// STL
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// SSE is part of every x86-64 CPU, other CPUs use the scalar code.
+#if defined(__SSE__) || defined(_M_X64) || defined(__x86_64__)
+#define LENS_DEFORMER_USE_SSE 1
+#include <xmmintrin.h>
+#else
+#define LENS_DEFORMER_USE_SSE 0
+#endif
+
+// OCG
+#include "opencompgraph.h"
+
+// OCG Maya
+#include <comp_nodes/lens_distort_node.h>
+#include "image_plane_lens_deformer.h"
+#include "image_plane_shader.h"
+#include "../worker_pool.h"
+
+namespace ocg = open_comp_graph;
+
+namespace open_comp_graph_maya {
+namespace image_plane {
+namespace lens_deformer {
+
+// Shader parameter names, shared by the textured and solid shaders.
+const MString kEnableParameterName = "gLensDistortEnable";
+const MString kDirectionParameterName = "gLensDistortDirection";
+const MString kDistortionParameterName = "gLensDistortion";
+const MString kAnamorphicSqueezeParameterName = "gLensAnamorphicSqueeze";
+const MString kCurvatureXParameterName = "gLensCurvatureX";
+const MString kCurvatureYParameterName = "gLensCurvatureY";
+const MString kQuarticDistortionParameterName = "gLensQuarticDistortion";
+const MString kCanvasToLensParameterName = "gLensCanvasToLensTransform";
+const MString kLensToCanvasParameterName = "gLensLensToCanvasTransform";
+
+// Direction values understood by the shader.
+const int32_t kShaderDirectionUndistort = 0;
+const int32_t kShaderDirectionDistort = 1;
+
+bool LensDeformer::operator==(const LensDeformer &other) const {
+    return (direction == other.direction)
+        && (distortion == other.distortion)
+        && (anamorphic_squeeze == other.anamorphic_squeeze)
+        && (curvature_x == other.curvature_x)
+        && (curvature_y == other.curvature_y)
+        && (quartic_distortion == other.quartic_distortion)
+        && (lens_center_offset_x == other.lens_center_offset_x)
+        && (lens_center_offset_y == other.lens_center_offset_y);
+}
+
+bool LensDeformer::operator!=(const LensDeformer &other) const {
+    return !(*this == other);
+}
+
+MStatus find_upstream_deformers(
+        const MPlug &plug,
+        std::vector<LensDeformer> &deformers) {
+    MStatus status;
+    deformers.clear();
+    if (plug.isNull()) {
+        return MS::kSuccess;
+    }
+
+    // All OCG nodes are plug-in nodes, anything else (such as the
+    // 'time' node) ends the traversal.
+    MPlug root_plug(plug);
+    MItDependencyGraph it(
+        root_plug,
+        MFn::kPluginDependNode,
+        MItDependencyGraph::kUpstream,
+        MItDependencyGraph::kDepthFirst,
+        MItDependencyGraph::kNodeLevel,
+        &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    for (; !it.isDone(); it.next()) {
+        MObject node = it.currentItem();
+        MFnDependencyNode fn_node(node, &status);
+        if (!status || fn_node.typeId() != LensDistortNode::m_id) {
+            continue;
+        }
+
+        MPlug enable_plug(node, LensDistortNode::m_enable_attr);
+        if (!enable_plug.asBool()) {
+            continue;
+        }
+
+        LensDeformer deformer;
+        deformer.direction = static_cast<int32_t>(
+            MPlug(node, LensDistortNode::m_direction_attr).asShort());
+        deformer.distortion =
+            MPlug(node, LensDistortNode::m_distortion_attr).asFloat();
+        deformer.anamorphic_squeeze =
+            MPlug(node, LensDistortNode::m_anamorphic_squeeze_attr).asFloat();
+        deformer.curvature_x =
+            MPlug(node, LensDistortNode::m_curvature_x_attr).asFloat();
+        deformer.curvature_y =
+            MPlug(node, LensDistortNode::m_curvature_y_attr).asFloat();
+        deformer.quartic_distortion =
+            MPlug(node, LensDistortNode::m_quartic_distortion_attr).asFloat();
+        deformer.lens_center_offset_x =
+            MPlug(node, LensDistortNode::m_lens_center_offset_x_attr).asFloat();
+        deformer.lens_center_offset_y =
+            MPlug(node, LensDistortNode::m_lens_center_offset_y_attr).asFloat();
+        deformers.push_back(deformer);
+    }
+    return MS::kSuccess;
+}
+
+bool can_deform_on_cpu(
+        const std::vector<LensDeformer> &deformers,
+        const size_t stream_deformers_len) {
+    return (stream_deformers_len > 0)
+        && (deformers.size() == stream_deformers_len);
+}
+
+bool can_deform_in_shader(
+        const std::vector<LensDeformer> &deformers,
+        const size_t stream_deformers_len) {
+    return (stream_deformers_len > 0)
+        && (stream_deformers_len <= kMaxShaderDeformers)
+        && (deformers.size() == stream_deformers_len);
+}
+
+namespace {
+
+float display_window_half_diagonal(const ocg::BBox2Di &display_window) {
+    auto display_width = static_cast<float>(
+        display_window.max_x - display_window.min_x);
+    auto display_height = static_cast<float>(
+        display_window.max_y - display_window.min_y);
+    auto half_diagonal = 0.5f * std::sqrt(
+        (display_width * display_width)
+        + (display_height * display_height));
+    if (half_diagonal <= 0.0f) {
+        half_diagonal = 1.0f;
+    }
+    return half_diagonal;
+}
+
+// The number of fixed-point iterations used to invert the lens
+// model, the same as 'lens_distort' in the image plane shaders.
+const int kDistortIterations = 8;
+
+// Polynomial coefficients of the lens model.
+struct LensCoefficients {
+    float cxx;
+    float cxy;
+    float cyx;
+    float cyy;
+    float cxxx;
+    float cxxy;
+    float cxyy;
+    float cyxx;
+    float cyyx;
+    float cyyy;
+};
+
+LensCoefficients lens_coefficients(const LensDeformer &deformer) {
+    const float sq = deformer.anamorphic_squeeze;
+    const float ld = deformer.distortion;
+    const float qd = deformer.quartic_distortion;
+    LensCoefficients c;
+    c.cxx = ld / sq;
+    c.cxy = (ld + deformer.curvature_x) / sq;
+    c.cyx = ld + deformer.curvature_y;
+    c.cyy = ld;
+    c.cxxx = qd / sq;
+    c.cxxy = 2.0f * qd / sq;
+    c.cxyy = qd / sq;
+    c.cyxx = qd;
+    c.cyyx = 2.0f * qd;
+    c.cyyy = qd;
+    return c;
+}
+
+// The same lens model as 'lens_undistort' in the image plane shaders.
+void lens_undistort(
+        const LensCoefficients &c,
+        const float x, const float y,
+        float &out_x, float &out_y) {
+    const float x2 = x * x;
+    const float y2 = y * y;
+    const float x4 = x2 * x2;
+    const float y4 = y2 * y2;
+    const float x2y2 = x2 * y2;
+    out_x = x * (1.0f + c.cxx * x2 + c.cxy * y2
+                 + c.cxxx * x4 + c.cxxy * x2y2 + c.cxyy * y4);
+    out_y = y * (1.0f + c.cyx * x2 + c.cyy * y2
+                 + c.cyxx * x4 + c.cyyx * x2y2 + c.cyyy * y4);
+}
+
+// The same as 'lens_distort' in the image plane shaders.
+void lens_distort(
+        const LensCoefficients &c,
+        const float x, const float y,
+        float &out_x, float &out_y) {
+    float qx = x;
+    float qy = y;
+    for (int i = 0; i < kDistortIterations; ++i) {
+        float ux = 0.0f;
+        float uy = 0.0f;
+        lens_undistort(c, qx, qy, ux, uy);
+        qx = qx - (ux - x);
+        qy = qy - (uy - y);
+    }
+    out_x = qx;
+    out_y = qy;
+}
+
+// The canvas covers the data window with positions 0.0 to 1.0. The
+// lens coordinates are normalized so the display window diagonal is
+// 2.0 units, centered on the display window (offset by the lens
+// center, in units of the display window size).
+MFloatMatrix canvas_to_lens_transform(
+        const LensDeformer &deformer,
+        const ocg::BBox2Di &display_window,
+        const ocg::BBox2Di &data_window) {
+    auto display_width = static_cast<float>(
+        display_window.max_x - display_window.min_x);
+    auto display_height = static_cast<float>(
+        display_window.max_y - display_window.min_y);
+    auto half_diagonal = display_window_half_diagonal(display_window);
+    auto center_x =
+        (static_cast<float>(display_window.min_x) + (display_width * 0.5f))
+        + (deformer.lens_center_offset_x * display_width);
+    auto center_y =
+        (static_cast<float>(display_window.min_y) + (display_height * 0.5f))
+        + (deformer.lens_center_offset_y * display_height);
+
+    auto scale_x = static_cast<float>(
+        data_window.max_x - data_window.min_x) / half_diagonal;
+    auto scale_y = static_cast<float>(
+        data_window.max_y - data_window.min_y) / half_diagonal;
+    auto offset_x =
+        (static_cast<float>(data_window.min_x) - center_x) / half_diagonal;
+    auto offset_y =
+        (static_cast<float>(data_window.min_y) - center_y) / half_diagonal;
+    const float matrix_values[4][4] = {
+        // X
+        {scale_x,  0.0,      0.0, 0.0},
+        // Y
+        {0.0,      scale_y,  0.0, 0.0},
+        // Z
+        {0.0,      0.0,      1.0, 0.0},
+        // W
+        {offset_x, offset_y, 0.0, 1.0},
+    };
+    return MFloatMatrix(matrix_values);
+}
+
+} // namespace
+
+MStatus set_shader_params(
+        Shader &shader,
+        const bool enable,
+        const LensDeformer &deformer,
+        const ocg::BBox2Di &display_window,
+        const ocg::BBox2Di &data_window) {
+    MStatus status = shader.set_bool_param(kEnableParameterName, enable);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+    if (!enable) {
+        // The other values are not used by the shader.
+        return status;
+    }
+
+    const int32_t direction_distort =
+        static_cast<int32_t>(ocg::LensDistortDirection::kDistort);
+    int32_t direction = kShaderDirectionUndistort;
+    if (deformer.direction == direction_distort) {
+        direction = kShaderDirectionDistort;
+    }
+    status = shader.set_int_param(kDirectionParameterName, direction);
+    CHECK_MSTATUS(status);
+    status = shader.set_float_param(
+        kDistortionParameterName, deformer.distortion);
+    CHECK_MSTATUS(status);
+    status = shader.set_float_param(
+        kAnamorphicSqueezeParameterName, deformer.anamorphic_squeeze);
+    CHECK_MSTATUS(status);
+    status = shader.set_float_param(
+        kCurvatureXParameterName, deformer.curvature_x);
+    CHECK_MSTATUS(status);
+    status = shader.set_float_param(
+        kCurvatureYParameterName, deformer.curvature_y);
+    CHECK_MSTATUS(status);
+    status = shader.set_float_param(
+        kQuarticDistortionParameterName, deformer.quartic_distortion);
+    CHECK_MSTATUS(status);
+
+    MFloatMatrix canvas_to_lens = canvas_to_lens_transform(
+        deformer, display_window, data_window);
+    status = shader.set_float_matrix4x4_param(
+        kCanvasToLensParameterName, canvas_to_lens);
+    CHECK_MSTATUS(status);
+    status = shader.set_float_matrix4x4_param(
+        kLensToCanvasParameterName, canvas_to_lens.inverse());
+    CHECK_MSTATUS(status);
+    return status;
+}
+
+geometry_buffer::CanvasDeformFunction canvas_deform_function(
+        const LensDeformer &deformer,
+        const ocg::BBox2Di &display_window,
+        const ocg::BBox2Di &data_window) {
+    MFloatMatrix canvas_to_lens = canvas_to_lens_transform(
+        deformer, display_window, data_window);
+    const float scale_x = canvas_to_lens[0][0];
+    const float scale_y = canvas_to_lens[1][1];
+    const float offset_x = canvas_to_lens[3][0];
+    const float offset_y = canvas_to_lens[3][1];
+    const float half_diagonal = display_window_half_diagonal(display_window);
+    const bool distort =
+        deformer.direction
+        == static_cast<int32_t>(ocg::LensDistortDirection::kDistort);
+    const LensCoefficients coefficients = lens_coefficients(deformer);
+    return [=](const float x, const float y, float &out_x, float &out_y) {
+        const float lens_x = (x * scale_x) + offset_x;
+        const float lens_y = (y * scale_y) + offset_y;
+        if (distort) {
+            lens_distort(coefficients, lens_x, lens_y, out_x, out_y);
+        } else {
+            lens_undistort(coefficients, lens_x, lens_y, out_x, out_y);
+        }
+        out_x *= half_diagonal;
+        out_y *= half_diagonal;
+    };
+}
+
+namespace {
+
+// Vertices are deformed in blocks, with the X and Y values stored in
+// separate arrays (structure-of-arrays) so the lens model is
+// evaluated on several vertices at once.
+const size_t kBlockSize = 256;
+
+// Tasks are only worth splitting for large cards; 128 x 128
+// divisions is about 16k vertices.
+const size_t kMinVerticesPerTask = 16384;
+
+// A deformer with everything that does not change per-vertex
+// computed up-front.
+struct BlockDeformer {
+    LensCoefficients coefficients;
+    bool distort;
+    float canvas_to_lens_scale_x;
+    float canvas_to_lens_scale_y;
+    float canvas_to_lens_offset_x;
+    float canvas_to_lens_offset_y;
+    float lens_to_canvas_scale_x;
+    float lens_to_canvas_scale_y;
+};
+
+BlockDeformer block_deformer(
+        const LensDeformer &deformer,
+        const ocg::BBox2Di &display_window,
+        const ocg::BBox2Di &data_window) {
+    MFloatMatrix canvas_to_lens = canvas_to_lens_transform(
+        deformer, display_window, data_window);
+    BlockDeformer block;
+    block.coefficients = lens_coefficients(deformer);
+    block.distort =
+        deformer.direction
+        == static_cast<int32_t>(ocg::LensDistortDirection::kDistort);
+    block.canvas_to_lens_scale_x = canvas_to_lens[0][0];
+    block.canvas_to_lens_scale_y = canvas_to_lens[1][1];
+    block.canvas_to_lens_offset_x = canvas_to_lens[3][0];
+    block.canvas_to_lens_offset_y = canvas_to_lens[3][1];
+    // An empty data window has no area to deform.
+    block.lens_to_canvas_scale_x = 0.0f;
+    block.lens_to_canvas_scale_y = 0.0f;
+    if (block.canvas_to_lens_scale_x != 0.0f) {
+        block.lens_to_canvas_scale_x = 1.0f / block.canvas_to_lens_scale_x;
+    }
+    if (block.canvas_to_lens_scale_y != 0.0f) {
+        block.lens_to_canvas_scale_y = 1.0f / block.canvas_to_lens_scale_y;
+    }
+    return block;
+}
+
+// Undistort 'count' lens coordinates, 'count' must be a multiple of
+// 4 and the arrays 16-byte aligned. The input and output arrays may
+// be the same.
+void lens_undistort_block(
+        const LensCoefficients &c,
+        const float *x, const float *y,
+        float *out_x, float *out_y,
+        const size_t count) {
+#if LENS_DEFORMER_USE_SSE
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 cxx = _mm_set1_ps(c.cxx);
+    const __m128 cxy = _mm_set1_ps(c.cxy);
+    const __m128 cyx = _mm_set1_ps(c.cyx);
+    const __m128 cyy = _mm_set1_ps(c.cyy);
+    const __m128 cxxx = _mm_set1_ps(c.cxxx);
+    const __m128 cxxy = _mm_set1_ps(c.cxxy);
+    const __m128 cxyy = _mm_set1_ps(c.cxyy);
+    const __m128 cyxx = _mm_set1_ps(c.cyxx);
+    const __m128 cyyx = _mm_set1_ps(c.cyyx);
+    const __m128 cyyy = _mm_set1_ps(c.cyyy);
+    for (size_t i = 0; i < count; i += 4) {
+        const __m128 vx = _mm_load_ps(x + i);
+        const __m128 vy = _mm_load_ps(y + i);
+        const __m128 x2 = _mm_mul_ps(vx, vx);
+        const __m128 y2 = _mm_mul_ps(vy, vy);
+        const __m128 x4 = _mm_mul_ps(x2, x2);
+        const __m128 y4 = _mm_mul_ps(y2, y2);
+        const __m128 x2y2 = _mm_mul_ps(x2, y2);
+
+        __m128 fx = _mm_add_ps(one, _mm_mul_ps(cxx, x2));
+        fx = _mm_add_ps(fx, _mm_mul_ps(cxy, y2));
+        fx = _mm_add_ps(fx, _mm_mul_ps(cxxx, x4));
+        fx = _mm_add_ps(fx, _mm_mul_ps(cxxy, x2y2));
+        fx = _mm_add_ps(fx, _mm_mul_ps(cxyy, y4));
+
+        __m128 fy = _mm_add_ps(one, _mm_mul_ps(cyx, x2));
+        fy = _mm_add_ps(fy, _mm_mul_ps(cyy, y2));
+        fy = _mm_add_ps(fy, _mm_mul_ps(cyxx, x4));
+        fy = _mm_add_ps(fy, _mm_mul_ps(cyyx, x2y2));
+        fy = _mm_add_ps(fy, _mm_mul_ps(cyyy, y4));
+
+        _mm_store_ps(out_x + i, _mm_mul_ps(vx, fx));
+        _mm_store_ps(out_y + i, _mm_mul_ps(vy, fy));
+    }
+#else
+    for (size_t i = 0; i < count; ++i) {
+        lens_undistort(c, x[i], y[i], out_x[i], out_y[i]);
+    }
+#endif
+}
+
+// Deform a block of canvas positions, in place.
+void deform_block(
+        const BlockDeformer &deformer,
+        float *x, float *y,
+        const size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        x[i] = (x[i] * deformer.canvas_to_lens_scale_x)
+            + deformer.canvas_to_lens_offset_x;
+        y[i] = (y[i] * deformer.canvas_to_lens_scale_y)
+            + deformer.canvas_to_lens_offset_y;
+    }
+
+    if (!deformer.distort) {
+        lens_undistort_block(deformer.coefficients, x, y, x, y, count);
+    } else {
+        alignas(16) float px[kBlockSize];
+        alignas(16) float py[kBlockSize];
+        alignas(16) float ux[kBlockSize];
+        alignas(16) float uy[kBlockSize];
+        std::copy(x, x + count, px);
+        std::copy(y, y + count, py);
+        for (int iteration = 0; iteration < kDistortIterations; ++iteration) {
+            lens_undistort_block(deformer.coefficients, x, y, ux, uy, count);
+            for (size_t i = 0; i < count; ++i) {
+                x[i] = x[i] - (ux[i] - px[i]);
+                y[i] = y[i] - (uy[i] - py[i]);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        x[i] = (x[i] - deformer.canvas_to_lens_offset_x)
+            * deformer.lens_to_canvas_scale_x;
+        y[i] = (y[i] - deformer.canvas_to_lens_offset_y)
+            * deformer.lens_to_canvas_scale_y;
+    }
+}
+
+// Deform the positions with indices 'start' to 'end', reading from
+// 'in_positions' and writing to 'out_positions'.
+void deform_positions_range(
+        const std::vector<BlockDeformer> &deformers,
+        const float *in_positions,
+        float *out_positions,
+        const size_t start,
+        const size_t end) {
+    alignas(16) float x[kBlockSize];
+    alignas(16) float y[kBlockSize];
+    for (size_t block_start = start; block_start < end;
+         block_start += kBlockSize) {
+        const size_t count = std::min(kBlockSize, end - block_start);
+        const float *in_block = in_positions + (block_start * 3);
+        float *out_block = out_positions + (block_start * 3);
+
+        // Pad to a whole number of SIMD lanes.
+        const size_t padded_count = (count + 3) & ~static_cast<size_t>(3);
+        for (size_t i = 0; i < count; ++i) {
+            x[i] = in_block[(i * 3) + 0];
+            y[i] = in_block[(i * 3) + 1];
+        }
+        for (size_t i = count; i < padded_count; ++i) {
+            x[i] = 0.0f;
+            y[i] = 0.0f;
+        }
+
+        for (const auto &deformer : deformers) {
+            deform_block(deformer, x, y, padded_count);
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            out_block[(i * 3) + 0] = x[i];
+            out_block[(i * 3) + 1] = y[i];
+            out_block[(i * 3) + 2] = in_block[(i * 3) + 2];
+        }
+    }
+}
+
+// Split the positions into contiguous ranges (whole rows of the
+// card, in blocks) and deform the ranges on the worker pool.
+void deform_positions(
+        const std::vector<BlockDeformer> &deformers,
+        const float *in_positions,
+        float *out_positions,
+        const size_t count) {
+    size_t task_count = std::min(
+        worker_pool::max_task_count(),
+        std::max<size_t>(1, count / kMinVerticesPerTask));
+    if (task_count <= 1) {
+        deform_positions_range(
+            deformers, in_positions, out_positions, 0, count);
+        return;
+    }
+
+    size_t range_size = (count + task_count - 1) / task_count;
+    range_size = ((range_size + kBlockSize - 1) / kBlockSize) * kBlockSize;
+    task_count = (count + range_size - 1) / range_size;
+    worker_pool::run_tasks(task_count, [&](const size_t task_index) {
+        const size_t start = task_index * range_size;
+        const size_t end = std::min(start + range_size, count);
+        deform_positions_range(
+            deformers, in_positions, out_positions, start, end);
+    });
+}
+
+} // namespace
+
+geometry_buffer::CanvasPositionsDeformFunction
+canvas_positions_deform_function(
+        const std::vector<LensDeformer> &deformers,
+        const ocg::BBox2Di &display_window,
+        const ocg::BBox2Di &data_window) {
+    // The upstream deformers are found nearest-first, the stream
+    // applies them in the opposite order.
+    std::vector<BlockDeformer> block_deformers;
+    block_deformers.reserve(deformers.size());
+    for (auto it = deformers.rbegin(); it != deformers.rend(); ++it) {
+        block_deformers.push_back(
+            block_deformer(*it, display_window, data_window));
+    }
+    return [=](const float *in_positions,
+               float *out_positions,
+               const size_t count) {
+        deform_positions(block_deformers, in_positions, out_positions, count);
+    };
+}
+
+} // namespace lens_deformer
+} // namespace image_plane
+} // namespace open_comp_graph_maya
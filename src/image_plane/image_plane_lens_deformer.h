@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2021 David Cattermole.
+ *
+ * This file is part of OpenCompGraphMaya.
+ *
+ * OpenCompGraphMaya is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * OpenCompGraphMaya is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OpenCompGraphMaya.  If not, see <https://www.gnu.org/licenses/>.
+ * ====================================================================
+ *
+ * Lens distortion deformers evaluated in the image plane vertex shader.
+ */
+
+#ifndef OPENCOMPGRAPHMAYA_IMAGE_PLANE_LENS_DEFORMER_H
+#define OPENCOMPGRAPHMAYA_IMAGE_PLANE_LENS_DEFORMER_H
+
+// Maya
+#include <maya/MPlug.h>
+#include <maya/MString.h>
+
+// STL
+#include <vector>
+
+// OCG
+#include "opencompgraph.h"
+
+// OCG Maya
+#include "geometry_buffer.h"
+#include "image_plane_shader.h"
+
+namespace ocg = open_comp_graph;
+
+namespace open_comp_graph_maya {
+namespace image_plane {
+namespace lens_deformer {
+
+// The most deformers the vertex shader can evaluate. Streams with
+// more deformers are deformed on the CPU.
+const size_t kMaxShaderDeformers = 1;
+
+// The parameters of an 'ocgLensDistort' node (3DE4 Classic model).
+struct LensDeformer {
+    LensDeformer()
+        : direction(0)
+        , distortion(0.0f)
+        , anamorphic_squeeze(1.0f)
+        , curvature_x(0.0f)
+        , curvature_y(0.0f)
+        , quartic_distortion(0.0f)
+        , lens_center_offset_x(0.0f)
+        , lens_center_offset_y(0.0f) {}
+
+    bool operator==(const LensDeformer &other) const;
+    bool operator!=(const LensDeformer &other) const;
+
+    int32_t direction;
+    float distortion;
+    float anamorphic_squeeze;
+    float curvature_x;
+    float curvature_y;
+    float quartic_distortion;
+    float lens_center_offset_x;
+    float lens_center_offset_y;
+};
+
+// Find the enabled lens distortion nodes upstream of 'plug'.
+MStatus find_upstream_deformers(
+    const MPlug &plug,
+    std::vector<LensDeformer> &deformers);
+
+// Can the C++ lens model evaluate all of the stream's deformers? Any
+// number of deformers can be evaluated on the CPU.
+bool can_deform_on_cpu(
+    const std::vector<LensDeformer> &deformers,
+    const size_t stream_deformers_len);
+
+// Can the vertex shader evaluate all of the stream's deformers?
+//
+// 'stream_deformers_len' is the number of deformers in the evaluated
+// stream; the upstream nodes found must account for all of them,
+// otherwise the CPU must apply the deformers.
+bool can_deform_in_shader(
+    const std::vector<LensDeformer> &deformers,
+    const size_t stream_deformers_len);
+
+// Set the lens distortion parameters of the shader. When 'enable' is
+// false the vertex positions are not changed by the shader.
+MStatus set_shader_params(
+    Shader &shader,
+    const bool enable,
+    const LensDeformer &deformer,
+    const ocg::BBox2Di &display_window,
+    const ocg::BBox2Di &data_window);
+
+// A function deforming canvas positions into display window pixels,
+// using the same lens model as the shader.
+geometry_buffer::CanvasDeformFunction canvas_deform_function(
+    const LensDeformer &deformer,
+    const ocg::BBox2Di &display_window,
+    const ocg::BBox2Di &data_window);
+
+// A function deforming canvas positions by all of 'deformers' (in
+// stream order), using the same lens model as the shader. The work
+// is vectorized and split across threads for large cards.
+geometry_buffer::CanvasPositionsDeformFunction
+canvas_positions_deform_function(
+    const std::vector<LensDeformer> &deformers,
+    const ocg::BBox2Di &display_window,
+    const ocg::BBox2Di &data_window);
+
+} // namespace lens_deformer
+} // namespace image_plane
+} // namespace open_comp_graph_maya
+
+#endif // OPENCOMPGRAPHMAYA_IMAGE_PLANE_LENS_DEFORMER_H
@@ -0,0 +1,230 @@
+/*
+ * Copyright (C) 2021 David Cattermole.
+ *
+ * This file is part of OpenCompGraphMaya.
+ *
+ * OpenCompGraphMaya is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * OpenCompGraphMaya is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OpenCompGraphMaya.  If not, see <https://www.gnu.org/licenses/>.
+ * ====================================================================
+ *
+ * Bakes color transform 3D LUTs on a background thread.
+ */
+
+// STL
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+
+// OCG
+#include "opencompgraph.h"
+
+// OCG Maya
+#include "global_cache.h"
+#include "logger.h"
+#include "image_plane_lut_baker.h"
+
+namespace ocg = open_comp_graph;
+
+namespace open_comp_graph_maya {
+namespace image_plane {
+
+ocg::internal::ImageShared bake_color_transform_3dlut(
+        const std::string &from_color_space,
+        const std::string &to_color_space,
+        const uint32_t lut_edge_size,
+        std::shared_ptr<ocg::Cache> &color_transform_cache) {
+    auto log = log::get_logger();
+    auto start_time = std::chrono::steady_clock::now();
+
+    rust::String from_color_space_string(from_color_space);
+    auto lut_image = ocg::get_color_transform_3dlut(
+        from_color_space_string, to_color_space.c_str(),
+        lut_edge_size, color_transform_cache);
+
+    auto end_time = std::chrono::steady_clock::now();
+    std::chrono::duration<double, std::milli> duration = end_time - start_time;
+    log->debug(
+        "Baked color transform 3D LUT {} to {}: edge_size={} time={:.2f} ms",
+        from_color_space, to_color_space, lut_edge_size, duration.count());
+    return lut_image;
+}
+
+ocg::internal::ImageShared bake_color_transform_3dlut(
+        const std::string &from_color_space,
+        const std::string &to_color_space,
+        const uint32_t lut_edge_size) {
+    // The cache may also be used by other image planes at the same
+    // time.
+    std::lock_guard<std::mutex> lock(
+        cache::get_shared_color_transform_cache_mutex());
+    auto &shared_color_transform_cache =
+        cache::get_shared_color_transform_cache();
+    return bake_color_transform_3dlut(
+        from_color_space, to_color_space, lut_edge_size,
+        shared_color_transform_cache);
+}
+
+LutBaker::LutBaker()
+        : m_started(false)
+        , m_stop(false)
+        , m_has_request(false)
+        , m_request_id(0)
+        , m_request_from_color_space()
+        , m_request_to_color_space()
+        , m_request_lut_edge_size(0)
+        , m_has_result(false)
+        , m_result()
+        , m_completed_callback()
+        , m_color_transform_cache() {}
+
+LutBaker::~LutBaker() {
+    this->stop();
+}
+
+void LutBaker::set_completed_callback(CompletedCallback callback) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_completed_callback = callback;
+}
+
+// The worker thread is only started when first needed, so image
+// planes that never use a large LUT do not cost a thread.
+void LutBaker::start() {
+    if (m_started) {
+        return;
+    }
+    m_stop = false;
+    m_thread = std::thread(&LutBaker::run, this);
+    m_started = true;
+}
+
+void LutBaker::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_started) {
+            return;
+        }
+        m_stop = true;
+        m_has_request = false;
+    }
+    m_condition.notify_all();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_started = false;
+}
+
+uint64_t LutBaker::request(
+        const std::string &from_color_space,
+        const std::string &to_color_space,
+        const uint32_t lut_edge_size) {
+    uint64_t request_id = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_request_id += 1;
+        m_request_from_color_space = from_color_space;
+        m_request_to_color_space = to_color_space;
+        m_request_lut_edge_size = lut_edge_size;
+        m_has_request = true;
+        request_id = m_request_id;
+        this->start();
+    }
+    m_condition.notify_one();
+    return request_id;
+}
+
+void LutBaker::cancel() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // A bake that is already running is discarded by its (now
+    // stale) request id.
+    m_request_id += 1;
+    m_has_request = false;
+    m_has_result = false;
+    m_result = LutBakeResult();
+}
+
+bool LutBaker::has_result() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_has_result;
+}
+
+uint64_t LutBaker::latest_request_id() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_request_id;
+}
+
+bool LutBaker::take_result(LutBakeResult &result) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_has_result) {
+        return false;
+    }
+    result = m_result;
+    m_result = LutBakeResult();
+    m_has_result = false;
+    return true;
+}
+
+void LutBaker::run() {
+    if (!m_color_transform_cache) {
+        m_color_transform_cache = std::make_shared<ocg::Cache>();
+        m_color_transform_cache->set_capacity_bytes(
+            kLutBakerCacheCapacityBytes);
+    }
+
+    while (true) {
+        LutBakeResult result;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this] {
+                return m_stop || m_has_request;
+            });
+            if (m_stop) {
+                break;
+            }
+            result.request_id = m_request_id;
+            result.from_color_space = m_request_from_color_space;
+            result.to_color_space = m_request_to_color_space;
+            result.lut_edge_size = m_request_lut_edge_size;
+            m_has_request = false;
+        }
+
+        auto lut_image = bake_color_transform_3dlut(
+            result.from_color_space,
+            result.to_color_space,
+            result.lut_edge_size,
+            m_color_transform_cache);
+        result.image = std::make_shared<ocg::internal::ImageShared>(
+            std::move(lut_image));
+
+        CompletedCallback callback;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (result.request_id != m_request_id) {
+                // Replaced or cancelled while baking.
+                continue;
+            }
+            m_result = result;
+            m_has_result = true;
+            callback = m_completed_callback;
+        }
+        if (callback) {
+            callback();
+        }
+    }
+}
+
+} // namespace image_plane
+} // namespace open_comp_graph_maya
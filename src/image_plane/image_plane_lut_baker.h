@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2021 David Cattermole.
+ *
+ * This file is part of OpenCompGraphMaya.
+ *
+ * OpenCompGraphMaya is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * OpenCompGraphMaya is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OpenCompGraphMaya.  If not, see <https://www.gnu.org/licenses/>.
+ * ====================================================================
+ *
+ * Bakes color transform 3D LUTs on a background thread.
+ */
+
+#ifndef OPENCOMPGRAPHMAYA_IMAGE_PLANE_LUT_BAKER_H
+#define OPENCOMPGRAPHMAYA_IMAGE_PLANE_LUT_BAKER_H
+
+// STL
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// OCG
+#include "opencompgraph.h"
+
+namespace ocg = open_comp_graph;
+
+namespace open_comp_graph_maya {
+namespace image_plane {
+
+// LUTs larger than this are first baked (quickly) at this edge size
+// and displayed while the full size LUT is baked in the background.
+const uint32_t kProgressiveLutEdgeSize = 17;
+
+// The memory used by the color transform cache of each LUT baker.
+const size_t kLutBakerCacheCapacityBytes = 32 * 1024 * 1024;  // 32MB
+
+// Bake a color transform 3D LUT, using the shared color transform
+// cache. The time taken is written to the debug log.
+ocg::internal::ImageShared bake_color_transform_3dlut(
+    const std::string &from_color_space,
+    const std::string &to_color_space,
+    const uint32_t lut_edge_size);
+
+// Bake a color transform 3D LUT, using 'color_transform_cache'. The
+// cache must not be used by any other thread at the same time.
+ocg::internal::ImageShared bake_color_transform_3dlut(
+    const std::string &from_color_space,
+    const std::string &to_color_space,
+    const uint32_t lut_edge_size,
+    std::shared_ptr<ocg::Cache> &color_transform_cache);
+
+// The outcome of a single background LUT bake.
+struct LutBakeResult {
+    LutBakeResult()
+        : request_id(0)
+        , from_color_space()
+        , to_color_space()
+        , lut_edge_size(0)
+        , image() {}
+
+    uint64_t request_id;
+    std::string from_color_space;
+    std::string to_color_space;
+    uint32_t lut_edge_size;
+    std::shared_ptr<ocg::internal::ImageShared> image;
+};
+
+// Bakes a color transform LUT on a worker thread, so changing the
+// color space or LUT edge size does not block the viewport.
+//
+// Only the newest request is kept; a request that has not started is
+// cancelled when a new request replaces it.
+//
+// The worker thread bakes with its own color transform cache, so a
+// long bake never holds the lock of the shared cache.
+class LutBaker {
+public:
+    // Called on the worker thread once a result is ready.
+    typedef std::function<void()> CompletedCallback;
+
+    LutBaker();
+    ~LutBaker();
+
+    void set_completed_callback(CompletedCallback callback);
+
+    // Queue a bake, replacing any pending request. Returns the new
+    // request id.
+    uint64_t request(
+        const std::string &from_color_space,
+        const std::string &to_color_space,
+        const uint32_t lut_edge_size);
+
+    // Cancel the pending request, and forget any result not yet
+    // taken.
+    void cancel();
+
+    // Is a result waiting to be taken?
+    bool has_result() const;
+
+    // The id of the newest request made.
+    uint64_t latest_request_id() const;
+
+    // Take the newest completed result. Returns false if no new
+    // result has finished since the last call.
+    bool take_result(LutBakeResult &result);
+
+    // Stop and join the worker thread, waiting for any running bake
+    // to finish.
+    void stop();
+
+private:
+    void start();
+    void run();
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::thread m_thread;
+    bool m_started;
+    bool m_stop;
+
+    // Pending request.
+    bool m_has_request;
+    uint64_t m_request_id;
+    std::string m_request_from_color_space;
+    std::string m_request_to_color_space;
+    uint32_t m_request_lut_edge_size;
+
+    // Latest completed result.
+    bool m_has_result;
+    LutBakeResult m_result;
+
+    CompletedCallback m_completed_callback;
+
+    // Only used by the worker thread.
+    std::shared_ptr<ocg::Cache> m_color_transform_cache;
+};
+
+} // namespace image_plane
+} // namespace open_comp_graph_maya
+
+#endif // OPENCOMPGRAPHMAYA_IMAGE_PLANE_LUT_BAKER_H
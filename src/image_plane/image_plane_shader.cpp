@@ -32,8 +32,10 @@
 #include <maya/MStateManager.h>
 
 // STL
+#include <array>
+#include <map>
 #include <memory>
-#include <cstdlib>
+#include <string>
 
 // OCG
 #include "opencompgraph.h"
@@ -41,6 +43,8 @@
 // OCG Maya
 #include "constant_texture_data.h"
 #include "image_plane_shader.h"
+#include "image_plane_shader_registry.h"
+#include "image_plane_texture_cache.h"
 #include "logger.h"
 
 namespace ocg = open_comp_graph;
@@ -48,11 +52,55 @@ namespace ocg = open_comp_graph;
 namespace open_comp_graph_maya {
 namespace image_plane {
 
-Shader::Shader() : m_shader(nullptr) {}
+namespace {
+
+// Has the parameter already been set to 'value'?
+template<typename T>
+bool param_is_unchanged(
+        const std::map<std::string, T> &params,
+        const MString &parameter_name,
+        const T &value) {
+    auto search = params.find(std::string(parameter_name.asChar()));
+    return (search != params.end()) && (search->second == value);
+}
+
+bool sampler_descriptions_are_equal(
+        const MHWRender::MSamplerStateDesc &a,
+        const MHWRender::MSamplerStateDesc &b) {
+    return a.filter == b.filter
+        && a.comparisonFn == b.comparisonFn
+        && a.addressU == b.addressU
+        && a.addressV == b.addressV
+        && a.addressW == b.addressW
+        && a.borderColor[0] == b.borderColor[0]
+        && a.borderColor[1] == b.borderColor[1]
+        && a.borderColor[2] == b.borderColor[2]
+        && a.borderColor[3] == b.borderColor[3]
+        && a.mipLODBias == b.mipLODBias
+        && a.minLOD == b.minLOD
+        && a.maxLOD == b.maxLOD
+        && a.maxAnisotropy == b.maxAnisotropy
+        && a.coordCount == b.coordCount
+        && a.elementIndex == b.elementIndex;
+}
+
+} // namespace
+
+Shader::Shader()
+        : m_shader(nullptr)
+        , m_has_stream_texture(false)
+        , m_stream_texture_key()
+        , m_param_updates_issued(0)
+        , m_param_updates_skipped(0) {}
 
 Shader::~Shader() {
     auto log = log::get_logger();
     log->debug("ocgImagePlane: Releasing shader...");
+    this->release_sampler_states();
+    if (m_has_stream_texture) {
+        texture_cache::release_stream_texture(m_stream_texture_key);
+        m_has_stream_texture = false;
+    }
     if (m_shader == nullptr) {
         return;
     }
@@ -162,73 +210,15 @@ Shader::compile_file(const MString shader_file_name) {
         return MS::kFailure;
     }
 
-    // TODO: Surely this should be run only once at plug-in start up?
-    MString shader_location;
-    MString cmd = MString("getModulePath -moduleName \"OpenCompGraphMaya\";");
-    if (!MGlobal::executeCommand(cmd, shader_location, false)) {
-        MString warning_message = MString(
-            "ocgImagePlane: Could not get module path, looking up env var.");
-        MGlobal::displayWarning(warning_message);
-        shader_location = MString(std::getenv("OPENCOMPGRAPHMAYA_LOCATION"));
-    }
-    shader_location += MString("/shader");
-    MString shader_path_message = MString(
-        "ocgImagePlane: Shader path is ") + shader_location;
-    MGlobal::displayWarning(shader_path_message);
-    shader_manager->addShaderPath(shader_location);
-
-    // Shader compiling options.
-    MShaderCompileMacro *macros = nullptr;
-    unsigned int number_of_macros = 0;
-    bool use_effect_cache = true;
-
-    // Get Techniques.
-    log->debug("ocgImagePlane: Get techniques...");
-    MStringArray technique_names;
-    shader_manager->getEffectsTechniques(
-        shader_file_name,
-        technique_names,
-        macros, number_of_macros,
-        use_effect_cache);
-    for (uint32_t i = 0; i < technique_names.length(); ++i) {
-        log->debug("ocgImagePlane: technique{}: {}", i, technique_names[i].asChar());
-    }
-    if (technique_names.length() == 0) {
-        log->error("ocgImagePlane: shader contains no techniques.");
-        return MS::kFailure;
-    }
-
-    // Compile shader.
-    log->debug("ocgImagePlane: Compiling shader...");
-    const MString technique_name(technique_names[0]);  // pick first technique.
-    m_shader = shader_manager->getEffectsFileShader(
-        shader_file_name, technique_name,
-        macros, number_of_macros,
-        use_effect_cache);
+    // The effect file is compiled only once for the plug-in, each
+    // image plane gets a clone to set its own parameters on.
+    m_shader = shader_registry::clone_effect(shader_manager, shader_file_name);
     if (!m_shader) {
-        MString error_message = MString(
-            "ocgImagePlane failed to compile shader.");
-        bool display_line_number = true;
-        bool filter_source = true;
-        uint32_t num_lines = 3;
-        MGlobal::displayError(error_message);
-        MGlobal::displayError(shader_manager->getLastError());
-        MGlobal::displayError(shader_manager->getLastErrorSource(
-                                  display_line_number, filter_source, num_lines));
-        log->error("ocgImagePlane failed to compile shader.");
-        log->error(shader_manager->getLastError().asChar());
-        log->error(shader_manager->getLastErrorSource(
-                       display_line_number, filter_source, num_lines).asChar());
+        log->error(
+            "ocgImagePlane: Failed to get shader effect: {}",
+            shader_file_name.asChar());
         return MS::kFailure;
     }
-
-    MStringArray parameter_list;
-    m_shader->parameterList(parameter_list);
-    for (uint32_t i = 0; i < parameter_list.length(); ++i) {
-        log->debug(
-            "ocgImagePlane: param {}: {}", i, parameter_list[i].asChar());
-    }
-
     return status;
 }
 
@@ -248,13 +238,20 @@ MStatus
 Shader::set_bool_param(
         const MString parameter_name,
         const bool value) {
+    if (param_is_unchanged(m_bool_params, parameter_name, value)) {
+        m_param_updates_skipped += 1;
+        return MS::kSuccess;
+    }
     MStatus status = m_shader->setParameter(
         parameter_name,
         value);
+    m_param_updates_issued += 1;
     if (status != MStatus::kSuccess) {
         auto log = log::get_logger();
         log->error("ocgImagePlane: Failed to set boolean parameter!");
+        return status;
     }
+    m_bool_params[parameter_name.asChar()] = value;
     return status;
 }
 
@@ -263,13 +260,20 @@ MStatus
 Shader::set_int_param(
         const MString parameter_name,
         const int32_t value) {
+    if (param_is_unchanged(m_int_params, parameter_name, value)) {
+        m_param_updates_skipped += 1;
+        return MS::kSuccess;
+    }
     MStatus status = m_shader->setParameter(
         parameter_name,
         value);
+    m_param_updates_issued += 1;
     if (status != MStatus::kSuccess) {
         auto log = log::get_logger();
         log->error("ocgImagePlane: Failed to set integer parameter!");
+        return status;
     }
+    m_int_params[parameter_name.asChar()] = value;
     return status;
 }
 
@@ -278,13 +282,20 @@ MStatus
 Shader::set_float_param(
         const MString parameter_name,
         const float value) {
+    if (param_is_unchanged(m_float_params, parameter_name, value)) {
+        m_param_updates_skipped += 1;
+        return MS::kSuccess;
+    }
     MStatus status = m_shader->setParameter(
         parameter_name,
         value);
+    m_param_updates_issued += 1;
     if (status != MStatus::kSuccess) {
         auto log = log::get_logger();
         log->error("ocgImagePlane: Failed to set float parameter!");
+        return status;
     }
+    m_float_params[parameter_name.asChar()] = value;
     return status;
 }
 
@@ -293,13 +304,22 @@ MStatus
 Shader::set_color_param(
         const MString parameter_name,
         const float color_values[4]) {
+    const std::array<float, 4> value = {{
+        color_values[0], color_values[1], color_values[2], color_values[3]}};
+    if (param_is_unchanged(m_color_params, parameter_name, value)) {
+        m_param_updates_skipped += 1;
+        return MS::kSuccess;
+    }
     MStatus status = m_shader->setParameter(
         parameter_name,
         color_values);
+    m_param_updates_issued += 1;
     if (status != MStatus::kSuccess) {
         auto log = log::get_logger();
         log->error("ocgImagePlane: Failed to set color parameter!");
+        return status;
     }
+    m_color_params[parameter_name.asChar()] = value;
     return status;
 }
 
@@ -308,13 +328,20 @@ MStatus
 Shader::set_float_matrix4x4_param(
         const MString parameter_name,
         const MFloatMatrix matrix) {
+    if (param_is_unchanged(m_matrix_params, parameter_name, matrix)) {
+        m_param_updates_skipped += 1;
+        return MS::kSuccess;
+    }
     MStatus status = m_shader->setParameter(
             parameter_name,
             matrix);
+    m_param_updates_issued += 1;
     if (status != MStatus::kSuccess) {
         auto log = log::get_logger();
         log->error("ocgImagePlane: Failed to set Matrix 4x4 parameter!");
+        return status;
     }
+    m_matrix_params[parameter_name.asChar()] = matrix;
     return status;
 }
 
@@ -344,70 +371,15 @@ Shader::set_texture_param_with_image_data(
         return MS::kFailure;
     }
 
-    // Upload Texture data to the GPU using Maya's API.
-    //
-    // See for details of values:
-    // http://help.autodesk.com/view/MAYAUL/2018/ENU/?guid=__cpp_ref_class_m_h_w_render_1_1_texture_description_html
-    MHWRender::MTextureDescription texture_description;
-    texture_description.setToDefault2DTexture();
-    texture_description.fWidth = pixel_width;
-    texture_description.fHeight = pixel_height;
-    texture_description.fDepth = pixel_depth;
-    texture_description.fTextureType = texture_type;
-    texture_description.fMipmaps = 1;
-
-    if (pixel_data_type == ocg::DataType::kUInt8) {
-        // log->warn("ocg::DataType::kUInt8");
-        // log->warn("MHWRender::kR8G8B8A8_UNORM");
-        texture_description.fFormat = MHWRender::kR8G8B8A8_UNORM;
-
-    } else if (pixel_data_type == ocg::DataType::kHalf16) {
-        // log->warn("ocg::DataType::kHalf16");
-        // log->warn("MHWRender::kR16G16B16A16_FLOAT");
-        texture_description.fFormat = MHWRender::kR16G16B16A16_FLOAT;
-
-    } else if (pixel_data_type == ocg::DataType::kUInt16) {
-        // log->warn("ocg::DataType::kUInt16");
-        // log->warn("MHWRender::kR16G16B16A16_UINT");
-        texture_description.fFormat = MHWRender::kR16G16B16A16_UINT;
-
-    } else if (pixel_data_type == ocg::DataType::kFloat32) {
-        // log->warn("ocg::DataType::kFloat32");
-        if (pixel_num_channels == 1) {
-            texture_description.fFormat = MHWRender::kR32_FLOAT;
-            // log->warn("MHWRender::kR32_FLOAT");
-        } else if (pixel_num_channels == 2) {
-            texture_description.fFormat = MHWRender::kR32G32_FLOAT;
-            // log->warn("MHWRender::kR32G32_FLOAT");
-        } else if (pixel_num_channels == 3) {
-            texture_description.fFormat = MHWRender::kR32G32B32_FLOAT;
-            // log->warn("MHWRender::kR32G32B32_FLOAT");
-        } else if (pixel_num_channels == 4) {
-            // log->warn("MHWRender::kR32G32B32A32_FLOAT");
-            texture_description.fFormat = MHWRender::kR32G32B32A32_FLOAT;
-        } else {
-            log->error("ocgImagePlane: Invalid number of channels in image.");
-            return MS::kFailure;
-        }
-
-    } else {
-        log->error(
-            "ocgImagePlane: Invalid image pixel data type: {}",
-            pixel_data_type);
-        return MS::kFailure;
-    }
-
-    // Using an empty texture name by-passes the MTextureManager's
-    // inbuilt caching system - so values are not remembered by
-    // Maya, we must store a cache.
-    MTexture *texture = texture_manager->acquireTexture(
-        /*textureName=*/ "",
-        texture_description,
-        buffer,
-        /*generateMipMaps=*/ false);
-
+    MTexture *texture = texture_cache::upload_texture(
+        texture_type,
+        pixel_width,
+        pixel_height,
+        pixel_depth,
+        pixel_num_channels,
+        pixel_data_type,
+        buffer);
     if (!texture) {
-        log->error("ocgImagePlane: Failed to acquire texture.");
         return MS::kFailure;
     }
 
@@ -416,58 +388,127 @@ Shader::set_texture_param_with_image_data(
     MHWRender::MTextureAssignment texture_resource;
     texture_resource.texture = texture;
     m_shader->setParameter(parameter_name, texture_resource);
+    m_param_updates_issued += 1;
     // Release our reference now that it is set on the shader
     texture_manager->releaseTexture(texture);
     return status;
 }
 
+// Set the texture parameter to the pixels of the stream.
+//
+// The texture is shared with all other shaders showing the same
+// stream pixels, so it is uploaded only once.
 MStatus
 Shader::set_texture_param_with_stream_data(
         const MString parameter_name,
-        ocg::StreamData stream_data) {
+        ocg::StreamData &stream_data) {
     auto log = log::get_logger();
     MStatus status = MS::kSuccess;
 
-    auto pixel_buffer = stream_data.pixel_buffer();
-    auto pixel_width = stream_data.pixel_width();
-    auto pixel_height = stream_data.pixel_height();
-    auto pixel_depth = 1;  // We do not support 3D textures.
-    auto pixel_num_channels = stream_data.pixel_num_channels();
-    auto pixel_data_type = stream_data.pixel_data_type();
+    auto texture_key = texture_cache::make_texture_key(stream_data);
+    if (m_has_stream_texture && (m_stream_texture_key == texture_key)) {
+        log->debug("ocgImagePlane: Texture is unchanged.");
+        m_param_updates_skipped += 1;
+        return status;
+    }
+
+    MTexture *texture = texture_cache::acquire_stream_texture(
+        stream_data, texture_key);
+    if (!texture) {
+        return MS::kFailure;
+    }
 
-    // log->warn("pixels: {}x{} c={}",
-    //           pixel_width,  pixel_height,
-    //           static_cast<uint32_t>(pixel_num_channels));
-    auto buffer = static_cast<const void*>(pixel_buffer.data());
+    log->debug("ocgImagePlane: Setting texture parameter...");
+    MHWRender::MTextureAssignment texture_resource;
+    texture_resource.texture = texture;
+    m_shader->setParameter(parameter_name, texture_resource);
+    m_param_updates_issued += 1;
 
-    return set_texture_param_with_image_data(
-        parameter_name,
-        MHWRender::kImage2D,
-        pixel_width,
-        pixel_height,
-        pixel_depth,
-        pixel_num_channels,
-        pixel_data_type,
-        buffer);
+    // The previous texture is only released after the shader no
+    // longer uses it.
+    if (m_has_stream_texture) {
+        texture_cache::release_stream_texture(m_stream_texture_key);
+    }
+    m_stream_texture_key = texture_key;
+    m_has_stream_texture = true;
+    return status;
 }
 
 // Acquire and bind the default texture sampler.
+//
+// The sampler state is kept until the sampler changes, rather than
+// acquired each time the parameter is set.
 MStatus
 Shader::set_texture_sampler_param(
         const MString parameter_name,
         MHWRender::MSamplerStateDesc sampler_description) {
     auto log = log::get_logger();
+    const std::string key(parameter_name.asChar());
+    auto search = m_sampler_params.find(key);
+    if ((search != m_sampler_params.end())
+        && sampler_descriptions_are_equal(
+            search->second.description, sampler_description)) {
+        m_param_updates_skipped += 1;
+        return MS::kSuccess;
+    }
+
     const MHWRender::MSamplerState* sampler =
         MHWRender::MStateManager::acquireSamplerState(sampler_description);
-    if (sampler) {
-        log->debug("ocgImagePlane: Setting texture sampler parameter...");
-        m_shader->setParameter(parameter_name, *sampler);
-    } else {
+    if (!sampler) {
         log->error("ocgImagePlane: Failed to get texture sampler.");
         return MS::kFailure;
     }
+    log->debug("ocgImagePlane: Setting texture sampler parameter...");
+    MStatus status = m_shader->setParameter(parameter_name, *sampler);
+    m_param_updates_issued += 1;
+    if (status != MStatus::kSuccess) {
+        log->error("ocgImagePlane: Failed to set texture sampler parameter!");
+        MHWRender::MStateManager::releaseSamplerState(sampler);
+        return status;
+    }
+
+    if (search != m_sampler_params.end()) {
+        MHWRender::MStateManager::releaseSamplerState(search->second.state);
+        search->second.description = sampler_description;
+        search->second.state = sampler;
+    } else {
+        SamplerParam sampler_param;
+        sampler_param.description = sampler_description;
+        sampler_param.state = sampler;
+        m_sampler_params.insert(std::make_pair(key, sampler_param));
+    }
     return MS::kSuccess;
 }
 
+void Shader::release_sampler_states() {
+    for (auto it = m_sampler_params.begin();
+         it != m_sampler_params.end(); ++it) {
+        MHWRender::MStateManager::releaseSamplerState(it->second.state);
+    }
+    m_sampler_params.clear();
+}
+
+void Shader::clear_param_cache() {
+    m_bool_params.clear();
+    m_int_params.clear();
+    m_float_params.clear();
+    m_color_params.clear();
+    m_matrix_params.clear();
+    this->release_sampler_states();
+}
+
+uint64_t Shader::param_updates_issued() const noexcept {
+    return m_param_updates_issued;
+}
+
+uint64_t Shader::param_updates_skipped() const noexcept {
+    return m_param_updates_skipped;
+}
+
+void Shader::reset_param_update_counts() noexcept {
+    m_param_updates_issued = 0;
+    m_param_updates_skipped = 0;
+}
+
 } // namespace image_plane
 } // namespace open_comp_graph_maya
@@ -37,14 +37,20 @@
 // Maya Viewport 2.0
 #include <maya/MHWGeometry.h>
 #include <maya/MHWGeometryUtilities.h>
+#include <maya/MStateManager.h>
 
 // STL
+#include <array>
 #include <map>
 #include <memory>
+#include <string>
 
 // OCG
 #include <opencompgraph.h>
 
+// OCG Maya
+#include "image_plane_texture_cache.h"
+
 
 namespace ocg = open_comp_graph;
 
@@ -104,12 +110,42 @@ public:
 
     MStatus set_texture_param_with_stream_data(
         const MString parameter_name,
-        ocg::StreamData stream_data);
+        ocg::StreamData &stream_data);
+
+    // Forget the remembered parameter values, so the next 'set_*'
+    // calls are always given to the shader instance.
+    void clear_param_cache();
+
+    // The number of parameter updates given to the shader instance,
+    // and the number skipped because the value was unchanged.
+    uint64_t param_updates_issued() const noexcept;
+    uint64_t param_updates_skipped() const noexcept;
+    void reset_param_update_counts() noexcept;
 
 private:
     const MHWRender::MShaderManager* get_shader_manager();
+    void release_sampler_states();
 
     MHWRender::MShaderInstance *m_shader;
+
+    // The values last set on the shader instance, by parameter
+    // name. Setting a parameter to its current value is skipped.
+    struct SamplerParam {
+        MHWRender::MSamplerStateDesc description;
+        const MHWRender::MSamplerState *state;
+    };
+    std::map<std::string, bool> m_bool_params;
+    std::map<std::string, int32_t> m_int_params;
+    std::map<std::string, float> m_float_params;
+    std::map<std::string, std::array<float, 4> > m_color_params;
+    std::map<std::string, MFloatMatrix> m_matrix_params;
+    std::map<std::string, SamplerParam> m_sampler_params;
+    uint64_t m_param_updates_issued;
+    uint64_t m_param_updates_skipped;
+
+    // The shared stream texture currently set on the shader.
+    bool m_has_stream_texture;
+    texture_cache::TextureKey m_stream_texture_key;
 };
 
 } // namespace image_plane
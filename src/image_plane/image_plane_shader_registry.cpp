@@ -0,0 +1,256 @@
+/*
+ * Copyright (C) 2021 David Cattermole.
+ *
+ * This file is part of OpenCompGraphMaya.
+ *
+ * OpenCompGraphMaya is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * OpenCompGraphMaya is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OpenCompGraphMaya.  If not, see <https://www.gnu.org/licenses/>.
+ * ====================================================================
+ *
+ * Plug-in wide registry of compiled shader effects.
+ */
+
+// Maya
+#include <maya/MString.h>
+#include <maya/MStringArray.h>
+#include <maya/MGlobal.h>
+
+// Maya Viewport 2.0
+#include <maya/MShaderManager.h>
+
+// STL
+#include <map>
+#include <string>
+#include <cstdlib>
+
+// OCG Maya
+#include "image_plane_shader_registry.h"
+#include "logger.h"
+
+namespace open_comp_graph_maya {
+namespace image_plane {
+namespace shader_registry {
+
+namespace {
+
+struct Registry {
+    Registry()
+        : directory()
+        , directory_added(false)
+        , effects() {}
+
+    MString directory;
+    bool directory_added;
+
+    // Compiled effects, keyed by effect file name. These instances
+    // are never assigned to a render item, they are only cloned.
+    std::map<std::string, MHWRender::MShaderInstance *> effects;
+};
+
+Registry &get_registry() {
+    static Registry registry;
+    return registry;
+}
+
+MString resolve_shader_directory() {
+    auto log = log::get_logger();
+    MString location;
+    MString cmd = MString("getModulePath -moduleName \"OpenCompGraphMaya\";");
+    if (!MGlobal::executeCommand(cmd, location, false)
+        || location.length() == 0) {
+        log->warn(
+            "ocgImagePlane: Could not get module path, "
+            "looking up OPENCOMPGRAPHMAYA_LOCATION env var.");
+        const char *env_value = std::getenv("OPENCOMPGRAPHMAYA_LOCATION");
+        if (env_value == nullptr) {
+            log->error(
+                "ocgImagePlane: OPENCOMPGRAPHMAYA_LOCATION is not set, "
+                "shaders cannot be found.");
+            return MString();
+        }
+        location = MString(env_value);
+    }
+    location += MString("/shader");
+    return location;
+}
+
+// The shader path can only be given to the shader manager once a
+// renderer exists, which may be after the plug-in is loaded.
+MStatus add_shader_directory(
+        Registry &registry,
+        const MHWRender::MShaderManager *shader_manager) {
+    if (registry.directory_added) {
+        return MS::kSuccess;
+    }
+    if (registry.directory.length() == 0) {
+        registry.directory = resolve_shader_directory();
+        if (registry.directory.length() == 0) {
+            return MS::kFailure;
+        }
+    }
+    auto log = log::get_logger();
+    log->info(
+        "ocgImagePlane: Shader path is {}",
+        registry.directory.asChar());
+    shader_manager->addShaderPath(registry.directory);
+    registry.directory_added = true;
+    return MS::kSuccess;
+}
+
+MHWRender::MShaderInstance *compile_effect(
+        const MHWRender::MShaderManager *shader_manager,
+        const MString effect_file_name) {
+    auto log = log::get_logger();
+    log->debug(
+        "ocgImagePlane: Compiling shader effect: {}",
+        effect_file_name.asChar());
+
+    // Shader compiling options.
+    MHWRender::MShaderCompileMacro *macros = nullptr;
+    unsigned int number_of_macros = 0;
+    bool use_effect_cache = true;
+
+    // Get Techniques.
+    MStringArray technique_names;
+    shader_manager->getEffectsTechniques(
+        effect_file_name,
+        technique_names,
+        macros, number_of_macros,
+        use_effect_cache);
+    for (uint32_t i = 0; i < technique_names.length(); ++i) {
+        log->debug("ocgImagePlane: technique{}: {}", i, technique_names[i].asChar());
+    }
+    if (technique_names.length() == 0) {
+        log->error("ocgImagePlane: shader contains no techniques.");
+        return nullptr;
+    }
+
+    // Compile shader.
+    const MString technique_name(technique_names[0]);  // pick first technique.
+    MHWRender::MShaderInstance *shader = shader_manager->getEffectsFileShader(
+        effect_file_name, technique_name,
+        macros, number_of_macros,
+        use_effect_cache);
+    if (!shader) {
+        MString error_message = MString(
+            "ocgImagePlane failed to compile shader.");
+        bool display_line_number = true;
+        bool filter_source = true;
+        uint32_t num_lines = 3;
+        MGlobal::displayError(error_message);
+        MGlobal::displayError(shader_manager->getLastError());
+        MGlobal::displayError(shader_manager->getLastErrorSource(
+                                  display_line_number, filter_source, num_lines));
+        log->error("ocgImagePlane failed to compile shader.");
+        log->error(shader_manager->getLastError().asChar());
+        log->error(shader_manager->getLastErrorSource(
+                       display_line_number, filter_source, num_lines).asChar());
+        return nullptr;
+    }
+
+    MStringArray parameter_list;
+    shader->parameterList(parameter_list);
+    for (uint32_t i = 0; i < parameter_list.length(); ++i) {
+        log->debug(
+            "ocgImagePlane: param {}: {}", i, parameter_list[i].asChar());
+    }
+    return shader;
+}
+
+} // namespace
+
+MStatus initialize() {
+    auto &registry = get_registry();
+    registry.directory = resolve_shader_directory();
+    registry.directory_added = false;
+    if (registry.directory.length() == 0) {
+        return MS::kFailure;
+    }
+
+    // When the plug-in is loaded in a session with Viewport 2.0
+    // running the shader path is added now, otherwise it is added
+    // when the first effect is compiled.
+    MHWRender::MRenderer *renderer = MHWRender::MRenderer::theRenderer();
+    if (renderer) {
+        const MHWRender::MShaderManager *shader_manager =
+            renderer->getShaderManager();
+        if (shader_manager) {
+            return add_shader_directory(registry, shader_manager);
+        }
+    }
+    return MS::kSuccess;
+}
+
+MStatus uninitialize() {
+    auto log = log::get_logger();
+    auto &registry = get_registry();
+
+    MHWRender::MRenderer *renderer = MHWRender::MRenderer::theRenderer();
+    const MHWRender::MShaderManager *shader_manager = nullptr;
+    if (renderer) {
+        shader_manager = renderer->getShaderManager();
+    }
+    if (shader_manager) {
+        for (auto it = registry.effects.begin();
+             it != registry.effects.end(); ++it) {
+            log->debug(
+                "ocgImagePlane: Releasing shader effect: {}",
+                it->first);
+            shader_manager->releaseShader(it->second);
+        }
+    } else if (!registry.effects.empty()) {
+        log->warn(
+            "ocgImagePlane: Shader manager is not available, "
+            "cannot release shader effects.");
+    }
+    registry.effects.clear();
+    registry.directory_added = false;
+    return MS::kSuccess;
+}
+
+MString shader_directory() {
+    return get_registry().directory;
+}
+
+MHWRender::MShaderInstance *clone_effect(
+        const MHWRender::MShaderManager *shader_manager,
+        const MString effect_file_name) {
+    if (shader_manager == nullptr) {
+        return nullptr;
+    }
+    auto &registry = get_registry();
+
+    const std::string key(effect_file_name.asChar());
+    MHWRender::MShaderInstance *effect = nullptr;
+    auto search = registry.effects.find(key);
+    if (search != registry.effects.end()) {
+        effect = search->second;
+    } else {
+        MStatus status = add_shader_directory(registry, shader_manager);
+        if (status != MS::kSuccess) {
+            return nullptr;
+        }
+        effect = compile_effect(shader_manager, effect_file_name);
+        if (effect == nullptr) {
+            // Failures are not remembered, so a fixed shader file
+            // can be compiled on the next attempt.
+            return nullptr;
+        }
+        registry.effects.insert(std::make_pair(key, effect));
+    }
+    return effect->clone();
+}
+
+} // namespace shader_registry
+} // namespace image_plane
+} // namespace open_comp_graph_maya
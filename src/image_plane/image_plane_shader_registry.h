@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2021 David Cattermole.
+ *
+ * This file is part of OpenCompGraphMaya.
+ *
+ * OpenCompGraphMaya is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * OpenCompGraphMaya is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OpenCompGraphMaya.  If not, see <https://www.gnu.org/licenses/>.
+ * ====================================================================
+ *
+ * Plug-in wide registry of compiled shader effects.
+ *
+ * Each effect file is compiled once and every image plane gets a
+ * clone of the compiled effect, so parameters can still be set per
+ * image plane.
+ */
+
+#ifndef OPENCOMPGRAPHMAYA_IMAGE_PLANE_SHADER_REGISTRY_H
+#define OPENCOMPGRAPHMAYA_IMAGE_PLANE_SHADER_REGISTRY_H
+
+// Maya
+#include <maya/MString.h>
+#include <maya/MStatus.h>
+
+// Maya Viewport 2.0
+#include <maya/MShaderManager.h>
+
+namespace open_comp_graph_maya {
+namespace image_plane {
+namespace shader_registry {
+
+// Resolve the shader directory of the module. Called once when the
+// plug-in is loaded.
+MStatus initialize();
+
+// Release all compiled effects. Called once when the plug-in is
+// unloaded.
+MStatus uninitialize();
+
+// The directory containing the plug-in's '.ogsfx' files.
+MString shader_directory();
+
+// Return a new shader instance for the named effect file, cloned
+// from the registered (compiled once) effect.
+//
+// The caller owns the returned instance and must release it with
+// 'MShaderManager::releaseShader'. Returns nullptr on failure.
+MHWRender::MShaderInstance *clone_effect(
+    const MHWRender::MShaderManager *shader_manager,
+    const MString effect_file_name);
+
+} // namespace shader_registry
+} // namespace image_plane
+} // namespace open_comp_graph_maya
+
+#endif // OPENCOMPGRAPHMAYA_IMAGE_PLANE_SHADER_REGISTRY_H
@@ -42,6 +42,9 @@
 #include <maya/MFnCamera.h>
 #include <maya/MFnPluginData.h>
 
+// STL
+#include <algorithm>
+
 // OCG
 #include "opencompgraph.h"
 
@@ -51,7 +54,9 @@
 #include "graph_data.h"
 #include "image_plane_shape.h"
 #include "attr_utils.h"
+#include "../image_spec.h"
 #include "../node_utils.h"
+#include "../proxy_resolution.h"
 
 namespace ocg = open_comp_graph;
 
@@ -90,18 +95,26 @@ MObject ShapeNode::m_display_gamma_attr;
 MObject ShapeNode::m_display_soft_clip_attr;
 MObject ShapeNode::m_display_use_draw_depth_attr;
 MObject ShapeNode::m_display_draw_depth_attr;
+MObject ShapeNode::m_display_scopes_attr;
 MObject ShapeNode::m_card_depth_attr;
 MObject ShapeNode::m_card_size_x_attr;
 MObject ShapeNode::m_card_size_y_attr;
 MObject ShapeNode::m_card_res_x_attr;
 MObject ShapeNode::m_card_res_y_attr;
+MObject ShapeNode::m_card_adaptive_attr;
+MObject ShapeNode::m_card_adaptive_tolerance_attr;
+MObject ShapeNode::m_card_adaptive_max_level_attr;
 MObject ShapeNode::m_color_space_name_attr;
 MObject ShapeNode::m_lut_edge_size_attr;
 MObject ShapeNode::m_cache_option_attr;
 MObject ShapeNode::m_cache_pixel_data_type_attr;
 MObject ShapeNode::m_cache_crop_on_format_attr;
+MObject ShapeNode::m_proxy_resolution_attr;
 MObject ShapeNode::m_disk_cache_enable_attr;
 MObject ShapeNode::m_disk_cache_file_path_attr;
+MObject ShapeNode::m_async_evaluation_attr;
+MObject ShapeNode::m_display_stale_indicator_attr;
+MObject ShapeNode::m_viewer_fast_path_attr;
 MObject ShapeNode::m_time_attr;
 
 // Output Attributes
@@ -115,6 +128,7 @@ MString ShapeNode::nodeName() {
 ShapeNode::ShapeNode()
         : m_node_uuid()
         , m_out_stream_node(ocg::Node(ocg::NodeType::kNull, 0))
+        , m_stream_spec()
 {}
 
 ShapeNode::~ShapeNode() {}
@@ -147,6 +161,8 @@ MStatus ShapeNode::compute(const MPlug & plug, MDataBlock & data) {
     // Pass the output node though the Maya DG.
     if (plug == m_out_stream_attr) {
         auto shared_graph = get_shared_graph();
+        std::lock_guard<std::recursive_mutex> graph_lock(
+            get_shared_graph_mutex());
         if (shared_graph) {
             if ((m_out_stream_node.get_id() != 0)
                     && shared_graph->node_exists(m_out_stream_node)) {
@@ -257,9 +273,29 @@ MBoundingBox ShapeNode::boundingBox() const {
     double multiplier_x = card_size_x_value.asCentimeters();
     double multiplier_y = card_size_y_value.asCentimeters();
 
-    // TODO: Replace this with a call to the OCG library.
-    MPoint corner1(-1.0 * multiplier_x, -1.0 * multiplier_y, 0.0);
-    MPoint corner2(1.0 * multiplier_x, 1.0 * multiplier_y, 0.0);
+    // The display window is fit horizontally into -1.0 to 1.0, as
+    // the geometry is, and the data window may extend outside of it.
+    double min_x = -1.0;
+    double min_y = -1.0;
+    double max_x = 1.0;
+    double max_y = 1.0;
+    const image_spec::ImageSpec &spec = m_stream_spec;
+    const ocg::BBox2Di &display = spec.display_window;
+    const ocg::BBox2Di &data = spec.data_window;
+    const double display_width = display.max_x - display.min_x;
+    const double display_height = display.max_y - display.min_y;
+    if (spec.is_known && (display_width > 0.0) && (display_height > 0.0)) {
+        const double fit_scale = display_width / 2.0;
+        const double center_x = display.min_x + (display_width / 2.0);
+        const double center_y = display.min_y + (display_height / 2.0);
+        min_x = (std::min(display.min_x, data.min_x) - center_x) / fit_scale;
+        min_y = (std::min(display.min_y, data.min_y) - center_y) / fit_scale;
+        max_x = (std::max(display.max_x, data.max_x) - center_x) / fit_scale;
+        max_y = (std::max(display.max_y, data.max_y) - center_y) / fit_scale;
+    }
+
+    MPoint corner1(min_x * multiplier_x, min_y * multiplier_y, 0.0);
+    MPoint corner2(max_x * multiplier_x, max_y * multiplier_y, 0.0);
     return MBoundingBox(corner1, corner2);
 }
 
@@ -427,6 +463,17 @@ MStatus ShapeNode::initialize() {
     CHECK_MSTATUS(nAttr.setMin(draw_depth_min));
     CHECK_MSTATUS(nAttr.setMax(draw_depth_max));
 
+    // Scopes
+    //
+    // Draw the histogram or waveform of the displayed stream over the
+    // viewport.
+    m_display_scopes_attr = eAttr.create(
+        "displayScopes", "dspscp", 0);
+    CHECK_MSTATUS(eAttr.addField("none", 0));
+    CHECK_MSTATUS(eAttr.addField("histogram", 1));
+    CHECK_MSTATUS(eAttr.addField("waveform", 2));
+    CHECK_MSTATUS(eAttr.setStorable(true));
+
     // Geometry Type Attribute
     //
     // The type of geometry that will draw the image.
@@ -499,6 +546,44 @@ MStatus ShapeNode::initialize() {
     CHECK_MSTATUS(nAttr.setMax(card_res_y_max));
     CHECK_MSTATUS(nAttr.setSoftMax(card_res_y_soft_max));
 
+    // Card Adaptive
+    //
+    // Subdivide the card cells where the lens distortion would be
+    // drawn with an error larger than the tolerance. The card
+    // resolution is the coarsest tessellation used.
+    bool card_adaptive_default = true;
+    m_card_adaptive_attr = nAttr.create(
+        "cardAdaptive", "crdadpt",
+        MFnNumericData::kBoolean, card_adaptive_default);
+    CHECK_MSTATUS(nAttr.setStorable(true));
+    CHECK_MSTATUS(nAttr.setKeyable(false));
+
+    // Card Adaptive Tolerance (in pixels)
+    float card_adaptive_tolerance_min = 0.01f;
+    float card_adaptive_tolerance_soft_max = 4.0f;
+    float card_adaptive_tolerance_default = 0.5f;
+    m_card_adaptive_tolerance_attr = nAttr.create(
+        "cardAdaptiveTolerance", "crdadpttol",
+        MFnNumericData::kFloat, card_adaptive_tolerance_default);
+    CHECK_MSTATUS(nAttr.setStorable(true));
+    CHECK_MSTATUS(nAttr.setKeyable(false));
+    CHECK_MSTATUS(nAttr.setMin(card_adaptive_tolerance_min));
+    CHECK_MSTATUS(nAttr.setSoftMax(card_adaptive_tolerance_soft_max));
+
+    // Card Adaptive Max Level
+    //
+    // The number of times a card cell may be split in half.
+    uint32_t card_adaptive_max_level_min = 0;
+    uint32_t card_adaptive_max_level_max = 6;
+    uint32_t card_adaptive_max_level_default = 3;
+    m_card_adaptive_max_level_attr = nAttr.create(
+        "cardAdaptiveMaxLevel", "crdadptmxl",
+        MFnNumericData::kInt, card_adaptive_max_level_default);
+    CHECK_MSTATUS(nAttr.setStorable(true));
+    CHECK_MSTATUS(nAttr.setKeyable(false));
+    CHECK_MSTATUS(nAttr.setMin(card_adaptive_max_level_min));
+    CHECK_MSTATUS(nAttr.setMax(card_adaptive_max_level_max));
+
     // Camera Plane Depth Attribute
 
     // Camera Plane Resolution Attribute
@@ -558,6 +643,53 @@ MStatus ShapeNode::initialize() {
     CHECK_MSTATUS(nAttr.setStorable(true));
     CHECK_MSTATUS(nAttr.setKeyable(false));
 
+    // Proxy Resolution
+    //
+    // Draw a reduced resolution copy of the image, by default as set
+    // in the preferences.
+    m_proxy_resolution_attr = eAttr.create(
+        "proxyResolution", "prxyres", proxy::kResolutionUseGlobal);
+    CHECK_MSTATUS(eAttr.addField("preferences", proxy::kResolutionUseGlobal));
+    CHECK_MSTATUS(eAttr.addField("full", proxy::kResolutionFull));
+    CHECK_MSTATUS(eAttr.addField("half", proxy::kResolutionHalf));
+    CHECK_MSTATUS(eAttr.addField("quarter", proxy::kResolutionQuarter));
+    CHECK_MSTATUS(eAttr.addField("eighth", proxy::kResolutionEighth));
+    CHECK_MSTATUS(eAttr.setStorable(true));
+
+    // Asynchronous Evaluation
+    //
+    // Evaluate the graph on a background thread and keep drawing the
+    // last completed image until the new image is ready.
+    bool async_evaluation_default = true;
+    m_async_evaluation_attr = nAttr.create(
+        "asyncEvaluation", "asyncevl",
+        MFnNumericData::kBoolean, async_evaluation_default);
+    CHECK_MSTATUS(nAttr.setStorable(true));
+    CHECK_MSTATUS(nAttr.setKeyable(false));
+
+    // Display Stale Indicator
+    //
+    // Draw text on the image plane while the displayed image is
+    // older than the requested frame.
+    bool display_stale_indicator_default = true;
+    m_display_stale_indicator_attr = nAttr.create(
+        "displayStaleIndicator", "dspstlind",
+        MFnNumericData::kBoolean, display_stale_indicator_default);
+    CHECK_MSTATUS(nAttr.setStorable(true));
+    CHECK_MSTATUS(nAttr.setKeyable(false));
+
+    // Viewer Fast Path
+    //
+    // Draw the color grade and transform nodes at the end of the
+    // input stream with the shader, so editing them does not
+    // evaluate the graph.
+    bool viewer_fast_path_default = true;
+    m_viewer_fast_path_attr = nAttr.create(
+        "viewerFastPath", "vwrfstpth",
+        MFnNumericData::kBoolean, viewer_fast_path_default);
+    CHECK_MSTATUS(nAttr.setStorable(true));
+    CHECK_MSTATUS(nAttr.setKeyable(false));
+
     // Time
     m_time_attr = uAttr.create("time", "tm", MFnUnitAttribute::kTime, 0.0);
     CHECK_MSTATUS(uAttr.setStorable(true));
@@ -581,12 +713,16 @@ MStatus ShapeNode::initialize() {
     CHECK_MSTATUS(addAttribute(m_display_soft_clip_attr));
     CHECK_MSTATUS(addAttribute(m_display_use_draw_depth_attr));
     CHECK_MSTATUS(addAttribute(m_display_draw_depth_attr));
+    CHECK_MSTATUS(addAttribute(m_display_scopes_attr));
     //
     CHECK_MSTATUS(addAttribute(m_card_depth_attr));
     CHECK_MSTATUS(addAttribute(m_card_size_x_attr));
     CHECK_MSTATUS(addAttribute(m_card_size_y_attr));
     CHECK_MSTATUS(addAttribute(m_card_res_x_attr));
     CHECK_MSTATUS(addAttribute(m_card_res_y_attr));
+    CHECK_MSTATUS(addAttribute(m_card_adaptive_attr));
+    CHECK_MSTATUS(addAttribute(m_card_adaptive_tolerance_attr));
+    CHECK_MSTATUS(addAttribute(m_card_adaptive_max_level_attr));
     //
     CHECK_MSTATUS(addAttribute(m_color_space_name_attr));
     CHECK_MSTATUS(addAttribute(m_lut_edge_size_attr));
@@ -594,10 +730,15 @@ MStatus ShapeNode::initialize() {
     CHECK_MSTATUS(addAttribute(m_cache_option_attr));
     CHECK_MSTATUS(addAttribute(m_cache_pixel_data_type_attr));
     CHECK_MSTATUS(addAttribute(m_cache_crop_on_format_attr));
+    CHECK_MSTATUS(addAttribute(m_proxy_resolution_attr));
     //
     CHECK_MSTATUS(addAttribute(m_disk_cache_enable_attr));
     CHECK_MSTATUS(addAttribute(m_disk_cache_file_path_attr));
     //
+    CHECK_MSTATUS(addAttribute(m_async_evaluation_attr));
+    CHECK_MSTATUS(addAttribute(m_display_stale_indicator_attr));
+    CHECK_MSTATUS(addAttribute(m_viewer_fast_path_attr));
+    //
     CHECK_MSTATUS(addAttribute(m_time_attr));
     CHECK_MSTATUS(addAttribute(m_in_stream_attr));
     CHECK_MSTATUS(addAttribute(m_out_stream_attr));
@@ -613,13 +754,18 @@ MStatus ShapeNode::initialize() {
     CHECK_MSTATUS(attributeAffects(m_display_soft_clip_attr, m_out_stream_attr));
     CHECK_MSTATUS(attributeAffects(m_display_use_draw_depth_attr, m_out_stream_attr));
     CHECK_MSTATUS(attributeAffects(m_display_draw_depth_attr, m_out_stream_attr));
+    CHECK_MSTATUS(attributeAffects(m_display_scopes_attr, m_out_stream_attr));
     CHECK_MSTATUS(attributeAffects(m_color_space_name_attr, m_out_stream_attr));
     CHECK_MSTATUS(attributeAffects(m_lut_edge_size_attr, m_out_stream_attr));
     CHECK_MSTATUS(attributeAffects(m_cache_option_attr, m_out_stream_attr));
     CHECK_MSTATUS(attributeAffects(m_cache_pixel_data_type_attr, m_out_stream_attr));
     CHECK_MSTATUS(attributeAffects(m_cache_crop_on_format_attr, m_out_stream_attr));
+    CHECK_MSTATUS(attributeAffects(m_proxy_resolution_attr, m_out_stream_attr));
     CHECK_MSTATUS(attributeAffects(m_disk_cache_enable_attr, m_out_stream_attr));
     CHECK_MSTATUS(attributeAffects(m_disk_cache_file_path_attr, m_out_stream_attr));
+    CHECK_MSTATUS(attributeAffects(m_async_evaluation_attr, m_out_stream_attr));
+    CHECK_MSTATUS(attributeAffects(m_display_stale_indicator_attr, m_out_stream_attr));
+    CHECK_MSTATUS(attributeAffects(m_viewer_fast_path_attr, m_out_stream_attr));
     CHECK_MSTATUS(attributeAffects(m_in_stream_attr, m_out_stream_attr));
 
     return MS::kSuccess;
@@ -50,6 +50,9 @@
 // OCG
 #include "opencompgraph.h"
 
+// OCG Maya
+#include "../image_spec.h"
+
 namespace ocg = open_comp_graph;
 
 namespace open_comp_graph_maya {
@@ -97,12 +100,16 @@ public:
     static MObject m_display_soft_clip_attr;
     static MObject m_display_use_draw_depth_attr;
     static MObject m_display_draw_depth_attr;
+    static MObject m_display_scopes_attr;
     //
     static MObject m_card_depth_attr;
     static MObject m_card_size_x_attr;
     static MObject m_card_size_y_attr;
     static MObject m_card_res_x_attr;
     static MObject m_card_res_y_attr;
+    static MObject m_card_adaptive_attr;
+    static MObject m_card_adaptive_tolerance_attr;
+    static MObject m_card_adaptive_max_level_attr;
     //
     static MObject m_color_space_name_attr;
     static MObject m_lut_edge_size_attr;
@@ -110,10 +117,15 @@ public:
     static MObject m_cache_option_attr;
     static MObject m_cache_pixel_data_type_attr;
     static MObject m_cache_crop_on_format_attr;
+    static MObject m_proxy_resolution_attr;
     //
     static MObject m_disk_cache_enable_attr;
     static MObject m_disk_cache_file_path_attr;
     //
+    static MObject m_async_evaluation_attr;
+    static MObject m_display_stale_indicator_attr;
+    static MObject m_viewer_fast_path_attr;
+    //
     static MObject m_time_attr;
     static MObject m_out_stream_attr;
 
@@ -128,6 +140,11 @@ public:
     // Output OCG node
     ocg::Node m_out_stream_node;
 
+    // The spec of the viewed stream on the current frame, set by the
+    // geometry override when it finds the spec, to size the bounding
+    // box.
+    image_spec::ImageSpec m_stream_spec;
+
     // Unique id for the node.
     MUuid m_node_uuid;
 };
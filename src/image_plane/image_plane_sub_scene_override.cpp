@@ -100,7 +100,9 @@ SubSceneOverride::SubSceneOverride(const MObject &obj)
           m_are_ui_drawables_dirty(true),
           m_instance_added_cb_id(0),
           m_instance_removed_cb_id(0),
-          m_in_stream_node(ocg::Node(ocg::NodeType::kNull, 0)) {
+          m_in_stream_node(ocg::Node(ocg::NodeType::kNull, 0)),
+          m_graph_generation(0),
+          m_stream_data() {
 
     MDagPath dag_path;
     if (MDagPath::getAPathTo(obj, dag_path)) {
@@ -166,7 +168,8 @@ void SubSceneOverride::update(
     bool in_stream_has_changed = false;
     MPlug in_stream_plug(m_locator_node, ShapeNode::m_in_stream_attr);
     std::tie(new_stream_node, in_stream_has_changed) =
-        utils::get_plug_value_stream(in_stream_plug, m_in_stream_node);
+        utils::get_plug_value_stream(
+            in_stream_plug, m_in_stream_node, m_graph_generation);
     auto shared_graph = get_shared_graph();
     if (!shared_graph) {
         log->error("OCG Graph is not valid.");
@@ -257,16 +260,21 @@ void SubSceneOverride::update(
 
     // Evaluate the OCG Graph.
     auto exec_status = ocg::ExecuteStatus::kUninitialized;
+    std::shared_ptr<ocg::StreamData> executed_stream_data;
     if (stream_values_changed > 0) {
         log->debug("ocgImagePlane: m_time={}", m_time);
         int32_t execute_frame = static_cast<int32_t>(std::lround(m_time));
         log->debug("ocgImagePlane: execute_frame={}", execute_frame);
         auto shared_cache = ocgm_cache::get_shared_cache();
-        exec_status = ocgm_graph::execute_ocg_graph(
+        exec_status = ocgm_graph::execute_ocg_graph_stream(
             m_in_stream_node,
             execute_frame,
             shared_graph,
-            shared_cache);
+            shared_cache,
+            executed_stream_data);
+        if (exec_status == ocg::ExecuteStatus::kSuccess) {
+            m_stream_data = executed_stream_data;
+        }
 
         // TODO: Get and check if the deformer has changed.
         vertex_values_changed += 1;
@@ -296,8 +304,8 @@ void SubSceneOverride::update(
     log->debug("update_topology={}", update_topology);
     log->debug("update_vertices={}", update_vertices);
 
-    if (update_vertices) {
-        auto stream_data = shared_graph->output_stream();
+    if (update_vertices && m_stream_data) {
+        ocg::StreamData &stream_data = *m_stream_data;
         auto num_deformers = stream_data.deformers_len();
         log->debug("Updating vertex position... num_deformers={}", num_deformers);
 
@@ -308,13 +316,12 @@ void SubSceneOverride::update(
 
         m_geometry_window_display.rebuild_vertex_buffer_positions();
         m_geometry_window_data.rebuild_vertex_buffer_positions();
-        m_geometry_canvas.rebuild_vertex_buffer_positions(
-            std::move(stream_data));
+        m_geometry_canvas.rebuild_vertex_buffer_positions(stream_data);
     }
 
     // Update Geometry.
-    if (update_topology) {
-        auto stream_data = shared_graph->output_stream();
+    if (update_topology && m_stream_data) {
+        ocg::StreamData &stream_data = *m_stream_data;
         auto display_window = stream_data.display_window();
         auto data_window = stream_data.data_window();
 
@@ -325,7 +332,7 @@ void SubSceneOverride::update(
 
         m_geometry_window_display.rebuild_buffer_all();
         m_geometry_window_data.rebuild_buffer_all();
-        m_geometry_canvas.rebuild_buffer_all(std::move(stream_data));
+        m_geometry_canvas.rebuild_buffer_all(stream_data);
 
         // The vertices have been updated already, so there's no need
         // to do it again.
@@ -496,7 +503,7 @@ void SubSceneOverride::update(
         CHECK_MSTATUS(status);
 
         if (exec_status == ocg::ExecuteStatus::kSuccess) {
-            auto stream_data = shared_graph->output_stream();
+            ocg::StreamData &stream_data = *m_stream_data;
 
             // Move display window to the image plane.
             auto display_window = stream_data.display_window();
@@ -624,7 +631,7 @@ void SubSceneOverride::update(
 
             status = m_shader.set_texture_param_with_stream_data(
                 m_shader_image_texture_parameter_name,
-                std::move(stream_data));
+                stream_data);
             CHECK_MSTATUS(status);
         }
     }
@@ -140,6 +140,10 @@ private:
     uint32_t m_card_res_y;
     float m_time;
     ocg::Node m_in_stream_node;
+    uint64_t m_graph_generation;
+
+    // The last stream executed.
+    std::shared_ptr<ocg::StreamData> m_stream_data;
 
     // Data kept for instances of this node (multiple DAG paths all
     // referring back to this single node).
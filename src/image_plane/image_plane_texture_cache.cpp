@@ -0,0 +1,262 @@
+/*
+ * Copyright (C) 2021 David Cattermole.
+ *
+ * This file is part of OpenCompGraphMaya.
+ *
+ * OpenCompGraphMaya is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * OpenCompGraphMaya is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OpenCompGraphMaya.  If not, see <https://www.gnu.org/licenses/>.
+ * ====================================================================
+ *
+ * Reference counted cache of uploaded stream textures.
+ */
+
+// Maya Viewport 2.0
+#include <maya/MShaderManager.h>
+#include <maya/MTextureManager.h>
+
+// STL
+#include <map>
+#include <tuple>
+
+// OCG
+#include "opencompgraph.h"
+
+// OCG Maya
+#include "image_plane_texture_cache.h"
+#include "logger.h"
+
+namespace ocg = open_comp_graph;
+
+namespace open_comp_graph_maya {
+namespace image_plane {
+namespace texture_cache {
+
+namespace {
+
+struct CacheEntry {
+    MHWRender::MTexture *texture;
+    uint32_t ref_count;
+};
+
+typedef std::map<TextureKey, CacheEntry> TextureMap;
+
+// Viewport 2.0 draws from the main thread only, so the cache is not
+// locked.
+TextureMap &get_texture_map() {
+    static TextureMap texture_map;
+    return texture_map;
+}
+
+MHWRender::MTextureManager *get_texture_manager() {
+    auto log = log::get_logger();
+    MHWRender::MRenderer *renderer = MHWRender::MRenderer::theRenderer();
+    if (!renderer) {
+        log->error("ocgImagePlane: Failed to get renderer.");
+        return nullptr;
+    }
+
+    MHWRender::MTextureManager *texture_manager =
+        renderer->getTextureManager();
+    if (!texture_manager) {
+        log->error("ocgImagePlane: Failed to get texture manager.");
+        return nullptr;
+    }
+    return texture_manager;
+}
+
+} // namespace
+
+bool TextureKey::operator==(const TextureKey &other) const {
+    return stream_hash == other.stream_hash
+        && pixel_width == other.pixel_width
+        && pixel_height == other.pixel_height
+        && pixel_num_channels == other.pixel_num_channels
+        && pixel_data_type == other.pixel_data_type;
+}
+
+bool TextureKey::operator<(const TextureKey &other) const {
+    return std::make_tuple(
+        stream_hash,
+        pixel_width,
+        pixel_height,
+        pixel_num_channels,
+        static_cast<uint32_t>(pixel_data_type))
+        < std::make_tuple(
+            other.stream_hash,
+            other.pixel_width,
+            other.pixel_height,
+            other.pixel_num_channels,
+            static_cast<uint32_t>(other.pixel_data_type));
+}
+
+TextureKey make_texture_key(ocg::StreamData &stream_data) {
+    TextureKey texture_key;
+    texture_key.stream_hash = stream_data.hash();
+    texture_key.pixel_width = stream_data.pixel_width();
+    texture_key.pixel_height = stream_data.pixel_height();
+    texture_key.pixel_num_channels = stream_data.pixel_num_channels();
+    texture_key.pixel_data_type = stream_data.pixel_data_type();
+    return texture_key;
+}
+
+MHWRender::MTexture *upload_texture(
+        const MHWRender::MTextureType texture_type,
+        const int32_t pixel_width,
+        const int32_t pixel_height,
+        const int32_t pixel_depth,
+        const int32_t pixel_num_channels,
+        const ocg::DataType pixel_data_type,
+        const void *buffer) {
+    auto log = log::get_logger();
+    MHWRender::MTextureManager *texture_manager = get_texture_manager();
+    if (!texture_manager) {
+        return nullptr;
+    }
+
+    // Upload Texture data to the GPU using Maya's API.
+    //
+    // See for details of values:
+    // http://help.autodesk.com/view/MAYAUL/2018/ENU/?guid=__cpp_ref_class_m_h_w_render_1_1_texture_description_html
+    MHWRender::MTextureDescription texture_description;
+    texture_description.setToDefault2DTexture();
+    texture_description.fWidth = pixel_width;
+    texture_description.fHeight = pixel_height;
+    texture_description.fDepth = pixel_depth;
+    texture_description.fTextureType = texture_type;
+    texture_description.fMipmaps = 1;
+
+    if (pixel_data_type == ocg::DataType::kUInt8) {
+        texture_description.fFormat = MHWRender::kR8G8B8A8_UNORM;
+
+    } else if (pixel_data_type == ocg::DataType::kHalf16) {
+        texture_description.fFormat = MHWRender::kR16G16B16A16_FLOAT;
+
+    } else if (pixel_data_type == ocg::DataType::kUInt16) {
+        texture_description.fFormat = MHWRender::kR16G16B16A16_UINT;
+
+    } else if (pixel_data_type == ocg::DataType::kFloat32) {
+        if (pixel_num_channels == 1) {
+            texture_description.fFormat = MHWRender::kR32_FLOAT;
+        } else if (pixel_num_channels == 2) {
+            texture_description.fFormat = MHWRender::kR32G32_FLOAT;
+        } else if (pixel_num_channels == 3) {
+            texture_description.fFormat = MHWRender::kR32G32B32_FLOAT;
+        } else if (pixel_num_channels == 4) {
+            texture_description.fFormat = MHWRender::kR32G32B32A32_FLOAT;
+        } else {
+            log->error("ocgImagePlane: Invalid number of channels in image.");
+            return nullptr;
+        }
+
+    } else {
+        log->error(
+            "ocgImagePlane: Invalid image pixel data type: {}",
+            pixel_data_type);
+        return nullptr;
+    }
+
+    // Using an empty texture name by-passes the MTextureManager's
+    // inbuilt caching system - so values are not remembered by
+    // Maya, we must store a cache.
+    MHWRender::MTexture *texture = texture_manager->acquireTexture(
+        /*textureName=*/ "",
+        texture_description,
+        buffer,
+        /*generateMipMaps=*/ false);
+    if (!texture) {
+        log->error("ocgImagePlane: Failed to acquire texture.");
+        return nullptr;
+    }
+    return texture;
+}
+
+MHWRender::MTexture *acquire_stream_texture(
+        ocg::StreamData &stream_data,
+        TextureKey &texture_key) {
+    auto log = log::get_logger();
+    texture_key = make_texture_key(stream_data);
+
+    auto &texture_map = get_texture_map();
+    auto search = texture_map.find(texture_key);
+    if (search != texture_map.end()) {
+        search->second.ref_count += 1;
+        log->debug(
+            "ocgImagePlane: Re-using texture: hash={} users={}",
+            texture_key.stream_hash, search->second.ref_count);
+        return search->second.texture;
+    }
+
+    auto pixel_buffer = stream_data.pixel_buffer();
+    auto pixel_depth = 1;  // We do not support 3D textures.
+    auto buffer = static_cast<const void*>(pixel_buffer.data());
+    MHWRender::MTexture *texture = upload_texture(
+        MHWRender::kImage2D,
+        texture_key.pixel_width,
+        texture_key.pixel_height,
+        pixel_depth,
+        texture_key.pixel_num_channels,
+        texture_key.pixel_data_type,
+        buffer);
+    if (!texture) {
+        return nullptr;
+    }
+
+    CacheEntry entry;
+    entry.texture = texture;
+    entry.ref_count = 1;
+    texture_map.insert(std::make_pair(texture_key, entry));
+    log->debug(
+        "ocgImagePlane: Uploaded texture: hash={} textures={}",
+        texture_key.stream_hash, texture_map.size());
+    return texture;
+}
+
+void release_stream_texture(const TextureKey &texture_key) {
+    auto &texture_map = get_texture_map();
+    auto search = texture_map.find(texture_key);
+    if (search == texture_map.end()) {
+        return;
+    }
+    search->second.ref_count -= 1;
+    if (search->second.ref_count > 0) {
+        return;
+    }
+
+    MHWRender::MTextureManager *texture_manager = get_texture_manager();
+    if (texture_manager) {
+        texture_manager->releaseTexture(search->second.texture);
+    }
+    texture_map.erase(search);
+}
+
+size_t count() {
+    return get_texture_map().size();
+}
+
+void clear() {
+    auto &texture_map = get_texture_map();
+    MHWRender::MTextureManager *texture_manager = nullptr;
+    if (MHWRender::MRenderer::theRenderer()) {
+        texture_manager = get_texture_manager();
+    }
+    if (texture_manager) {
+        for (auto it = texture_map.begin(); it != texture_map.end(); ++it) {
+            texture_manager->releaseTexture(it->second.texture);
+        }
+    }
+    texture_map.clear();
+}
+
+} // namespace texture_cache
+} // namespace image_plane
+} // namespace open_comp_graph_maya
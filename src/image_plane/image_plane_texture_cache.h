@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2021 David Cattermole.
+ *
+ * This file is part of OpenCompGraphMaya.
+ *
+ * OpenCompGraphMaya is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * OpenCompGraphMaya is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OpenCompGraphMaya.  If not, see <https://www.gnu.org/licenses/>.
+ * ====================================================================
+ *
+ * Reference counted cache of uploaded stream textures.
+ *
+ * Image planes viewing the same stream (for example one image plane
+ * per camera connected to the same node) share a single GPU texture.
+ */
+
+#ifndef OPENCOMPGRAPHMAYA_IMAGE_PLANE_TEXTURE_CACHE_H
+#define OPENCOMPGRAPHMAYA_IMAGE_PLANE_TEXTURE_CACHE_H
+
+// Maya
+#include <maya/MStatus.h>
+
+// Maya Viewport 2.0
+#include <maya/MTextureManager.h>
+
+// STL
+#include <cstdint>
+
+// OCG
+#include <opencompgraph.h>
+
+namespace ocg = open_comp_graph;
+
+namespace open_comp_graph_maya {
+namespace image_plane {
+namespace texture_cache {
+
+// Identifies the pixels of a stream and the texture format they are
+// uploaded with.
+struct TextureKey {
+    TextureKey()
+        : stream_hash(0)
+        , pixel_width(0)
+        , pixel_height(0)
+        , pixel_num_channels(0)
+        , pixel_data_type(ocg::DataType::kUnknown) {}
+
+    uint64_t stream_hash;
+    int32_t pixel_width;
+    int32_t pixel_height;
+    int32_t pixel_num_channels;
+    ocg::DataType pixel_data_type;
+
+    bool operator==(const TextureKey &other) const;
+    bool operator<(const TextureKey &other) const;
+};
+
+TextureKey make_texture_key(ocg::StreamData &stream_data);
+
+// Upload pixels into a new (un-cached) texture. The caller owns the
+// texture and must release it with the MTextureManager.
+MHWRender::MTexture *upload_texture(
+    const MHWRender::MTextureType texture_type,
+    const int32_t pixel_width,
+    const int32_t pixel_height,
+    const int32_t pixel_depth,
+    const int32_t pixel_num_channels,
+    const ocg::DataType pixel_data_type,
+    const void *buffer);
+
+// Get the texture for the stream, uploading the pixels only if no
+// other user holds a texture with the same key. Each successful
+// acquire must be matched by a 'release_stream_texture' call.
+MHWRender::MTexture *acquire_stream_texture(
+    ocg::StreamData &stream_data,
+    TextureKey &texture_key);
+
+void release_stream_texture(const TextureKey &texture_key);
+
+// The number of textures currently held in the cache.
+size_t count();
+
+// Release all textures, regardless of users. Called when the plug-in
+// is unloaded.
+void clear();
+
+} // namespace texture_cache
+} // namespace image_plane
+} // namespace open_comp_graph_maya
+
+#endif // OPENCOMPGRAPHMAYA_IMAGE_PLANE_TEXTURE_CACHE_H
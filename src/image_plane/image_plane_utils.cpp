@@ -34,6 +34,7 @@
 
 // STL
 #include <cmath>
+#include <mutex>
 #include <tuple>
 
 // OCG
@@ -206,7 +207,10 @@ get_plug_value_string(MPlug plug, MString old_value) {
 
 // Get the ocgStreamData type from the given plug.
 std::tuple<ocg::Node, bool>
-get_plug_value_stream(MPlug &plug, ocg::Node old_value) {
+get_plug_value_stream(
+        MPlug &plug,
+        ocg::Node old_value,
+        uint64_t &graph_generation) {
     MStatus status;
     auto log = log::get_logger();
 
@@ -219,8 +223,13 @@ get_plug_value_stream(MPlug &plug, ocg::Node old_value) {
         new_value = ocg::Node(ocg::NodeType::kNull, 0);
     }
 
+    // The generation is read without the graph lock, so a
+    // background execution never makes the stream look changed.
+    const uint64_t new_graph_generation = shared_graph->generation();
+    bool graph_is_dirty = new_graph_generation != graph_generation;
+    graph_generation = new_graph_generation;
     bool has_changed =
-        (shared_graph->state() != ocg::GraphState::kClean)
+        graph_is_dirty
         || (old_value.get_id() != new_value.get_id());
     if (has_changed) {
         value = new_value;
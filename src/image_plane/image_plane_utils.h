@@ -77,8 +77,15 @@ std::tuple<MString, bool>
 get_plug_value_string(MPlug plug, MString old_value);
 
 // Get the ocgStreamData type from the given plug.
+//
+// 'graph_generation' is the generation of the shared graph last
+// seen, and is updated; a change of the graph is a change of the
+// stream.
 std::tuple<ocg::Node, bool>
-get_plug_value_stream(MPlug &plug, ocg::Node old_value);
+get_plug_value_stream(
+    MPlug &plug,
+    ocg::Node old_value,
+    uint64_t &graph_generation);
 
 } // namespace utils
 } // namespace image_plane
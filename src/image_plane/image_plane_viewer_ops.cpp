@@ -0,0 +1,467 @@
+/*
+ * Copyright (C) 2021 David Cattermole.
+ *
+ * This file is part of OpenCompGraphMaya.
+ *
+ * OpenCompGraphMaya is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * OpenCompGraphMaya is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OpenCompGraphMaya.  If not, see <https://www.gnu.org/licenses/>.
+ * ====================================================================
+ *
+ * Color grade and 2D transform nodes drawn by the image plane shader
+ * instead of being evaluated by the graph.
+ */
+
+// Maya
+#include <maya/MObject.h>
+#include <maya/MPlug.h>
+#include <maya/MString.h>
+#include <maya/MFnDependencyNode.h>
+#include <maya/MFloatMatrix.h>
+
+// STL
+#include <cmath>
+#include <vector>
+
+// OCG
+#include "opencompgraph.h"
+
+// OCG Maya
+#include <comp_nodes/color_grade_node.h>
+#include <comp_nodes/image_transform_node.h>
+#include "image_plane_viewer_ops.h"
+#include "image_plane_shader.h"
+
+namespace ocg = open_comp_graph;
+
+namespace open_comp_graph_maya {
+namespace image_plane {
+namespace viewer_ops {
+
+namespace {
+
+const MString kGradeEnableParameterName = "gViewerGradeEnable";
+const MString kGradeProcessParameterName = "gViewerGradeProcess";
+const MString kGradeScaleParameterName = "gViewerGradeScale";
+const MString kGradeOffsetParameterName = "gViewerGradeOffset";
+const MString kGradeExponentParameterName = "gViewerGradeExponent";
+const MString kGradeReverseParameterName = "gViewerGradeReverse";
+const MString kGradeClampBlackParameterName = "gViewerGradeClampBlack";
+const MString kGradeClampWhiteParameterName = "gViewerGradeClampWhite";
+const MString kGradePremultParameterName = "gViewerGradePremult";
+const MString kGradeMixParameterName = "gViewerGradeMix";
+
+const size_t kChannels = 4;
+
+bool channels_equal(const float a[4], const float b[4]) {
+    for (size_t i = 0; i < kChannels; ++i) {
+        if (a[i] != b[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void set_channels(float values[4], const float value) {
+    for (size_t i = 0; i < kChannels; ++i) {
+        values[i] = value;
+    }
+}
+
+void get_plug_channels(
+        const MObject &node,
+        const MObject &attr_r,
+        const MObject &attr_g,
+        const MObject &attr_b,
+        const MObject &attr_a,
+        float values[4]) {
+    values[0] = MPlug(node, attr_r).asFloat();
+    values[1] = MPlug(node, attr_g).asFloat();
+    values[2] = MPlug(node, attr_b).asFloat();
+    values[3] = MPlug(node, attr_a).asFloat();
+}
+
+ViewerGrade get_grade(const MObject &node) {
+    ViewerGrade grade;
+    grade.process[0] = MPlug(node, ColorGradeNode::m_process_r_attr).asBool();
+    grade.process[1] = MPlug(node, ColorGradeNode::m_process_g_attr).asBool();
+    grade.process[2] = MPlug(node, ColorGradeNode::m_process_b_attr).asBool();
+    grade.process[3] = MPlug(node, ColorGradeNode::m_process_a_attr).asBool();
+    get_plug_channels(
+        node,
+        ColorGradeNode::m_black_point_r_attr,
+        ColorGradeNode::m_black_point_g_attr,
+        ColorGradeNode::m_black_point_b_attr,
+        ColorGradeNode::m_black_point_a_attr,
+        grade.black_point);
+    get_plug_channels(
+        node,
+        ColorGradeNode::m_white_point_r_attr,
+        ColorGradeNode::m_white_point_g_attr,
+        ColorGradeNode::m_white_point_b_attr,
+        ColorGradeNode::m_white_point_a_attr,
+        grade.white_point);
+    get_plug_channels(
+        node,
+        ColorGradeNode::m_lift_r_attr,
+        ColorGradeNode::m_lift_g_attr,
+        ColorGradeNode::m_lift_b_attr,
+        ColorGradeNode::m_lift_a_attr,
+        grade.lift);
+    get_plug_channels(
+        node,
+        ColorGradeNode::m_gain_r_attr,
+        ColorGradeNode::m_gain_g_attr,
+        ColorGradeNode::m_gain_b_attr,
+        ColorGradeNode::m_gain_a_attr,
+        grade.gain);
+    get_plug_channels(
+        node,
+        ColorGradeNode::m_multiply_r_attr,
+        ColorGradeNode::m_multiply_g_attr,
+        ColorGradeNode::m_multiply_b_attr,
+        ColorGradeNode::m_multiply_a_attr,
+        grade.multiply);
+    get_plug_channels(
+        node,
+        ColorGradeNode::m_offset_r_attr,
+        ColorGradeNode::m_offset_g_attr,
+        ColorGradeNode::m_offset_b_attr,
+        ColorGradeNode::m_offset_a_attr,
+        grade.offset);
+    get_plug_channels(
+        node,
+        ColorGradeNode::m_gamma_r_attr,
+        ColorGradeNode::m_gamma_g_attr,
+        ColorGradeNode::m_gamma_b_attr,
+        ColorGradeNode::m_gamma_a_attr,
+        grade.gamma);
+    grade.reverse = MPlug(node, ColorGradeNode::m_reverse_attr).asBool();
+    grade.clamp_black = MPlug(node, ColorGradeNode::m_clamp_black_attr).asBool();
+    grade.clamp_white = MPlug(node, ColorGradeNode::m_clamp_white_attr).asBool();
+    grade.premult = MPlug(node, ColorGradeNode::m_premult_attr).asBool();
+    grade.mix = MPlug(node, ColorGradeNode::m_mix_attr).asFloat();
+    return grade;
+}
+
+MFloatMatrix translate_matrix(const float x, const float y) {
+    const float matrix_values[4][4] = {
+        // X
+        {1.0, 0.0, 0.0, 0.0},
+        // Y
+        {0.0, 1.0, 0.0, 0.0},
+        // Z
+        {0.0, 0.0, 1.0, 0.0},
+        // W
+        {x,   y,   0.0, 1.0},
+    };
+    return MFloatMatrix(matrix_values);
+}
+
+MFloatMatrix scale_matrix(const float x, const float y) {
+    const float matrix_values[4][4] = {
+        // X
+        {x,   0.0, 0.0, 0.0},
+        // Y
+        {0.0, y,   0.0, 0.0},
+        // Z
+        {0.0, 0.0, 1.0, 0.0},
+        // W
+        {0.0, 0.0, 0.0, 1.0},
+    };
+    return MFloatMatrix(matrix_values);
+}
+
+// Counter-clockwise rotation.
+MFloatMatrix rotate_matrix(const float degrees) {
+    // Hard-code 'pi' so we don't have cross-platform problems
+    // between Linux and Windows.
+    const double pi = 3.14159265358979323846;
+    auto radians = static_cast<double>(degrees) * (pi / 180.0);
+    auto c = static_cast<float>(std::cos(radians));
+    auto s = static_cast<float>(std::sin(radians));
+    const float matrix_values[4][4] = {
+        // X
+        {c,    s,   0.0, 0.0},
+        // Y
+        {-s,   c,   0.0, 0.0},
+        // Z
+        {0.0,  0.0, 1.0, 0.0},
+        // W
+        {0.0,  0.0, 0.0, 1.0},
+    };
+    return MFloatMatrix(matrix_values);
+}
+
+// Scale about the pivot, rotate about the rotate center (relative to
+// the pivot), then translate.
+MFloatMatrix transform_matrix(
+        const ViewerTransform &transform,
+        const ocg::BBox2Di &display_window) {
+    auto display_width = static_cast<float>(
+        display_window.max_x - display_window.min_x);
+    auto display_height = static_cast<float>(
+        display_window.max_y - display_window.min_y);
+    auto pivot_x = static_cast<float>(display_window.min_x)
+        + (transform.pivot_x * display_width);
+    auto pivot_y = static_cast<float>(display_window.min_y)
+        + (transform.pivot_y * display_height);
+    auto center_x = pivot_x + (transform.rotate_center_x * display_width);
+    auto center_y = pivot_y + (transform.rotate_center_y * display_height);
+
+    MFloatMatrix matrix = translate_matrix(-pivot_x, -pivot_y);
+    matrix *= scale_matrix(transform.scale_x, transform.scale_y);
+    matrix *= translate_matrix(pivot_x - center_x, pivot_y - center_y);
+    matrix *= rotate_matrix(transform.rotate);
+    matrix *= translate_matrix(
+        center_x + (transform.translate_x * display_width),
+        center_y + (transform.translate_y * display_height));
+    if (transform.invert) {
+        matrix = matrix.inverse();
+    }
+    return matrix;
+}
+
+} // namespace
+
+ViewerTransform get_transform(const MObject &node) {
+    ViewerTransform transform;
+    transform.translate_x =
+        MPlug(node, ImageTransformNode::m_translate_x_attr).asFloat();
+    transform.translate_y =
+        MPlug(node, ImageTransformNode::m_translate_y_attr).asFloat();
+    transform.rotate =
+        MPlug(node, ImageTransformNode::m_rotate_attr).asFloat();
+    transform.rotate_center_x =
+        MPlug(node, ImageTransformNode::m_rotate_center_x_attr).asFloat();
+    transform.rotate_center_y =
+        MPlug(node, ImageTransformNode::m_rotate_center_y_attr).asFloat();
+    auto scale_uniform =
+        MPlug(node, ImageTransformNode::m_scale_uniform_attr).asFloat();
+    transform.scale_x = scale_uniform
+        * MPlug(node, ImageTransformNode::m_scale_x_attr).asFloat();
+    transform.scale_y = scale_uniform
+        * MPlug(node, ImageTransformNode::m_scale_y_attr).asFloat();
+    transform.pivot_x =
+        MPlug(node, ImageTransformNode::m_pivot_x_attr).asFloat();
+    transform.pivot_y =
+        MPlug(node, ImageTransformNode::m_pivot_y_attr).asFloat();
+    transform.invert =
+        MPlug(node, ImageTransformNode::m_invert_attr).asBool();
+    return transform;
+}
+
+ViewerGrade::ViewerGrade()
+        : reverse(false)
+        , clamp_black(false)
+        , clamp_white(false)
+        , premult(false)
+        , mix(1.0f) {
+    process[0] = true;
+    process[1] = true;
+    process[2] = true;
+    process[3] = false;
+    set_channels(black_point, 0.0f);
+    set_channels(white_point, 1.0f);
+    set_channels(lift, 0.0f);
+    set_channels(gain, 1.0f);
+    set_channels(multiply, 1.0f);
+    set_channels(offset, 0.0f);
+    set_channels(gamma, 1.0f);
+}
+
+bool ViewerGrade::operator==(const ViewerGrade &other) const {
+    for (size_t i = 0; i < kChannels; ++i) {
+        if (process[i] != other.process[i]) {
+            return false;
+        }
+    }
+    return channels_equal(black_point, other.black_point)
+        && channels_equal(white_point, other.white_point)
+        && channels_equal(lift, other.lift)
+        && channels_equal(gain, other.gain)
+        && channels_equal(multiply, other.multiply)
+        && channels_equal(offset, other.offset)
+        && channels_equal(gamma, other.gamma)
+        && (reverse == other.reverse)
+        && (clamp_black == other.clamp_black)
+        && (clamp_white == other.clamp_white)
+        && (premult == other.premult)
+        && (mix == other.mix);
+}
+
+bool ViewerGrade::operator!=(const ViewerGrade &other) const {
+    return !(*this == other);
+}
+
+bool ViewerTransform::operator==(const ViewerTransform &other) const {
+    return (translate_x == other.translate_x)
+        && (translate_y == other.translate_y)
+        && (rotate == other.rotate)
+        && (rotate_center_x == other.rotate_center_x)
+        && (rotate_center_y == other.rotate_center_y)
+        && (scale_x == other.scale_x)
+        && (scale_y == other.scale_y)
+        && (pivot_x == other.pivot_x)
+        && (pivot_y == other.pivot_y)
+        && (invert == other.invert);
+}
+
+bool ViewerTransform::operator!=(const ViewerTransform &other) const {
+    return !(*this == other);
+}
+
+bool ViewerOps::operator==(const ViewerOps &other) const {
+    return (nodes_len == other.nodes_len)
+        && (has_grade == other.has_grade)
+        && (grade == other.grade)
+        && (transforms == other.transforms);
+}
+
+bool ViewerOps::operator!=(const ViewerOps &other) const {
+    return !(*this == other);
+}
+
+MStatus find_trailing_viewer_ops(
+        const MPlug &plug,
+        ViewerOps &viewer_ops,
+        MPlug &viewer_input_plug) {
+    MStatus status;
+    viewer_ops = ViewerOps();
+    viewer_input_plug = plug;
+    if (plug.isNull()) {
+        return MS::kSuccess;
+    }
+
+    MPlug current_plug(plug);
+    while (true) {
+        MPlug source_plug = current_plug.source(&status);
+        if (!status || source_plug.isNull()) {
+            break;
+        }
+        MObject node = source_plug.node();
+        MFnDependencyNode fn_node(node, &status);
+        if (!status) {
+            break;
+        }
+
+        auto type_id = fn_node.typeId();
+        if (type_id == ColorGradeNode::m_id) {
+            bool enable = MPlug(node, ColorGradeNode::m_enable_attr).asBool();
+            if (enable) {
+                if (viewer_ops.has_grade) {
+                    // Grades cannot be combined into one.
+                    break;
+                }
+                viewer_ops.grade = get_grade(node);
+                viewer_ops.has_grade = true;
+            }
+            current_plug = MPlug(node, ColorGradeNode::m_in_stream_attr);
+        } else if (type_id == ImageTransformNode::m_id) {
+            bool enable =
+                MPlug(node, ImageTransformNode::m_enable_attr).asBool();
+            if (enable) {
+                viewer_ops.transforms.push_back(get_transform(node));
+            }
+            current_plug = MPlug(node, ImageTransformNode::m_in_stream_attr);
+        } else {
+            break;
+        }
+        viewer_ops.nodes_len += 1;
+        viewer_input_plug = current_plug;
+    }
+    return MS::kSuccess;
+}
+
+MFloatMatrix transform_matrix(
+        const std::vector<ViewerTransform> &transforms,
+        const ocg::BBox2Di &display_window) {
+    // The transforms are applied in stream order, the furthest
+    // upstream node first.
+    MFloatMatrix matrix;
+    for (auto it = transforms.rbegin(); it != transforms.rend(); ++it) {
+        matrix *= transform_matrix(*it, display_window);
+    }
+    return matrix;
+}
+
+MStatus set_shader_grade_params(
+        Shader &shader,
+        const bool enable,
+        const ViewerGrade &grade) {
+    MStatus status = shader.set_bool_param(kGradeEnableParameterName, enable);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+    if (!enable) {
+        // The other values are not used by the shader.
+        return status;
+    }
+
+    // The grade is 'pow((in * scale) + offset, 1.0 / gamma)', or the
+    // inverse when reversed, which is the same form with the power
+    // applied first.
+    float process[4];
+    float scale[4];
+    float offset[4];
+    float exponent[4];
+    for (size_t i = 0; i < kChannels; ++i) {
+        process[i] = grade.process[i] ? 1.0f : 0.0f;
+
+        auto range = grade.white_point[i] - grade.black_point[i];
+        if (std::fabs(range) < 1.0e-6f) {
+            range = 1.0e-6f;
+        }
+        auto a = grade.multiply[i] * (grade.gain[i] - grade.lift[i]) / range;
+        auto b = grade.offset[i] + grade.lift[i] - (a * grade.black_point[i]);
+        auto gamma = grade.gamma[i];
+        if (gamma <= 0.0f) {
+            gamma = 1.0f;
+        }
+        if (!grade.reverse) {
+            scale[i] = a;
+            offset[i] = b;
+            exponent[i] = 1.0f / gamma;
+        } else {
+            if (std::fabs(a) < 1.0e-6f) {
+                a = 1.0e-6f;
+            }
+            scale[i] = 1.0f / a;
+            offset[i] = -b / a;
+            exponent[i] = gamma;
+        }
+    }
+
+    status = shader.set_color_param(kGradeProcessParameterName, process);
+    CHECK_MSTATUS(status);
+    status = shader.set_color_param(kGradeScaleParameterName, scale);
+    CHECK_MSTATUS(status);
+    status = shader.set_color_param(kGradeOffsetParameterName, offset);
+    CHECK_MSTATUS(status);
+    status = shader.set_color_param(kGradeExponentParameterName, exponent);
+    CHECK_MSTATUS(status);
+    status = shader.set_bool_param(kGradeReverseParameterName, grade.reverse);
+    CHECK_MSTATUS(status);
+    status = shader.set_bool_param(
+        kGradeClampBlackParameterName, grade.clamp_black);
+    CHECK_MSTATUS(status);
+    status = shader.set_bool_param(
+        kGradeClampWhiteParameterName, grade.clamp_white);
+    CHECK_MSTATUS(status);
+    status = shader.set_bool_param(kGradePremultParameterName, grade.premult);
+    CHECK_MSTATUS(status);
+    status = shader.set_float_param(kGradeMixParameterName, grade.mix);
+    CHECK_MSTATUS(status);
+    return status;
+}
+
+} // namespace viewer_ops
+} // namespace image_plane
+} // namespace open_comp_graph_maya
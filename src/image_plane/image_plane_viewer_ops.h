@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2021 David Cattermole.
+ *
+ * This file is part of OpenCompGraphMaya.
+ *
+ * OpenCompGraphMaya is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * OpenCompGraphMaya is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OpenCompGraphMaya.  If not, see <https://www.gnu.org/licenses/>.
+ * ====================================================================
+ *
+ * Color grade and 2D transform nodes drawn by the image plane shader
+ * instead of being evaluated by the graph.
+ */
+
+#ifndef OPENCOMPGRAPHMAYA_IMAGE_PLANE_VIEWER_OPS_H
+#define OPENCOMPGRAPHMAYA_IMAGE_PLANE_VIEWER_OPS_H
+
+// Maya
+#include <maya/MObject.h>
+#include <maya/MPlug.h>
+#include <maya/MString.h>
+#include <maya/MFloatMatrix.h>
+
+// STL
+#include <vector>
+
+// OCG
+#include "opencompgraph.h"
+
+// OCG Maya
+#include "image_plane_shader.h"
+
+namespace ocg = open_comp_graph;
+
+namespace open_comp_graph_maya {
+namespace image_plane {
+namespace viewer_ops {
+
+// The parameters of an 'ocgColorGrade' node, per RGBA channel.
+struct ViewerGrade {
+    ViewerGrade();
+
+    bool operator==(const ViewerGrade &other) const;
+    bool operator!=(const ViewerGrade &other) const;
+
+    bool process[4];
+    float black_point[4];
+    float white_point[4];
+    float lift[4];
+    float gain[4];
+    float multiply[4];
+    float offset[4];
+    float gamma[4];
+    bool reverse;
+    bool clamp_black;
+    bool clamp_white;
+    bool premult;
+    float mix;
+};
+
+// The parameters of an 'ocgImageTransform' node. Positions are
+// relative to the display window, (0.0, 0.0) is the lower-left corner
+// and (1.0, 1.0) is the upper-right corner.
+struct ViewerTransform {
+    ViewerTransform()
+        : translate_x(0.0f)
+        , translate_y(0.0f)
+        , rotate(0.0f)
+        , rotate_center_x(0.0f)
+        , rotate_center_y(0.0f)
+        , scale_x(1.0f)
+        , scale_y(1.0f)
+        , pivot_x(0.5f)
+        , pivot_y(0.5f)
+        , invert(false) {}
+
+    bool operator==(const ViewerTransform &other) const;
+    bool operator!=(const ViewerTransform &other) const;
+
+    float translate_x;
+    float translate_y;
+    float rotate;  // degrees
+    float rotate_center_x;
+    float rotate_center_y;
+    float scale_x;
+    float scale_y;
+    float pivot_x;
+    float pivot_y;
+    bool invert;
+};
+
+// The nodes at the end of an image plane's input stream that the
+// shader draws.
+struct ViewerOps {
+    ViewerOps()
+        : nodes_len(0)
+        , has_grade(false)
+        , grade()
+        , transforms() {}
+
+    bool operator==(const ViewerOps &other) const;
+    bool operator!=(const ViewerOps &other) const;
+
+    // Number of nodes (enabled or not) skipped by the viewer.
+    size_t nodes_len;
+
+    bool has_grade;
+    ViewerGrade grade;
+
+    // Nearest node first (the reverse of stream order).
+    std::vector<ViewerTransform> transforms;
+};
+
+// Find the grade and transform nodes directly upstream of 'plug',
+// that can be drawn by the shader. Only one (enabled) grade can be
+// drawn, any node above a second grade, or above any other type of
+// node, is evaluated by the graph.
+//
+// 'viewer_input_plug' is set to the plug the viewer should read the
+// stream from; 'plug' itself when no nodes are found.
+MStatus find_trailing_viewer_ops(
+    const MPlug &plug,
+    ViewerOps &viewer_ops,
+    MPlug &viewer_input_plug);
+
+// The parameters of the 'ocgImageTransform' node 'node'.
+ViewerTransform get_transform(const MObject &node);
+
+// The transform of the display window pixels by all of 'transforms',
+// for points multiplied on the left (as Maya does).
+MFloatMatrix transform_matrix(
+    const std::vector<ViewerTransform> &transforms,
+    const ocg::BBox2Di &display_window);
+
+// Set the color grade parameters of the shader. When 'enable' is
+// false the colors are not changed by the shader.
+MStatus set_shader_grade_params(
+    Shader &shader,
+    const bool enable,
+    const ViewerGrade &grade);
+
+} // namespace viewer_ops
+} // namespace image_plane
+} // namespace open_comp_graph_maya
+
+#endif // OPENCOMPGRAPHMAYA_IMAGE_PLANE_VIEWER_OPS_H
@@ -0,0 +1,394 @@
+/*
+ * Copyright (C) 2021 David Cattermole.
+ *
+ * This file is part of OpenCompGraphMaya.
+ *
+ * OpenCompGraphMaya is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * OpenCompGraphMaya is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OpenCompGraphMaya.  If not, see <https://www.gnu.org/licenses/>.
+ * ====================================================================
+ *
+ * Image scopes (histogram, waveform and channel statistics) of a
+ * stream's pixels.
+ */
+
+// STL
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// OCG
+#include "opencompgraph.h"
+
+// OCG Maya
+#include "image_scopes.h"
+#include "logger.h"
+#include "worker_pool.h"
+
+namespace ocg = open_comp_graph;
+
+namespace open_comp_graph_maya {
+namespace scopes {
+
+namespace {
+
+// Tasks are only worth splitting for large images; a tile is a
+// range of whole rows.
+const int32_t kMinRowsPerTask = 64;
+
+// The scopes of a few recent frames are kept, so scrubbing back and
+// forth does not compute them again.
+const size_t kMaxCachedScopes = 16;
+
+typedef std::map<uint64_t, std::shared_ptr<const ImageScopes>> ScopesMap;
+
+struct ScopesCache {
+    std::mutex mutex;
+    ScopesMap scopes_map;
+    // Stream hashes, oldest first.
+    std::deque<uint64_t> order;
+};
+
+// The image plane draws from the main thread, but nodes may be
+// computed on other threads, so the cache is locked.
+ScopesCache &get_scopes_cache() {
+    static ScopesCache scopes_cache;
+    return scopes_cache;
+}
+
+float half_to_float(const uint16_t value) {
+    const uint32_t sign = static_cast<uint32_t>(value & 0x8000u) << 16;
+    const uint32_t exponent = (value >> 10) & 0x1fu;
+    uint32_t mantissa = value & 0x3ffu;
+    uint32_t bits = sign;
+    if (exponent == 0x1fu) {
+        // Infinity or NaN.
+        bits |= 0x7f800000u | (mantissa << 13);
+    } else if (exponent != 0) {
+        bits |= ((exponent + (127 - 15)) << 23) | (mantissa << 13);
+    } else if (mantissa != 0) {
+        // Sub-normal half values are normal float values.
+        int32_t normal_exponent = 1;
+        while ((mantissa & 0x400u) == 0) {
+            mantissa <<= 1;
+            normal_exponent -= 1;
+        }
+        mantissa &= 0x3ffu;
+        bits |= (static_cast<uint32_t>(normal_exponent + (127 - 15)) << 23)
+            | (mantissa << 13);
+    }
+    float result = 0.0f;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+// All 65536 half values, converted once.
+const std::vector<float> &get_half_table() {
+    static const std::vector<float> half_table = [] {
+        std::vector<float> table(std::numeric_limits<uint16_t>::max() + 1);
+        for (size_t i = 0; i < table.size(); ++i) {
+            table[i] = half_to_float(static_cast<uint16_t>(i));
+        }
+        return table;
+    }();
+    return half_table;
+}
+
+size_t bytes_per_channel(const ocg::DataType pixel_data_type) {
+    if (pixel_data_type == ocg::DataType::kUInt8) {
+        return sizeof(uint8_t);
+    } else if (pixel_data_type == ocg::DataType::kHalf16) {
+        return sizeof(uint16_t);
+    } else if (pixel_data_type == ocg::DataType::kUInt16) {
+        return sizeof(uint16_t);
+    } else if (pixel_data_type == ocg::DataType::kFloat32) {
+        return sizeof(float);
+    }
+    return 0;
+}
+
+// The pixels of the stream, as seen by the reductions.
+struct PixelRows {
+    const uint8_t *buffer;
+    ocg::DataType pixel_data_type;
+    int32_t pixel_width;
+    int32_t pixel_height;
+    int32_t num_channels;
+    size_t row_stride;  // bytes
+};
+
+// Convert one row of pixels into normalized floating point values.
+void load_row(
+        const PixelRows &pixels,
+        const int32_t row,
+        std::vector<float> &values) {
+    const size_t count =
+        static_cast<size_t>(pixels.pixel_width) * pixels.num_channels;
+    const uint8_t *row_start = pixels.buffer + (row * pixels.row_stride);
+    if (pixels.pixel_data_type == ocg::DataType::kFloat32) {
+        std::memcpy(values.data(), row_start, count * sizeof(float));
+    } else if (pixels.pixel_data_type == ocg::DataType::kHalf16) {
+        const auto &half_table = get_half_table();
+        const uint16_t *row_values =
+            reinterpret_cast<const uint16_t *>(row_start);
+        for (size_t i = 0; i < count; ++i) {
+            values[i] = half_table[row_values[i]];
+        }
+    } else if (pixels.pixel_data_type == ocg::DataType::kUInt16) {
+        const uint16_t *row_values =
+            reinterpret_cast<const uint16_t *>(row_start);
+        for (size_t i = 0; i < count; ++i) {
+            values[i] = static_cast<float>(row_values[i]) / 65535.0f;
+        }
+    } else if (pixels.pixel_data_type == ocg::DataType::kUInt8) {
+        for (size_t i = 0; i < count; ++i) {
+            values[i] = static_cast<float>(row_start[i]) / 255.0f;
+        }
+    }
+}
+
+// The bin (or row) a value falls into. NaN values are counted with
+// the lowest values.
+inline uint32_t value_index(const float value, const uint32_t count) {
+    if (!(value > 0.0f)) {
+        return 0;
+    } else if (value >= 1.0f) {
+        return count - 1;
+    }
+    return std::min(
+        static_cast<uint32_t>(value * static_cast<float>(count)),
+        count - 1);
+}
+
+// The reduction of a tile of rows, merged into the final scopes
+// once every tile is done.
+struct Partial {
+    std::vector<float> minimum;
+    std::vector<float> maximum;
+    std::vector<double> sum;
+    std::vector<uint64_t> clipped_low;
+    std::vector<uint64_t> clipped_high;
+    std::vector<uint32_t> histogram;
+    std::vector<uint32_t> waveform;
+};
+
+void reduce_rows(
+        const PixelRows &pixels,
+        const int32_t row_start,
+        const int32_t row_end,
+        Partial &partial) {
+    const size_t num_channels = pixels.num_channels;
+    partial.minimum.assign(num_channels, std::numeric_limits<float>::max());
+    partial.maximum.assign(num_channels, std::numeric_limits<float>::lowest());
+    partial.sum.assign(num_channels, 0.0);
+    partial.clipped_low.assign(num_channels, 0);
+    partial.clipped_high.assign(num_channels, 0);
+    partial.histogram.assign(num_channels * kHistogramBins, 0);
+    partial.waveform.assign(
+        num_channels * kWaveformColumns * kWaveformRows, 0);
+
+    // The waveform column of each pixel column does not change per
+    // row.
+    std::vector<uint32_t> columns(pixels.pixel_width);
+    for (int32_t x = 0; x < pixels.pixel_width; ++x) {
+        columns[x] = static_cast<uint32_t>(
+            (static_cast<uint64_t>(x) * kWaveformColumns)
+            / static_cast<uint64_t>(pixels.pixel_width));
+    }
+
+    std::vector<float> values(
+        static_cast<size_t>(pixels.pixel_width) * num_channels);
+    for (int32_t y = row_start; y < row_end; ++y) {
+        load_row(pixels, y, values);
+        for (size_t c = 0; c < num_channels; ++c) {
+            float minimum = partial.minimum[c];
+            float maximum = partial.maximum[c];
+            double sum = 0.0;
+            uint32_t *histogram = &partial.histogram[c * kHistogramBins];
+            uint32_t *waveform =
+                &partial.waveform[c * kWaveformColumns * kWaveformRows];
+            for (int32_t x = 0; x < pixels.pixel_width; ++x) {
+                const float value = values[(x * num_channels) + c];
+                minimum = std::min(minimum, value);
+                maximum = std::max(maximum, value);
+                sum += value;
+                partial.clipped_low[c] += value < 0.0f;
+                partial.clipped_high[c] += value > 1.0f;
+                histogram[value_index(value, kHistogramBins)] += 1;
+                const uint32_t wave_row = value_index(value, kWaveformRows);
+                waveform[(wave_row * kWaveformColumns) + columns[x]] += 1;
+            }
+            partial.minimum[c] = minimum;
+            partial.maximum[c] = maximum;
+            partial.sum[c] += sum;
+        }
+    }
+}
+
+std::shared_ptr<ImageScopes> compute_image_scopes(
+        const PixelRows &pixels,
+        const uint64_t stream_hash) {
+    const int32_t height = pixels.pixel_height;
+    const size_t tile_count = std::min(
+        worker_pool::max_task_count(),
+        static_cast<size_t>(std::max(1, height / kMinRowsPerTask)));
+    const int32_t rows_per_tile = static_cast<int32_t>(
+        (height + tile_count - 1) / tile_count);
+
+    // Each tile is reduced on the worker pool.
+    std::vector<Partial> partials(tile_count);
+    worker_pool::run_tasks(tile_count, [&](const size_t tile_index) {
+        const int32_t row_start =
+            static_cast<int32_t>(tile_index) * rows_per_tile;
+        const int32_t row_end = std::min(row_start + rows_per_tile, height);
+        reduce_rows(pixels, row_start, row_end, partials[tile_index]);
+    });
+
+    // Merge the tiles.
+    const size_t num_channels = pixels.num_channels;
+    auto scopes = std::make_shared<ImageScopes>();
+    scopes->stream_hash = stream_hash;
+    scopes->pixel_width = pixels.pixel_width;
+    scopes->pixel_height = pixels.pixel_height;
+    scopes->num_channels = pixels.num_channels;
+    scopes->minimum = partials[0].minimum;
+    scopes->maximum = partials[0].maximum;
+    scopes->clipped_low = partials[0].clipped_low;
+    scopes->clipped_high = partials[0].clipped_high;
+    scopes->histogram = partials[0].histogram;
+    scopes->waveform = partials[0].waveform;
+    std::vector<double> sum = partials[0].sum;
+    for (size_t i = 1; i < partials.size(); ++i) {
+        const Partial &partial = partials[i];
+        for (size_t c = 0; c < num_channels; ++c) {
+            scopes->minimum[c] = std::min(scopes->minimum[c], partial.minimum[c]);
+            scopes->maximum[c] = std::max(scopes->maximum[c], partial.maximum[c]);
+            scopes->clipped_low[c] += partial.clipped_low[c];
+            scopes->clipped_high[c] += partial.clipped_high[c];
+            sum[c] += partial.sum[c];
+        }
+        for (size_t j = 0; j < scopes->histogram.size(); ++j) {
+            scopes->histogram[j] += partial.histogram[j];
+        }
+        for (size_t j = 0; j < scopes->waveform.size(); ++j) {
+            scopes->waveform[j] += partial.waveform[j];
+        }
+    }
+
+    const double pixel_count =
+        static_cast<double>(pixels.pixel_width) * pixels.pixel_height;
+    scopes->mean.resize(num_channels);
+    for (size_t c = 0; c < num_channels; ++c) {
+        scopes->mean[c] = static_cast<float>(sum[c] / pixel_count);
+    }
+    scopes->histogram_peak = *std::max_element(
+        scopes->histogram.begin(), scopes->histogram.end());
+    scopes->waveform_peak = *std::max_element(
+        scopes->waveform.begin(), scopes->waveform.end());
+    return scopes;
+}
+
+} // namespace
+
+std::shared_ptr<const ImageScopes> get_image_scopes(
+        ocg::StreamData &stream_data) {
+    auto log = log::get_logger();
+    const uint64_t stream_hash = stream_data.hash();
+    const int32_t pixel_width = stream_data.pixel_width();
+    const int32_t pixel_height = stream_data.pixel_height();
+    const int32_t num_channels = stream_data.pixel_num_channels();
+
+    auto &scopes_cache = get_scopes_cache();
+    {
+        std::lock_guard<std::mutex> lock(scopes_cache.mutex);
+        auto search = scopes_cache.scopes_map.find(stream_hash);
+        if (search != scopes_cache.scopes_map.end()) {
+            const auto &scopes = search->second;
+            if ((scopes->pixel_width == pixel_width)
+                && (scopes->pixel_height == pixel_height)
+                && (scopes->num_channels == num_channels)) {
+                return scopes;
+            }
+        }
+    }
+
+    const ocg::DataType pixel_data_type = stream_data.pixel_data_type();
+    const size_t channel_bytes = bytes_per_channel(pixel_data_type);
+    if ((pixel_width <= 0) || (pixel_height <= 0)
+        || (num_channels <= 0) || (channel_bytes == 0)) {
+        return nullptr;
+    }
+
+    auto pixel_buffer = stream_data.pixel_buffer();
+    const size_t row_stride =
+        static_cast<size_t>(pixel_width) * num_channels * channel_bytes;
+    if (pixel_buffer.size() < (row_stride * pixel_height)) {
+        log->error(
+            "Image Scopes: Pixel buffer is smaller than the image: "
+            "hash={} size={}",
+            stream_hash, pixel_buffer.size());
+        return nullptr;
+    }
+
+    PixelRows pixels;
+    pixels.buffer = static_cast<const uint8_t *>(
+        static_cast<const void *>(pixel_buffer.data()));
+    pixels.pixel_data_type = pixel_data_type;
+    pixels.pixel_width = pixel_width;
+    pixels.pixel_height = pixel_height;
+    pixels.num_channels = num_channels;
+    pixels.row_stride = row_stride;
+
+    // The cache is not locked while computing, two users asking for
+    // the same new stream at once may both compute it; the scopes are
+    // identical.
+    std::shared_ptr<const ImageScopes> scopes =
+        compute_image_scopes(pixels, stream_hash);
+    log->debug(
+        "Image Scopes: Computed scopes: hash={} width={} height={}",
+        stream_hash, pixel_width, pixel_height);
+
+    std::lock_guard<std::mutex> lock(scopes_cache.mutex);
+    auto inserted = scopes_cache.scopes_map.insert(
+        std::make_pair(stream_hash, scopes));
+    if (inserted.second) {
+        scopes_cache.order.push_back(stream_hash);
+    } else {
+        inserted.first->second = scopes;
+    }
+    while (scopes_cache.order.size() > kMaxCachedScopes) {
+        scopes_cache.scopes_map.erase(scopes_cache.order.front());
+        scopes_cache.order.pop_front();
+    }
+    return scopes;
+}
+
+size_t count() {
+    auto &scopes_cache = get_scopes_cache();
+    std::lock_guard<std::mutex> lock(scopes_cache.mutex);
+    return scopes_cache.scopes_map.size();
+}
+
+void clear() {
+    auto &scopes_cache = get_scopes_cache();
+    std::lock_guard<std::mutex> lock(scopes_cache.mutex);
+    scopes_cache.scopes_map.clear();
+    scopes_cache.order.clear();
+}
+
+} // namespace scopes
+} // namespace open_comp_graph_maya
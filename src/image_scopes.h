@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2021 David Cattermole.
+ *
+ * This file is part of OpenCompGraphMaya.
+ *
+ * OpenCompGraphMaya is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * OpenCompGraphMaya is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OpenCompGraphMaya.  If not, see <https://www.gnu.org/licenses/>.
+ * ====================================================================
+ *
+ * Image scopes (histogram, waveform and channel statistics) of a
+ * stream's pixels.
+ *
+ * Scopes are computed in one pass over the pixels, split into row
+ * tiles reduced on separate threads, and cached by the stream hash;
+ * asking again for the same stream costs nothing.
+ */
+
+#ifndef OPENCOMPGRAPHMAYA_IMAGE_SCOPES_H
+#define OPENCOMPGRAPHMAYA_IMAGE_SCOPES_H
+
+// STL
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// OCG
+#include "opencompgraph.h"
+
+namespace ocg = open_comp_graph;
+
+namespace open_comp_graph_maya {
+namespace scopes {
+
+// Histogram and waveform resolution. Values in the range 0.0 to 1.0
+// are spread over the bins (or rows); values outside the range are
+// counted in the first and last bin.
+const uint32_t kHistogramBins = 256;
+const uint32_t kWaveformColumns = 256;
+const uint32_t kWaveformRows = 128;
+
+// The scopes of one stream. Per-channel arrays hold 'num_channels'
+// values, the histogram holds 'kHistogramBins' values per channel,
+// and the waveform holds 'kWaveformColumns * kWaveformRows' values
+// per channel (rows ordered from the lowest value up).
+struct ImageScopes {
+    ImageScopes()
+        : stream_hash(0)
+        , pixel_width(0)
+        , pixel_height(0)
+        , num_channels(0)
+        , histogram_peak(0)
+        , waveform_peak(0) {}
+
+    uint64_t stream_hash;
+    int32_t pixel_width;
+    int32_t pixel_height;
+    int32_t num_channels;
+
+    std::vector<float> minimum;
+    std::vector<float> maximum;
+    std::vector<float> mean;
+
+    // The number of values below 0.0 and above 1.0.
+    std::vector<uint64_t> clipped_low;
+    std::vector<uint64_t> clipped_high;
+
+    std::vector<uint32_t> histogram;
+    std::vector<uint32_t> waveform;
+
+    // The largest count in any channel, to normalize drawing.
+    uint32_t histogram_peak;
+    uint32_t waveform_peak;
+};
+
+// Get the scopes of the stream, computing them only if the stream
+// has not been seen before. Returns nullptr when the stream has no
+// pixels, or the pixel data type is not supported.
+std::shared_ptr<const ImageScopes> get_image_scopes(
+    ocg::StreamData &stream_data);
+
+// The number of scopes currently held in the cache.
+size_t count();
+
+// Forget all cached scopes. Called when the plug-in is unloaded.
+void clear();
+
+} // namespace scopes
+} // namespace open_comp_graph_maya
+
+#endif // OPENCOMPGRAPHMAYA_IMAGE_SCOPES_H
@@ -0,0 +1,383 @@
+/*
+ * Copyright (C) 2021 David Cattermole.
+ *
+ * This file is part of OpenCompGraphMaya.
+ *
+ * OpenCompGraphMaya is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * OpenCompGraphMaya is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OpenCompGraphMaya.  If not, see <https://www.gnu.org/licenses/>.
+ * ====================================================================
+ *
+ * The image spec of a stream found without executing the graph.
+ */
+
+// Maya
+#include <maya/MPlug.h>
+#include <maya/MObject.h>
+#include <maya/MFnDependencyNode.h>
+#include <maya/MFloatMatrix.h>
+#include <maya/MFloatPoint.h>
+
+// STL
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+// OCG
+#include "opencompgraph.h"
+
+// OCG Maya
+#include <comp_nodes/image_crop_node.h>
+#include <comp_nodes/image_merge_node.h>
+#include <comp_nodes/image_read_node.h>
+#include <comp_nodes/image_resample_node.h>
+#include <comp_nodes/image_transform_node.h>
+#include <comp_nodes/lens_distort_node.h>
+#include <image_plane/image_plane_viewer_ops.h>
+#include "image_header.h"
+#include "image_spec.h"
+#include "io_pool.h"
+#include "sequence_index.h"
+
+namespace ocg = open_comp_graph;
+
+namespace open_comp_graph_maya {
+namespace image_spec {
+
+namespace {
+
+// Networks deeper than this are not followed; the spec is not known.
+const uint32_t kMaxDepth = 256;
+
+ocg::BBox2Di make_window(
+        const int32_t min_x,
+        const int32_t min_y,
+        const int32_t max_x,
+        const int32_t max_y) {
+    ocg::BBox2Di window;
+    window.min_x = min_x;
+    window.min_y = min_y;
+    window.max_x = std::max(min_x, max_x);
+    window.max_y = std::max(min_y, max_y);
+    return window;
+}
+
+bool is_empty_window(const ocg::BBox2Di &window) {
+    return (window.max_x <= window.min_x) || (window.max_y <= window.min_y);
+}
+
+ocg::BBox2Di intersect_windows(const ocg::BBox2Di &a, const ocg::BBox2Di &b) {
+    return make_window(
+        std::max(a.min_x, b.min_x),
+        std::max(a.min_y, b.min_y),
+        std::min(a.max_x, b.max_x),
+        std::min(a.max_y, b.max_y));
+}
+
+ocg::BBox2Di unite_windows(const ocg::BBox2Di &a, const ocg::BBox2Di &b) {
+    if (is_empty_window(a)) {
+        return b;
+    }
+    if (is_empty_window(b)) {
+        return a;
+    }
+    return make_window(
+        std::min(a.min_x, b.min_x),
+        std::min(a.min_y, b.min_y),
+        std::max(a.max_x, b.max_x),
+        std::max(a.max_y, b.max_y));
+}
+
+bool windows_equal(const ocg::BBox2Di &a, const ocg::BBox2Di &b) {
+    return (a.min_x == b.min_x)
+        && (a.min_y == b.min_y)
+        && (a.max_x == b.max_x)
+        && (a.max_y == b.max_y);
+}
+
+// The same node as 'roi::find_read_regions' follows.
+bool get_stream_node(const MPlug &plug, MObject &node) {
+    MStatus status;
+    if (plug.isNull()) {
+        return false;
+    }
+    if (!plug.isDestination()) {
+        node = plug.node();
+        return true;
+    }
+    MPlug source_plug = plug.source(&status);
+    if (!status || source_plug.isNull()) {
+        return false;
+    }
+    node = source_plug.node();
+    return true;
+}
+
+// The spec of the file read by the read node on 'frame', from the
+// file's header.
+//
+// OpenEXR windows have the origin at the top-left and an inclusive
+// maximum; the data window is flipped around the display window.
+ImageSpec read_spec(const MObject &node, const int32_t frame) {
+    ImageSpec spec;
+    std::vector<int32_t> frames(1, frame);
+    std::vector<std::string> file_paths;
+    io_pool::ChannelSelection selection;
+    io_pool::find_read_file_paths(node, frames, file_paths, selection);
+    image_header::ImageHeader header;
+    if (file_paths.empty()
+        || !sequence::find_header(file_paths[0], header)
+        || header.parts.empty()) {
+        return spec;
+    }
+
+    size_t part_index = 0;
+    for (size_t i = 0; i < header.parts.size(); ++i) {
+        if (!selection.layer.empty() && (header.parts[i].name == selection.layer)) {
+            part_index = i;
+            break;
+        }
+    }
+    const image_header::Part &part = header.parts[part_index];
+    const bool in_layer_part =
+        !selection.layer.empty() && (part.name == selection.layer);
+    const int32_t flip_y = part.display_min_y + part.display_max_y;
+    spec.is_known = true;
+    spec.display_window = make_window(
+        part.display_min_x,
+        part.display_min_y,
+        part.display_max_x + 1,
+        part.display_max_y + 1);
+    spec.data_window = make_window(
+        part.data_min_x,
+        flip_y - part.data_max_y,
+        part.data_max_x + 1,
+        (flip_y - part.data_min_y) + 1);
+    for (const auto &channel : part.channels) {
+        if (selection.contains_channel(channel.name, in_layer_part)) {
+            spec.channel_names.push_back(channel.name);
+        }
+    }
+    spec.color_space = part.color_space;
+    return spec;
+}
+
+// The crop keeps the pixels inside its window; a reformat makes the
+// window the display window.
+ImageSpec crop_spec(const MObject &node, const ImageSpec &input_spec) {
+    ImageSpec spec = input_spec;
+    const ocg::BBox2Di window = make_window(
+        MPlug(node, ImageCropNode::m_window_min_x_attr).asInt(),
+        MPlug(node, ImageCropNode::m_window_min_y_attr).asInt(),
+        MPlug(node, ImageCropNode::m_window_max_x_attr).asInt(),
+        MPlug(node, ImageCropNode::m_window_max_y_attr).asInt());
+    const bool intersect = MPlug(node, ImageCropNode::m_intersect_attr).asBool();
+    const bool reformat = MPlug(node, ImageCropNode::m_reformat_attr).asBool();
+    spec.data_window = intersect
+        ? intersect_windows(input_spec.data_window, window)
+        : window;
+    if (reformat) {
+        spec.display_window = window;
+    }
+    return spec;
+}
+
+// The transform moves the data window; the display window stays.
+ImageSpec transform_spec(const MObject &node, const ImageSpec &input_spec) {
+    auto transform = image_plane::viewer_ops::get_transform(node);
+    if ((transform == image_plane::viewer_ops::ViewerTransform())
+        || is_empty_window(input_spec.data_window)) {
+        return input_spec;
+    }
+    std::vector<image_plane::viewer_ops::ViewerTransform> transforms;
+    transforms.push_back(transform);
+    MFloatMatrix input_to_output = image_plane::viewer_ops::transform_matrix(
+        transforms, input_spec.display_window);
+
+    const ocg::BBox2Di &window = input_spec.data_window;
+    const float corners[4][2] = {
+        {static_cast<float>(window.min_x), static_cast<float>(window.min_y)},
+        {static_cast<float>(window.max_x), static_cast<float>(window.min_y)},
+        {static_cast<float>(window.min_x), static_cast<float>(window.max_y)},
+        {static_cast<float>(window.max_x), static_cast<float>(window.max_y)},
+    };
+    float min_x = std::numeric_limits<float>::max();
+    float min_y = std::numeric_limits<float>::max();
+    float max_x = -std::numeric_limits<float>::max();
+    float max_y = -std::numeric_limits<float>::max();
+    for (size_t i = 0; i < 4; ++i) {
+        MFloatPoint point(corners[i][0], corners[i][1], 0.0f);
+        point *= input_to_output;
+        min_x = std::min(min_x, point.x);
+        min_y = std::min(min_y, point.y);
+        max_x = std::max(max_x, point.x);
+        max_y = std::max(max_y, point.y);
+    }
+    ImageSpec spec = input_spec;
+    spec.data_window = make_window(
+        static_cast<int32_t>(std::floor(min_x)),
+        static_cast<int32_t>(std::floor(min_y)),
+        static_cast<int32_t>(std::ceil(max_x)),
+        static_cast<int32_t>(std::ceil(max_y)));
+    return spec;
+}
+
+// The lens model can move pixels across the whole image; only an
+// identity distortion is known to keep the windows.
+bool is_lens_distort_identity(const MObject &node) {
+    return (MPlug(node, LensDistortNode::m_distortion_attr).asFloat() == 0.0f)
+        && (MPlug(node, LensDistortNode::m_quartic_distortion_attr).asFloat() == 0.0f)
+        && (MPlug(node, LensDistortNode::m_curvature_x_attr).asFloat() == 0.0f)
+        && (MPlug(node, LensDistortNode::m_curvature_y_attr).asFloat() == 0.0f)
+        && (MPlug(node, LensDistortNode::m_anamorphic_squeeze_attr).asFloat() == 1.0f);
+}
+
+MStatus propagate_spec(
+        const MObject &node,
+        const int32_t frame,
+        const uint32_t depth,
+        ImageSpec &spec) {
+    MStatus status;
+    spec = ImageSpec();
+    if (depth > kMaxDepth) {
+        return MS::kSuccess;
+    }
+    MFnDependencyNode fn_node(node, &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+    auto type_id = fn_node.typeId();
+
+    if (type_id == ImageReadNode::m_id) {
+        if (MPlug(node, ImageReadNode::m_enable_attr).asBool()) {
+            spec = read_spec(node, frame);
+        }
+        return MS::kSuccess;
+    }
+
+    // A merge covers the data of both inputs, in the display window
+    // of the B input; a disabled merge passes B through.
+    if (type_id == ImageMergeNode::m_id) {
+        ImageSpec spec_a;
+        ImageSpec spec_b;
+        MObject input_node;
+        if (get_stream_node(MPlug(node, ImageMergeNode::m_in_stream_b_attr), input_node)) {
+            status = propagate_spec(input_node, frame, depth + 1, spec_b);
+            CHECK_MSTATUS_AND_RETURN_IT(status);
+        }
+        if (!MPlug(node, ImageMergeNode::m_enable_attr).asBool()) {
+            spec = spec_b;
+            return MS::kSuccess;
+        }
+        if (get_stream_node(MPlug(node, ImageMergeNode::m_in_stream_a_attr), input_node)) {
+            status = propagate_spec(input_node, frame, depth + 1, spec_a);
+            CHECK_MSTATUS_AND_RETURN_IT(status);
+        }
+        if (spec_a.is_known && spec_b.is_known) {
+            spec = spec_b;
+            spec.data_window = unite_windows(spec_a.data_window, spec_b.data_window);
+        }
+        return MS::kSuccess;
+    }
+
+    // Any other node with one input stream is followed; nodes not
+    // listed here keep the windows of their input.
+    MObject in_stream_attr = fn_node.attribute("inStream", &status);
+    if (!status || in_stream_attr.isNull()) {
+        return MS::kSuccess;
+    }
+    MObject input_node;
+    if (!get_stream_node(MPlug(node, in_stream_attr), input_node)) {
+        return MS::kSuccess;
+    }
+    ImageSpec input_spec;
+    status = propagate_spec(input_node, frame, depth + 1, input_spec);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+    if (!input_spec.is_known) {
+        return MS::kSuccess;
+    }
+
+    MObject enable_attr = fn_node.attribute("enable", &status);
+    const bool enable =
+        !status || enable_attr.isNull() || MPlug(node, enable_attr).asBool();
+    spec = input_spec;
+    if (!enable) {
+        return MS::kSuccess;
+    }
+    if (type_id == ImageCropNode::m_id) {
+        spec = crop_spec(node, input_spec);
+    } else if (type_id == ImageTransformNode::m_id) {
+        spec = transform_spec(node, input_spec);
+    } else if (type_id == ImageResampleNode::m_id) {
+        const int32_t factor = MPlug(node, ImageResampleNode::m_factor_attr).asInt();
+        spec = resampled(input_spec, factor);
+    } else if (type_id == LensDistortNode::m_id) {
+        if (!is_lens_distort_identity(node)) {
+            spec = ImageSpec();
+        }
+    }
+    return MS::kSuccess;
+}
+
+} // namespace
+
+ImageSpec::ImageSpec()
+        : is_known(false)
+        , display_window(make_window(0, 0, 0, 0))
+        , data_window(make_window(0, 0, 0, 0)) {}
+
+bool ImageSpec::operator==(const ImageSpec &other) const {
+    return (is_known == other.is_known)
+        && windows_equal(display_window, other.display_window)
+        && windows_equal(data_window, other.data_window)
+        && (channel_names == other.channel_names)
+        && (color_space == other.color_space);
+}
+
+bool ImageSpec::operator!=(const ImageSpec &other) const {
+    return !(*this == other);
+}
+
+ImageSpec resampled(const ImageSpec &spec, const int32_t factor) {
+    if (!spec.is_known || (factor == 0)) {
+        return spec;
+    }
+    const double scale = std::pow(2.0, static_cast<double>(factor));
+    auto scale_window = [scale](const ocg::BBox2Di &window) {
+        return make_window(
+            static_cast<int32_t>(std::floor(window.min_x * scale)),
+            static_cast<int32_t>(std::floor(window.min_y * scale)),
+            static_cast<int32_t>(std::ceil(window.max_x * scale)),
+            static_cast<int32_t>(std::ceil(window.max_y * scale)));
+    };
+    ImageSpec resampled_spec = spec;
+    resampled_spec.display_window = scale_window(spec.display_window);
+    resampled_spec.data_window = scale_window(spec.data_window);
+    return resampled_spec;
+}
+
+MStatus find_stream_spec(
+        const MPlug &plug,
+        const double frame,
+        ImageSpec &spec) {
+    spec = ImageSpec();
+    MObject node;
+    if (!get_stream_node(plug, node)) {
+        return MS::kSuccess;
+    }
+    const uint32_t depth = 0;
+    return propagate_spec(
+        node, static_cast<int32_t>(std::lround(frame)), depth, spec);
+}
+
+} // namespace image_spec
+} // namespace open_comp_graph_maya
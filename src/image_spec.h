@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2021 David Cattermole.
+ *
+ * This file is part of OpenCompGraphMaya.
+ *
+ * OpenCompGraphMaya is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * OpenCompGraphMaya is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OpenCompGraphMaya.  If not, see <https://www.gnu.org/licenses/>.
+ * ====================================================================
+ *
+ * The image spec of a stream (its windows, channels and color space)
+ * found without executing the graph.
+ *
+ * The display and data windows of a stream are known from the
+ * headers of the files read upstream, mapped downstream through each
+ * node, so nothing is decoded. The image plane uses the windows to
+ * size its bounding box and show the resolution of a frame straight
+ * away, while the pixels of the frame are still being computed.
+ */
+
+#ifndef OPENCOMPGRAPHMAYA_IMAGE_SPEC_H
+#define OPENCOMPGRAPHMAYA_IMAGE_SPEC_H
+
+// Maya
+#include <maya/MPlug.h>
+#include <maya/MStatus.h>
+
+// STL
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// OCG
+#include "opencompgraph.h"
+
+namespace ocg = open_comp_graph;
+
+namespace open_comp_graph_maya {
+namespace image_spec {
+
+struct ImageSpec {
+    ImageSpec();
+
+    bool operator==(const ImageSpec &other) const;
+    bool operator!=(const ImageSpec &other) const;
+
+    // Are the windows known? Streams with nodes whose output windows
+    // depend on the pixels (or on parameters not mirrored here) are
+    // only known by executing the graph.
+    bool is_known;
+
+    // The windows use the same coordinates as 'ocg::StreamData'; the
+    // origin is at the bottom-left and the maximum is exclusive.
+    ocg::BBox2Di display_window;
+    ocg::BBox2Di data_window;
+
+    // The channels and color space of the first file read.
+    std::vector<std::string> channel_names;
+    std::string color_space;
+};
+
+// The spec scaled by 2 to the power of 'factor', as the resample node
+// (and the image plane proxy) scales images.
+ImageSpec resampled(const ImageSpec &spec, const int32_t factor);
+
+// Find the spec of the stream at 'plug' on 'frame'. 'plug' may be the
+// input of a consumer (such as an image plane), or the output of a
+// node.
+MStatus find_stream_spec(
+    const MPlug &plug,
+    const double frame,
+    ImageSpec &spec);
+
+} // namespace image_spec
+} // namespace open_comp_graph_maya
+
+#endif // OPENCOMPGRAPHMAYA_IMAGE_SPEC_H
@@ -0,0 +1,1130 @@
+/*
+ * Copyright (C) 2021 David Cattermole.
+ *
+ * This file is part of OpenCompGraphMaya.
+ *
+ * OpenCompGraphMaya is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * OpenCompGraphMaya is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OpenCompGraphMaya.  If not, see <https://www.gnu.org/licenses/>.
+ * ====================================================================
+ *
+ * A bounded pool of threads reading image files ahead of the graph.
+ */
+
+// Maya
+#include <maya/MPlug.h>
+#include <maya/MString.h>
+#include <maya/MObject.h>
+#include <maya/MFnDependencyNode.h>
+
+// STL
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// OCG Maya
+#include <comp_nodes/image_read_node.h>
+#include "cache_container.h"
+#include "image_header.h"
+#include "io_pool.h"
+#include "logger.h"
+#include "region_of_interest.h"
+#include "sequence_index.h"
+
+namespace open_comp_graph_maya {
+namespace io_pool {
+
+namespace {
+
+using image_header::FileFormat;
+using image_header::ImageHeader;
+using image_header::kExrNoCompression;
+using image_header::exr_lines_per_chunk;
+using image_header::read_uint32_le;
+using image_header::read_uint64_le;
+
+// Files are read in blocks, each block waits its turn within the
+// bandwidth limit.
+const size_t kReadBlockSize = 1024 * 1024;
+
+// A scrub can ask for many frames; only the newest requests are
+// kept.
+const size_t kMaxQueuedReads = 64;
+
+// Recently read files are not read again; the operating system
+// keeps them cached.
+const size_t kMaxRecentReads = 256;
+
+// Mapped files are touched once per page; the smallest page size in
+// use is assumed, so larger pages are touched more than once.
+const size_t kPageSize = 4096;
+
+const uint32_t kMaxThreads = 8;
+const uint32_t kDefaultReadAheadFrames = 2;
+
+// The part of a file that is read.
+struct ReadExtent {
+    ReadExtent() {}
+
+    ReadExtent(
+            const roi::Region &region_,
+            const ChannelSelection &selection_)
+        : region(region_)
+        , selection(selection_) {}
+
+    bool contains(const ReadExtent &other) const {
+        return region.contains(other.region)
+            && (selection.is_all() || (selection == other.selection));
+    }
+
+    // Different selections of the same file are read whole.
+    ReadExtent united(const ReadExtent &other) const {
+        ReadExtent extent;
+        extent.region = region.united(other.region);
+        if (selection == other.selection) {
+            extent.selection = selection;
+        }
+        return extent;
+    }
+
+    roi::Region region;
+    ChannelSelection selection;
+};
+
+// A range of bytes in a file; the end is exclusive.
+struct ByteRange {
+    ByteRange(const uint64_t begin_, const uint64_t end_)
+        : begin(begin_)
+        , end(end_) {}
+
+    bool operator<(const ByteRange &other) const {
+        return begin < other.begin;
+    }
+
+    uint64_t begin;
+    uint64_t end;
+};
+
+// Find the ranges of bytes of an OpenEXR file (mapped as 'data')
+// needed to decode the pixels inside 'region' of the selected layer
+// and channels; the headers, the offset tables and the selected
+// chunks. Of uncompressed scan lines only the bytes of the selected
+// channels are needed.
+//
+// Returns false when the whole file is needed.
+bool find_exr_read_ranges(
+        const uint8_t *data,
+        const size_t size,
+        const ImageHeader &header,
+        const roi::Region &region,
+        const ChannelSelection &selection,
+        std::vector<ByteRange> &ranges) {
+    ranges.clear();
+    if ((header.format != FileFormat::kExr) || header.parts.empty()
+        || (!region.is_bounded && selection.is_all())) {
+        return false;
+    }
+
+    uint64_t tables_end = header.header_size;
+    bool has_layer_part = false;
+    for (const auto &part : header.parts) {
+        const bool has_lines_per_chunk = part.is_tiled
+            || (exr_lines_per_chunk(part.compression) > 0);
+        if (part.is_deep || (part.chunk_count < 0) || !has_lines_per_chunk) {
+            return false;
+        }
+        tables_end += static_cast<uint64_t>(part.chunk_count) * 8;
+        has_layer_part = has_layer_part
+            || (!selection.layer.empty() && (part.name == selection.layer));
+    }
+    if (tables_end > size) {
+        return false;
+    }
+    ranges.push_back(ByteRange(0, tables_end));
+
+    // Chunks of multi-part files start with their part number, then
+    // the Y coordinate of scan lines (or the four coordinates of
+    // tiles) and the size of the chunk's data.
+    const uint64_t part_number_size = header.is_multi_part ? 4 : 0;
+    uint64_t table_begin = header.header_size;
+    for (const auto &part : header.parts) {
+        const uint64_t table = table_begin;
+        table_begin += static_cast<uint64_t>(part.chunk_count) * 8;
+        if (has_layer_part && (part.name != selection.layer)) {
+            continue;
+        }
+
+        const bool in_layer_part = has_layer_part;
+        std::vector<bool> selected_channels;
+        bool any_selected = false;
+        bool all_selected = true;
+        bool is_subsampled = false;
+        for (const auto &channel : part.channels) {
+            const bool selected =
+                selection.contains_channel(channel.name, in_layer_part);
+            selected_channels.push_back(selected);
+            any_selected = any_selected || selected;
+            all_selected = all_selected && selected;
+            is_subsampled = is_subsampled
+                || (channel.x_sampling != 1) || (channel.y_sampling != 1);
+        }
+        if (!any_selected) {
+            continue;
+        }
+        const bool split_channels = !all_selected
+            && !part.is_tiled
+            && !is_subsampled
+            && (part.compression == kExrNoCompression);
+
+        // Regions start at the bottom of the display window, OpenEXR
+        // scan lines at the top.
+        const int32_t flip_y = part.display_min_y + part.display_max_y;
+        const int32_t first_line = region.is_bounded
+            ? std::max(part.data_min_y, flip_y - (region.max_y - 1))
+            : part.data_min_y;
+        const int32_t last_line = region.is_bounded
+            ? std::min(part.data_max_y, flip_y - region.min_y)
+            : part.data_max_y;
+        if (region.is_empty() || (first_line > last_line)) {
+            continue;
+        }
+        const int32_t lines_per_chunk = part.is_tiled
+            ? 0 : exr_lines_per_chunk(part.compression);
+        const uint64_t line_size = static_cast<uint64_t>(
+            (part.data_max_x - part.data_min_x) + 1);
+
+        const uint64_t chunk_header_size =
+            part_number_size + (part.is_tiled ? 20 : 8);
+        for (int32_t i = 0; i < part.chunk_count; ++i) {
+            const uint64_t chunk = read_uint64_le(data + table + (i * 8));
+            if ((chunk < tables_end) || ((chunk + chunk_header_size) > size)) {
+                return false;
+            }
+            const uint64_t data_begin = chunk + chunk_header_size;
+            const uint64_t data_size = read_uint32_le(data + data_begin - 4);
+            const uint64_t data_end = std::min<uint64_t>(
+                size, data_begin + data_size);
+
+            if (part.is_tiled) {
+                ranges.push_back(ByteRange(chunk, data_end));
+                continue;
+            }
+            const int32_t chunk_first_line = static_cast<int32_t>(
+                read_uint32_le(data + chunk + part_number_size));
+            const int32_t chunk_last_line = std::min(
+                part.data_max_y, chunk_first_line + lines_per_chunk - 1);
+            if ((chunk_last_line < first_line)
+                || (chunk_first_line > last_line)) {
+                continue;
+            }
+            if (!split_channels) {
+                ranges.push_back(ByteRange(chunk, data_end));
+                continue;
+            }
+
+            // Uncompressed chunks are one scan line, storing all
+            // samples of each channel in turn.
+            uint64_t offset = data_begin;
+            for (size_t c = 0; (c < part.channels.size()) && (offset < data_end); ++c) {
+                const uint64_t channel_size =
+                    line_size * part.channels[c].sample_size;
+                if (selected_channels[c]) {
+                    ranges.push_back(ByteRange(
+                        offset, std::min(data_end, offset + channel_size)));
+                }
+                offset += channel_size;
+            }
+        }
+    }
+    return true;
+}
+
+// A read-only view of a whole file, mapped into memory.
+class MappedFile {
+public:
+    MappedFile()
+        : m_data(nullptr)
+        , m_size(0)
+#ifdef _WIN32
+        , m_file(INVALID_HANDLE_VALUE)
+        , m_mapping(nullptr)
+#endif
+    {}
+
+    ~MappedFile() {
+        this->close();
+    }
+
+    // Returns false when the file cannot be mapped.
+    bool open(const std::string &file_path) {
+        this->close();
+#ifdef _WIN32
+        m_file = CreateFileA(
+            file_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+            OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (m_file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(m_file, &file_size) || (file_size.QuadPart <= 0)) {
+            this->close();
+            return false;
+        }
+        m_mapping = CreateFileMappingA(
+            m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (m_mapping == nullptr) {
+            this->close();
+            return false;
+        }
+        void *data = MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+        if (data == nullptr) {
+            this->close();
+            return false;
+        }
+        m_data = static_cast<const uint8_t *>(data);
+        m_size = static_cast<size_t>(file_size.QuadPart);
+#else
+        int file_descriptor = ::open(file_path.c_str(), O_RDONLY);
+        if (file_descriptor < 0) {
+            return false;
+        }
+        struct stat file_stat;
+        if ((fstat(file_descriptor, &file_stat) != 0)
+            || (file_stat.st_size <= 0)) {
+            ::close(file_descriptor);
+            return false;
+        }
+        const size_t size = static_cast<size_t>(file_stat.st_size);
+        void *data = mmap(
+            nullptr, size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+        // The mapping keeps its own reference to the file.
+        ::close(file_descriptor);
+        if (data == MAP_FAILED) {
+            return false;
+        }
+        madvise(data, size, MADV_SEQUENTIAL);
+        m_data = static_cast<const uint8_t *>(data);
+        m_size = size;
+#endif
+        return true;
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (m_data != nullptr) {
+            UnmapViewOfFile(m_data);
+        }
+        if (m_mapping != nullptr) {
+            CloseHandle(m_mapping);
+            m_mapping = nullptr;
+        }
+        if (m_file != INVALID_HANDLE_VALUE) {
+            CloseHandle(m_file);
+            m_file = INVALID_HANDLE_VALUE;
+        }
+#else
+        if (m_data != nullptr) {
+            munmap(const_cast<uint8_t *>(m_data), m_size);
+        }
+#endif
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+    const uint8_t *data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+private:
+    MappedFile(const MappedFile &);
+    MappedFile &operator=(const MappedFile &);
+
+    const uint8_t *m_data;
+    size_t m_size;
+#ifdef _WIN32
+    HANDLE m_file;
+    HANDLE m_mapping;
+#endif
+};
+
+class IoPool {
+public:
+    IoPool()
+        : m_stop(false)
+        , m_thread_count(0)
+        , m_read_ahead_frames(kDefaultReadAheadFrames)
+        , m_memory_map(true)
+        , m_bytes_read(0)
+        , m_bytes_skipped(0)
+        , m_bytes_per_second(0.0)
+        , m_next_read_time(std::chrono::steady_clock::now()) {}
+
+    ~IoPool() {
+        this->stop();
+    }
+
+    void set_concurrency(const uint32_t thread_count) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_thread_count == thread_count) {
+                return;
+            }
+            m_thread_count = thread_count;
+        }
+        // The threads are started again with the next request.
+        this->stop_threads();
+    }
+
+    void set_read_limit(const double bytes_per_second) {
+        std::lock_guard<std::mutex> lock(m_throttle_mutex);
+        m_bytes_per_second = std::max(0.0, bytes_per_second);
+    }
+
+    void set_read_ahead_frames(const uint32_t frame_count) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_read_ahead_frames = frame_count;
+    }
+
+    uint32_t read_ahead_frames() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_read_ahead_frames;
+    }
+
+    void set_memory_map(const bool value) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_memory_map = value;
+    }
+
+    bool memory_map() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_memory_map;
+    }
+
+    // Frames of cache containers needed now are queued first, and
+    // only extracted. They are queued even when read recently, as
+    // the container may have changed since.
+    void request_extracts(const std::vector<std::string> &file_paths) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (const auto &file_path : file_paths) {
+                if (file_path.empty()
+                    || (m_reading.count(file_path) > 0)
+                    || (m_extracts.count(file_path) > 0)) {
+                    continue;
+                }
+                auto it = std::find(m_queue.begin(), m_queue.end(), file_path);
+                if (it != m_queue.end()) {
+                    m_queue.erase(it);
+                } else {
+                    m_queued[file_path] = ReadExtent();
+                }
+                m_extract_queue.push_back(file_path);
+                m_extracts.insert(file_path);
+            }
+            if (m_extract_queue.empty()) {
+                return;
+            }
+            this->start_threads();
+        }
+        m_condition.notify_all();
+    }
+
+    void request(
+            const std::vector<std::string> &file_paths,
+            const std::vector<roi::Region> &regions,
+            const std::vector<ChannelSelection> &selections) {
+        auto log = log::get_logger();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (size_t i = 0; i < file_paths.size(); ++i) {
+                const auto &file_path = file_paths[i];
+                const ReadExtent extent(
+                    i < regions.size() ? regions[i] : roi::Region(),
+                    i < selections.size() ? selections[i] : ChannelSelection());
+                if (file_path.empty()
+                    || is_covered(m_reading, file_path, extent)
+                    || is_covered(m_recent, file_path, extent)) {
+                    continue;
+                }
+                auto it = m_queued.find(file_path);
+                if (it != m_queued.end()) {
+                    it->second = it->second.united(extent);
+                    continue;
+                }
+                m_queue.push_back(file_path);
+                m_queued[file_path] = extent;
+            }
+            while (m_queue.size() > kMaxQueuedReads) {
+                log->debug("IoPool: dropped read: {}", m_queue.front());
+                m_queued.erase(m_queue.front());
+                m_queue.pop_front();
+            }
+            if (m_queue.empty()) {
+                return;
+            }
+            this->start_threads();
+        }
+        m_condition.notify_all();
+    }
+
+    void wait(const std::vector<std::string> &file_paths) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done_condition.wait(lock, [this, &file_paths] {
+            for (const auto &file_path : file_paths) {
+                if ((m_queued.count(file_path) > 0)
+                    || (m_reading.count(file_path) > 0)) {
+                    return false;
+                }
+            }
+            return true;
+        });
+    }
+
+    void statistics(uint64_t &bytes_read, uint64_t &bytes_skipped) {
+        bytes_read = m_bytes_read.load();
+        bytes_skipped = m_bytes_skipped.load();
+    }
+
+    void stop() {
+        this->stop_threads();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.clear();
+        m_extract_queue.clear();
+        m_extracts.clear();
+        m_queued.clear();
+        m_recent.clear();
+        m_recent_order.clear();
+    }
+
+private:
+    // Has 'file_path' been read (or is it being read) with all of
+    // 'extent'?
+    template <typename ExtentMap>
+    static bool is_covered(
+            const ExtentMap &extents,
+            const std::string &file_path,
+            const ReadExtent &extent) {
+        auto range = extents.equal_range(file_path);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second.contains(extent)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Must be called with 'm_mutex' locked.
+    void start_threads() {
+        if (!m_threads.empty()) {
+            return;
+        }
+        uint32_t thread_count = m_thread_count;
+        if (thread_count == 0) {
+            // Reading is mostly waiting, but the decoder needs the
+            // cores; use half of them.
+            thread_count = std::max<uint32_t>(
+                1, std::thread::hardware_concurrency() / 2);
+        }
+        thread_count = std::min(thread_count, kMaxThreads);
+        m_stop = false;
+        for (uint32_t i = 0; i < thread_count; ++i) {
+            m_threads.emplace_back(&IoPool::run, this);
+        }
+    }
+
+    void stop_threads() {
+        std::vector<std::thread> threads;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+            threads.swap(m_threads);
+        }
+        m_condition.notify_all();
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        // Files being read when the threads stopped are no longer
+        // being read.
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_reading.clear();
+            m_stop = false;
+        }
+        m_done_condition.notify_all();
+    }
+
+    // Wait until 'byte_count' more bytes may be read. The limit is
+    // shared by all threads; each read reserves the next free time
+    // slot.
+    void throttle(const size_t byte_count) {
+        std::chrono::steady_clock::time_point read_time;
+        {
+            std::lock_guard<std::mutex> lock(m_throttle_mutex);
+            if (m_bytes_per_second <= 0.0) {
+                return;
+            }
+            auto now = std::chrono::steady_clock::now();
+            read_time = std::max(now, m_next_read_time);
+            auto duration = std::chrono::duration<double>(
+                static_cast<double>(byte_count) / m_bytes_per_second);
+            m_next_read_time = read_time
+                + std::chrono::duration_cast<
+                    std::chrono::steady_clock::duration>(duration);
+        }
+        std::this_thread::sleep_until(read_time);
+    }
+
+    bool is_stopping() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_stop;
+    }
+
+    // Read the whole file, discarding the bytes; the point is to
+    // have the file cached when OCG decodes it.
+    size_t read_file(const std::string &file_path, std::vector<char> &buffer) {
+        std::ifstream file(file_path, std::ios::in | std::ios::binary);
+        if (!file.is_open()) {
+            return 0;
+        }
+        size_t total_bytes = 0;
+        while (file) {
+            this->throttle(buffer.size());
+            if (this->is_stopping()) {
+                break;
+            }
+            file.read(buffer.data(), buffer.size());
+            total_bytes += static_cast<size_t>(file.gcount());
+        }
+        return total_bytes;
+    }
+
+    // Touch one byte of each page of 'data' between 'begin' and
+    // 'end'. Returns the number of bytes touched.
+    size_t touch_pages(
+            const uint8_t *data,
+            const size_t begin,
+            const size_t end) {
+        volatile uint8_t sink = 0;
+        size_t total_bytes = 0;
+        for (size_t block_start = begin; block_start < end;
+             block_start += kReadBlockSize) {
+            const size_t block_end = std::min(end, block_start + kReadBlockSize);
+            this->throttle(block_end - block_start);
+            if (this->is_stopping()) {
+                break;
+            }
+            for (size_t offset = block_start; offset < block_end;
+                 offset += kPageSize) {
+                sink = sink + data[offset];
+            }
+            total_bytes += block_end - block_start;
+        }
+        return total_bytes;
+    }
+
+    // Bring the file into the file cache by mapping it and touching
+    // one byte of each page. The operating system reads the pages
+    // straight into the cache, which the decoder's reads then share,
+    // so the bytes are never copied into a buffer of ours.
+    //
+    // Of OpenEXR files with a bounded region or a channel selection
+    // only the headers, the offset tables and the bytes of the
+    // selected chunks (and channels) are touched; see
+    // 'find_exr_read_ranges'.
+    //
+    // Returns false when the file cannot be mapped, or when a
+    // compressed file would be read whole.
+    bool map_file(
+            const std::string &file_path,
+            const ImageHeader &header,
+            const ReadExtent &extent,
+            size_t &total_bytes,
+            size_t &skipped_bytes) {
+        total_bytes = 0;
+        skipped_bytes = 0;
+        MappedFile mapped_file;
+        if (!mapped_file.open(file_path)) {
+            return false;
+        }
+        const uint8_t *data = mapped_file.data();
+        const size_t size = mapped_file.size();
+        std::vector<ByteRange> ranges;
+        if (!find_exr_read_ranges(
+                data, size, header, extent.region, extent.selection, ranges)) {
+            if (!header.is_uncompressed) {
+                return false;
+            }
+            total_bytes = this->touch_pages(data, 0, size);
+            return true;
+        }
+
+        // Ranges sharing a page are read together.
+        std::sort(ranges.begin(), ranges.end());
+        std::vector<ByteRange> merged_ranges;
+        for (const auto &range : ranges) {
+            if (!merged_ranges.empty()) {
+                auto &last = merged_ranges.back();
+                const uint64_t last_page_end =
+                    ((last.end + kPageSize - 1) / kPageSize) * kPageSize;
+                if (range.begin <= last_page_end) {
+                    last.end = std::max(last.end, range.end);
+                    continue;
+                }
+            }
+            merged_ranges.push_back(range);
+        }
+
+        size_t range_bytes = 0;
+        for (const auto &range : merged_ranges) {
+            total_bytes += this->touch_pages(
+                data,
+                static_cast<size_t>(range.begin),
+                static_cast<size_t>(range.end));
+            range_bytes += static_cast<size_t>(range.end - range.begin);
+        }
+        skipped_bytes = size - std::min(size, range_bytes);
+        return true;
+    }
+
+    void run() {
+        auto log = log::get_logger();
+        std::vector<char> buffer(kReadBlockSize);
+        while (true) {
+            std::string file_path;
+            ReadExtent extent;
+            bool extract_only = false;
+            std::multimap<std::string, ReadExtent>::iterator reading_it;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_condition.wait(lock, [this] {
+                    return m_stop
+                        || !m_extract_queue.empty()
+                        || !m_queue.empty();
+                });
+                if (m_stop) {
+                    break;
+                }
+                if (!m_extract_queue.empty()) {
+                    file_path = m_extract_queue.front();
+                    m_extract_queue.pop_front();
+                    m_extracts.erase(file_path);
+                    extract_only = true;
+                } else {
+                    file_path = m_queue.front();
+                    m_queue.pop_front();
+                    extract_only = false;
+                }
+                extent = m_queued[file_path];
+                m_queued.erase(file_path);
+                reading_it = m_reading.emplace(file_path, extent);
+            }
+
+            // Frames of cache containers the graph reads now are
+            // extracted to their local files; the graph reads them
+            // straight away.
+            auto start_time = std::chrono::steady_clock::now();
+            if (extract_only) {
+                if (!cache_container::extract_local_frame(file_path)) {
+                    log->warn("IoPool: could not extract file={}", file_path);
+                }
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_reading.erase(reading_it);
+                }
+                m_done_condition.notify_all();
+                continue;
+            }
+
+            // Frames of cache containers read ahead are read from
+            // the container, where the chunk is stored; reading the
+            // chunk is the read from the file server, and the frame
+            // is extracted from the file cache once needed.
+            //
+            // Compressed files that must be read whole, and files
+            // that cannot be mapped, fall back to buffered reads.
+            size_t byte_count = 0;
+            size_t skipped_byte_count = 0;
+            ImageHeader header;
+            const bool is_container_frame =
+                cache_container::is_local_frame_path(file_path);
+            if (is_container_frame) {
+                byte_count = static_cast<size_t>(
+                    cache_container::read_local_frame(
+                        file_path, buffer,
+                        [this](const size_t block_size) {
+                            this->throttle(block_size);
+                            return !this->is_stopping();
+                        }));
+            }
+            bool mapped = !is_container_frame
+                && this->memory_map()
+                && sequence::find_header(file_path, header)
+                && (header.is_uncompressed || (header.format == FileFormat::kExr))
+                && this->map_file(
+                    file_path, header, extent,
+                    byte_count, skipped_byte_count);
+            if (!mapped && !is_container_frame) {
+                byte_count = this->read_file(file_path, buffer);
+                skipped_byte_count = 0;
+            }
+            m_bytes_read += byte_count;
+            m_bytes_skipped += skipped_byte_count;
+            auto end_time = std::chrono::steady_clock::now();
+            log->debug(
+                "IoPool: read file={} mapped={} bytes={} skipped={} seconds={}",
+                file_path, mapped, byte_count, skipped_byte_count,
+                std::chrono::duration<double>(end_time - start_time).count());
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_reading.erase(reading_it);
+                // Buffered reads always read the whole file.
+                if (!mapped) {
+                    extent = ReadExtent();
+                }
+                auto it = m_recent.find(file_path);
+                if (it == m_recent.end()) {
+                    m_recent[file_path] = extent;
+                    m_recent_order.push_back(file_path);
+                } else {
+                    it->second = it->second.united(extent);
+                }
+                while (m_recent_order.size() > kMaxRecentReads) {
+                    m_recent.erase(m_recent_order.front());
+                    m_recent_order.pop_front();
+                }
+            }
+            m_done_condition.notify_all();
+        }
+    }
+
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::condition_variable m_done_condition;
+    std::vector<std::thread> m_threads;
+    bool m_stop;
+    uint32_t m_thread_count;
+    uint32_t m_read_ahead_frames;
+    bool m_memory_map;
+
+    std::deque<std::string> m_queue;
+    std::deque<std::string> m_extract_queue;
+    std::set<std::string> m_extracts;
+    std::map<std::string, ReadExtent> m_queued;
+    // A file may be read again with a larger extent while it is
+    // being read.
+    std::multimap<std::string, ReadExtent> m_reading;
+    std::map<std::string, ReadExtent> m_recent;
+    std::deque<std::string> m_recent_order;
+
+    std::atomic<uint64_t> m_bytes_read;
+    std::atomic<uint64_t> m_bytes_skipped;
+
+    std::mutex m_throttle_mutex;
+    double m_bytes_per_second;
+    std::chrono::steady_clock::time_point m_next_read_time;
+};
+
+IoPool &get_io_pool() {
+    static IoPool io_pool;
+    return io_pool;
+}
+
+} // namespace
+
+ChannelSelection::ChannelSelection(
+        const std::string &layer_name,
+        const std::string &channel_names)
+        : layer(layer_name) {
+    std::string channel_name;
+    for (const char c : channel_names) {
+        if ((c == ',') || std::isspace(static_cast<unsigned char>(c))) {
+            if (!channel_name.empty()) {
+                channels.push_back(channel_name);
+                channel_name.clear();
+            }
+        } else {
+            channel_name.push_back(c);
+        }
+    }
+    if (!channel_name.empty()) {
+        channels.push_back(channel_name);
+    }
+}
+
+bool ChannelSelection::operator==(const ChannelSelection &other) const {
+    return (layer == other.layer) && (channels == other.channels);
+}
+
+bool ChannelSelection::operator!=(const ChannelSelection &other) const {
+    return !(*this == other);
+}
+
+bool ChannelSelection::is_all() const {
+    return layer.empty() && channels.empty();
+}
+
+bool ChannelSelection::contains_channel(
+        const std::string &channel_name,
+        const bool in_layer_part) const {
+    // Channels are named "<layer>.<channel>"; the channels of a part
+    // named after the layer may omit the layer.
+    std::string name = channel_name;
+    if (!layer.empty()) {
+        const std::string prefix = layer + ".";
+        const bool has_prefix = name.compare(0, prefix.size(), prefix) == 0;
+        if (has_prefix) {
+            name = name.substr(prefix.size());
+        } else if (!in_layer_part) {
+            return false;
+        }
+    }
+    if (channels.empty()) {
+        return true;
+    }
+    return std::find(channels.begin(), channels.end(), name) != channels.end();
+}
+
+void set_concurrency(const uint32_t thread_count) {
+    get_io_pool().set_concurrency(thread_count);
+}
+
+void set_read_limit(const double megabytes_per_second) {
+    get_io_pool().set_read_limit(megabytes_per_second * 1024.0 * 1024.0);
+}
+
+void set_read_ahead_frames(const uint32_t frame_count) {
+    get_io_pool().set_read_ahead_frames(frame_count);
+}
+
+uint32_t read_ahead_frames() {
+    return get_io_pool().read_ahead_frames();
+}
+
+void set_memory_map(const bool value) {
+    get_io_pool().set_memory_map(value);
+}
+
+void request_reads(const std::vector<std::string> &file_paths) {
+    std::vector<roi::Region> regions;
+    std::vector<ChannelSelection> selections;
+    get_io_pool().request(file_paths, regions, selections);
+}
+
+void request_reads(
+        const std::vector<std::string> &file_paths,
+        const std::vector<roi::Region> &regions) {
+    std::vector<ChannelSelection> selections;
+    get_io_pool().request(file_paths, regions, selections);
+}
+
+void request_reads(
+        const std::vector<std::string> &file_paths,
+        const std::vector<roi::Region> &regions,
+        const std::vector<ChannelSelection> &selections) {
+    get_io_pool().request(file_paths, regions, selections);
+}
+
+void request_frame_extracts(const std::vector<std::string> &file_paths) {
+    std::vector<std::string> frame_file_paths;
+    for (const auto &file_path : file_paths) {
+        if (cache_container::is_local_frame_path(file_path)) {
+            frame_file_paths.push_back(file_path);
+        }
+    }
+    get_io_pool().request_extracts(frame_file_paths);
+}
+
+void read_statistics(uint64_t &bytes_read, uint64_t &bytes_skipped) {
+    get_io_pool().statistics(bytes_read, bytes_skipped);
+}
+
+void wait_for_reads(const std::vector<std::string> &file_paths) {
+    get_io_pool().wait(file_paths);
+}
+
+void shutdown() {
+    get_io_pool().stop();
+}
+
+void find_read_file_paths(
+        const MObject &node,
+        const std::vector<int32_t> &frames,
+        std::vector<std::string> &file_paths,
+        ChannelSelection &selection) {
+    file_paths.clear();
+    selection = ChannelSelection();
+
+    // The disk cache is read instead of the file, when enabled.
+    MString file_path =
+        MPlug(node, ImageReadNode::m_file_path_attr).asString();
+    bool use_disk_cache =
+        MPlug(node, ImageReadNode::m_disk_cache_enable_attr).asBool();
+    // The disk cache files hold only the channels read.
+    if (use_disk_cache) {
+        const MString disk_cache_file_path =
+            MPlug(node, ImageReadNode::m_disk_cache_file_path_attr).asString();
+        file_path = cache_container::resolve_file_path(
+            disk_cache_file_path.asChar()).c_str();
+    } else {
+        const MString layer_name =
+            MPlug(node, ImageReadNode::m_layer_name_attr).asString();
+        const MString channel_names =
+            MPlug(node, ImageReadNode::m_channel_names_attr).asString();
+        selection = ChannelSelection(
+            layer_name.asChar(), channel_names.asChar());
+    }
+    if (file_path.length() == 0) {
+        return;
+    }
+
+    // Frames missing from the sequence are not read; a frame range
+    // of zero to zero is the range found on disk.
+    const std::string file_path_pattern(file_path.asChar());
+    auto frame_sequence = sequence::find_sequence(file_path_pattern);
+    int32_t start_frame =
+        MPlug(node, ImageReadNode::m_frame_start_attr).asInt();
+    int32_t end_frame =
+        MPlug(node, ImageReadNode::m_frame_end_attr).asInt();
+    if (frame_sequence && !frame_sequence->is_empty()
+        && (start_frame == 0) && (end_frame == 0)) {
+        start_frame = frame_sequence->start_frame;
+        end_frame = frame_sequence->end_frame;
+    }
+    const int32_t before_mode =
+        MPlug(node, ImageReadNode::m_frame_before_attr).asShort();
+    const int32_t after_mode =
+        MPlug(node, ImageReadNode::m_frame_after_attr).asShort();
+    for (auto frame : frames) {
+        int32_t mapped_frame = frame;
+        if (!sequence::map_frame(frame, start_frame, end_frame,
+                       before_mode, after_mode, mapped_frame)) {
+            continue;
+        }
+        if (frame_sequence) {
+            std::string frame_path = frame_sequence->frame_path(mapped_frame);
+            if (frame_path.empty()) {
+                continue;
+            }
+            file_paths.push_back(frame_path);
+        } else {
+            file_paths.push_back(
+                sequence::expand_frame_path(file_path_pattern, mapped_frame));
+        }
+    }
+}
+
+MStatus find_upstream_file_paths(
+        const MPlug &plug,
+        const std::vector<int32_t> &frames,
+        const ocg::BBox2Di &display_window,
+        std::vector<std::string> &file_paths,
+        std::vector<roi::Region> &regions,
+        std::vector<ChannelSelection> &selections) {
+    MStatus status;
+    file_paths.clear();
+    regions.clear();
+    selections.clear();
+    if (plug.isNull() || frames.empty()) {
+        return MS::kSuccess;
+    }
+
+    // Consumers use the whole image; the nodes in between may need
+    // less of it.
+    std::vector<roi::ReadRegion> read_regions;
+    status = roi::find_read_regions(
+        plug, roi::Region(), display_window, read_regions);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+
+    std::vector<std::string> node_file_paths;
+    for (const auto &read_region : read_regions) {
+        ChannelSelection selection;
+        find_read_file_paths(
+            read_region.node, frames, node_file_paths, selection);
+        for (const auto &file_path : node_file_paths) {
+            file_paths.push_back(file_path);
+            regions.push_back(read_region.region);
+            selections.push_back(selection);
+        }
+    }
+    return MS::kSuccess;
+}
+
+MStatus read_ahead(
+        const MPlug &plug,
+        const double frame,
+        const ocg::BBox2Di &display_window,
+        std::vector<std::string> &frame_file_paths) {
+    // The graph reads the current frame straight away, so its
+    // frames of cache containers are extracted before any file is
+    // read ahead.
+    frame_file_paths.clear();
+    const int32_t current_frame = static_cast<int32_t>(std::lround(frame));
+    std::vector<int32_t> frames(1, current_frame);
+    std::vector<std::string> file_paths;
+    std::vector<roi::Region> regions;
+    std::vector<ChannelSelection> selections;
+    MStatus status = find_upstream_file_paths(
+        plug, frames, display_window, file_paths, regions, selections);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+    for (const auto &file_path : file_paths) {
+        if (cache_container::is_local_frame_path(file_path)) {
+            frame_file_paths.push_back(file_path);
+        }
+    }
+    request_frame_extracts(frame_file_paths);
+
+    const uint32_t frame_count = read_ahead_frames();
+    if (frame_count == 0) {
+        return MS::kSuccess;
+    }
+    frames.clear();
+    frames.reserve(frame_count);
+    for (uint32_t i = 1; i <= frame_count; ++i) {
+        frames.push_back(current_frame + static_cast<int32_t>(i));
+    }
+    status = find_upstream_file_paths(
+        plug, frames, display_window, file_paths, regions, selections);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+    request_reads(file_paths, regions, selections);
+    return status;
+}
+
+} // namespace io_pool
+} // namespace open_comp_graph_maya
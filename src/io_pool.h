@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2021 David Cattermole.
+ *
+ * This file is part of OpenCompGraphMaya.
+ *
+ * OpenCompGraphMaya is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * OpenCompGraphMaya is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OpenCompGraphMaya.  If not, see <https://www.gnu.org/licenses/>.
+ * ====================================================================
+ *
+ * A bounded pool of threads reading image files ahead of the graph.
+ *
+ * Image files are decoded by OCG when the graph executes. The pool
+ * reads the files of upcoming frames into the operating system's
+ * file cache beforehand, so the decode of one frame overlaps with the
+ * file reads of the next frames, and the decoder reads from memory
+ * rather than the network. All reads share one bandwidth limit, so
+ * reading ahead (for example while baking) cannot saturate a shared
+ * file server.
+ *
+ * Uncompressed files (such as uncompressed OpenEXR disk cache files)
+ * are memory mapped and paged in, rather than read through a buffer,
+ * so their bytes are not copied on the way into the file cache. Of
+ * uncompressed scan line OpenEXR files, only the scan lines inside
+ * the region of interest of the read node are read.
+ *
+ * Of OpenEXR files with many parts or layers (such as the render
+ * passes of a lighting render), only the chunks of the part and the
+ * channels selected by the read node are read.
+ */
+
+#ifndef OPENCOMPGRAPHMAYA_IO_POOL_H
+#define OPENCOMPGRAPHMAYA_IO_POOL_H
+
+// Maya
+#include <maya/MObject.h>
+#include <maya/MPlug.h>
+#include <maya/MStatus.h>
+
+// STL
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// OCG
+#include "opencompgraph.h"
+
+// OCG Maya
+#include "region_of_interest.h"
+
+namespace ocg = open_comp_graph;
+
+namespace open_comp_graph_maya {
+namespace io_pool {
+
+// The layer and channels of a file that are read; the 'layerName'
+// and 'channelNames' attributes of an 'ocgImageRead' node.
+struct ChannelSelection {
+    ChannelSelection() {}
+
+    // 'channel_names' is separated by commas or spaces.
+    ChannelSelection(
+        const std::string &layer_name,
+        const std::string &channel_names);
+
+    bool operator==(const ChannelSelection &other) const;
+    bool operator!=(const ChannelSelection &other) const;
+
+    // Are all layers and channels selected?
+    bool is_all() const;
+
+    // Is the channel named 'channel_name' selected? 'in_layer_part'
+    // is true when the channel is in the part named after the layer,
+    // otherwise the layer must be the channel name's prefix.
+    bool contains_channel(
+        const std::string &channel_name,
+        const bool in_layer_part) const;
+
+    std::string layer;
+    std::vector<std::string> channels;
+};
+
+// The number of reading threads, zero picks a number from the
+// hardware. Changing the number restarts the threads.
+void set_concurrency(const uint32_t thread_count);
+
+// The most bytes read per second by all threads together, zero is
+// unlimited.
+void set_read_limit(const double megabytes_per_second);
+
+// The number of frames after the current frame that are read ahead.
+void set_read_ahead_frames(const uint32_t frame_count);
+uint32_t read_ahead_frames();
+
+// Map uncompressed files into memory instead of reading them through
+// a buffer. Compressed files are always read through a buffer.
+void set_memory_map(const bool value);
+
+// Queue files to be read. Files already queued, being read, or read
+// recently are skipped. When the queue is full the oldest queued
+// files are dropped.
+void request_reads(const std::vector<std::string> &file_paths);
+
+// Queue files to be read, only reading the pixels of each file
+// inside the matching region, where the file layout allows it.
+void request_reads(
+    const std::vector<std::string> &file_paths,
+    const std::vector<roi::Region> &regions);
+
+// Queue files to be read, only reading the pixels of each file
+// inside the matching region and channel selection, where the file
+// layout allows it.
+void request_reads(
+    const std::vector<std::string> &file_paths,
+    const std::vector<roi::Region> &regions,
+    const std::vector<ChannelSelection> &selections);
+
+// Queue the frames of cache containers the graph reads next, ahead of
+// any other queued files. The frames are extracted to their local
+// files (see 'cache_container::extract_local_frame') by the pool
+// threads, and are never dropped; wait for them with
+// 'wait_for_reads' before executing the graph. Files that are not
+// frames of containers are skipped.
+void request_frame_extracts(const std::vector<std::string> &file_paths);
+
+// The bytes read by the pool since the plug-in was loaded, and the
+// bytes of the files read that were skipped, because they were
+// outside of the regions, layers or channels requested.
+void read_statistics(uint64_t &bytes_read, uint64_t &bytes_skipped);
+
+// Block until none of the files are queued or being read.
+void wait_for_reads(const std::vector<std::string> &file_paths);
+
+// Stop the threads and forget all queued files. Called when the
+// plug-in is unloaded.
+void shutdown();
+
+// Find the files read by the 'ocgImageRead' node at each of 'frames'.
+// Frames without a file (outside the frame range with the 'black'
+// mode, or missing from the sequence) are skipped. 'selection' is set
+// to the layer and channels read.
+void find_read_file_paths(
+    const MObject &node,
+    const std::vector<int32_t> &frames,
+    std::vector<std::string> &file_paths,
+    ChannelSelection &selection);
+
+// Find the files read by the enabled 'ocgImageRead' nodes upstream of
+// 'plug' at each of 'frames'. Frames outside a node's frame range are
+// mapped with the node's before/after frame mode.
+//
+// 'regions' is set to the region of interest of each file; see
+// 'roi::find_read_regions' for 'display_window'. 'selections' is set
+// to the layer and channels of each file.
+MStatus find_upstream_file_paths(
+    const MPlug &plug,
+    const std::vector<int32_t> &frames,
+    const ocg::BBox2Di &display_window,
+    std::vector<std::string> &file_paths,
+    std::vector<roi::Region> &regions,
+    std::vector<ChannelSelection> &selections);
+
+// Request the files of the frames after 'frame' for the read nodes
+// upstream of 'plug'. The frames of cache containers needed at
+// 'frame' are queued to be extracted first (see
+// 'request_frame_extracts'), and returned in 'frame_file_paths'
+// for the caller to wait for.
+MStatus read_ahead(
+    const MPlug &plug,
+    const double frame,
+    const ocg::BBox2Di &display_window,
+    std::vector<std::string> &frame_file_paths);
+
+} // namespace io_pool
+} // namespace open_comp_graph_maya
+
+#endif // OPENCOMPGRAPHMAYA_IO_POOL_H
@@ -88,7 +88,7 @@ MString get_attr_value_string(MDataBlock &data_block, MObject &attr) {
 // Get the ocgStreamData type from the given plug.
 MStatus
 get_plug_ocg_stream_value(MPlug &plug,
-                          std::shared_ptr<ocg::Graph> &graph,
+                          std::shared_ptr<SharedGraph> &graph,
                           ocg::Node &value) {
     MStatus status;
     auto log = log::get_logger();
@@ -205,7 +205,7 @@ MStatus set_new_unique_node_hash_attr(MFnDependencyNode &fn_depend_node) {
 }
 
 MStatus join_ocg_nodes(
-        std::shared_ptr<ocg::Graph> &shared_graph,
+        std::shared_ptr<SharedGraph> &shared_graph,
         ocg::Node &input_ocg_node,
         ocg::Node &output_ocg_node,
         uint8_t input_num) {
@@ -32,6 +32,9 @@
 // OCG
 #include "opencompgraph.h"
 
+// OCG Maya
+#include "shared_graph.h"
+
 namespace open_comp_graph_maya {
 namespace utils {
 
@@ -58,7 +61,7 @@ set_new_unique_node_hash_attr(MFnDependencyNode &fn_depend_node);
 
 MStatus
 join_ocg_nodes(
-    std::shared_ptr<ocg::Graph> &shared_graph,
+    std::shared_ptr<SharedGraph> &shared_graph,
     ocg::Node &input_ocg_node,
     ocg::Node &output_ocg_node,
     uint8_t input_num);
@@ -35,6 +35,8 @@
 #include <opencompgraphmaya/build_constants.h>  // Build-Time constant values.
 #include <opencompgraphmaya/node_type_ids.h>
 #include <image_plane/image_plane_shape.h>
+#include <image_plane/image_plane_shader_registry.h>
+#include <image_plane/image_plane_texture_cache.h>
 #if OCG_USE_SUB_SCENE_OVERRIDE == 1
     #include <image_plane/image_plane_sub_scene_override.h>
 #else
@@ -44,6 +46,7 @@
 #include <comp_nodes/image_read_node.h>
 #include <comp_nodes/image_write_node.h>
 #include <comp_nodes/image_cache_node.h>
+#include <comp_nodes/image_scopes_node.h>
 #include <comp_nodes/image_merge_node.h>
 #include <comp_nodes/lens_distort_node.h>
 #include <comp_nodes/image_transform_node.h>
@@ -52,6 +55,9 @@
 #include <preferences_node.h>
 #include <execute_cmd.h>
 #include <graph_data.h>
+#include <image_scopes.h>
+#include <io_pool.h>
+#include <worker_pool.h>
 #include "global_cache.h"
 #include "logger.h"
 
@@ -176,6 +182,13 @@ MStatus initializePlugin(MObject obj) {
                   ocgm::ImageCacheNode::initialize,
                   status);
 
+    REGISTER_NODE(plugin,
+                  ocgm::ImageScopesNode::nodeName(),
+                  ocgm::ImageScopesNode::m_id,
+                  ocgm::ImageScopesNode::creator,
+                  ocgm::ImageScopesNode::initialize,
+                  status);
+
     REGISTER_NODE(plugin,
                   ocgm::ImageMergeNode::nodeName(),
                   ocgm::ImageMergeNode::m_id,
@@ -268,6 +281,13 @@ MStatus initializePlugin(MObject obj) {
         ocgm::image_plane::ShapeNode::m_display_filter_label,
         ocgm::image_plane::ShapeNode::m_draw_db_classification);
 
+    // Find the shader files once, rather than for each image plane.
+    status = ocgm::image_plane::shader_registry::initialize();
+    if (!status) {
+        log->warn("Could not find the OpenCompGraphMaya shader directory.");
+        status = MS::kSuccess;
+    }
+
     return status;
 }
 
@@ -299,6 +319,15 @@ MStatus uninitializePlugin(MObject obj) {
     }
 #endif
 
+    // Released after the draw overrides, because the overrides own
+    // clones of the registered shader effects.
+    status = ocgm::image_plane::shader_registry::uninitialize();
+    CHECK_MSTATUS(status);
+    ocgm::image_plane::texture_cache::clear();
+    ocgm::scopes::clear();
+    ocgm::io_pool::shutdown();
+    ocgm::worker_pool::shutdown();
+
     status = plugin.deregisterNode(ocgm::image_plane::ShapeNode::m_id);
     if (!status) {
         status.perror("deregisterNode");
@@ -321,6 +350,9 @@ MStatus uninitializePlugin(MObject obj) {
     DEREGISTER_NODE(plugin, ocgm::ImageCacheNode::nodeName(),
                     ocgm::ImageCacheNode::m_id, status);
 
+    DEREGISTER_NODE(plugin, ocgm::ImageScopesNode::nodeName(),
+                    ocgm::ImageScopesNode::m_id, status);
+
     DEREGISTER_NODE(plugin, ocgm::ImageMergeNode::nodeName(),
                     ocgm::ImageMergeNode::m_id, status);
 
@@ -33,6 +33,10 @@
  *   - Default log color space (string)
  *   - Default 32-bit color space (string)
  *   - OpenColorIO path (string)
+ * - I/O
+ *   - Number of threads reading files (int)
+ *   - Read bandwidth limit (double)
+ *   - Number of frames to read ahead (int)
  */
 
 // Maya
@@ -40,6 +44,7 @@
 #include <maya/MDataBlock.h>
 #include <maya/MDataHandle.h>
 #include <maya/MFnNumericAttribute.h>
+#include <maya/MFnEnumAttribute.h>
 #include <maya/MFnUnitAttribute.h>
 #include <maya/MFnTypedAttribute.h>
 #include <maya/MFnNumericData.h>
@@ -49,8 +54,16 @@
 #include <maya/MFnStringData.h>
 #include <maya/MFnDependencyNode.h>
 #include <maya/MUuid.h>
+#include <maya/MNodeMessage.h>
+#include <maya/MMessage.h>
+#include <maya/MItDependencyNodes.h>
+#include <maya/M3dView.h>
+
+// Maya Viewport 2.0
+#include <maya/MViewport2Renderer.h>
 
 // STL
+#include <algorithm>
 #include <cstring>
 #include <cmath>
 
@@ -60,7 +73,11 @@
 // OCG Maya
 #include <opencompgraphmaya/node_type_ids.h>
 #include "logger.h"
+#include "cache_container.h"
 #include "graph_data.h"
+#include "io_pool.h"
+#include "proxy_resolution.h"
+#include <image_plane/image_plane_shape.h>
 #include "preferences_node.h"
 
 namespace ocg = open_comp_graph;
@@ -76,10 +93,105 @@ MObject PreferencesNode::m_ocio_path_attr;
 MObject PreferencesNode::m_mem_cache_enable_attr;
 MObject PreferencesNode::m_mem_cache_size_attr;
 MObject PreferencesNode::m_disk_cache_base_dir_attr;
+MObject PreferencesNode::m_io_thread_count_attr;
+MObject PreferencesNode::m_io_read_limit_attr;
+MObject PreferencesNode::m_io_read_ahead_frames_attr;
+MObject PreferencesNode::m_io_memory_map_attr;
+MObject PreferencesNode::m_proxy_resolution_attr;
+
+PreferencesNode::PreferencesNode()
+        : m_attribute_changed_callback_id(0) {}
+
+PreferencesNode::~PreferencesNode() {
+    if (m_attribute_changed_callback_id != 0) {
+        MMessage::removeCallback(m_attribute_changed_callback_id);
+        m_attribute_changed_callback_id = 0;
+    }
+}
+
+// The I/O pool is global, so the values are pushed to it as soon
+// as they change (including when a scene is opened), rather than
+// pulled by a compute.
+void PreferencesNode::postConstructor() {
+    MStatus status;
+    MObject this_node = thisMObject();
+    m_attribute_changed_callback_id =
+        MNodeMessage::addAttributeChangedCallback(
+            this_node,
+            PreferencesNode::attributeChangedCallback,
+            this,
+            &status);
+    CHECK_MSTATUS(status);
+    applyIoPreferences();
+    applyProxyPreferences();
+}
+
+void PreferencesNode::applyIoPreferences() {
+    MObject this_node = thisMObject();
+    MPlug thread_count_plug(this_node, m_io_thread_count_attr);
+    MPlug read_limit_plug(this_node, m_io_read_limit_attr);
+    MPlug read_ahead_frames_plug(this_node, m_io_read_ahead_frames_attr);
+    MPlug memory_map_plug(this_node, m_io_memory_map_attr);
+    MPlug disk_cache_base_dir_plug(this_node, m_disk_cache_base_dir_attr);
+    io_pool::set_concurrency(
+        static_cast<uint32_t>(std::max(0, thread_count_plug.asInt())));
+    io_pool::set_read_limit(std::max(0.0, read_limit_plug.asDouble()));
+    io_pool::set_read_ahead_frames(
+        static_cast<uint32_t>(std::max(0, read_ahead_frames_plug.asInt())));
+    io_pool::set_memory_map(memory_map_plug.asBool());
+
+    // The frames of cache containers are extracted (and written)
+    // under the base directory.
+    const MString disk_cache_base_dir =
+        disk_cache_base_dir_plug.asString().expandEnvironmentVariablesAndTilde();
+    cache_container::set_local_directory(disk_cache_base_dir.asChar());
+}
+
+// The image planes only update when their own attributes change, so
+// they are asked to redraw, picking up the new resolution.
+void PreferencesNode::applyProxyPreferences() {
+    MObject this_node = thisMObject();
+    MPlug proxy_resolution_plug(this_node, m_proxy_resolution_attr);
+    const int32_t resolution = proxy_resolution_plug.asShort();
+    if (resolution == proxy::global_resolution()) {
+        return;
+    }
+    proxy::set_global_resolution(resolution);
 
-PreferencesNode::PreferencesNode() {}
+    MItDependencyNodes it(MFn::kPluginShape);
+    for (; !it.isDone(); it.next()) {
+        MObject node = it.thisNode();
+        MFnDependencyNode fn_node(node);
+        if (fn_node.typeId() == image_plane::ShapeNode::m_id) {
+            MHWRender::MRenderer::setGeometryDrawDirty(node);
+        }
+    }
+    M3dView::scheduleRefreshAllViews();
+}
 
-PreferencesNode::~PreferencesNode() {}
+void PreferencesNode::attributeChangedCallback(
+        MNodeMessage::AttributeMessage msg,
+        MPlug &plug,
+        MPlug &/*other_plug*/,
+        void *client_data) {
+    if (!(msg & MNodeMessage::kAttributeSet)) {
+        return;
+    }
+    MObject attr = plug.attribute();
+    auto node = static_cast<PreferencesNode *>(client_data);
+    if (!node) {
+        return;
+    }
+    if ((attr == m_io_thread_count_attr)
+        || (attr == m_io_read_limit_attr)
+        || (attr == m_io_read_ahead_frames_attr)
+        || (attr == m_io_memory_map_attr)
+        || (attr == m_disk_cache_base_dir_attr)) {
+        node->applyIoPreferences();
+    } else if (attr == m_proxy_resolution_attr) {
+        node->applyProxyPreferences();
+    }
+}
 
 MString PreferencesNode::nodeName() {
     return MString(OCGM_PREFERENCES_TYPE_NAME);
@@ -98,6 +210,7 @@ MStatus PreferencesNode::initialize() {
     MFnUnitAttribute    uAttr;
     MFnNumericAttribute nAttr;
     MFnTypedAttribute   tAttr;
+    MFnEnumAttribute    eAttr;
 
     // TODO: Add more color space attributes.
     //
@@ -182,6 +295,65 @@ MStatus PreferencesNode::initialize() {
     CHECK_MSTATUS(tAttr.setStorable(true));
     CHECK_MSTATUS(tAttr.setUsedAsFilename(true));
 
+    // I/O Thread Count
+    //
+    // The number of threads reading image files ahead of the graph,
+    // zero picks a number from the hardware.
+    int32_t io_thread_count_min = 0;
+    int32_t io_thread_count_max = 8;
+    int32_t io_thread_count_default = 0;
+    m_io_thread_count_attr = nAttr.create(
+        "ioThreadCount", "iothrcnt",
+        MFnNumericData::kInt, io_thread_count_default);
+    CHECK_MSTATUS(nAttr.setStorable(true));
+    CHECK_MSTATUS(nAttr.setKeyable(false));
+    CHECK_MSTATUS(nAttr.setMin(io_thread_count_min));
+    CHECK_MSTATUS(nAttr.setMax(io_thread_count_max));
+
+    // I/O Read Limit
+    //
+    // The most megabytes read per second, by all I/O threads
+    // together, so reading ahead does not saturate a shared file
+    // server. Zero is unlimited.
+    double io_read_limit_min = 0.0;
+    double io_read_limit_soft_max = 1000.0;
+    double io_read_limit_default = 0.0;
+    m_io_read_limit_attr = nAttr.create(
+        "ioReadLimitMegabytesPerSecond", "iordlmtmbps",
+        MFnNumericData::kDouble, io_read_limit_default);
+    CHECK_MSTATUS(nAttr.setStorable(true));
+    CHECK_MSTATUS(nAttr.setKeyable(false));
+    CHECK_MSTATUS(nAttr.setMin(io_read_limit_min));
+    CHECK_MSTATUS(nAttr.setSoftMax(io_read_limit_soft_max));
+
+    // I/O Read Ahead Frames
+    int32_t io_read_ahead_frames_min = 0;
+    int32_t io_read_ahead_frames_soft_max = 16;
+    int32_t io_read_ahead_frames_default = 2;
+    m_io_read_ahead_frames_attr = nAttr.create(
+        "ioReadAheadFrames", "iordahdfrm",
+        MFnNumericData::kInt, io_read_ahead_frames_default);
+    CHECK_MSTATUS(nAttr.setStorable(true));
+    CHECK_MSTATUS(nAttr.setKeyable(false));
+    CHECK_MSTATUS(nAttr.setMin(io_read_ahead_frames_min));
+    CHECK_MSTATUS(nAttr.setSoftMax(io_read_ahead_frames_soft_max));
+
+    // I/O Memory Map Files
+    m_io_memory_map_attr = nAttr.create(
+        "ioMemoryMapFiles", "iomemmapfl",
+        MFnNumericData::kBoolean, true);
+    CHECK_MSTATUS(nAttr.setStorable(true));
+    CHECK_MSTATUS(nAttr.setKeyable(false));
+
+    // Proxy Resolution
+    m_proxy_resolution_attr = eAttr.create(
+        "proxyResolution", "prxyres", proxy::kResolutionFull);
+    CHECK_MSTATUS(eAttr.addField("full", proxy::kResolutionFull));
+    CHECK_MSTATUS(eAttr.addField("half", proxy::kResolutionHalf));
+    CHECK_MSTATUS(eAttr.addField("quarter", proxy::kResolutionQuarter));
+    CHECK_MSTATUS(eAttr.addField("eighth", proxy::kResolutionEighth));
+    CHECK_MSTATUS(eAttr.setStorable(true));
+
     // Add Attributes
     CHECK_MSTATUS(MPxNode::addAttribute(m_color_space_name_linear_attr));
     CHECK_MSTATUS(MPxNode::addAttribute(m_ocio_path_enable_attr));
@@ -189,6 +361,11 @@ MStatus PreferencesNode::initialize() {
     CHECK_MSTATUS(MPxNode::addAttribute(m_mem_cache_enable_attr));
     CHECK_MSTATUS(MPxNode::addAttribute(m_mem_cache_size_attr));
     CHECK_MSTATUS(MPxNode::addAttribute(m_disk_cache_base_dir_attr));
+    CHECK_MSTATUS(MPxNode::addAttribute(m_io_thread_count_attr));
+    CHECK_MSTATUS(MPxNode::addAttribute(m_io_read_limit_attr));
+    CHECK_MSTATUS(MPxNode::addAttribute(m_io_read_ahead_frames_attr));
+    CHECK_MSTATUS(MPxNode::addAttribute(m_io_memory_map_attr));
+    CHECK_MSTATUS(MPxNode::addAttribute(m_proxy_resolution_attr));
 
     return MS::kSuccess;
 }
@@ -28,6 +28,9 @@
 #include <maya/MString.h>
 #include <maya/MObject.h>
 #include <maya/MTypeId.h>
+#include <maya/MPlug.h>
+#include <maya/MNodeMessage.h>
+#include <maya/MMessage.h>
 
 // OCG
 #include "opencompgraph.h"
@@ -40,6 +43,8 @@ public:
 
     virtual ~PreferencesNode();
 
+    void postConstructor();
+
     virtual MStatus compute(const MPlug &plug, MDataBlock &data);
 
     static void *creator();
@@ -57,6 +62,27 @@ public:
     static MObject m_color_space_name_linear_attr;
     static MObject m_ocio_path_enable_attr;
     static MObject m_ocio_path_attr;
+    static MObject m_io_thread_count_attr;
+    static MObject m_io_read_limit_attr;
+    static MObject m_io_read_ahead_frames_attr;
+    static MObject m_io_memory_map_attr;
+    static MObject m_proxy_resolution_attr;
+
+private:
+    // Apply the I/O attribute values to the I/O pool.
+    void applyIoPreferences();
+
+    // Apply the proxy resolution and redraw the image planes using
+    // it.
+    void applyProxyPreferences();
+
+    static void attributeChangedCallback(
+        MNodeMessage::AttributeMessage msg,
+        MPlug &plug,
+        MPlug &other_plug,
+        void *client_data);
+
+    MCallbackId m_attribute_changed_callback_id;
 };
 
 } // namespace open_comp_graph_maya
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2021 David Cattermole.
+ *
+ * This file is part of OpenCompGraphMaya.
+ *
+ * OpenCompGraphMaya is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * OpenCompGraphMaya is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OpenCompGraphMaya.  If not, see <https://www.gnu.org/licenses/>.
+ * ====================================================================
+ *
+ * Proxy resolutions.
+ */
+
+// STL
+#include <algorithm>
+#include <atomic>
+
+// OCG Maya
+#include "proxy_resolution.h"
+
+namespace open_comp_graph_maya {
+namespace proxy {
+
+namespace {
+
+// Read by the image planes while drawing, written by the preferences
+// node.
+std::atomic<int32_t> &get_global_resolution() {
+    static std::atomic<int32_t> resolution(kResolutionFull);
+    return resolution;
+}
+
+int32_t clamp_resolution(const int32_t resolution) {
+    return std::min(std::max(resolution, kResolutionFull), kResolutionEighth);
+}
+
+} // namespace
+
+void set_global_resolution(const int32_t resolution) {
+    get_global_resolution() = clamp_resolution(resolution);
+}
+
+int32_t global_resolution() {
+    return get_global_resolution();
+}
+
+int32_t resolve(const int32_t resolution) {
+    if (resolution == kResolutionUseGlobal) {
+        return global_resolution();
+    }
+    return clamp_resolution(resolution);
+}
+
+int32_t resample_factor(const int32_t resolution) {
+    return -clamp_resolution(resolution);
+}
+
+} // namespace proxy
+} // namespace open_comp_graph_maya
@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2021 David Cattermole.
+ *
+ * This file is part of OpenCompGraphMaya.
+ *
+ * OpenCompGraphMaya is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * OpenCompGraphMaya is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OpenCompGraphMaya.  If not, see <https://www.gnu.org/licenses/>.
+ * ====================================================================
+ *
+ * Proxy resolutions; image planes may draw a reduced resolution copy
+ * of the image for faster (layout and animation) reviews.
+ */
+
+#ifndef OPENCOMPGRAPHMAYA_PROXY_RESOLUTION_H
+#define OPENCOMPGRAPHMAYA_PROXY_RESOLUTION_H
+
+// STL
+#include <cstdint>
+
+namespace open_comp_graph_maya {
+namespace proxy {
+
+// Each level halves the width and height of the image.
+const int32_t kResolutionFull = 0;
+const int32_t kResolutionHalf = 1;
+const int32_t kResolutionQuarter = 2;
+const int32_t kResolutionEighth = 3;
+
+// An image plane using the resolution of the 'ocgPreferences' node.
+const int32_t kResolutionUseGlobal = -1;
+
+// The resolution set in the 'ocgPreferences' node.
+void set_global_resolution(const int32_t resolution);
+int32_t global_resolution();
+
+// The resolution drawn by an image plane set to 'resolution'.
+int32_t resolve(const int32_t resolution);
+
+// The 'factor' of an OCG resample node reducing the image to
+// 'resolution'.
+int32_t resample_factor(const int32_t resolution);
+
+} // namespace proxy
+} // namespace open_comp_graph_maya
+
+#endif // OPENCOMPGRAPHMAYA_PROXY_RESOLUTION_H
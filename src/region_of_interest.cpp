@@ -0,0 +1,362 @@
+/*
+ * Copyright (C) 2021 David Cattermole.
+ *
+ * This file is part of OpenCompGraphMaya.
+ *
+ * OpenCompGraphMaya is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * OpenCompGraphMaya is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OpenCompGraphMaya.  If not, see <https://www.gnu.org/licenses/>.
+ * ====================================================================
+ *
+ * Regions of interest, propagated upstream from the consumer of a
+ * stream to the image read nodes.
+ */
+
+// Maya
+#include <maya/MPlug.h>
+#include <maya/MObject.h>
+#include <maya/MFnDependencyNode.h>
+#include <maya/MFloatMatrix.h>
+#include <maya/MFloatPoint.h>
+
+// STL
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+// OCG
+#include "opencompgraph.h"
+
+// OCG Maya
+#include <comp_nodes/image_crop_node.h>
+#include <comp_nodes/image_merge_node.h>
+#include <comp_nodes/image_read_node.h>
+#include <comp_nodes/image_resample_node.h>
+#include <comp_nodes/image_transform_node.h>
+#include <comp_nodes/lens_distort_node.h>
+#include <image_plane/image_plane_viewer_ops.h>
+#include "region_of_interest.h"
+
+namespace ocg = open_comp_graph;
+
+namespace open_comp_graph_maya {
+namespace roi {
+
+namespace {
+
+// Networks deeper than this are not followed; the read nodes further
+// upstream are not found.
+const uint32_t kMaxDepth = 256;
+
+// The pixels around each output pixel read by the filters of the
+// transform and resample nodes.
+const int32_t kTransformFilterMargin = 2;
+const int32_t kResampleFilterMargin = 2;
+
+// The node the stream at 'plug' comes from. Input plugs are followed
+// to the node connected to them.
+bool get_stream_node(const MPlug &plug, MObject &node) {
+    MStatus status;
+    if (plug.isNull()) {
+        return false;
+    }
+    if (!plug.isDestination()) {
+        node = plug.node();
+        return true;
+    }
+    MPlug source_plug = plug.source(&status);
+    if (!status || source_plug.isNull()) {
+        return false;
+    }
+    node = source_plug.node();
+    return true;
+}
+
+void add_read_region(
+        const MObject &node,
+        const Region &region,
+        std::vector<ReadRegion> &read_regions) {
+    for (auto &read_region : read_regions) {
+        if (read_region.node == node) {
+            read_region.region = read_region.region.united(region);
+            return;
+        }
+    }
+    ReadRegion read_region;
+    read_region.node = node;
+    read_region.region = region;
+    read_regions.push_back(read_region);
+}
+
+// The region of the crop node's input that is kept.
+Region crop_input_region(const MObject &node, const Region &region) {
+    Region window(
+        MPlug(node, ImageCropNode::m_window_min_x_attr).asInt(),
+        MPlug(node, ImageCropNode::m_window_min_y_attr).asInt(),
+        MPlug(node, ImageCropNode::m_window_max_x_attr).asInt(),
+        MPlug(node, ImageCropNode::m_window_max_y_attr).asInt());
+    return region.intersected(window);
+}
+
+// The region of the transform node's input that lands in 'region'.
+//
+// Transform positions are relative to the display window, so without
+// one the whole input may be needed.
+Region transform_input_region(
+        const MObject &node,
+        const Region &region,
+        const ocg::BBox2Di &display_window) {
+    if (!region.is_bounded) {
+        return region;
+    }
+    auto transform = image_plane::viewer_ops::get_transform(node);
+    if (transform == image_plane::viewer_ops::ViewerTransform()) {
+        return region;
+    }
+    if ((display_window.max_x <= display_window.min_x)
+        || (display_window.max_y <= display_window.min_y)) {
+        return Region();
+    }
+
+    std::vector<image_plane::viewer_ops::ViewerTransform> transforms;
+    transforms.push_back(transform);
+    MFloatMatrix input_to_output =
+        image_plane::viewer_ops::transform_matrix(transforms, display_window);
+    MFloatMatrix output_to_input = input_to_output.inverse();
+
+    const float corners[4][2] = {
+        {static_cast<float>(region.min_x), static_cast<float>(region.min_y)},
+        {static_cast<float>(region.max_x), static_cast<float>(region.min_y)},
+        {static_cast<float>(region.min_x), static_cast<float>(region.max_y)},
+        {static_cast<float>(region.max_x), static_cast<float>(region.max_y)},
+    };
+    float min_x = std::numeric_limits<float>::max();
+    float min_y = std::numeric_limits<float>::max();
+    float max_x = -std::numeric_limits<float>::max();
+    float max_y = -std::numeric_limits<float>::max();
+    for (size_t i = 0; i < 4; ++i) {
+        MFloatPoint point(corners[i][0], corners[i][1], 0.0f);
+        point *= output_to_input;
+        min_x = std::min(min_x, point.x);
+        min_y = std::min(min_y, point.y);
+        max_x = std::max(max_x, point.x);
+        max_y = std::max(max_y, point.y);
+    }
+    Region input_region(
+        static_cast<int32_t>(std::floor(min_x)),
+        static_cast<int32_t>(std::floor(min_y)),
+        static_cast<int32_t>(std::ceil(max_x)),
+        static_cast<int32_t>(std::ceil(max_y)));
+    return input_region.expanded(kTransformFilterMargin);
+}
+
+// The region of the resample node's input that lands in 'region'. The
+// output is the input scaled by 2 to the power of 'factor'.
+Region resample_input_region(const MObject &node, const Region &region) {
+    const int32_t factor = MPlug(node, ImageResampleNode::m_factor_attr).asInt();
+    if (!region.is_bounded || (factor == 0)) {
+        return region;
+    }
+    const double scale = std::pow(2.0, static_cast<double>(-factor));
+    Region input_region(
+        static_cast<int32_t>(std::floor(region.min_x * scale)),
+        static_cast<int32_t>(std::floor(region.min_y * scale)),
+        static_cast<int32_t>(std::ceil(region.max_x * scale)),
+        static_cast<int32_t>(std::ceil(region.max_y * scale)));
+    return input_region.expanded(kResampleFilterMargin);
+}
+
+// The lens model can move pixels across the whole image, so any
+// distortion needs the whole input.
+Region lens_distort_input_region(const MObject &node, const Region &region) {
+    const bool is_identity =
+        (MPlug(node, LensDistortNode::m_distortion_attr).asFloat() == 0.0f)
+        && (MPlug(node, LensDistortNode::m_quartic_distortion_attr).asFloat() == 0.0f)
+        && (MPlug(node, LensDistortNode::m_curvature_x_attr).asFloat() == 0.0f)
+        && (MPlug(node, LensDistortNode::m_curvature_y_attr).asFloat() == 0.0f)
+        && (MPlug(node, LensDistortNode::m_anamorphic_squeeze_attr).asFloat() == 1.0f);
+    if (is_identity) {
+        return region;
+    }
+    return Region();
+}
+
+MStatus propagate_region(
+        const MObject &node,
+        const Region &region,
+        const ocg::BBox2Di &display_window,
+        const uint32_t depth,
+        std::vector<ReadRegion> &read_regions) {
+    MStatus status;
+    if (depth > kMaxDepth) {
+        return MS::kSuccess;
+    }
+    MFnDependencyNode fn_node(node, &status);
+    CHECK_MSTATUS_AND_RETURN_IT(status);
+    auto type_id = fn_node.typeId();
+
+    if (type_id == ImageReadNode::m_id) {
+        if (MPlug(node, ImageReadNode::m_enable_attr).asBool()) {
+            add_read_region(node, region, read_regions);
+        }
+        return MS::kSuccess;
+    }
+
+    if (type_id == ImageMergeNode::m_id) {
+        const MObject input_attrs[2] = {
+            ImageMergeNode::m_in_stream_a_attr,
+            ImageMergeNode::m_in_stream_b_attr,
+        };
+        for (size_t i = 0; i < 2; ++i) {
+            MObject input_node;
+            if (get_stream_node(MPlug(node, input_attrs[i]), input_node)) {
+                status = propagate_region(
+                    input_node, region, display_window, depth + 1,
+                    read_regions);
+                CHECK_MSTATUS_AND_RETURN_IT(status);
+            }
+        }
+        return MS::kSuccess;
+    }
+
+    // Any other node with one input stream is followed; nodes not
+    // listed here need the same region from their input as they
+    // produce.
+    MObject in_stream_attr = fn_node.attribute("inStream", &status);
+    if (!status || in_stream_attr.isNull()) {
+        return MS::kSuccess;
+    }
+    MObject enable_attr = fn_node.attribute("enable", &status);
+    const bool enable =
+        !status || enable_attr.isNull() || MPlug(node, enable_attr).asBool();
+
+    Region input_region = region;
+    if (enable) {
+        if (type_id == ImageCropNode::m_id) {
+            input_region = crop_input_region(node, region);
+        } else if (type_id == ImageTransformNode::m_id) {
+            input_region = transform_input_region(node, region, display_window);
+        } else if (type_id == ImageResampleNode::m_id) {
+            input_region = resample_input_region(node, region);
+        } else if (type_id == LensDistortNode::m_id) {
+            input_region = lens_distort_input_region(node, region);
+        }
+    }
+
+    MObject input_node;
+    if (!get_stream_node(MPlug(node, in_stream_attr), input_node)) {
+        return MS::kSuccess;
+    }
+    return propagate_region(
+        input_node, input_region, display_window, depth + 1,
+        read_regions);
+}
+
+} // namespace
+
+bool Region::operator==(const Region &other) const {
+    if (is_bounded != other.is_bounded) {
+        return false;
+    }
+    if (!is_bounded) {
+        return true;
+    }
+    return (min_x == other.min_x)
+        && (min_y == other.min_y)
+        && (max_x == other.max_x)
+        && (max_y == other.max_y);
+}
+
+bool Region::operator!=(const Region &other) const {
+    return !(*this == other);
+}
+
+bool Region::is_empty() const {
+    return is_bounded && ((max_x <= min_x) || (max_y <= min_y));
+}
+
+bool Region::contains(const Region &other) const {
+    if (!is_bounded) {
+        return true;
+    }
+    if (!other.is_bounded) {
+        return false;
+    }
+    if (other.is_empty()) {
+        return true;
+    }
+    return (min_x <= other.min_x)
+        && (min_y <= other.min_y)
+        && (max_x >= other.max_x)
+        && (max_y >= other.max_y);
+}
+
+Region Region::intersected(const Region &other) const {
+    if (!is_bounded) {
+        return other;
+    }
+    if (!other.is_bounded) {
+        return *this;
+    }
+    return Region(
+        std::max(min_x, other.min_x),
+        std::max(min_y, other.min_y),
+        std::min(max_x, other.max_x),
+        std::min(max_y, other.max_y));
+}
+
+Region Region::united(const Region &other) const {
+    if (!is_bounded || !other.is_bounded) {
+        return Region();
+    }
+    if (is_empty()) {
+        return other;
+    }
+    if (other.is_empty()) {
+        return *this;
+    }
+    return Region(
+        std::min(min_x, other.min_x),
+        std::min(min_y, other.min_y),
+        std::max(max_x, other.max_x),
+        std::max(max_y, other.max_y));
+}
+
+Region Region::expanded(const int32_t margin) const {
+    if (!is_bounded || is_empty()) {
+        return *this;
+    }
+    return Region(
+        min_x - margin,
+        min_y - margin,
+        max_x + margin,
+        max_y + margin);
+}
+
+MStatus find_read_regions(
+        const MPlug &plug,
+        const Region &region,
+        const ocg::BBox2Di &display_window,
+        std::vector<ReadRegion> &read_regions) {
+    read_regions.clear();
+    MObject node;
+    if (!get_stream_node(plug, node)) {
+        return MS::kSuccess;
+    }
+    const uint32_t depth = 0;
+    return propagate_region(
+        node, region, display_window, depth, read_regions);
+}
+
+} // namespace roi
+} // namespace open_comp_graph_maya
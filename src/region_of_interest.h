@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2021 David Cattermole.
+ *
+ * This file is part of OpenCompGraphMaya.
+ *
+ * OpenCompGraphMaya is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * OpenCompGraphMaya is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OpenCompGraphMaya.  If not, see <https://www.gnu.org/licenses/>.
+ * ====================================================================
+ *
+ * Regions of interest, propagated upstream from the consumer of a
+ * stream to the image read nodes.
+ *
+ * A consumer only needs part of an image when, for example, an
+ * 'ocgImageCrop' keeps a small window of it. The region the consumer
+ * needs is mapped backwards through each upstream node, widened by
+ * the pixels the node's filter reads around each output pixel, so
+ * each read node knows the pixels that can affect the consumer.
+ */
+
+#ifndef OPENCOMPGRAPHMAYA_REGION_OF_INTEREST_H
+#define OPENCOMPGRAPHMAYA_REGION_OF_INTEREST_H
+
+// Maya
+#include <maya/MPlug.h>
+#include <maya/MObject.h>
+#include <maya/MStatus.h>
+
+// STL
+#include <cstdint>
+#include <vector>
+
+// OCG
+#include "opencompgraph.h"
+
+namespace ocg = open_comp_graph;
+
+namespace open_comp_graph_maya {
+namespace roi {
+
+// A rectangle of pixels, in the coordinates of the image (origin at
+// the bottom-left of the display window). The maximum is exclusive.
+//
+// The default region is unbounded; every pixel is needed.
+struct Region {
+    Region()
+        : is_bounded(false)
+        , min_x(0)
+        , min_y(0)
+        , max_x(0)
+        , max_y(0) {}
+
+    Region(const int32_t min_x_,
+           const int32_t min_y_,
+           const int32_t max_x_,
+           const int32_t max_y_)
+        : is_bounded(true)
+        , min_x(min_x_)
+        , min_y(min_y_)
+        , max_x(max_x_)
+        , max_y(max_y_) {}
+
+    bool operator==(const Region &other) const;
+    bool operator!=(const Region &other) const;
+
+    bool is_empty() const;
+
+    // Are all the pixels of 'other' in this region?
+    bool contains(const Region &other) const;
+
+    // The pixels in both regions.
+    Region intersected(const Region &other) const;
+
+    // The smallest region containing both regions.
+    Region united(const Region &other) const;
+
+    // The region grown by 'margin' pixels on each side.
+    Region expanded(const int32_t margin) const;
+
+    bool is_bounded;
+    int32_t min_x;
+    int32_t min_y;
+    int32_t max_x;
+    int32_t max_y;
+};
+
+// The region needed from one 'ocgImageRead' node.
+struct ReadRegion {
+    MObject node;
+    Region region;
+};
+
+// Find the enabled 'ocgImageRead' nodes upstream of 'plug', and the
+// region of each needed to produce 'region' at 'plug'. 'plug' may be
+// the input of a consumer (such as an image plane), or the output
+// of a node. A read node reached by more than one path needs the
+// union of the regions.
+//
+// 'display_window' is the display window of the stream, used to
+// place transforms; when it is empty (not yet known) regions passing
+// through a transform become unbounded.
+MStatus find_read_regions(
+    const MPlug &plug,
+    const Region &region,
+    const ocg::BBox2Di &display_window,
+    std::vector<ReadRegion> &read_regions);
+
+} // namespace roi
+} // namespace open_comp_graph_maya
+
+#endif // OPENCOMPGRAPHMAYA_REGION_OF_INTEREST_H
@@ -0,0 +1,534 @@
+/*
+ * Copyright (C) 2021 David Cattermole.
+ *
+ * This file is part of OpenCompGraphMaya.
+ *
+ * OpenCompGraphMaya is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * OpenCompGraphMaya is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OpenCompGraphMaya.  If not, see <https://www.gnu.org/licenses/>.
+ * ====================================================================
+ *
+ * An index of the image sequences on disk.
+ */
+
+// STL
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+
+// OCG Maya
+#include "image_header.h"
+#include "sequence_index.h"
+
+namespace open_comp_graph_maya {
+namespace sequence {
+
+namespace {
+
+// A directory is checked for changes at most this often; scrubbing
+// and read-ahead look up many frames per second.
+const std::chrono::milliseconds kDirectoryCheckInterval(1000);
+
+// File systems store modification times in seconds (or coarser), so
+// a directory modified this recently may be modified again without
+// its time changing; it is listed again at each check.
+const int64_t kRecentModificationSeconds = 2;
+
+// The most headers cached; the cache is emptied when full.
+const size_t kMaxCachedHeaders = 4096;
+
+// Frame numbers with more digits than this are not frame numbers.
+const size_t kMaxFrameDigits = 9;
+
+// 64-bit FNV-1a, to hash the identities of files.
+const uint64_t kHashOffsetBasis = 14695981039346656037ULL;
+const uint64_t kHashPrime = 1099511628211ULL;
+
+struct FileStatus {
+    FileStatus()
+        : size(0)
+        , modified_time(0)
+        , file_id(0) {}
+
+    bool operator==(const FileStatus &other) const {
+        return (size == other.size)
+            && (modified_time == other.modified_time)
+            && (file_id == other.file_id);
+    }
+
+    uint64_t size;
+    int64_t modified_time;
+
+    // The inode of the file; a file replaced by renaming another
+    // over it has a new inode, even with the same size and time.
+    // Zero on Windows.
+    uint64_t file_id;
+};
+
+bool get_file_status(const std::string &path, FileStatus &file_status) {
+#ifdef _WIN32
+    struct _stat64 path_stat;
+    if (_stat64(path.c_str(), &path_stat) != 0) {
+        return false;
+    }
+#else
+    struct stat path_stat;
+    if (stat(path.c_str(), &path_stat) != 0) {
+        return false;
+    }
+#endif
+    file_status.size = static_cast<uint64_t>(path_stat.st_size);
+    file_status.modified_time = static_cast<int64_t>(path_stat.st_mtime);
+#ifndef _WIN32
+    file_status.file_id = static_cast<uint64_t>(path_stat.st_ino);
+#endif
+    return true;
+}
+
+void hash_bytes(uint64_t &hash, const void *data, const size_t size) {
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<uint64_t>(bytes[i]);
+        hash *= kHashPrime;
+    }
+}
+
+int32_t positive_modulo(const int32_t value, const int32_t divisor) {
+    return ((value % divisor) + divisor) % divisor;
+}
+
+// List the names of the files in 'directory'.
+bool list_directory(
+        const std::string &directory,
+        std::vector<std::string> &file_names) {
+    file_names.clear();
+#ifdef _WIN32
+    const std::string pattern = directory + "\\*";
+    WIN32_FIND_DATAA find_data;
+    HANDLE find_handle = FindFirstFileA(pattern.c_str(), &find_data);
+    if (find_handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    do {
+        if ((find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0) {
+            file_names.push_back(find_data.cFileName);
+        }
+    } while (FindNextFileA(find_handle, &find_data));
+    FindClose(find_handle);
+#else
+    DIR *dir = opendir(directory.c_str());
+    if (dir == nullptr) {
+        return false;
+    }
+    while (struct dirent *entry = readdir(dir)) {
+        const std::string file_name(entry->d_name);
+        if ((file_name != ".") && (file_name != "..")) {
+            file_names.push_back(file_name);
+        }
+    }
+    closedir(dir);
+#endif
+    return true;
+}
+
+// A file path split around its run of '#' characters.
+struct FramePattern {
+    FramePattern()
+        : padding(0) {}
+
+    std::string directory;
+    std::string prefix;
+    std::string suffix;
+    size_t padding;
+};
+
+// Split 'file_path' into the directory and the file name parts
+// before and after the (last) run of '#' characters. Returns false
+// when the file name has no '#' characters.
+bool split_frame_pattern(
+        const std::string &file_path,
+        FramePattern &pattern) {
+    const auto separator = file_path.find_last_of("/\\");
+    const size_t name_start =
+        (separator == std::string::npos) ? 0 : separator + 1;
+    const auto end = file_path.find_last_of('#');
+    if ((end == std::string::npos) || (end < name_start)) {
+        return false;
+    }
+    auto start = end;
+    while ((start > name_start) && (file_path[start - 1] == '#')) {
+        start -= 1;
+    }
+    if (separator == std::string::npos) {
+        pattern.directory = ".";
+    } else if (separator == 0) {
+        pattern.directory = file_path.substr(0, 1);
+    } else {
+        pattern.directory = file_path.substr(0, separator);
+    }
+    pattern.prefix = file_path.substr(name_start, start - name_start);
+    pattern.suffix = file_path.substr(end + 1);
+    pattern.padding = (end - start) + 1;
+    return true;
+}
+
+// Parse the frame number of 'file_name', the inverse of
+// 'expand_frame_path'; at least 'padding' digits, with no more zeros
+// than the padding needs, and a '-' before negative frames.
+bool parse_frame(
+        const std::string &file_name,
+        const FramePattern &pattern,
+        int32_t &frame) {
+    const size_t affix_size = pattern.prefix.size() + pattern.suffix.size();
+    if ((file_name.size() <= affix_size)
+        || (file_name.compare(0, pattern.prefix.size(), pattern.prefix) != 0)
+        || (file_name.compare(
+                file_name.size() - pattern.suffix.size(),
+                pattern.suffix.size(), pattern.suffix) != 0)) {
+        return false;
+    }
+    std::string digits = file_name.substr(
+        pattern.prefix.size(), file_name.size() - affix_size);
+    const bool is_negative = digits[0] == '-';
+    if (is_negative) {
+        digits.erase(0, 1);
+    }
+    if ((digits.size() < pattern.padding)
+        || (digits.size() > kMaxFrameDigits)
+        || ((digits.size() > pattern.padding) && (digits[0] == '0'))) {
+        return false;
+    }
+    for (auto c : digits) {
+        if ((c < '0') || (c > '9')) {
+            return false;
+        }
+    }
+    const int32_t value = static_cast<int32_t>(std::strtol(digits.c_str(), nullptr, 10));
+    if (is_negative && (value == 0)) {
+        return false;
+    }
+    frame = is_negative ? -value : value;
+    return true;
+}
+
+// The files of a directory, as last listed.
+struct DirectoryListing {
+    DirectoryListing()
+        : generation(0)
+        , modified_time(0) {}
+
+    // Increases each time the directory is listed, so the sequences
+    // found from an older listing are found again.
+    uint64_t generation;
+    int64_t modified_time;
+    std::chrono::steady_clock::time_point check_time;
+    std::vector<std::string> file_names;
+};
+
+struct CachedSequence {
+    CachedSequence()
+        : generation(0) {}
+
+    uint64_t generation;
+    std::shared_ptr<const Sequence> sequence;
+};
+
+struct CachedHeader {
+    FileStatus file_status;
+    image_header::ImageHeader header;
+};
+
+class SequenceIndex {
+public:
+    SequenceIndex()
+        : m_generation(0) {}
+
+    std::shared_ptr<const Sequence> find_sequence(const std::string &file_path) {
+        FramePattern pattern;
+        if (!split_frame_pattern(file_path, pattern)) {
+            return nullptr;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const DirectoryListing *listing = this->update_listing(pattern.directory);
+        if (listing == nullptr) {
+            return nullptr;
+        }
+        auto sequence_it = m_sequences.find(file_path);
+        if ((sequence_it != m_sequences.end())
+            && (sequence_it->second.generation == listing->generation)) {
+            return sequence_it->second.sequence;
+        }
+
+        auto sequence = std::make_shared<Sequence>();
+        for (const auto &file_name : listing->file_names) {
+            int32_t frame = 0;
+            if (parse_frame(file_name, pattern, frame)) {
+                sequence->frame_paths[frame] =
+                    file_path.substr(0, file_path.size()
+                                     - pattern.prefix.size()
+                                     - pattern.padding
+                                     - pattern.suffix.size())
+                    + file_name;
+            }
+        }
+        if (!sequence->frame_paths.empty()) {
+            sequence->start_frame = sequence->frame_paths.begin()->first;
+            sequence->end_frame = sequence->frame_paths.rbegin()->first;
+            for (auto it = sequence->frame_paths.begin();
+                 it != sequence->frame_paths.end(); ++it) {
+                auto next_it = std::next(it);
+                if (next_it == sequence->frame_paths.end()) {
+                    break;
+                }
+                for (int32_t frame = it->first + 1;
+                     frame < next_it->first; ++frame) {
+                    sequence->missing_frames.push_back(frame);
+                }
+            }
+        }
+
+        CachedSequence cached_sequence;
+        cached_sequence.generation = listing->generation;
+        cached_sequence.sequence = sequence;
+        m_sequences[file_path] = cached_sequence;
+        return sequence;
+    }
+
+    bool find_header(
+            const std::string &file_path,
+            image_header::ImageHeader &header) {
+        FileStatus file_status;
+        if (!get_file_status(file_path, file_status)) {
+            return false;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto header_it = m_headers.find(file_path);
+            if ((header_it != m_headers.end())
+                && (header_it->second.file_status == file_status)) {
+                header = header_it->second.header;
+                return true;
+            }
+        }
+
+        // Read without the lock, so slow file systems do not block
+        // the other lookups.
+        if (!image_header::read_header(file_path, header)) {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_headers.size() >= kMaxCachedHeaders) {
+            m_headers.clear();
+        }
+        CachedHeader cached_header;
+        cached_header.file_status = file_status;
+        cached_header.header = header;
+        m_headers[file_path] = cached_header;
+        return true;
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_listings.clear();
+        m_sequences.clear();
+        m_headers.clear();
+    }
+
+private:
+    // List 'directory' when it was never listed, or has been modified
+    // since it was last listed. Must be called with the mutex held.
+    const DirectoryListing *update_listing(const std::string &directory) {
+        const auto now = std::chrono::steady_clock::now();
+        auto listing_it = m_listings.find(directory);
+        if ((listing_it != m_listings.end())
+            && ((now - listing_it->second.check_time) < kDirectoryCheckInterval)) {
+            return &listing_it->second;
+        }
+
+        FileStatus directory_status;
+        if (!get_file_status(directory, directory_status)) {
+            m_listings.erase(directory);
+            return nullptr;
+        }
+        const int64_t system_time = static_cast<int64_t>(
+            std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count());
+        const bool is_recently_modified =
+            std::abs(system_time - directory_status.modified_time)
+            <= kRecentModificationSeconds;
+        if ((listing_it != m_listings.end())
+            && (listing_it->second.modified_time == directory_status.modified_time)
+            && !is_recently_modified) {
+            listing_it->second.check_time = now;
+            return &listing_it->second;
+        }
+
+        DirectoryListing listing;
+        if (!list_directory(directory, listing.file_names)) {
+            m_listings.erase(directory);
+            return nullptr;
+        }
+        m_generation += 1;
+        listing.generation = m_generation;
+        listing.modified_time = directory_status.modified_time;
+        listing.check_time = now;
+        DirectoryListing &stored_listing = m_listings[directory];
+        stored_listing = std::move(listing);
+        return &stored_listing;
+    }
+
+    std::mutex m_mutex;
+    uint64_t m_generation;
+    std::map<std::string, DirectoryListing> m_listings;
+    std::map<std::string, CachedSequence> m_sequences;
+    std::map<std::string, CachedHeader> m_headers;
+};
+
+SequenceIndex &get_sequence_index() {
+    static SequenceIndex sequence_index;
+    return sequence_index;
+}
+
+} // namespace
+
+bool Sequence::is_empty() const {
+    return frame_paths.empty();
+}
+
+bool Sequence::has_frame(const int32_t frame) const {
+    return frame_paths.find(frame) != frame_paths.end();
+}
+
+std::string Sequence::frame_path(const int32_t frame) const {
+    auto it = frame_paths.find(frame);
+    if (it == frame_paths.end()) {
+        return std::string();
+    }
+    return it->second;
+}
+
+std::string expand_frame_path(
+        const std::string &file_path,
+        const int32_t frame) {
+    auto end = file_path.find_last_of('#');
+    if (end == std::string::npos) {
+        return file_path;
+    }
+    auto start = end;
+    while ((start > 0) && (file_path[start - 1] == '#')) {
+        start -= 1;
+    }
+    const size_t padding = (end - start) + 1;
+
+    std::string frame_string = std::to_string(std::abs(frame));
+    if (frame_string.size() < padding) {
+        frame_string.insert(0, padding - frame_string.size(), '0');
+    }
+    if (frame < 0) {
+        frame_string.insert(0, 1, '-');
+    }
+    std::string expanded_path = file_path;
+    expanded_path.replace(start, padding, frame_string);
+    return expanded_path;
+}
+
+bool map_frame(
+        const int32_t frame,
+        const int32_t start_frame,
+        const int32_t end_frame,
+        const int32_t before_mode,
+        const int32_t after_mode,
+        int32_t &mapped_frame) {
+    mapped_frame = frame;
+    if ((end_frame < start_frame)
+        || ((frame >= start_frame) && (frame <= end_frame))) {
+        return true;
+    }
+
+    const int32_t mode = frame < start_frame ? before_mode : after_mode;
+    const int32_t length = (end_frame - start_frame) + 1;
+    if (mode == kFrameModeHold) {
+        mapped_frame = std::min(std::max(frame, start_frame), end_frame);
+    } else if (mode == kFrameModeLoop) {
+        mapped_frame = start_frame + positive_modulo(frame - start_frame, length);
+    } else if (mode == kFrameModeBounce) {
+        if (length == 1) {
+            mapped_frame = start_frame;
+        } else {
+            const int32_t period = 2 * (length - 1);
+            const int32_t offset = positive_modulo(frame - start_frame, period);
+            mapped_frame = offset < length
+                ? start_frame + offset
+                : start_frame + (period - offset);
+        }
+    } else {
+        return false;
+    }
+    return true;
+}
+
+std::shared_ptr<const Sequence> find_sequence(const std::string &file_path) {
+    return get_sequence_index().find_sequence(file_path);
+}
+
+bool find_header(
+        const std::string &file_path,
+        image_header::ImageHeader &header) {
+    return get_sequence_index().find_header(file_path, header);
+}
+
+uint64_t hash_file_identities(const std::vector<std::string> &file_paths) {
+    uint64_t hash = kHashOffsetBasis;
+    for (const auto &file_path : file_paths) {
+        hash_bytes(hash, file_path.data(), file_path.size());
+        FileStatus file_status;
+        if (get_file_status(file_path, file_status)) {
+            hash_bytes(hash, &file_status.size, sizeof(file_status.size));
+            hash_bytes(hash, &file_status.modified_time,
+                       sizeof(file_status.modified_time));
+            hash_bytes(hash, &file_status.file_id, sizeof(file_status.file_id));
+        }
+    }
+    return hash;
+}
+
+void clear() {
+    get_sequence_index().clear();
+}
+
+} // namespace sequence
+} // namespace open_comp_graph_maya
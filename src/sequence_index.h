@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2021 David Cattermole.
+ *
+ * This file is part of OpenCompGraphMaya.
+ *
+ * OpenCompGraphMaya is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * OpenCompGraphMaya is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OpenCompGraphMaya.  If not, see <https://www.gnu.org/licenses/>.
+ * ====================================================================
+ *
+ * An index of the image sequences on disk.
+ *
+ * File paths of 'ocgImageRead' nodes name a sequence with a run of
+ * '#' characters, replaced by the zero-padded frame number. The index
+ * lists each directory once, finds the frames of each sequence in it,
+ * and lists it again only when the directory is modified, so looking
+ * up the file of a frame, the frame range or the missing frames does
+ * not touch the file system.
+ *
+ * The headers of the files are cached too (keyed on the file's size
+ * and modification time), so the resolution, windows, channels and
+ * color space of a frame are known without reading the file again.
+ */
+
+#ifndef OPENCOMPGRAPHMAYA_SEQUENCE_INDEX_H
+#define OPENCOMPGRAPHMAYA_SEQUENCE_INDEX_H
+
+// STL
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// OCG Maya
+#include "image_header.h"
+
+namespace open_comp_graph_maya {
+namespace sequence {
+
+// Values of the 'beforeFrame' and 'afterFrame' attributes of
+// 'ocgImageRead' nodes.
+const int32_t kFrameModeHold = 0;
+const int32_t kFrameModeLoop = 1;
+const int32_t kFrameModeBounce = 2;
+
+// The frames of a sequence found on disk.
+struct Sequence {
+    Sequence()
+        : start_frame(0)
+        , end_frame(0) {}
+
+    bool is_empty() const;
+    bool has_frame(const int32_t frame) const;
+
+    // The file path of 'frame', or an empty string when the frame is
+    // not on disk.
+    std::string frame_path(const int32_t frame) const;
+
+    // The file path of each frame on disk.
+    std::map<int32_t, std::string> frame_paths;
+
+    // The first and last frames on disk (inclusive).
+    int32_t start_frame;
+    int32_t end_frame;
+
+    // The frames between the start and end frame that are not on
+    // disk.
+    std::vector<int32_t> missing_frames;
+};
+
+// Replace the (last) run of '#' characters in 'file_path' with the
+// zero-padded frame number.
+std::string expand_frame_path(
+    const std::string &file_path,
+    const int32_t frame);
+
+// Map a frame outside of the range the same way the read node does.
+// Returns false when the frame has no file ('black' or 'error').
+bool map_frame(
+    const int32_t frame,
+    const int32_t start_frame,
+    const int32_t end_frame,
+    const int32_t before_mode,
+    const int32_t after_mode,
+    int32_t &mapped_frame);
+
+// Find the sequence named by 'file_path'. Returns nullptr when the
+// file name has no '#' characters, or the directory cannot be listed.
+//
+// The returned sequence is never modified; a directory that changed
+// gives a new sequence.
+std::shared_ptr<const Sequence> find_sequence(const std::string &file_path);
+
+// Read the header of 'file_path', or take it from the cache when the
+// file has not changed since it was read. Returns false when the file
+// cannot be read.
+bool find_header(
+    const std::string &file_path,
+    image_header::ImageHeader &header);
+
+// A hash of the path, size and modification time of each of
+// 'file_paths', which changes when any of the files is replaced.
+// Files that cannot be found only add their path.
+uint64_t hash_file_identities(const std::vector<std::string> &file_paths);
+
+// Forget all directories, sequences and headers.
+void clear();
+
+} // namespace sequence
+} // namespace open_comp_graph_maya
+
+#endif // OPENCOMPGRAPHMAYA_SEQUENCE_INDEX_H
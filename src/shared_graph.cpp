@@ -0,0 +1,382 @@
+/*
+ * Copyright (C) 2021 David Cattermole.
+ *
+ * This file is part of OpenCompGraphMaya.
+ *
+ * OpenCompGraphMaya is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * OpenCompGraphMaya is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OpenCompGraphMaya.  If not, see <https://www.gnu.org/licenses/>.
+ * ====================================================================
+ *
+ * The node graph edited by the Maya DG.
+ */
+
+// STL
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// OCG
+#include "opencompgraph.h"
+
+// OCG Maya
+#include "sequence_index.h"
+#include "shared_graph.h"
+
+namespace ocg = open_comp_graph;
+
+namespace open_comp_graph_maya {
+
+namespace {
+
+// Deeper graphs are not expected; the limit guards against cycles.
+const uint32_t kMaxNodeHashDepth = 1024;
+
+// 64-bit FNV-1a.
+const uint64_t kHashOffsetBasis = 14695981039346656037ULL;
+const uint64_t kHashPrime = 1099511628211ULL;
+
+void hash_bytes(uint64_t &hash, const void *data, const size_t size) {
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<uint64_t>(bytes[i]);
+        hash *= kHashPrime;
+    }
+}
+
+template <typename T>
+void hash_value(uint64_t &hash, const T &value) {
+    hash_bytes(hash, &value, sizeof(T));
+}
+
+void hash_string(uint64_t &hash, const std::string &value) {
+    hash_value(hash, value.size());
+    hash_bytes(hash, value.data(), value.size());
+}
+
+} // namespace
+
+bool GraphAttrEdit::has_same_value(const GraphAttrEdit &other) const {
+    if (type != other.type) {
+        return false;
+    }
+    switch (type) {
+        case GraphAttrType::kFloat32:
+            return value_f32 == other.value_f32;
+        case GraphAttrType::kInteger32:
+            return value_i32 == other.value_i32;
+        case GraphAttrType::kString:
+            return value_str == other.value_str;
+    }
+    return false;
+}
+
+bool GraphEdits::empty() const {
+    return nodes.empty() && attrs.empty() && inputs.empty();
+}
+
+SharedGraph::SharedGraph()
+        : m_generation(0)
+        , m_nodes()
+        , m_attrs()
+        , m_inputs() {}
+
+uint64_t SharedGraph::next_generation() {
+    return m_generation.fetch_add(1) + 1;
+}
+
+uint64_t SharedGraph::generation() const {
+    return m_generation.load();
+}
+
+bool SharedGraph::node_exists(const ocg::Node &node) const {
+    const uint64_t id = node.get_id();
+    return (id != 0) && (m_nodes.find(id) != m_nodes.end());
+}
+
+ocg::Node SharedGraph::create_node(ocg::NodeType node_type, uint64_t id) {
+    auto node = ocg::Node(node_type, id);
+    auto it = m_nodes.find(id);
+    if ((it != m_nodes.end())
+        && (it->second.edit.get_node_type() == node_type)) {
+        return node;
+    }
+    Record<ocg::Node> record = {node, this->next_generation()};
+    m_nodes[id] = record;
+    return node;
+}
+
+void SharedGraph::set_node_attr(const GraphAttrEdit &edit) {
+    const AttrKey key(edit.node.get_id(), edit.name);
+    auto it = m_attrs.find(key);
+    if ((it != m_attrs.end()) && it->second.edit.has_same_value(edit)) {
+        return;
+    }
+    Record<GraphAttrEdit> record = {edit, this->next_generation()};
+    m_attrs[key] = record;
+}
+
+void SharedGraph::set_node_attr_f32(
+        const ocg::Node &node, const std::string &name, float value) {
+    GraphAttrEdit edit;
+    edit.node = node;
+    edit.name = name;
+    edit.type = GraphAttrType::kFloat32;
+    edit.value_f32 = value;
+    this->set_node_attr(edit);
+}
+
+void SharedGraph::set_node_attr_i32(
+        const ocg::Node &node, const std::string &name, int32_t value) {
+    GraphAttrEdit edit;
+    edit.node = node;
+    edit.name = name;
+    edit.type = GraphAttrType::kInteger32;
+    edit.value_i32 = value;
+    this->set_node_attr(edit);
+}
+
+void SharedGraph::set_node_attr_str(
+        const ocg::Node &node, const std::string &name,
+        const std::string &value) {
+    GraphAttrEdit edit;
+    edit.node = node;
+    edit.name = name;
+    edit.type = GraphAttrType::kString;
+    edit.value_str = value;
+    this->set_node_attr(edit);
+}
+
+void SharedGraph::connect(
+        const ocg::Node &input_node,
+        const ocg::Node &node,
+        uint8_t input_num) {
+    const InputKey key(node.get_id(), input_num);
+    auto it = m_inputs.find(key);
+    if ((it != m_inputs.end())
+        && (it->second.edit.input_node.get_id() == input_node.get_id())) {
+        return;
+    }
+    GraphInputEdit edit;
+    edit.node = node;
+    edit.input_num = input_num;
+    edit.input_node = input_node;
+    Record<GraphInputEdit> record = {edit, this->next_generation()};
+    m_inputs[key] = record;
+}
+
+void SharedGraph::disconnect_input(const ocg::Node &node, uint8_t input_num) {
+    const InputKey key(node.get_id(), input_num);
+    auto it = m_inputs.find(key);
+    if ((it == m_inputs.end())
+        || (it->second.edit.input_node.get_id() == 0)) {
+        return;
+    }
+    GraphInputEdit edit;
+    edit.node = node;
+    edit.input_num = input_num;
+    Record<GraphInputEdit> record = {edit, this->next_generation()};
+    m_inputs[key] = record;
+}
+
+std::string SharedGraph::data_debug_string() const {
+    std::stringstream stream;
+    stream << "SharedGraph generation=" << this->generation()
+           << " nodes=" << m_nodes.size()
+           << " attrs=" << m_attrs.size()
+           << " inputs=" << m_inputs.size() << '\n';
+    for (const auto &item : m_inputs) {
+        const GraphInputEdit &edit = item.second.edit;
+        stream << "  " << edit.input_node.get_id()
+               << " -> " << edit.node.get_id()
+               << " [" << static_cast<uint32_t>(edit.input_num) << "]\n";
+    }
+    return stream.str();
+}
+
+uint64_t SharedGraph::node_hash(const ocg::Node &node) const {
+    std::unordered_map<uint64_t, uint64_t> node_hashes;
+    return this->node_hash(node.get_id(), 0, node_hashes);
+}
+
+uint64_t SharedGraph::node_hash(
+        const uint64_t node_id,
+        const uint32_t depth,
+        std::unordered_map<uint64_t, uint64_t> &node_hashes) const {
+    uint64_t hash = kHashOffsetBasis;
+    auto node_it = m_nodes.find(node_id);
+    if ((node_id == 0)
+        || (node_it == m_nodes.end())
+        || (depth > kMaxNodeHashDepth)) {
+        return hash;
+    }
+    auto cached_it = node_hashes.find(node_id);
+    if (cached_it != node_hashes.end()) {
+        return cached_it->second;
+    }
+
+    const auto node_type =
+        static_cast<uint32_t>(node_it->second.edit.get_node_type());
+    hash_value(hash, node_type);
+
+    // The keys are sorted by node id, then attribute name or input
+    // number.
+    for (auto it = m_attrs.lower_bound(AttrKey(node_id, std::string()));
+         (it != m_attrs.end()) && (it->first.first == node_id);
+         ++it) {
+        const GraphAttrEdit &edit = it->second.edit;
+        hash_string(hash, edit.name);
+        hash_value(hash, static_cast<uint8_t>(edit.type));
+        switch (edit.type) {
+            case GraphAttrType::kFloat32:
+                hash_value(hash, edit.value_f32);
+                break;
+            case GraphAttrType::kInteger32:
+                hash_value(hash, edit.value_i32);
+                break;
+            case GraphAttrType::kString:
+                hash_string(hash, edit.value_str);
+                break;
+        }
+    }
+    for (auto it = m_inputs.lower_bound(InputKey(node_id, 0));
+         (it != m_inputs.end()) && (it->first.first == node_id);
+         ++it) {
+        const GraphInputEdit &edit = it->second.edit;
+        hash_value(hash, edit.input_num);
+        const uint64_t input_hash = this->node_hash(
+            edit.input_node.get_id(), depth + 1, node_hashes);
+        hash_value(hash, input_hash);
+    }
+
+    node_hashes[node_id] = hash;
+    return hash;
+}
+
+const GraphAttrEdit *SharedGraph::find_attr(
+        const uint64_t node_id,
+        const std::string &name) const {
+    auto it = m_attrs.find(AttrKey(node_id, name));
+    if (it == m_attrs.end()) {
+        return nullptr;
+    }
+    return &it->second.edit;
+}
+
+void SharedGraph::node_file_paths(
+        const ocg::Node &node,
+        const double frame,
+        std::vector<std::string> &file_paths) const {
+    const int32_t execute_frame = static_cast<int32_t>(std::lround(frame));
+    std::vector<uint64_t> node_ids(1, node.get_id());
+    std::unordered_set<uint64_t> visited_ids;
+    while (!node_ids.empty()) {
+        const uint64_t node_id = node_ids.back();
+        node_ids.pop_back();
+        if ((node_id == 0) || !visited_ids.insert(node_id).second) {
+            continue;
+        }
+        for (auto it = m_inputs.lower_bound(InputKey(node_id, 0));
+             (it != m_inputs.end()) && (it->first.first == node_id);
+             ++it) {
+            node_ids.push_back(it->second.edit.input_node.get_id());
+        }
+
+        const GraphAttrEdit *file_path = this->find_attr(node_id, "file_path");
+        if ((file_path == nullptr)
+            || (file_path->type != GraphAttrType::kString)
+            || file_path->value_str.empty()) {
+            continue;
+        }
+
+        // Nodes without a frame range read the frame itself.
+        int32_t frame_range[4] = {0, -1, 0, 0};
+        const char *frame_range_names[4] = {
+            "start_frame", "end_frame", "before_frame", "after_frame"};
+        for (size_t i = 0; i < 4; ++i) {
+            const GraphAttrEdit *attr = this->find_attr(node_id, frame_range_names[i]);
+            if ((attr != nullptr) && (attr->type == GraphAttrType::kInteger32)) {
+                frame_range[i] = attr->value_i32;
+            }
+        }
+        int32_t mapped_frame = execute_frame;
+        if (sequence::map_frame(
+                execute_frame,
+                frame_range[0], frame_range[1],
+                frame_range[2], frame_range[3],
+                mapped_frame)) {
+            file_paths.push_back(
+                sequence::expand_frame_path(file_path->value_str, mapped_frame));
+        }
+    }
+}
+
+void SharedGraph::edits_since(
+        const uint64_t generation,
+        GraphEdits &edits) const {
+    edits.generation = this->generation();
+    for (const auto &item : m_nodes) {
+        if (item.second.generation > generation) {
+            edits.nodes.push_back(item.second.edit);
+        }
+    }
+    for (const auto &item : m_attrs) {
+        if (item.second.generation > generation) {
+            edits.attrs.push_back(item.second.edit);
+        }
+    }
+    for (const auto &item : m_inputs) {
+        if (item.second.generation > generation) {
+            edits.inputs.push_back(item.second.edit);
+        }
+    }
+}
+
+// Nodes are created before they are connected or given values.
+void apply_graph_edits(const GraphEdits &edits, ocg::Graph &graph) {
+    for (auto node : edits.nodes) {
+        graph.create_node(node.get_node_type(), node.get_id());
+    }
+    for (const auto &edit : edits.inputs) {
+        auto node = edit.node;
+        auto input_node = edit.input_node;
+        if (input_node.get_id() != 0) {
+            graph.connect(input_node, node, edit.input_num);
+        } else {
+            graph.disconnect_input(node, edit.input_num);
+        }
+    }
+    for (const auto &edit : edits.attrs) {
+        auto node = edit.node;
+        switch (edit.type) {
+            case GraphAttrType::kFloat32:
+                graph.set_node_attr_f32(
+                    node, edit.name.c_str(), edit.value_f32);
+                break;
+            case GraphAttrType::kInteger32:
+                graph.set_node_attr_i32(
+                    node, edit.name.c_str(), edit.value_i32);
+                break;
+            case GraphAttrType::kString:
+                graph.set_node_attr_str(
+                    node, edit.name.c_str(), edit.value_str.c_str());
+                break;
+        }
+    }
+}
+
+} // namespace open_comp_graph_maya
@@ -0,0 +1,188 @@
+/*
+ * Copyright (C) 2021 David Cattermole.
+ *
+ * This file is part of OpenCompGraphMaya.
+ *
+ * OpenCompGraphMaya is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * OpenCompGraphMaya is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OpenCompGraphMaya.  If not, see <https://www.gnu.org/licenses/>.
+ * ====================================================================
+ *
+ * The node graph edited by the Maya DG.
+ *
+ * DG computes describe the OCG nodes, attributes and connections of
+ * the scene in a shared graph, while images are computed by OCG
+ * graphs owned by the threads executing them. An execution copies the
+ * edits made since it last executed into its own graph, holding the
+ * shared graph lock only while copying, so DG computes never wait
+ * for images to be computed.
+ */
+
+#ifndef OPENCOMPGRAPHMAYA_SHARED_GRAPH_H
+#define OPENCOMPGRAPHMAYA_SHARED_GRAPH_H
+
+// STL
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+// OCG
+#include "opencompgraph.h"
+
+namespace ocg = open_comp_graph;
+
+namespace open_comp_graph_maya {
+
+enum class GraphAttrType : uint8_t {
+    kFloat32 = 0,
+    kInteger32,
+    kString,
+};
+
+struct GraphAttrEdit {
+    GraphAttrEdit()
+        : node(ocg::NodeType::kNull, 0)
+        , name()
+        , type(GraphAttrType::kInteger32)
+        , value_f32(0.0f)
+        , value_i32(0)
+        , value_str() {}
+
+    bool has_same_value(const GraphAttrEdit &other) const;
+
+    ocg::Node node;
+    std::string name;
+    GraphAttrType type;
+    float value_f32;
+    int32_t value_i32;
+    std::string value_str;
+};
+
+struct GraphInputEdit {
+    GraphInputEdit()
+        : node(ocg::NodeType::kNull, 0)
+        , input_num(0)
+        , input_node(ocg::NodeType::kNull, 0) {}
+
+    ocg::Node node;
+    uint8_t input_num;
+
+    // A null node disconnects the input.
+    ocg::Node input_node;
+};
+
+// The edits of a shared graph made after a generation.
+struct GraphEdits {
+    GraphEdits()
+        : generation(0) {}
+
+    bool empty() const;
+
+    // The generation of the shared graph the edits were taken at.
+    uint64_t generation;
+
+    std::vector<ocg::Node> nodes;
+    std::vector<GraphAttrEdit> attrs;
+    std::vector<GraphInputEdit> inputs;
+};
+
+// The nodes, attributes and connections of the OCG graph, with the
+// same editing functions as 'ocg::Graph'.
+//
+// Must only be accessed while the shared graph lock is held, except
+// for 'generation'.
+class SharedGraph {
+public:
+    SharedGraph();
+
+    bool node_exists(const ocg::Node &node) const;
+
+    ocg::Node create_node(ocg::NodeType node_type, uint64_t id);
+
+    void set_node_attr_f32(
+        const ocg::Node &node, const std::string &name, float value);
+    void set_node_attr_i32(
+        const ocg::Node &node, const std::string &name, int32_t value);
+    void set_node_attr_str(
+        const ocg::Node &node, const std::string &name,
+        const std::string &value);
+
+    void connect(
+        const ocg::Node &input_node,
+        const ocg::Node &node,
+        uint8_t input_num);
+    void disconnect_input(const ocg::Node &node, uint8_t input_num);
+
+    std::string data_debug_string() const;
+
+    // A hash of the node's type, attribute values and inputs
+    // (recursively), without node ids. Nodes of different Maya nodes
+    // computing the same image, such as the viewer nodes of two
+    // image planes viewing the same stream, have the same hash.
+    uint64_t node_hash(const ocg::Node &node) const;
+
+    // The files read by the nodes upstream of 'node' (and 'node'
+    // itself) at 'frame'; each node with a 'file_path' attribute
+    // reads the frame mapped by its frame range attributes. The hash
+    // does not cover the files, so streams computed from files that
+    // have changed on disk are told apart with these.
+    void node_file_paths(
+        const ocg::Node &node,
+        const double frame,
+        std::vector<std::string> &file_paths) const;
+
+    // Increases each time the graph is changed. Setting an attribute
+    // to the value it already has is not a change. May be read without
+    // holding the shared graph lock.
+    uint64_t generation() const;
+
+    // Add the edits made after 'generation' to 'edits'; zero gives
+    // the whole graph.
+    void edits_since(const uint64_t generation, GraphEdits &edits) const;
+
+private:
+    uint64_t next_generation();
+    void set_node_attr(const GraphAttrEdit &edit);
+    uint64_t node_hash(
+        const uint64_t node_id,
+        const uint32_t depth,
+        std::unordered_map<uint64_t, uint64_t> &node_hashes) const;
+    const GraphAttrEdit *find_attr(
+        const uint64_t node_id,
+        const std::string &name) const;
+
+    template <typename T>
+    struct Record {
+        T edit;
+        uint64_t generation;
+    };
+
+    typedef std::pair<uint64_t, std::string> AttrKey;
+    typedef std::pair<uint64_t, uint8_t> InputKey;
+
+    std::atomic<uint64_t> m_generation;
+    std::unordered_map<uint64_t, Record<ocg::Node>> m_nodes;
+    std::map<AttrKey, Record<GraphAttrEdit>> m_attrs;
+    std::map<InputKey, Record<GraphInputEdit>> m_inputs;
+};
+
+// Copy 'edits' into 'graph'.
+void apply_graph_edits(const GraphEdits &edits, ocg::Graph &graph);
+
+} // namespace open_comp_graph_maya
+
+#endif // OPENCOMPGRAPHMAYA_SHARED_GRAPH_H
@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) 2021 David Cattermole.
+ *
+ * This file is part of OpenCompGraphMaya.
+ *
+ * OpenCompGraphMaya is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * OpenCompGraphMaya is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OpenCompGraphMaya.  If not, see <https://www.gnu.org/licenses/>.
+ * ====================================================================
+ *
+ * A bounded pool of threads shared by the parallel reductions of the
+ * plug-in.
+ */
+
+// STL
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// OCG Maya
+#include "worker_pool.h"
+
+namespace open_comp_graph_maya {
+namespace worker_pool {
+
+namespace {
+
+const size_t kMaxThreads = 7;
+
+// The tasks of one 'run_tasks' call. Tasks are taken in order by the
+// calling thread and the pool's threads.
+struct Job {
+    Job(const size_t count, const TaskFunction &function)
+        : task_count(count)
+        , task(function)
+        , next_task(0)
+        , finished_count(0) {}
+
+    const size_t task_count;
+    const TaskFunction &task;
+
+    // Guarded by the pool mutex.
+    size_t next_task;
+    size_t finished_count;
+};
+
+class WorkerPool {
+public:
+    WorkerPool()
+        : m_stop(false) {}
+
+    ~WorkerPool() {
+        this->shutdown();
+    }
+
+    size_t thread_count() const {
+        const size_t hardware_count = std::max<size_t>(
+            1, static_cast<size_t>(std::thread::hardware_concurrency()));
+        return std::min(hardware_count - 1, kMaxThreads);
+    }
+
+    void run_tasks(const size_t task_count, const TaskFunction &task) {
+        if (task_count == 0) {
+            return;
+        }
+        auto job = std::make_shared<Job>(task_count, task);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            this->start();
+            m_jobs.push_back(job);
+        }
+        m_condition.notify_all();
+
+        // The calling thread takes tasks until none are left, then
+        // waits for the tasks still running on the pool's threads.
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (job->next_task < job->task_count) {
+            this->run_next_task(job, lock);
+        }
+        m_done_condition.wait(lock, [&job] {
+            return job->finished_count == job->task_count;
+        });
+    }
+
+    void shutdown() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_condition.notify_all();
+        for (auto &thread : m_threads) {
+            if (thread.joinable()) {
+                thread.join();
+            }
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_threads.clear();
+        m_stop = false;
+    }
+
+private:
+    // The threads are only started when first needed. Must be called
+    // with the mutex held.
+    void start() {
+        if (!m_threads.empty()) {
+            return;
+        }
+        const size_t count = this->thread_count();
+        for (size_t i = 0; i < count; ++i) {
+            m_threads.emplace_back(&WorkerPool::run, this);
+        }
+    }
+
+    // Run the next task of 'job', unlocking 'lock' while it runs.
+    // Finished jobs leave the queue once their last task is taken.
+    void run_next_task(
+            const std::shared_ptr<Job> &job,
+            std::unique_lock<std::mutex> &lock) {
+        const size_t task_index = job->next_task;
+        job->next_task += 1;
+        if (job->next_task == job->task_count) {
+            m_jobs.erase(std::find(m_jobs.begin(), m_jobs.end(), job));
+        }
+        lock.unlock();
+        job->task(task_index);
+        lock.lock();
+        job->finished_count += 1;
+        if (job->finished_count == job->task_count) {
+            m_done_condition.notify_all();
+        }
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true) {
+            m_condition.wait(lock, [this] {
+                return m_stop || !m_jobs.empty();
+            });
+            if (m_stop) {
+                break;
+            }
+            // Keep a reference, the job leaves the queue when its
+            // last task is taken.
+            std::shared_ptr<Job> job = m_jobs.front();
+            this->run_next_task(job, lock);
+        }
+    }
+
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::condition_variable m_done_condition;
+    std::vector<std::thread> m_threads;
+    std::deque<std::shared_ptr<Job>> m_jobs;
+    bool m_stop;
+};
+
+WorkerPool &get_worker_pool() {
+    static WorkerPool worker_pool;
+    return worker_pool;
+}
+
+} // namespace
+
+size_t max_task_count() {
+    return get_worker_pool().thread_count() + 1;
+}
+
+void run_tasks(const size_t task_count, const TaskFunction &task) {
+    get_worker_pool().run_tasks(task_count, task);
+}
+
+void shutdown() {
+    get_worker_pool().shutdown();
+}
+
+} // namespace worker_pool
+} // namespace open_comp_graph_maya
@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2021 David Cattermole.
+ *
+ * This file is part of OpenCompGraphMaya.
+ *
+ * OpenCompGraphMaya is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * OpenCompGraphMaya is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with OpenCompGraphMaya.  If not, see <https://www.gnu.org/licenses/>.
+ * ====================================================================
+ *
+ * A bounded pool of threads shared by the parallel reductions of the
+ * plug-in.
+ *
+ * Deforming the vertices of an image plane and computing the scopes
+ * of an image are split into tasks run on one pool, rather than on
+ * threads created for each call, so scrubbing with many image planes
+ * does not create threads per plane per frame.
+ */
+
+#ifndef OPENCOMPGRAPHMAYA_WORKER_POOL_H
+#define OPENCOMPGRAPHMAYA_WORKER_POOL_H
+
+// STL
+#include <cstddef>
+#include <functional>
+
+namespace open_comp_graph_maya {
+namespace worker_pool {
+
+// Called with the index of each task, from zero to 'task_count'.
+typedef std::function<void(const size_t)> TaskFunction;
+
+// The most tasks worth splitting work into; the pool's threads and
+// the calling thread.
+size_t max_task_count();
+
+// Run 'task_count' tasks and return once all have finished. The
+// calling thread runs tasks too, so this may be called from any
+// thread, including from inside a task.
+void run_tasks(const size_t task_count, const TaskFunction &task);
+
+// Stop the threads. Called when the plug-in is unloaded.
+void shutdown();
+
+} // namespace worker_pool
+} // namespace open_comp_graph_maya
+
+#endif // OPENCOMPGRAPHMAYA_WORKER_POOL_H
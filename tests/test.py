@@ -5,6 +5,9 @@ working as expected.
 
 import os
 import random
+import shutil
+import struct
+import tempfile
 import maya.cmds
 
 
@@ -38,6 +41,95 @@ def _get_random_file_path():
     return os.path.abspath(file_path), start_frame, end_frame
 
 
+def _get_test_data_dir():
+    """The directory of the OpenCompGraph test images."""
+    try:
+        root_dir = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..')
+    except NameError:
+        # Run from the Script Editor.
+        root_dir = "C:/Users/catte/dev/OpenCompGraphMaya"
+    return os.path.abspath(
+        os.path.join(root_dir, 'src', 'OpenCompGraph', 'tests', 'data'))
+
+
+def _get_checker_file_path():
+    return os.path.join(_get_test_data_dir(), 'checker_8bit_rgba_3840x2160.png')
+
+
+def _execute_fails(node, start_frame, end_frame, write_queue_depth=2):
+    """Does 'ocgExecute' fail to execute 'node' on the frames?"""
+    try:
+        maya.cmds.ocgExecute(
+            node,
+            frameStart=start_frame,
+            frameEnd=end_frame,
+            writeQueueDepth=write_queue_depth)
+    except RuntimeError:
+        return True
+    return False
+
+
+def _write_checker_sequence(file_path, start_frame, end_frame):
+    """Write the checker image as the frames of 'file_path' (with '#'
+    frame padding).
+    """
+    read_node = maya.cmds.createNode('ocgImageRead')
+    write_node = maya.cmds.createNode('ocgImageWrite')
+    maya.cmds.connectAttr(read_node + '.outStream', write_node + '.inStream')
+    maya.cmds.setAttr(read_node + '.filePath', _get_checker_file_path(), type='string')
+    maya.cmds.setAttr(write_node + '.filePath', file_path, type='string')
+    maya.cmds.ocgExecute(write_node, frameStart=start_frame, frameEnd=end_frame)
+    maya.cmds.delete(read_node, write_node)
+
+
+def _frame_path(file_path, frame):
+    return file_path.replace('####', '%04d' % frame)
+
+
+def _read_file(file_path):
+    with open(file_path, 'rb') as f:
+        return f.read()
+
+
+def _read_container_entries(file_path, index_offset, entry_count):
+    """The frame index of a cache container, as a dict of frame
+    number to (chunk offset, chunk stored size, frame file size).
+    """
+    entries = {}
+    with open(file_path, 'rb') as f:
+        f.seek(index_offset)
+        for i in range(entry_count):
+            frame, compression, offset, stored_size, size = struct.unpack(
+                '<iIQQQ', f.read(32))
+            assert compression == 0
+            entries[frame] = (offset, stored_size, size)
+    return entries
+
+
+def _read_container_index(file_path):
+    """Read the header of a cache container ('.ocgcache' file), and the
+    frame index it names.
+
+    Returns the chunk alignment, the index offset, the number of
+    entries, and the entries (see '_read_container_entries').
+    """
+    with open(file_path, 'rb') as f:
+        header = f.read(64)
+    assert header[0:4] == b'OCGC'
+    version, alignment, flags, index_offset, entry_count, index_hash = \
+        struct.unpack('<IIIQQQ', header[4:40])
+    assert version == 1
+    entries = _read_container_entries(file_path, index_offset, entry_count)
+    return alignment, index_offset, entry_count, entries
+
+
+def _read_container_chunk(file_path, entry):
+    offset, stored_size, size = entry
+    with open(file_path, 'rb') as f:
+        f.seek(offset)
+        return f.read(stored_size)
+
+
 def test_a():
     """
     An image plane without any inputs must not fail.
@@ -247,6 +339,202 @@ def test_h():
     return
 
 
+def test_i():
+    """Write frames to a cache container, replace a frame, then read the
+    frames back from the container.
+
+    A writer never overwrites the chunks or the index readers may be
+    using, so a reader that read the index before a frame was
+    replaced still reads whole frames.
+    """
+    temp_dir = tempfile.mkdtemp(prefix='ocgTest')
+    container_path = os.path.join(temp_dir, 'cache.ocgcache')
+
+    read_node = maya.cmds.createNode('ocgImageRead')
+    write_node = maya.cmds.createNode('ocgImageWrite')
+    maya.cmds.connectAttr(read_node + '.outStream', write_node + '.inStream')
+    maya.cmds.setAttr(read_node + '.filePath', _get_checker_file_path(), type='string')
+    maya.cmds.setAttr(write_node + '.filePath', container_path, type='string')
+
+    # Append frames.
+    maya.cmds.ocgExecute(write_node, frameStart=1, frameEnd=3)
+    alignment, index_offset, entry_count, entries = \
+        _read_container_index(container_path)
+    assert sorted(entries.keys()) == [1, 2, 3]
+    chunks = {}
+    for frame, entry in entries.items():
+        offset, stored_size, size = entry
+        assert (offset % alignment) == 0
+        assert stored_size == size
+        assert size > 0
+        chunks[frame] = _read_container_chunk(container_path, entry)
+        # OpenEXR magic number.
+        assert chunks[frame][0:4] == b'\x76\x2f\x31\x01'
+
+    # Replace a frame. One frame of three (of the same size) replaced
+    # is not enough to compact the container.
+    maya.cmds.ocgExecute(write_node, frameStart=2, frameEnd=2)
+    _, new_index_offset, _, new_entries = _read_container_index(container_path)
+    assert sorted(new_entries.keys()) == [1, 2, 3]
+    assert new_index_offset > index_offset
+    assert new_entries[1] == entries[1]
+    assert new_entries[3] == entries[3]
+    assert new_entries[2][0] > entries[2][0]
+
+    # Read while appending; the old index and chunks are unchanged.
+    old_entries = _read_container_entries(
+        container_path, index_offset, entry_count)
+    assert old_entries == entries
+    for frame, entry in old_entries.items():
+        assert _read_container_chunk(container_path, entry) == chunks[frame]
+
+    # Read the frames back.
+    cache_read_node = maya.cmds.createNode('ocgImageRead')
+    read_back_node = maya.cmds.createNode('ocgImageWrite')
+    maya.cmds.connectAttr(cache_read_node + '.outStream', read_back_node + '.inStream')
+    maya.cmds.setAttr(cache_read_node + '.filePath', _get_checker_file_path(), type='string')
+    maya.cmds.setAttr(cache_read_node + '.diskCacheEnable', 1)
+    maya.cmds.setAttr(cache_read_node + '.diskCacheFilePath', container_path, type='string')
+    read_back_path = os.path.join(temp_dir, 'read_back.####.exr')
+    maya.cmds.setAttr(read_back_node + '.filePath', read_back_path, type='string')
+    maya.cmds.ocgExecute(read_back_node, frameStart=1, frameEnd=3)
+    for frame in [1, 2, 3]:
+        assert os.path.getsize(_frame_path(read_back_path, frame)) > 0
+
+    shutil.rmtree(temp_dir)
+    return
+
+
+def test_j():
+    """Read a sequence with a missing frame, without setting the frame
+    range; the range of the frames on disk is used.
+    """
+    temp_dir = tempfile.mkdtemp(prefix='ocgTest')
+    sequence_path = os.path.join(temp_dir, 'sequence.####.exr')
+    _write_checker_sequence(sequence_path, 11, 15)
+    os.remove(_frame_path(sequence_path, 13))
+
+    read_node = maya.cmds.createNode('ocgImageRead')
+    write_node = maya.cmds.createNode('ocgImageWrite')
+    maya.cmds.connectAttr(read_node + '.outStream', write_node + '.inStream')
+    maya.cmds.setAttr(read_node + '.filePath', sequence_path, type='string')
+    maya.cmds.setAttr(read_node + '.startFrame', 0)
+    maya.cmds.setAttr(read_node + '.endFrame', 0)
+    out_path = os.path.join(temp_dir, 'out.####.exr')
+    maya.cmds.setAttr(write_node + '.filePath', out_path, type='string')
+
+    # Frames outside of the range on disk are an error.
+    maya.cmds.setAttr(read_node + '.beforeFrame', 4)  # error
+    maya.cmds.setAttr(read_node + '.afterFrame', 4)  # error
+    assert not _execute_fails(write_node, 11, 12)
+    assert not _execute_fails(write_node, 14, 15)
+    assert _execute_fails(write_node, 10, 10)
+    assert _execute_fails(write_node, 16, 16)
+
+    # The missing frame is inside the range, so it is not held.
+    maya.cmds.setAttr(read_node + '.beforeFrame', 0)  # hold
+    maya.cmds.setAttr(read_node + '.afterFrame', 0)  # hold
+    assert _execute_fails(write_node, 13, 13)
+    assert not _execute_fails(write_node, 9, 9)
+    assert not _execute_fails(write_node, 17, 17)
+    assert _read_file(_frame_path(out_path, 9)) == \
+        _read_file(_frame_path(out_path, 11))
+    assert _read_file(_frame_path(out_path, 17)) == \
+        _read_file(_frame_path(out_path, 15))
+
+    shutil.rmtree(temp_dir)
+    return
+
+
+def test_k():
+    """A frame that fails to execute fails the 'ocgExecute' command; the
+    frames before it are written. Without a write queue, no frames are
+    executed after it.
+    """
+    temp_dir = tempfile.mkdtemp(prefix='ocgTest')
+    sequence_path = os.path.join(temp_dir, 'sequence.####.exr')
+    _write_checker_sequence(sequence_path, 1, 5)
+    os.remove(_frame_path(sequence_path, 3))
+
+    read_node = maya.cmds.createNode('ocgImageRead')
+    write_node = maya.cmds.createNode('ocgImageWrite')
+    maya.cmds.connectAttr(read_node + '.outStream', write_node + '.inStream')
+    maya.cmds.setAttr(read_node + '.filePath', sequence_path, type='string')
+    maya.cmds.setAttr(read_node + '.startFrame', 1)
+    maya.cmds.setAttr(read_node + '.endFrame', 5)
+
+    # Frames are executed one after the other.
+    out_path = os.path.join(temp_dir, 'out.####.exr')
+    maya.cmds.setAttr(write_node + '.filePath', out_path, type='string')
+    assert _execute_fails(write_node, 1, 5, write_queue_depth=0)
+    assert os.path.isfile(_frame_path(out_path, 1))
+    assert os.path.isfile(_frame_path(out_path, 2))
+    assert not os.path.isfile(_frame_path(out_path, 3))
+    assert not os.path.isfile(_frame_path(out_path, 4))
+    assert not os.path.isfile(_frame_path(out_path, 5))
+
+    # Frames are executed while the next frames are queued.
+    queued_out_path = os.path.join(temp_dir, 'queued_out.####.exr')
+    maya.cmds.setAttr(write_node + '.filePath', queued_out_path, type='string')
+    assert _execute_fails(write_node, 1, 5, write_queue_depth=2)
+    assert os.path.isfile(_frame_path(queued_out_path, 1))
+    assert os.path.isfile(_frame_path(queued_out_path, 2))
+    assert not os.path.isfile(_frame_path(queued_out_path, 3))
+
+    # The frames that can be read succeed.
+    assert not _execute_fails(write_node, 4, 5, write_queue_depth=2)
+    assert os.path.isfile(_frame_path(queued_out_path, 5))
+
+    shutil.rmtree(temp_dir)
+    return
+
+
+def test_l():
+    """Execute the copies of the shared graph made for each frame.
+
+    Equal graphs (other than their node ids) give equal images, and
+    an attribute changed between executions is copied, so an image
+    computed for the old value is never reused.
+    """
+    temp_dir = tempfile.mkdtemp(prefix='ocgTest')
+    out_paths = []
+    grade_nodes = []
+    write_nodes = []
+    for name in ['a', 'b']:
+        read_node = maya.cmds.createNode('ocgImageRead')
+        grade_node = maya.cmds.createNode('ocgColorGrade')
+        write_node = maya.cmds.createNode('ocgImageWrite')
+        maya.cmds.connectAttr(read_node + '.outStream', grade_node + '.inStream')
+        maya.cmds.connectAttr(grade_node + '.outStream', write_node + '.inStream')
+        maya.cmds.setAttr(read_node + '.filePath', _get_checker_file_path(), type='string')
+        maya.cmds.setAttr(grade_node + '.multiplyR', 0.25)
+        out_path = os.path.join(temp_dir, name + '.####.exr')
+        maya.cmds.setAttr(write_node + '.filePath', out_path, type='string')
+        out_paths.append(_frame_path(out_path, 1))
+        grade_nodes.append(grade_node)
+        write_nodes.append(write_node)
+
+    maya.cmds.ocgExecute(write_nodes, frameStart=1, frameEnd=1)
+    image_b = _read_file(out_paths[1])
+    assert _read_file(out_paths[0]) == image_b
+
+    maya.cmds.setAttr(grade_nodes[0] + '.multiplyR', 2.0)
+    maya.cmds.ocgExecute(write_nodes[0], frameStart=1, frameEnd=1)
+    image_a = _read_file(out_paths[0])
+    assert image_a != image_b
+
+    # No edits since the last execution.
+    maya.cmds.ocgExecute(write_nodes[0], frameStart=1, frameEnd=1, writeQueueDepth=0)
+    assert _read_file(out_paths[0]) == image_a
+
+    maya.cmds.setAttr(grade_nodes[0] + '.multiplyR', 0.25)
+    maya.cmds.ocgExecute(write_nodes[0], frameStart=1, frameEnd=1)
+    assert _read_file(out_paths[0]) == image_b
+
+    shutil.rmtree(temp_dir)
+    return
+
+
 def main():
     maya.cmds.loadPlugin('OpenCompGraphMaya')
     test_a()
@@ -257,6 +545,10 @@ def main():
     test_f()
     test_g()
     test_h()
+    test_i()
+    test_j()
+    test_k()
+    test_l()
 
 
 main()